@@ -24,8 +24,8 @@ static uint32_t gMusicVolume = MAX_VOLUME;
 static uint32_t gSoundVolume = MAX_VOLUME;
 static uint32_t gPlayingMusicTrackNum = UINT32_MAX;
 
-void init() noexcept {
-    if (!gAudioOutputDevice.init()) {
+void init(const bool bNullOutput) noexcept {
+    if (!gAudioOutputDevice.init(bNullOutput)) {
         FATAL_ERROR("Unable to initialize an audio output device!");
     }
 
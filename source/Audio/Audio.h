@@ -11,8 +11,9 @@ class AudioSystem;
 //------------------------------------------------------------------------------------------------------------------------------------------
 BEGIN_NAMESPACE(Audio)
 
-// Init and shutdown
-void init() noexcept;
+// Init and shutdown.
+// If using null output then no audio device is opened and nothing is heard.
+void init(const bool bNullOutput = false) noexcept;
 void loadAllSounds() noexcept;
 void shutdown() noexcept;
 
@@ -19,10 +19,16 @@ AudioOutputDevice::~AudioOutputDevice() noexcept {
     shutdown();
 }
 
-bool AudioOutputDevice::init() noexcept {
+bool AudioOutputDevice::init(const bool bNullDevice) noexcept {
     ASSERT(!mbIsInitialized);
     mbIsInitialized = true;
 
+    // If using a null device then just pretend there is an output at the usual sample rate
+    if (bNullDevice) {
+        mSampleRate = 48000;
+        return true;
+    }
+
     // Firstly initialize SDL
     if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
         shutdown();
@@ -106,12 +112,18 @@ void AudioOutputDevice::unregisterAudioSystem(AudioSystem& system) noexcept {
 
 void AudioOutputDevice::lockAudioDevice() noexcept {
     ASSERT(mbIsInitialized);
-    SDL_LockAudioDevice(mAudioDeviceId);
+
+    if (mAudioDeviceId != 0) {
+        SDL_LockAudioDevice(mAudioDeviceId);
+    }
 }
 
 void AudioOutputDevice::unlockAudioDevice() noexcept {
     ASSERT(mbIsInitialized);
-    SDL_UnlockAudioDevice(mAudioDeviceId);
+
+    if (mAudioDeviceId != 0) {
+        SDL_UnlockAudioDevice(mAudioDeviceId);
+    }
 }
 
 void AudioOutputDevice::audioCallback(
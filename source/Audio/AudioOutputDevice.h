@@ -14,7 +14,9 @@ public:
     AudioOutputDevice() noexcept;
     ~AudioOutputDevice() noexcept;
 
-    bool init() noexcept;
+    // Initialize the device, optionally as a null device which does not open any actual audio output.
+    // Nothing is ever mixed or played with a null device, which is used when running headless.
+    bool init(const bool bNullDevice = false) noexcept;
     void shutdown() noexcept;
     inline bool isInitialized() const noexcept { return mbIsInitialized; }
 
@@ -0,0 +1,55 @@
+#include "CommandLine.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(CommandLine)
+
+static std::vector<std::string> gArgs;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Find the index of the given argument in the list of arguments, or returns '-1' if not found
+//------------------------------------------------------------------------------------------------------------------------------------------
+static int32_t findArg(const char* const arg) noexcept {
+    ASSERT(arg);
+    const int32_t numArgs = (int32_t) gArgs.size();
+
+    for (int32_t i = 0; i < numArgs; ++i) {
+        if (gArgs[i] == arg)
+            return i;
+    }
+
+    return -1;
+}
+
+void init(const int argc, const char* const* const argv) noexcept {
+    gArgs.clear();
+
+    // Note: skip the first argument, which is the program name
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i]) {
+            gArgs.emplace_back(argv[i]);
+        }
+    }
+}
+
+void shutdown() noexcept {
+    gArgs.clear();
+    gArgs.shrink_to_fit();
+}
+
+bool hasArg(const char* const arg) noexcept {
+    return (findArg(arg) >= 0);
+}
+
+const char* getArgValue(const char* const arg, const char* const defaultValue) noexcept {
+    const int32_t argIdx = findArg(arg);
+
+    if ((argIdx < 0) || (argIdx + 1 >= (int32_t) gArgs.size()))
+        return defaultValue;
+
+    return gArgs[(size_t) argIdx + 1].c_str();
+}
+
+END_NAMESPACE(CommandLine)
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Macros.h"
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Access to the arguments the program was launched with.
+// Arguments are matched exactly (case sensitive) and the program name itself is not included in the list.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(CommandLine)
+
+// Save a copy of the program arguments on startup and release them on shutdown
+void init(const int argc, const char* const* const argv) noexcept;
+void shutdown() noexcept;
+
+// Tells if the given argument was passed
+bool hasArg(const char* const arg) noexcept;
+
+// Returns the value following the given argument, or the default if the argument is not present or has no value following it
+const char* getArgValue(const char* const arg, const char* const defaultValue = nullptr) noexcept;
+
+END_NAMESPACE(CommandLine)
@@ -0,0 +1,109 @@
+#include "HardwareCounters.h"
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <cstring>
+#endif
+
+BEGIN_NAMESPACE(HardwareCounters)
+
+#if defined(__linux__)
+    static int gL1dReadMissesFd = -1;
+    static int gLlcMissesFd = -1;
+
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    // Opens a single hardware counter for the calling thread and starts it counting; returns '-1' on failure
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    static int openCounter(const uint32_t type, const uint64_t config) noexcept {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        const int fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        return fd;
+    }
+
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    // Reads the value of a counter opened with 'openCounter'; returns '0' on failure
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    static uint64_t readCounter(const int fd) noexcept {
+        uint64_t value = 0;
+
+        if ((fd < 0) || (read(fd, &value, sizeof(value)) != (ssize_t) sizeof(value))) {
+            value = 0;
+        }
+
+        return value;
+    }
+
+    static void closeCounter(int& fd) noexcept {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+#endif  // #if defined(__linux__)
+
+bool init() noexcept {
+    #if defined(__linux__)
+        shutdown();
+
+        gL1dReadMissesFd = openCounter(
+            PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+        );
+
+        gLlcMissesFd = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+        // Only treat the counters as available if both could be opened
+        if ((gL1dReadMissesFd < 0) || (gLlcMissesFd < 0)) {
+            shutdown();
+            return false;
+        }
+
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+void shutdown() noexcept {
+    #if defined(__linux__)
+        closeCounter(gL1dReadMissesFd);
+        closeCounter(gLlcMissesFd);
+    #endif
+}
+
+bool isAvailable() noexcept {
+    #if defined(__linux__)
+        return (gL1dReadMissesFd >= 0);
+    #else
+        return false;
+    #endif
+}
+
+CacheMissCounts readCacheMisses() noexcept {
+    CacheMissCounts counts = {};
+
+    #if defined(__linux__)
+        counts.l1dReadMisses = readCounter(gL1dReadMissesFd);
+        counts.llcMisses = readCounter(gLlcMissesFd);
+    #endif
+
+    return counts;
+}
+
+END_NAMESPACE(HardwareCounters)
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Macros.h"
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Very basic access to CPU hardware performance counters, for cache miss counts in benchmarks.
+//
+// Notes:
+//  (1) Only implemented on Linux at present, via 'perf_event_open'. On other platforms, or if the kernel does not allow access to the
+//      counters (see '/proc/sys/kernel/perf_event_paranoid'), the counters are simply reported as being unavailable.
+//  (2) Counters are opened for the thread which calls 'init' and ONLY count events for that thread.
+//      Work done by job system worker threads is not counted.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(HardwareCounters)
+
+// Cache miss counts read from the hardware counters
+struct CacheMissCounts {
+    uint64_t    l1dReadMisses;      // Level 1 data cache read misses
+    uint64_t    llcMisses;          // Last level cache misses
+};
+
+// Opens the counters for the calling thread and starts them counting.
+// Returns 'false' if the counters are not available on this system.
+bool init() noexcept;
+void shutdown() noexcept;
+
+// Tells if the counters were successfully opened
+bool isAvailable() noexcept;
+
+// Reads the current (cumulative) cache miss counts for the thread which opened the counters.
+// If the counters are not available then all counts are returned as '0'.
+CacheMissCounts readCacheMisses() noexcept;
+
+END_NAMESPACE(HardwareCounters)
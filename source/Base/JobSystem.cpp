@@ -0,0 +1,173 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+BEGIN_NAMESPACE(JobSystem)
+
+// Never create more threads than this, regardless of what is requested
+static constexpr uint32_t MAX_THREADS = 64;
+
+static std::vector<std::thread>     gWorkerThreads;         // Worker threads (excludes the main thread)
+static std::mutex                   gMutex;                 // Guards the batch details and signalling below
+static std::condition_variable      gBatchStartedCV;        // Signalled when a new batch is issued or when shutting down
+static std::condition_variable      gBatchFinishedCV;       // Signalled when the last worker finishes with the current batch
+static uint64_t                     gBatchId;               // Incremented for every batch issued
+static uint32_t                     gNumWorkersFinished;    // How many workers are done with the current batch
+static bool                         gbShutdownRequested;    // Set when the workers should exit
+static JobFunc                      gBatchJobFunc;          // Details for the current batch of jobs
+static void*                        gpBatchUserData;
+static uint32_t                     gBatchNumJobs;
+static std::atomic<uint32_t>        gNextJobIdx;            // The next job in the batch to be claimed by a thread
+static thread_local uint32_t        gThreadIdx;             // Index of the current thread amongst the threads that run jobs (main thread is '0')
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Claims and runs jobs in the current batch until there are no more left
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void runJobsInBatch(const JobFunc jobFunc, void* const pUserData, const uint32_t numJobs) noexcept {
+    while (true) {
+        const uint32_t jobIdx = gNextJobIdx.fetch_add(1, std::memory_order_relaxed);
+
+        if (jobIdx >= numJobs)
+            break;
+
+        jobFunc(jobIdx, pUserData);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Main loop for a worker thread: waits for batches to be issued and helps to run them until told to exit.
+//
+// Note: every worker must check in after each batch before the batch is regarded as finished. This ensures that a worker never
+// sleeps through one batch and wakes up in the middle of the next with stale batch details.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void workerThreadMain(const uint32_t threadIdx) noexcept {
+    gThreadIdx = threadIdx;
+    uint64_t lastBatchId = 0;
+
+    while (true) {
+        JobFunc jobFunc;
+        void* pUserData;
+        uint32_t numJobs;
+
+        {
+            std::unique_lock<std::mutex> lock(gMutex);
+            gBatchStartedCV.wait(lock, [&]() noexcept {
+                return (gbShutdownRequested || (gBatchId != lastBatchId));
+            });
+
+            if (gbShutdownRequested)
+                return;
+
+            lastBatchId = gBatchId;
+            jobFunc = gBatchJobFunc;
+            pUserData = gpBatchUserData;
+            numJobs = gBatchNumJobs;
+        }
+
+        runJobsInBatch(jobFunc, pUserData, numJobs);
+
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+            ++gNumWorkersFinished;
+
+            if (gNumWorkersFinished >= (uint32_t) gWorkerThreads.size()) {
+                gBatchFinishedCV.notify_one();
+            }
+        }
+    }
+}
+
+void init(const uint32_t numThreads) noexcept {
+    ASSERT(gWorkerThreads.empty());
+
+    // Figure out how many threads to use in total (including the main thread)
+    uint32_t numThreadsToUse = numThreads;
+
+    if (numThreadsToUse <= 0) {
+        numThreadsToUse = std::thread::hardware_concurrency();
+    }
+
+    numThreadsToUse = std::clamp(numThreadsToUse, 1u, MAX_THREADS);
+
+    // Spawn the workers: the main thread counts as one of the threads, so we need 1 less than the total
+    gBatchId = 0;
+    gNumWorkersFinished = 0;
+    gbShutdownRequested = false;
+    gBatchJobFunc = nullptr;
+    gpBatchUserData = nullptr;
+    gBatchNumJobs = 0;
+    gNextJobIdx = 0;
+
+    const uint32_t numWorkers = numThreadsToUse - 1;
+    gWorkerThreads.reserve(numWorkers);
+
+    for (uint32_t i = 0; i < numWorkers; ++i) {
+        gWorkerThreads.emplace_back(workerThreadMain, i + 1);
+    }
+}
+
+void shutdown() noexcept {
+    // Tell all the workers to exit and wait for them to finish up
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gbShutdownRequested = true;
+    }
+
+    gBatchStartedCV.notify_all();
+
+    for (std::thread& thread : gWorkerThreads) {
+        thread.join();
+    }
+
+    gWorkerThreads.clear();
+    gWorkerThreads.shrink_to_fit();
+}
+
+uint32_t getNumThreads() noexcept {
+    return (uint32_t) gWorkerThreads.size() + 1;
+}
+
+uint32_t getThreadIdx() noexcept {
+    return gThreadIdx;
+}
+
+void runJobs(const JobFunc jobFunc, void* const pUserData, const uint32_t numJobs) noexcept {
+    ASSERT(jobFunc);
+
+    // If there is no point in using workers then just run the jobs here serially
+    if (gWorkerThreads.empty() || (numJobs <= 1)) {
+        for (uint32_t jobIdx = 0; jobIdx < numJobs; ++jobIdx) {
+            jobFunc(jobIdx, pUserData);
+        }
+
+        return;
+    }
+
+    // Issue the batch to the workers
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        gBatchJobFunc = jobFunc;
+        gpBatchUserData = pUserData;
+        gBatchNumJobs = numJobs;
+        gNumWorkersFinished = 0;
+        gNextJobIdx.store(0, std::memory_order_relaxed);
+        ++gBatchId;
+    }
+
+    gBatchStartedCV.notify_all();
+
+    // Help out with running the jobs and then wait for all the workers to check in
+    runJobsInBatch(jobFunc, pUserData, numJobs);
+
+    std::unique_lock<std::mutex> lock(gMutex);
+    gBatchFinishedCV.wait(lock, []() noexcept {
+        return (gNumWorkersFinished >= (uint32_t) gWorkerThreads.size());
+    });
+}
+
+END_NAMESPACE(JobSystem)
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Macros.h"
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A very simple job system: a pool of worker threads which can be given a batch of numbered jobs to run in parallel.
+//
+// Notes:
+//  (1) Batches are always issued from the main thread and the main thread also helps out running jobs in the batch.
+//      The call to issue a batch does not return until all jobs in the batch have finished running.
+//  (2) Jobs within a batch may run in any order and on any thread, so they must not depend on each other.
+//  (3) If the system is configured to use just 1 thread then all jobs simply run serially on the calling thread.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(JobSystem)
+
+// Signature for a job function: receives the index of the job within the batch and user data for the batch
+typedef void (*JobFunc)(const uint32_t jobIdx, void* const pUserData) noexcept;
+
+// Startup and shutdown the job system.
+// The thread count given includes the main thread; if '0' is given then the number of hardware threads is used.
+void init(const uint32_t numThreads) noexcept;
+void shutdown() noexcept;
+
+// Returns the total number of threads that can run jobs, including the main thread
+uint32_t getNumThreads() noexcept;
+
+// Returns the index of the calling thread amongst the threads that can run jobs: the main thread is always index '0'.
+// Useful for jobs that need scratch memory which is private to the thread running the job.
+uint32_t getThreadIdx() noexcept;
+
+// Runs the specified number of jobs with the given function and user data and waits for them all to complete
+void runJobs(const JobFunc jobFunc, void* const pUserData, const uint32_t numJobs) noexcept;
+
+END_NAMESPACE(JobSystem)
@@ -0,0 +1,356 @@
+#include "Profiler.h"
+
+#include "JobSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+BEGIN_NAMESPACE(Profiler)
+
+// A scope recorded for the current frame
+struct Zone {
+    const char*     name;
+    uint32_t        depth;
+    uint64_t        startNs;    // Start and end time, relative to when the profiler was initialized
+    uint64_t        endNs;
+};
+
+// A counter value recorded for the current frame
+struct Counter {
+    const char*     name;
+    int64_t         value;
+};
+
+// Accumulated time for a scope over the frames being averaged for the overlay.
+// Scopes are identified by their name and the scope they are nested in.
+struct ZoneTotal {
+    const char*     name;
+    uint32_t        parentIdx;
+    uint64_t        totalNs;
+};
+
+// Accumulated value for a counter over the frames being averaged for the overlay
+struct CounterTotal {
+    const char*     name;
+    int64_t         total;
+};
+
+static constexpr uint32_t NO_PARENT = UINT32_MAX;
+static constexpr uint32_t MAX_ZONE_DEPTH = 32;
+
+bool gbCapturing;
+
+static std::chrono::steady_clock::time_point    gInitTime;
+static bool                                     gbOverlayEnabled;
+static std::FILE*                               gpCsvFile;
+static std::FILE*                               gpTraceFile;
+
+// Recording for the current frame
+static std::vector<Zone>        gFrameZones;
+static std::vector<Counter>     gFrameCounters;
+static uint32_t                 gCurZoneDepth;
+static uint64_t                 gFrameStartNs;
+static uint64_t                 gFrameNum;
+
+// Averaging of results for the overlay, and the most recent averaged results
+static std::vector<ZoneTotal>       gZoneTotals;
+static std::vector<CounterTotal>    gCounterTotals;
+static uint64_t                     gFrameTotalNs;
+static uint32_t                     gNumFramesTotalled;
+static std::vector<ZoneStats>       gZoneStats;
+static std::vector<CounterStats>    gCounterStats;
+static float                        gAverageFrameUSec;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Get the current time in nanoseconds since the profiler was initialized
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t getTimeNs() noexcept {
+    const auto timeSinceInit = std::chrono::steady_clock::now() - gInitTime;
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(timeSinceInit).count();
+}
+
+static bool namesMatch(const char* const pName1, const char* const pName2) noexcept {
+    return ((pName1 == pName2) || (std::strcmp(pName1, pName2) == 0));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Write the scopes and counters recorded for the current frame to the output files (if any)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeFrameToFiles(const uint64_t frameEndNs) noexcept {
+    const double frameStartUSec = (double) gFrameStartNs / 1000.0;
+    const double frameUSec = (double)(frameEndNs - gFrameStartNs) / 1000.0;
+
+    if (gpCsvFile) {
+        std::FILE* const pFile = gpCsvFile;
+        std::fprintf(pFile, "%llu,frame,Frame,,%.3f,%.3f,\n", (unsigned long long) gFrameNum, frameStartUSec, frameUSec);
+
+        for (const Zone& zone : gFrameZones) {
+            std::fprintf(
+                pFile,
+                "%llu,zone,%s,%u,%.3f,%.3f,\n",
+                (unsigned long long) gFrameNum,
+                zone.name,
+                zone.depth,
+                (double) zone.startNs / 1000.0,
+                (double)(zone.endNs - zone.startNs) / 1000.0
+            );
+        }
+
+        for (const Counter& counter : gFrameCounters) {
+            std::fprintf(pFile, "%llu,counter,%s,,,,%lld\n", (unsigned long long) gFrameNum, counter.name, (long long) counter.value);
+        }
+    }
+
+    if (gpTraceFile) {
+        // Note: every event is preceded by a comma, since the file always starts with a metadata event
+        std::FILE* const pFile = gpTraceFile;
+        std::fprintf(pFile, ",\n{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", frameStartUSec, frameUSec);
+
+        for (const Zone& zone : gFrameZones) {
+            std::fprintf(
+                pFile,
+                ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                zone.name,
+                (double) zone.startNs / 1000.0,
+                (double)(zone.endNs - zone.startNs) / 1000.0
+            );
+        }
+
+        for (const Counter& counter : gFrameCounters) {
+            std::fprintf(
+                pFile,
+                ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                counter.name,
+                frameStartUSec,
+                (long long) counter.value
+            );
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Add the scopes and counters recorded for the current frame to the totals being averaged for the overlay
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void addFrameToTotals(const uint64_t frameEndNs) noexcept {
+    uint32_t zoneTotalIdxForDepth[MAX_ZONE_DEPTH];
+
+    for (const Zone& zone : gFrameZones) {
+        if (zone.depth >= MAX_ZONE_DEPTH)
+            continue;
+
+        const uint32_t parentIdx = (zone.depth > 0) ? zoneTotalIdxForDepth[zone.depth - 1] : NO_PARENT;
+        uint32_t totalIdx = 0;
+
+        while ((totalIdx < gZoneTotals.size()) && (!namesMatch(gZoneTotals[totalIdx].name, zone.name) || (gZoneTotals[totalIdx].parentIdx != parentIdx))) {
+            ++totalIdx;
+        }
+
+        if (totalIdx >= gZoneTotals.size()) {
+            gZoneTotals.push_back(ZoneTotal{ zone.name, parentIdx, 0 });
+        }
+
+        gZoneTotals[totalIdx].totalNs += zone.endNs - zone.startNs;
+        zoneTotalIdxForDepth[zone.depth] = totalIdx;
+    }
+
+    for (const Counter& counter : gFrameCounters) {
+        uint32_t totalIdx = 0;
+
+        while ((totalIdx < gCounterTotals.size()) && (!namesMatch(gCounterTotals[totalIdx].name, counter.name))) {
+            ++totalIdx;
+        }
+
+        if (totalIdx >= gCounterTotals.size()) {
+            gCounterTotals.push_back(CounterTotal{ counter.name, 0 });
+        }
+
+        gCounterTotals[totalIdx].total += counter.value;
+    }
+
+    gFrameTotalNs += frameEndNs - gFrameStartNs;
+    gNumFramesTotalled++;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Outputs averaged stats for the given scope total and all the scopes nested within it, in the order they were first encountered
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void addZoneStatsForTotal(const uint32_t totalIdx, const uint32_t depth) noexcept {
+    const ZoneTotal& total = gZoneTotals[totalIdx];
+    gZoneStats.push_back(ZoneStats{ total.name, depth, (float)((double) total.totalNs / (double) gNumFramesTotalled / 1000.0) });
+
+    for (uint32_t childIdx = totalIdx + 1; childIdx < gZoneTotals.size(); ++childIdx) {
+        if (gZoneTotals[childIdx].parentIdx == totalIdx) {
+            addZoneStatsForTotal(childIdx, depth + 1);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Updates the averaged results for the overlay from the current totals and then clears the totals
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void publishAveragedStats() noexcept {
+    gZoneStats.clear();
+    gCounterStats.clear();
+
+    for (uint32_t totalIdx = 0; totalIdx < gZoneTotals.size(); ++totalIdx) {
+        if (gZoneTotals[totalIdx].parentIdx == NO_PARENT) {
+            addZoneStatsForTotal(totalIdx, 0);
+        }
+    }
+
+    for (const CounterTotal& total : gCounterTotals) {
+        gCounterStats.push_back(CounterStats{ total.name, (float)((double) total.total / (double) gNumFramesTotalled) });
+    }
+
+    gAverageFrameUSec = (float)((double) gFrameTotalNs / (double) gNumFramesTotalled / 1000.0);
+    gZoneTotals.clear();
+    gCounterTotals.clear();
+    gFrameTotalNs = 0;
+    gNumFramesTotalled = 0;
+}
+
+void init(const char* const csvFilePath, const char* const traceFilePath) noexcept {
+    gInitTime = std::chrono::steady_clock::now();
+    gbCapturing = false;
+    gbOverlayEnabled = false;
+    gFrameZones.reserve(256);
+    gFrameCounters.reserve(64);
+
+    if (csvFilePath && csvFilePath[0]) {
+        gpCsvFile = std::fopen(csvFilePath, "w");
+
+        if (gpCsvFile) {
+            std::fprintf(gpCsvFile, "frame,type,name,depth,start_usec,duration_usec,value\n");
+        } else {
+            std::printf("Profiler: failed to open CSV output file '%s'!\n", csvFilePath);
+        }
+    }
+
+    if (traceFilePath && traceFilePath[0]) {
+        gpTraceFile = std::fopen(traceFilePath, "w");
+
+        if (gpTraceFile) {
+            std::fprintf(gpTraceFile, "[\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Main thread\"}}");
+        } else {
+            std::printf("Profiler: failed to open trace output file '%s'!\n", traceFilePath);
+        }
+    }
+}
+
+void shutdown() noexcept {
+    if (gpCsvFile) {
+        std::fclose(gpCsvFile);
+        gpCsvFile = nullptr;
+    }
+
+    if (gpTraceFile) {
+        std::fprintf(gpTraceFile, "\n]\n");
+        std::fclose(gpTraceFile);
+        gpTraceFile = nullptr;
+    }
+
+    gbCapturing = false;
+    gFrameZones.clear();
+    gFrameCounters.clear();
+    gZoneTotals.clear();
+    gCounterTotals.clear();
+    gZoneStats.clear();
+    gCounterStats.clear();
+    gFrameTotalNs = 0;
+    gNumFramesTotalled = 0;
+}
+
+void setOverlayEnabled(const bool bEnabled) noexcept {
+    if (gbOverlayEnabled != bEnabled) {
+        // Don't mix in stale totals from the last time the overlay was shown
+        gZoneTotals.clear();
+        gCounterTotals.clear();
+        gFrameTotalNs = 0;
+        gNumFramesTotalled = 0;
+    }
+
+    gbOverlayEnabled = bEnabled;
+}
+
+void beginFrame() noexcept {
+    gbCapturing = (gbOverlayEnabled || gpCsvFile || gpTraceFile);
+
+    if (!gbCapturing)
+        return;
+
+    gFrameZones.clear();
+    gFrameCounters.clear();
+    gCurZoneDepth = 0;
+    gFrameStartNs = getTimeNs();
+}
+
+void endFrame(const uint32_t numFramesToAverage) noexcept {
+    if (!gbCapturing)
+        return;
+
+    gbCapturing = false;
+    const uint64_t frameEndNs = getTimeNs();
+
+    // Close off any scopes that were left open (shouldn't happen normally)
+    for (Zone& zone : gFrameZones) {
+        zone.endNs = (zone.endNs == 0) ? frameEndNs : zone.endNs;
+    }
+
+    writeFrameToFiles(frameEndNs);
+    gFrameNum++;
+
+    if (gbOverlayEnabled) {
+        addFrameToTotals(frameEndNs);
+
+        if (gNumFramesTotalled >= numFramesToAverage) {
+            publishAveragedStats();
+        }
+    }
+}
+
+uint32_t beginZone(const char* const name) noexcept {
+    if ((!gbCapturing) || (JobSystem::getThreadIdx() != 0))
+        return ScopedZone::INVALID_ZONE;
+
+    const uint32_t zoneIdx = (uint32_t) gFrameZones.size();
+    gFrameZones.push_back(Zone{ name, gCurZoneDepth, getTimeNs(), 0 });
+    gCurZoneDepth++;
+    return zoneIdx;
+}
+
+void endZone(const uint32_t zoneIdx) noexcept {
+    // Note: capture might have been stopped if the frame ended while the scope was open
+    if ((!gbCapturing) || (zoneIdx >= gFrameZones.size()))
+        return;
+
+    gFrameZones[zoneIdx].endNs = getTimeNs();
+    gCurZoneDepth--;
+}
+
+void setCounter(const char* const name, const int64_t value) noexcept {
+    if ((!gbCapturing) || (JobSystem::getThreadIdx() != 0))
+        return;
+
+    for (Counter& counter : gFrameCounters) {
+        if (namesMatch(counter.name, name)) {
+            counter.value = value;
+            return;
+        }
+    }
+
+    gFrameCounters.push_back(Counter{ name, value });
+}
+
+const std::vector<ZoneStats>& getZoneStats() noexcept {
+    return gZoneStats;
+}
+
+const std::vector<CounterStats>& getCounterStats() noexcept {
+    return gCounterStats;
+}
+
+float getAverageFrameUSec() noexcept {
+    return gAverageFrameUSec;
+}
+
+END_NAMESPACE(Profiler)
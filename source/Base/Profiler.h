@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Macros.h"
+#include <cstdint>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A simple hierarchical frame profiler.
+//
+// Code is instrumented with scoped timers ('PROFILE_SCOPE') which record when the scope started and how long it took, nested within any
+// other scopes open at the time. Named counters (e.g fragment counts) can also be recorded for each frame.
+//
+// Notes:
+//  (1) Only scopes and counters on the main thread are recorded; anything done on job system worker threads is ignored. Time spent by
+//      the main thread waiting on jobs to finish is included in the time for the scope that issued the jobs, however.
+//  (2) Capture is only switched on or off at the start of a frame. When capture is off the cost of a scoped timer is just a check of a
+//      single global flag on entry and exit.
+//  (3) Names passed in for scopes and counters are NOT copied and must live for the lifetime of the program (e.g string literals).
+//  (4) Recorded frames can be written to a CSV file and/or a Chrome trace event file (which can be opened via 'chrome://tracing' or
+//      Perfetto). Averaged results are also made available for an on-screen overlay.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Profiler)
+
+// Averaged timings for a scope, for display in the overlay
+struct ZoneStats {
+    const char*     name;           // Name of the scope
+    uint32_t        depth;          // How deeply nested the scope is: '0' is for scopes not nested within anything else
+    float           avgUSec;        // Average time per frame spent in the scope, in microseconds
+};
+
+// Averaged value of a counter, for display in the overlay
+struct CounterStats {
+    const char*     name;
+    float           avgValue;
+};
+
+// Whether scopes and counters are being recorded for the current frame.
+// Checked by every scoped timer so it needs to be fast to access.
+extern bool gbCapturing;
+
+// Startup and shutdown the profiler.
+// If output file paths are given (non empty) then every frame will be recorded and written to those files.
+void init(const char* const csvFilePath, const char* const traceFilePath) noexcept;
+void shutdown() noexcept;
+
+// Sets whether the on-screen overlay wants results, which causes frames to be recorded even if there is no file output.
+// Takes effect on the next call to 'beginFrame'.
+void setOverlayEnabled(const bool bEnabled) noexcept;
+
+// Start and end a frame. Scopes and counters are only recorded between these calls.
+// The number of frames to average the overlay results over is given when ending the frame.
+void beginFrame() noexcept;
+void endFrame(const uint32_t numFramesToAverage) noexcept;
+
+// Begin and end a scope manually; 'endZone' must be given what 'beginZone' returned.
+// Prefer to use 'PROFILE_SCOPE' instead of calling these directly.
+uint32_t beginZone(const char* const name) noexcept;
+void endZone(const uint32_t zoneIdx) noexcept;
+
+// Sets the value of a named counter for the current frame
+void setCounter(const char* const name, const int64_t value) noexcept;
+
+// Get the latest averaged results for the overlay
+const std::vector<ZoneStats>& getZoneStats() noexcept;
+const std::vector<CounterStats>& getCounterStats() noexcept;
+float getAverageFrameUSec() noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Records a scope for the profiler for as long as the object is alive
+//------------------------------------------------------------------------------------------------------------------------------------------
+class ScopedZone {
+public:
+    static constexpr uint32_t INVALID_ZONE = UINT32_MAX;
+
+    inline explicit ScopedZone(const char* const name) noexcept
+        : mZoneIdx((gbCapturing) ? beginZone(name) : INVALID_ZONE)
+    {
+    }
+
+    inline ~ScopedZone() noexcept {
+        if (mZoneIdx != INVALID_ZONE) {
+            endZone(mZoneIdx);
+        }
+    }
+
+    ScopedZone(const ScopedZone& other) = delete;
+    ScopedZone& operator = (const ScopedZone& other) = delete;
+
+private:
+    const uint32_t mZoneIdx;
+};
+
+END_NAMESPACE(Profiler)
+
+// Profiles the rest of the enclosing scope under the given name
+#define PROFILE_SCOPE_CONCAT_INNER(A, B) A##B
+#define PROFILE_SCOPE_CONCAT(A, B) PROFILE_SCOPE_CONCAT_INNER(A, B)
+#define PROFILE_SCOPE(Name)\
+    const Profiler::ScopedZone PROFILE_SCOPE_CONCAT(profileScopedZone_, __LINE__)(Name)
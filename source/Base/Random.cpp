@@ -2,17 +2,39 @@
 
 #include <random>
 
-static std::mt19937 gRandom;
+static std::mt19937  gRandom;
+static std::mt19937  gUIRandom{ std::random_device()() };
+static bool         gbUseFixedSeed;
+static uint32_t     gFixedSeed;
 
 void Random::init() noexcept {
-    std::random_device randomDevice;
-    gRandom.seed(randomDevice());
+    if (gbUseFixedSeed) {
+        gRandom.seed(gFixedSeed);
+    } else {
+        std::random_device randomDevice;
+        gRandom.seed(randomDevice());
+    }
 }
 
 void Random::init(const uint32_t seed) noexcept {
     gRandom.seed(seed);
 }
 
+void Random::setFixedSeed(const uint32_t seed) noexcept {
+    gbUseFixedSeed = true;
+    gFixedSeed = seed;
+}
+
+void Random::clearFixedSeed() noexcept {
+    gbUseFixedSeed = false;
+    gFixedSeed = 0;
+}
+
+uint32_t Random::getStateHash() noexcept {
+    std::mt19937 generatorCopy = gRandom;
+    return (uint32_t) generatorCopy();
+}
+
 bool Random::nextBool() noexcept {
     return (std::uniform_int_distribution<uint16_t>()(gRandom) & 1) != 0;
 }
@@ -44,3 +66,11 @@ uint8_t Random::nextU8(const uint8_t max) noexcept {
 float Random::nextFloat() noexcept {
     return std::uniform_real_distribution<float>()(gRandom);
 }
+
+uint32_t Random::nextUIU32(const uint32_t max) noexcept {
+    return std::uniform_int_distribution<uint32_t>(0, max)(gUIRandom);
+}
+
+float Random::nextUIFloat() noexcept {
+    return std::uniform_real_distribution<float>()(gUIRandom);
+}
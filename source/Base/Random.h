@@ -7,6 +7,15 @@ namespace Random {
     void init() noexcept;
     void init(const uint32_t seed) noexcept;
 
+    // If a fixed seed is set then 'init()' always uses that seed instead of a truly random one.
+    // Used to make the game simulation repeatable for demos and benchmarks.
+    void setFixedSeed(const uint32_t seed) noexcept;
+    void clearFixedSeed() noexcept;
+
+    // Gives a value derived from the current state of the generator, without advancing it.
+    // Used to check that the game simulation is playing out the same way as before.
+    uint32_t getStateHash() noexcept;
+
     bool nextBool() noexcept;
 
     uint32_t nextU32() noexcept;
@@ -20,4 +29,10 @@ namespace Random {
 
     // Gives a float between 0 and 1
     float nextFloat() noexcept;
+
+    // A separate stream of random numbers for presentation only (screen wipes, the status bar face etc.), which is never seeded with the
+    // fixed seed and never affects the game simulation. Keeps the game simulation (and demos) independent of how much randomness the
+    // presentation needs, which can vary with things like the screen resolution.
+    uint32_t nextUIU32(const uint32_t max) noexcept;
+    float nextUIFloat() noexcept;
 }
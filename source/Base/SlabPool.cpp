@@ -0,0 +1,81 @@
+#include "SlabPool.h"
+
+#include "Macros.h"
+#include <new>
+
+SlabPool::SlabPool(const uint32_t slotSize) noexcept
+    : mSlabs()
+    , mpFreeList(nullptr)
+    , mSlotSize(((slotSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE)
+    , mSlotsPerSlab(0)
+    , mCurSlabIdx(0)
+    , mCurSlabNumUsed(0)
+    , mNumLiveSlots(0)
+    , mNumAllocs(0)
+{
+    ASSERT(slotSize > 0);
+    ASSERT(mSlotSize <= SLAB_SIZE);
+    mSlotsPerSlab = SLAB_SIZE / mSlotSize;
+}
+
+SlabPool::~SlabPool() noexcept {
+    for (std::byte* const pSlab : mSlabs) {
+        ::operator delete(pSlab, std::align_val_t(CACHE_LINE_SIZE));
+    }
+}
+
+void* SlabPool::alloc() noexcept {
+    std::byte* pSlot;
+
+    if (mpFreeList) {
+        pSlot = reinterpret_cast<std::byte*>(mpFreeList);
+        mpFreeList = mpFreeList->pNext;
+    } else {
+        pSlot = allocSlotFromSlabs();
+    }
+
+    mNumLiveSlots++;
+    mNumAllocs++;
+    return pSlot;
+}
+
+void SlabPool::free(void* const pSlot) noexcept {
+    ASSERT(pSlot);
+    ASSERT(mNumLiveSlots > 0);
+
+    FreeSlot* const pFreeSlot = reinterpret_cast<FreeSlot*>(pSlot);
+    pFreeSlot->pNext = mpFreeList;
+    mpFreeList = pFreeSlot;
+    mNumLiveSlots--;
+}
+
+void SlabPool::reset() noexcept {
+    mpFreeList = nullptr;
+    mCurSlabIdx = 0;
+    mCurSlabNumUsed = 0;
+    mNumLiveSlots = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bumps a new slot out of the current slab, moving onto the next slab (or allocating a new one) when the current slab is full
+//------------------------------------------------------------------------------------------------------------------------------------------
+std::byte* SlabPool::allocSlotFromSlabs() noexcept {
+    if ((mCurSlabIdx < mSlabs.size()) && (mCurSlabNumUsed >= mSlotsPerSlab)) {
+        mCurSlabIdx++;
+        mCurSlabNumUsed = 0;
+    }
+
+    if (mCurSlabIdx >= mSlabs.size()) {
+        std::byte* const pSlab = (std::byte*) ::operator new(SLAB_SIZE, std::align_val_t(CACHE_LINE_SIZE), std::nothrow);
+
+        if (!pSlab) {
+            FatalErrors::outOfMemory();
+        }
+
+        mSlabs.push_back(pSlab);
+    }
+
+    std::byte* const pSlot = mSlabs[mCurSlabIdx] + (size_t) mCurSlabNumUsed * mSlotSize;
+    mCurSlabNumUsed++;
+    return pSlot;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A pool of fixed size memory slots, carved out of large cache line aligned slabs.
+//
+// Slots are handed out by bumping through the slabs and freed slots go onto a free list, which is used first for new allocations.
+// Slabs are never returned to the system until the pool is destroyed, so once a pool has grown to the size needed it does not touch the
+// system allocator again. The whole pool can also be emptied in one go by 'reset', without visiting any of the individual slots.
+//
+// Notes:
+//  (1) The slot size is rounded up to a multiple of the cache line size, and every slot starts on a cache line boundary.
+//  (2) Slot memory is NOT cleared when allocated, the same as 'malloc'.
+//  (3) The pool is not thread safe.
+//------------------------------------------------------------------------------------------------------------------------------------------
+class SlabPool {
+public:
+    static constexpr uint32_t CACHE_LINE_SIZE = 64;
+    static constexpr uint32_t SLAB_SIZE = 64 * 1024;
+
+    explicit SlabPool(const uint32_t slotSize) noexcept;
+    ~SlabPool() noexcept;
+
+    void* alloc() noexcept;
+    void free(void* const pSlot) noexcept;
+
+    // Frees all slots at once, in constant time. The slabs are kept around for reuse.
+    void reset() noexcept;
+
+    inline uint32_t getSlotSize() const noexcept { return mSlotSize; }
+    inline uint32_t getNumLiveSlots() const noexcept { return mNumLiveSlots; }
+    inline uint64_t getNumAllocs() const noexcept { return mNumAllocs; }
+    inline size_t getNumBytesReserved() const noexcept { return mSlabs.size() * (size_t) SLAB_SIZE; }
+
+private:
+    // A slot which is on the free list
+    struct FreeSlot {
+        FreeSlot* pNext;
+    };
+
+    std::byte* allocSlotFromSlabs() noexcept;
+
+    std::vector<std::byte*>     mSlabs;             // All the slabs allocated so far
+    FreeSlot*                   mpFreeList;         // Slots which have been freed and can be reused
+    uint32_t                    mSlotSize;          // Size of each slot, rounded up to a multiple of the cache line size
+    uint32_t                    mSlotsPerSlab;
+    uint32_t                    mCurSlabIdx;        // The slab which slots are currently being bumped out of
+    uint32_t                    mCurSlabNumUsed;    // How many slots have been bumped out of the current slab
+    uint32_t                    mNumLiveSlots;      // How many slots are currently allocated
+    uint64_t                    mNumAllocs;         // How many slots have been allocated over the lifetime of the pool
+};
@@ -2069,6 +2069,8 @@ uint32_t    gCenterX;
 uint32_t    gCenterY;
 uint32_t    g3dViewWidth;
 uint32_t    g3dViewHeight;
+uint32_t    g3dViewScreenWidth;
+uint32_t    g3dViewScreenHeight;
 uint32_t    g3dViewXOffset;
 uint32_t    g3dViewYOffset;
 float       gScaleFactor;
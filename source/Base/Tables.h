@@ -18,8 +18,10 @@ extern angle_t      gTanToAngle[2049];
 extern uint32_t     gIDivTable[8192];                   // 1.0 / 0-5500 for recipocal muls
 extern uint32_t     gCenterX;                           // Center view center X coord (integer)
 extern uint32_t     gCenterY;                           // Center view center Y coord (integer)
-extern uint32_t     g3dViewWidth;                       // Width of the 3d view
-extern uint32_t     g3dViewHeight;                      // Height of the 3d view
+extern uint32_t     g3dViewWidth;                       // Width of the 3d view as it is rendered (may be less than the width on screen)
+extern uint32_t     g3dViewHeight;                      // Height of the 3d view as it is rendered (may be less than the height on screen)
+extern uint32_t     g3dViewScreenWidth;                 // Width of the area covered by the 3d view on the screen
+extern uint32_t     g3dViewScreenHeight;                // Height of the area covered by the 3d view on the screen
 extern uint32_t     g3dViewXOffset;                     // The left X coord for the 3d view on the screen
 extern uint32_t     g3dViewYOffset;                     // The top y coord for the 3d view on the screen
 extern float        gScaleFactor;                       // Ratio of current resolution over original 320x200 resolution
@@ -0,0 +1,878 @@
+#include "BlitSimd.h"
+
+#if BLIT_SIMD_X86 && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+BEGIN_NAMESPACE(BlitSimd)
+
+static InstructionSet gInstructionSet = InstructionSet::NONE;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the CPU and OS support AVX2
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if BLIT_SIMD_X86
+static bool isAvx2Supported() noexcept {
+    #if defined(_MSC_VER) && (!defined(__clang__))
+        // Need CPUID leaf 7 to check for AVX2
+        int cpuInfo[4] = {};
+        __cpuid(cpuInfo, 0);
+
+        if (cpuInfo[0] < 7)
+            return false;
+
+        // The OS must also support saving the AVX registers (OSXSAVE and the YMM state enabled)
+        __cpuid(cpuInfo, 1);
+        const bool bHasOsXSave = ((cpuInfo[2] & (1 << 27)) != 0);
+        const bool bHasAvx = ((cpuInfo[2] & (1 << 28)) != 0);
+
+        if ((!bHasOsXSave) || (!bHasAvx))
+            return false;
+
+        if ((_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(cpuInfo, 7, 0);
+        return ((cpuInfo[1] & (1 << 5)) != 0);
+    #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    #endif
+}
+#endif
+
+void init(const bool bAllowSimd) noexcept {
+    gInstructionSet = InstructionSet::NONE;
+
+    if (!bAllowSimd)
+        return;
+
+    #if BLIT_SIMD_X86
+        gInstructionSet = (isAvx2Supported()) ? InstructionSet::AVX2 : InstructionSet::SSE2;
+    #endif
+}
+
+InstructionSet getInstructionSet() noexcept {
+    return gInstructionSet;
+}
+
+#if BLIT_SIMD_X86
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Fetches the next 'N' texels for a wall column into 32-bit slots.
+// Steps the texture coordinate in exactly the same way as 'Blit::blitColumn' does, with wrapping.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <uint32_t N>
+static inline void fetchWallTexels(
+    const uint16_t* const pSrcCol,
+    const uint32_t srcH,
+    const float srcYStep,
+    float& nextSrcY,
+    uint32_t& curSrcYInt,
+    int32_t texelsOut[N]
+) noexcept {
+    for (uint32_t i = 0; i < N; ++i) {
+        curSrcYInt = Blit::wrapYCoord<Blit::BCF_V_WRAP_WRAP>((int32_t) curSrcYInt, srcH);
+        texelsOut[i] = pSrcCol[curSrcYInt];
+        nextSrcY += srcYStep;
+        curSrcYInt = (uint32_t) nextSrcY;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Fetches the next 'N' texels for a sprite column into 32-bit slots.
+// Steps the texture coordinate and does the 'discard' wrap mode logic in exactly the same way as 'Blit::blitColumn' does.
+// Any pixels which should be discarded due to being outside the texture are fetched as '0' (fully transparent) so that the alpha
+// test will reject them.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <uint32_t N>
+static inline void fetchSpriteTexels(
+    const uint16_t* const pSrcCol,
+    const uint32_t srcH,
+    const float srcYStep,
+    float& nextSrcY,
+    uint32_t& curSrcYInt,
+    bool& bDidVWrapDiscardClamp,
+    int32_t texelsOut[N]
+) noexcept {
+    for (uint32_t i = 0; i < N; ++i) {
+        texelsOut[i] = 0;
+
+        do {
+            if (curSrcYInt >= srcH) {
+                if (bDidVWrapDiscardClamp)
+                    break;
+
+                curSrcYInt = Blit::wrapYCoord<Blit::BCF_V_WRAP_CLAMP>((int32_t) curSrcYInt, srcH);
+                bDidVWrapDiscardClamp = true;
+                const uint32_t prevSrcYInt = (uint32_t)(nextSrcY - srcYStep);
+
+                if (prevSrcYInt == curSrcYInt)
+                    break;
+            }
+
+            texelsOut[i] = pSrcCol[curSrcYInt];
+        } while (false);
+
+        nextSrcY += srcYStep;
+        curSrcYInt = (uint32_t) nextSrcY;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes 'N' pixels down a column of the output image
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <uint32_t N>
+static inline void storeColumnPixels(const uint32_t pixels[N], uint32_t*& pDstPixel, const uint32_t dstPixelsPitch) noexcept {
+    for (uint32_t i = 0; i < N; ++i) {
+        *pDstPixel = pixels[i];
+        pDstPixel += dstPixelsPitch;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes 'N' pixels down a column of the output image, skipping any pixels where the source texel failed the alpha test
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <uint32_t N>
+static inline void storeAlphaTestedColumnPixels(
+    const uint32_t pixels[N],
+    const int32_t texels[N],
+    uint32_t*& pDstPixel,
+    const uint32_t dstPixelsPitch
+) noexcept {
+    for (uint32_t i = 0; i < N; ++i) {
+        if (texels[i] & 0x8000) {
+            *pDstPixel = pixels[i];
+        }
+
+        pDstPixel += dstPixelsPitch;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Wall column blitting: SSE2 and AVX2 versions
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void blitWallColumn_SSE2(
+    const uint16_t* const pSrcCol,
+    const uint32_t srcH,
+    float nextSrcY,
+    uint32_t curSrcYInt,
+    uint32_t* pDstPixel,
+    const uint32_t dstPixelsPitch,
+    const uint32_t dstCount,
+    const float srcYStep,
+    const float lightMul
+) noexcept {
+    const __m128 lightMulV = _mm_set1_ps(lightMul);
+    uint32_t numLeft = dstCount;
+
+    while (numLeft >= 4) {
+        alignas(16) int32_t texels[4];
+        alignas(16) uint32_t pixels[4];
+        fetchWallTexels<4>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, texels);
+        _mm_store_si128((__m128i*) pixels, lightARGB1555Texels_SSE2(_mm_load_si128((const __m128i*) texels), lightMulV));
+        storeColumnPixels<4>(pixels, pDstPixel, dstPixelsPitch);
+        numLeft -= 4;
+    }
+
+    for (; numLeft > 0; --numLeft) {
+        int32_t texel;
+        fetchWallTexels<1>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, &texel);
+        *pDstPixel = lightARGB1555Texel((uint16_t) texel, lightMul);
+        pDstPixel += dstPixelsPitch;
+    }
+}
+
+BLIT_SIMD_AVX2_FUNC static void blitWallColumn_AVX2(
+    const uint16_t* const pSrcCol,
+    const uint32_t srcH,
+    float nextSrcY,
+    uint32_t curSrcYInt,
+    uint32_t* pDstPixel,
+    const uint32_t dstPixelsPitch,
+    const uint32_t dstCount,
+    const float srcYStep,
+    const float lightMul
+) noexcept {
+    const __m256 lightMulV = _mm256_set1_ps(lightMul);
+    uint32_t numLeft = dstCount;
+
+    while (numLeft >= 8) {
+        alignas(32) int32_t texels[8];
+        alignas(32) uint32_t pixels[8];
+        fetchWallTexels<8>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, texels);
+        _mm256_store_si256((__m256i*) pixels, lightARGB1555Texels_AVX2(_mm256_load_si256((const __m256i*) texels), lightMulV));
+        storeColumnPixels<8>(pixels, pDstPixel, dstPixelsPitch);
+        numLeft -= 8;
+    }
+
+    for (; numLeft > 0; --numLeft) {
+        int32_t texel;
+        fetchWallTexels<1>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, &texel);
+        *pDstPixel = lightARGB1555Texel((uint16_t) texel, lightMul);
+        pDstPixel += dstPixelsPitch;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sprite column blitting: SSE2 and AVX2 versions
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void blitSpriteColumn_SSE2(
+    const uint16_t* const pSrcCol,
+    const uint32_t srcH,
+    float nextSrcY,
+    uint32_t curSrcYInt,
+    uint32_t* pDstPixel,
+    const uint32_t dstPixelsPitch,
+    const uint32_t dstCount,
+    const float srcYStep,
+    const float lightMul
+) noexcept {
+    const __m128 lightMulV = _mm_set1_ps(lightMul);
+    bool bDidVWrapDiscardClamp = false;
+    uint32_t numLeft = dstCount;
+
+    while (numLeft >= 4) {
+        alignas(16) int32_t texels[4];
+        alignas(16) uint32_t pixels[4];
+        fetchSpriteTexels<4>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, bDidVWrapDiscardClamp, texels);
+        _mm_store_si128((__m128i*) pixels, lightARGB1555Texels_SSE2(_mm_load_si128((const __m128i*) texels), lightMulV));
+        storeAlphaTestedColumnPixels<4>(pixels, texels, pDstPixel, dstPixelsPitch);
+        numLeft -= 4;
+    }
+
+    for (; numLeft > 0; --numLeft) {
+        int32_t texel;
+        fetchSpriteTexels<1>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, bDidVWrapDiscardClamp, &texel);
+
+        if (texel & 0x8000) {
+            *pDstPixel = lightARGB1555Texel((uint16_t) texel, lightMul);
+        }
+
+        pDstPixel += dstPixelsPitch;
+    }
+}
+
+BLIT_SIMD_AVX2_FUNC static void blitSpriteColumn_AVX2(
+    const uint16_t* const pSrcCol,
+    const uint32_t srcH,
+    float nextSrcY,
+    uint32_t curSrcYInt,
+    uint32_t* pDstPixel,
+    const uint32_t dstPixelsPitch,
+    const uint32_t dstCount,
+    const float srcYStep,
+    const float lightMul
+) noexcept {
+    const __m256 lightMulV = _mm256_set1_ps(lightMul);
+    bool bDidVWrapDiscardClamp = false;
+    uint32_t numLeft = dstCount;
+
+    while (numLeft >= 8) {
+        alignas(32) int32_t texels[8];
+        alignas(32) uint32_t pixels[8];
+        fetchSpriteTexels<8>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, bDidVWrapDiscardClamp, texels);
+        _mm256_store_si256((__m256i*) pixels, lightARGB1555Texels_AVX2(_mm256_load_si256((const __m256i*) texels), lightMulV));
+        storeAlphaTestedColumnPixels<8>(pixels, texels, pDstPixel, dstPixelsPitch);
+        numLeft -= 8;
+    }
+
+    for (; numLeft > 0; --numLeft) {
+        int32_t texel;
+        fetchSpriteTexels<1>(pSrcCol, srcH, srcYStep, nextSrcY, curSrcYInt, bDidVWrapDiscardClamp, &texel);
+
+        if (texel & 0x8000) {
+            *pDstPixel = lightARGB1555Texel((uint16_t) texel, lightMul);
+        }
+
+        pDstPixel += dstPixelsPitch;
+    }
+}
+
+#endif  // #if BLIT_SIMD_X86
+
+void blitWallColumn(
+    const uint16_t* const pSrcPixels,
+    const uint32_t srcW,
+    const uint32_t srcH,
+    const float srcX,
+    const float srcY,
+    const float srcYSubPixelAdjustment,
+    uint32_t* const pDstPixels,
+    const uint32_t dstW,
+    const uint32_t dstH,
+    const uint32_t dstPixelsPitch,
+    const int32_t dstX,
+    const int32_t dstY,
+    const uint32_t dstCount,
+    const float srcYStep,
+    const float lightMul
+) noexcept {
+    #if BLIT_SIMD_X86
+        if (gInstructionSet != InstructionSet::NONE) {
+            BLIT_ASSERT(pSrcPixels);
+            BLIT_ASSERT(srcW > 0);
+            BLIT_ASSERT(srcH > 0);
+            BLIT_ASSERT(pDstPixels);
+            BLIT_ASSERT(dstX >= 0 && dstX < (int32_t) dstW);
+            BLIT_ASSERT(dstY >= 0 && (uint32_t) dstY + dstCount <= dstH);
+            BLIT_ASSERT(lightMul >= 0.0f);
+
+            // Same setup as 'Blit::blitColumn': index into the source column and apply the sub pixel adjustment after the 1st pixel
+            const uint16_t* const pSrcCol = pSrcPixels + (uintptr_t) Blit::wrapXCoord<Blit::BCF_H_WRAP_WRAP>((int32_t) srcX, srcW) * srcH;
+            uint32_t* const pDstPixel = pDstPixels + (uintptr_t) dstY * dstPixelsPitch + dstX;
+            const uint32_t curSrcYInt = (uint32_t) srcY;
+            const float nextSrcY = srcY + srcYSubPixelAdjustment;
+
+            if (gInstructionSet == InstructionSet::AVX2) {
+                blitWallColumn_AVX2(pSrcCol, srcH, nextSrcY, curSrcYInt, pDstPixel, dstPixelsPitch, dstCount, srcYStep, lightMul);
+            } else {
+                blitWallColumn_SSE2(pSrcCol, srcH, nextSrcY, curSrcYInt, pDstPixel, dstPixelsPitch, dstCount, srcYStep, lightMul);
+            }
+
+            return;
+        }
+    #endif
+
+    // No SIMD available: use the regular blitter
+    Blit::blitColumn<
+        Blit::BCF_STEP_Y |
+        Blit::BCF_H_WRAP_WRAP |
+        Blit::BCF_V_WRAP_WRAP |
+        Blit::BCF_COLOR_MULT_RGB
+    >(
+        pSrcPixels,
+        srcW,
+        srcH,
+        srcX,
+        srcY,
+        0.0f,
+        srcYSubPixelAdjustment,
+        pDstPixels,
+        dstW,
+        dstH,
+        dstPixelsPitch,
+        dstX,
+        dstY,
+        dstCount,
+        0,
+        srcYStep,
+        lightMul,
+        lightMul,
+        lightMul
+    );
+}
+
+void blitSpriteColumn(
+    const uint16_t* const pSrcPixels,
+    const uint32_t srcH,
+    float srcY,
+    float srcYSubPixelAdjustment,
+    uint32_t* const pDstPixels,
+    const uint32_t dstW,
+    const uint32_t dstH,
+    const uint32_t dstPixelsPitch,
+    const int32_t dstX,
+    int32_t dstY,
+    uint32_t dstCount,
+    const float srcYStep,
+    const float lightMul
+) noexcept {
+    #if BLIT_SIMD_X86
+        if (gInstructionSet != InstructionSet::NONE) {
+            BLIT_ASSERT(pSrcPixels);
+            BLIT_ASSERT(srcH > 0);
+            BLIT_ASSERT(pDstPixels);
+            BLIT_ASSERT(dstX >= 0 && dstX < (int32_t) dstW);
+            BLIT_ASSERT(dstH > 0);
+            BLIT_ASSERT(lightMul >= 0.0f);
+
+            // Clip against the top and bottom of the draw area, same as 'Blit::blitColumn'
+            {
+                const int32_t numPixelsOutOfBounds = -dstY;
+
+                if (numPixelsOutOfBounds > 0) {
+                    if (numPixelsOutOfBounds >= (int32_t) dstCount)
+                        return;
+
+                    dstY = 0;
+                    srcY = srcY + srcYStep * numPixelsOutOfBounds + srcYSubPixelAdjustment;
+                    srcYSubPixelAdjustment = 0;
+                    dstCount -= (uint32_t) numPixelsOutOfBounds;
+                }
+            }
+
+            {
+                const uint32_t endY = (uint32_t) dstY + dstCount;
+
+                if (endY > dstH) {
+                    const uint32_t numPixelsOutOfBounds = endY - dstH;
+                    dstCount -= numPixelsOutOfBounds;
+                }
+            }
+
+            BLIT_ASSERT(dstY >= 0 && dstY < (int32_t) dstH);
+            BLIT_ASSERT((uint32_t) dstY + dstCount <= dstH);
+
+            // Draw the column
+            uint32_t* const pDstPixel = pDstPixels + (uintptr_t) dstY * dstPixelsPitch + dstX;
+            const uint32_t curSrcYInt = (uint32_t) srcY;
+            const float nextSrcY = srcY + srcYSubPixelAdjustment;
+
+            if (gInstructionSet == InstructionSet::AVX2) {
+                blitSpriteColumn_AVX2(pSrcPixels, srcH, nextSrcY, curSrcYInt, pDstPixel, dstPixelsPitch, dstCount, srcYStep, lightMul);
+            } else {
+                blitSpriteColumn_SSE2(pSrcPixels, srcH, nextSrcY, curSrcYInt, pDstPixel, dstPixelsPitch, dstCount, srcYStep, lightMul);
+            }
+
+            return;
+        }
+    #endif
+
+    // No SIMD available: use the regular blitter
+    Blit::blitColumn<
+        Blit::BCF_STEP_Y |
+        Blit::BCF_ALPHA_TEST |
+        Blit::BCF_COLOR_MULT_RGB |
+        Blit::BCF_V_WRAP_DISCARD |
+        Blit::BCF_V_CLIP
+    >(
+        pSrcPixels,
+        1,
+        srcH,
+        0.0f,
+        srcY,
+        0.0f,
+        srcYSubPixelAdjustment,
+        pDstPixels,
+        dstW,
+        dstH,
+        dstPixelsPitch,
+        dstX,
+        dstY,
+        dstCount,
+        0.0f,
+        srcYStep,
+        lightMul,
+        lightMul,
+        lightMul
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transposes the given rectangle of a column major image into a row major image, one pixel at a time
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void transposeArea_Scalar(
+    const uint32_t* const pSrcPixels,
+    const uint32_t srcPitch,
+    uint32_t* const pDstPixels,
+    const uint32_t dstPitch,
+    const uint32_t startX,
+    const uint32_t endX,
+    const uint32_t startY,
+    const uint32_t endY
+) noexcept {
+    for (uint32_t y = startY; y < endY; ++y) {
+        const uint32_t* pSrcPixel = pSrcPixels + (uintptr_t) startX * srcPitch + y;
+        uint32_t* const pDstRow = pDstPixels + (uintptr_t) y * dstPitch;
+
+        for (uint32_t x = startX; x < endX; ++x, pSrcPixel += srcPitch) {
+            pDstRow[x] = *pSrcPixel;
+        }
+    }
+}
+
+#if BLIT_SIMD_X86
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transposes a 4x4 block of pixels from a column major image into a row major image using SSE2
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void transposeBlock4x4_SSE2(
+    const uint32_t* const pSrc,
+    const uint32_t srcPitch,
+    uint32_t* const pDst,
+    const uint32_t dstPitch
+) noexcept {
+    const __m128i c0 = _mm_loadu_si128((const __m128i*)(pSrc));
+    const __m128i c1 = _mm_loadu_si128((const __m128i*)(pSrc + (uintptr_t) srcPitch));
+    const __m128i c2 = _mm_loadu_si128((const __m128i*)(pSrc + (uintptr_t) srcPitch * 2));
+    const __m128i c3 = _mm_loadu_si128((const __m128i*)(pSrc + (uintptr_t) srcPitch * 3));
+
+    const __m128i t0 = _mm_unpacklo_epi32(c0, c1);      // Rows 0 & 1 of columns 0 & 1
+    const __m128i t1 = _mm_unpacklo_epi32(c2, c3);      // Rows 0 & 1 of columns 2 & 3
+    const __m128i t2 = _mm_unpackhi_epi32(c0, c1);      // Rows 2 & 3 of columns 0 & 1
+    const __m128i t3 = _mm_unpackhi_epi32(c2, c3);      // Rows 2 & 3 of columns 2 & 3
+
+    _mm_storeu_si128((__m128i*)(pDst), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(pDst + (uintptr_t) dstPitch), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i*)(pDst + (uintptr_t) dstPitch * 2), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128((__m128i*)(pDst + (uintptr_t) dstPitch * 3), _mm_unpackhi_epi64(t2, t3));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transposes an 8x8 block of pixels from a column major image into a row major image using AVX2
+//------------------------------------------------------------------------------------------------------------------------------------------
+BLIT_SIMD_AVX2_FUNC static inline void transposeBlock8x8_AVX2(
+    const uint32_t* const pSrc,
+    const uint32_t srcPitch,
+    uint32_t* const pDst,
+    const uint32_t dstPitch
+) noexcept {
+    __m256i c[8];
+
+    for (uint32_t i = 0; i < 8; ++i) {
+        c[i] = _mm256_loadu_si256((const __m256i*)(pSrc + (uintptr_t) srcPitch * i));
+    }
+
+    // Interleave pairs of columns, then pairs of pairs. Each 128-bit lane is transposed separately by this:
+    // afterwards the low lanes hold rows 0-3 and the high lanes rows 4-7, for 4 columns at a time.
+    const __m256i t0 = _mm256_unpacklo_epi32(c[0], c[1]);
+    const __m256i t1 = _mm256_unpackhi_epi32(c[0], c[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(c[2], c[3]);
+    const __m256i t3 = _mm256_unpackhi_epi32(c[2], c[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(c[4], c[5]);
+    const __m256i t5 = _mm256_unpackhi_epi32(c[4], c[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(c[6], c[7]);
+    const __m256i t7 = _mm256_unpackhi_epi32(c[6], c[7]);
+
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);   // Columns 0-3: rows 0 & 4
+    const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);   // Columns 0-3: rows 1 & 5
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);   // Columns 0-3: rows 2 & 6
+    const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);   // Columns 0-3: rows 3 & 7
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);   // Columns 4-7: rows 0 & 4
+    const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);   // Columns 4-7: rows 1 & 5
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);   // Columns 4-7: rows 2 & 6
+    const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);   // Columns 4-7: rows 3 & 7
+
+    // Join up the lanes for columns 0-3 and 4-7 to make each full row
+    _mm256_storeu_si256((__m256i*)(pDst), _mm256_permute2x128_si256(u0, u4, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 1), _mm256_permute2x128_si256(u1, u5, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 2), _mm256_permute2x128_si256(u2, u6, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 3), _mm256_permute2x128_si256(u3, u7, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 4), _mm256_permute2x128_si256(u0, u4, 0x31));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 5), _mm256_permute2x128_si256(u1, u5, 0x31));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 6), _mm256_permute2x128_si256(u2, u6, 0x31));
+    _mm256_storeu_si256((__m256i*)(pDst + (uintptr_t) dstPitch * 7), _mm256_permute2x128_si256(u3, u7, 0x31));
+}
+#endif  // #if BLIT_SIMD_X86
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transposes all the whole blocks of pixels in the given range of rows, leaving any leftover pixels that don't make a whole block.
+// Returns the end x coordinate of the whole blocks done.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <uint32_t BLOCK_SIZE, class TransposeBlockFunc>
+static inline uint32_t transposeWholeBlocks(
+    const uint32_t* const pSrcPixels,
+    const uint32_t srcPitch,
+    uint32_t* const pDstPixels,
+    const uint32_t dstPitch,
+    const uint32_t width,
+    const uint32_t startY,
+    const uint32_t endY,
+    const TransposeBlockFunc& transposeBlock
+) noexcept {
+    const uint32_t endBlockX = (width / BLOCK_SIZE) * BLOCK_SIZE;
+
+    for (uint32_t x = 0; x < endBlockX; x += BLOCK_SIZE) {
+        for (uint32_t y = startY; y + BLOCK_SIZE <= endY; y += BLOCK_SIZE) {
+            transposeBlock(
+                pSrcPixels + (uintptr_t) x * srcPitch + y,
+                srcPitch,
+                pDstPixels + (uintptr_t) y * dstPitch + x,
+                dstPitch
+            );
+        }
+    }
+
+    return endBlockX;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does the transpose for 'transposeColumnMajorToRowMajor', and optionally for 'transposeAndTruncateSourceTo16Bit' also truncates each
+// part of the source after it has been transposed. The part of the source done in each pass was just read so it is still in the cache.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <bool bTruncateSrc>
+static void transposeImpl(
+    const uint32_t* const pSrcPixels,
+    const uint32_t srcPitch,
+    uint32_t* const pDstPixels,
+    const uint32_t dstPitch,
+    const uint32_t width,
+    const uint32_t height
+) noexcept {
+    BLIT_ASSERT(pSrcPixels);
+    BLIT_ASSERT(pDstPixels);
+    BLIT_ASSERT(srcPitch >= height);
+    BLIT_ASSERT(dstPitch >= width);
+
+    // Go down the image in passes covering one 64-byte cache line of each source column, so that every source line fetched is used
+    // in full before moving on. The destination is written a whole row at a time, so it streams out nicely regardless.
+    constexpr uint32_t ROWS_PER_PASS = 16;
+
+    for (uint32_t passStartY = 0; passStartY < height; passStartY += ROWS_PER_PASS) {
+        const uint32_t passEndY = std::min(passStartY + ROWS_PER_PASS, height);
+        uint32_t blockSize = 1;
+        uint32_t endBlockX = 0;
+
+        #if BLIT_SIMD_X86
+            if (gInstructionSet == InstructionSet::AVX2) {
+                blockSize = 8;
+                endBlockX = transposeWholeBlocks<8>(
+                    pSrcPixels, srcPitch, pDstPixels, dstPitch, width, passStartY, passEndY, transposeBlock8x8_AVX2
+                );
+            } else if (gInstructionSet == InstructionSet::SSE2) {
+                blockSize = 4;
+                endBlockX = transposeWholeBlocks<4>(
+                    pSrcPixels, srcPitch, pDstPixels, dstPitch, width, passStartY, passEndY, transposeBlock4x4_SSE2
+                );
+            }
+        #endif
+
+        // Mop up the pixels not covered by whole blocks: the rows at the bottom of the pass and the columns on the right
+        const uint32_t endBlockY = passStartY + ((passEndY - passStartY) / blockSize) * blockSize;
+        transposeArea_Scalar(pSrcPixels, srcPitch, pDstPixels, dstPitch, 0, endBlockX, endBlockY, passEndY);
+        transposeArea_Scalar(pSrcPixels, srcPitch, pDstPixels, dstPitch, endBlockX, width, passStartY, passEndY);
+
+        if constexpr (bTruncateSrc) {
+            for (uint32_t x = 0; x < width; ++x) {
+                uint32_t* const pSrcCol = const_cast<uint32_t*>(pSrcPixels) + (uintptr_t) x * srcPitch;
+                truncatePixelsTo16Bit(pSrcCol + passStartY, passEndY - passStartY);
+            }
+        }
+    }
+}
+
+void transposeColumnMajorToRowMajor(
+    const uint32_t* const pSrcPixels,
+    const uint32_t srcPitch,
+    uint32_t* const pDstPixels,
+    const uint32_t dstPitch,
+    const uint32_t width,
+    const uint32_t height
+) noexcept {
+    transposeImpl<false>(pSrcPixels, srcPitch, pDstPixels, dstPitch, width, height);
+}
+
+void transposeAndTruncateSourceTo16Bit(
+    uint32_t* const pSrcPixels,
+    const uint32_t srcPitch,
+    uint32_t* const pDstPixels,
+    const uint32_t dstPitch,
+    const uint32_t width,
+    const uint32_t height
+) noexcept {
+    transposeImpl<true>(pSrcPixels, srcPitch, pDstPixels, dstPitch, width, height);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Post processing: scalar versions of each operation for a single pixel
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline uint32_t tintPixel(const uint32_t color, const Fixed rMul, const Fixed gMul, const Fixed bMul) noexcept {
+    constexpr Fixed COL8_MAX_FRAC = intToFixed16(255);
+
+    const Fixed rFrac = std::min(fixed16Mul(intToFixed16((color >> 16) & 0xFFu), rMul), COL8_MAX_FRAC);
+    const Fixed gFrac = std::min(fixed16Mul(intToFixed16((color >> 8) & 0xFFu), gMul), COL8_MAX_FRAC);
+    const Fixed bFrac = std::min(fixed16Mul(intToFixed16(color & 0xFFu), bMul), COL8_MAX_FRAC);
+
+    return (
+        ((uint32_t) fixed16ToInt(rFrac) << 16) |
+        ((uint32_t) fixed16ToInt(gFrac) << 8) |
+        ((uint32_t) fixed16ToInt(bFrac))
+    );
+}
+
+static constexpr uint32_t INVERT_PIXEL_MASK = 0x00FFFFFFu;
+static constexpr uint32_t TRUNCATE_PIXEL_16_BIT_MASK = 0x00F8F8F8u;
+
+#if BLIT_SIMD_X86
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tints 4 pixels using SSE2.
+//
+// The 8-bit colors are widened to 16-bits and each multiplier is split into its integer and fractional parts, so that the exact result
+// of the fixed point multiply is 'color * mulInt + ((color * mulFrac) >> 16)'. For multipliers below 128.0 this fits in a signed 16-bit
+// value, and the final pack to 8-bits (which treats the values as signed) saturates at 255 which does the clamp.
+// The unused top byte of each pixel has a multiplier of '0'.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline __m128i tint4Pixels_SSE2(const __m128i pixels, const __m128i mulInt, const __m128i mulFrac) noexcept {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colorsLo = _mm_unpacklo_epi8(pixels, zero);
+    const __m128i colorsHi = _mm_unpackhi_epi8(pixels, zero);
+    const __m128i tintedLo = _mm_add_epi16(_mm_mullo_epi16(colorsLo, mulInt), _mm_mulhi_epu16(colorsLo, mulFrac));
+    const __m128i tintedHi = _mm_add_epi16(_mm_mullo_epi16(colorsHi, mulInt), _mm_mulhi_epu16(colorsHi, mulFrac));
+    return _mm_packus_epi16(tintedLo, tintedHi);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 version of 'tint4Pixels_SSE2' which does 8 pixels at a time.
+// Note: the unpacks and the pack both work within each 128-bit lane, so the pixels come out in the same order they went in.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BLIT_SIMD_AVX2_FUNC static inline __m256i tint8Pixels_AVX2(const __m256i pixels, const __m256i mulInt, const __m256i mulFrac) noexcept {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i colorsLo = _mm256_unpacklo_epi8(pixels, zero);
+    const __m256i colorsHi = _mm256_unpackhi_epi8(pixels, zero);
+    const __m256i tintedLo = _mm256_add_epi16(_mm256_mullo_epi16(colorsLo, mulInt), _mm256_mulhi_epu16(colorsLo, mulFrac));
+    const __m256i tintedHi = _mm256_add_epi16(_mm256_mullo_epi16(colorsHi, mulInt), _mm256_mulhi_epu16(colorsHi, mulFrac));
+    return _mm256_packus_epi16(tintedLo, tintedHi);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Post processing: SSE2 and AVX2 versions.
+// Each loop iteration does 2 vectors worth of pixels (8 for SSE2, 16 for AVX2) and returns how many pixels were done in total.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t tintPixels_SSE2(uint32_t* const pPixels, const uint32_t count, const Fixed rMul, const Fixed gMul, const Fixed bMul) noexcept {
+    const int16_t rMulInt = (int16_t)(rMul >> 16);
+    const int16_t gMulInt = (int16_t)(gMul >> 16);
+    const int16_t bMulInt = (int16_t)(bMul >> 16);
+    const int16_t rMulFrac = (int16_t)(rMul & 0xFFFF);
+    const int16_t gMulFrac = (int16_t)(gMul & 0xFFFF);
+    const int16_t bMulFrac = (int16_t)(bMul & 0xFFFF);
+    const __m128i mulInt = _mm_setr_epi16(bMulInt, gMulInt, rMulInt, 0, bMulInt, gMulInt, rMulInt, 0);
+    const __m128i mulFrac = _mm_setr_epi16(bMulFrac, gMulFrac, rMulFrac, 0, bMulFrac, gMulFrac, rMulFrac, 0);
+
+    const uint32_t numDone = (count / 8) * 8;
+
+    for (uint32_t i = 0; i < numDone; i += 8) {
+        __m128i* const pVec = (__m128i*)(pPixels + i);
+        const __m128i pixels1 = _mm_loadu_si128(pVec);
+        const __m128i pixels2 = _mm_loadu_si128(pVec + 1);
+        _mm_storeu_si128(pVec, tint4Pixels_SSE2(pixels1, mulInt, mulFrac));
+        _mm_storeu_si128(pVec + 1, tint4Pixels_SSE2(pixels2, mulInt, mulFrac));
+    }
+
+    return numDone;
+}
+
+BLIT_SIMD_AVX2_FUNC static uint32_t tintPixels_AVX2(
+    uint32_t* const pPixels,
+    const uint32_t count,
+    const Fixed rMul,
+    const Fixed gMul,
+    const Fixed bMul
+) noexcept {
+    const int16_t rMulInt = (int16_t)(rMul >> 16);
+    const int16_t gMulInt = (int16_t)(gMul >> 16);
+    const int16_t bMulInt = (int16_t)(bMul >> 16);
+    const int16_t rMulFrac = (int16_t)(rMul & 0xFFFF);
+    const int16_t gMulFrac = (int16_t)(gMul & 0xFFFF);
+    const int16_t bMulFrac = (int16_t)(bMul & 0xFFFF);
+
+    const __m256i mulInt = _mm256_setr_epi16(
+        bMulInt, gMulInt, rMulInt, 0, bMulInt, gMulInt, rMulInt, 0,
+        bMulInt, gMulInt, rMulInt, 0, bMulInt, gMulInt, rMulInt, 0
+    );
+
+    const __m256i mulFrac = _mm256_setr_epi16(
+        bMulFrac, gMulFrac, rMulFrac, 0, bMulFrac, gMulFrac, rMulFrac, 0,
+        bMulFrac, gMulFrac, rMulFrac, 0, bMulFrac, gMulFrac, rMulFrac, 0
+    );
+
+    const uint32_t numDone = (count / 16) * 16;
+
+    for (uint32_t i = 0; i < numDone; i += 16) {
+        __m256i* const pVec = (__m256i*)(pPixels + i);
+        const __m256i pixels1 = _mm256_loadu_si256(pVec);
+        const __m256i pixels2 = _mm256_loadu_si256(pVec + 1);
+        _mm256_storeu_si256(pVec, tint8Pixels_AVX2(pixels1, mulInt, mulFrac));
+        _mm256_storeu_si256(pVec + 1, tint8Pixels_AVX2(pixels2, mulInt, mulFrac));
+    }
+
+    return numDone;
+}
+
+// Inverts the pixels when 'bInvert' is true, otherwise masks them with the given mask.
+// Inverting is an 'and not' with the mask, so both operations are a single instruction per vector.
+template <bool bInvert>
+static uint32_t maskPixels_SSE2(uint32_t* const pPixels, const uint32_t count, const uint32_t mask) noexcept {
+    const __m128i maskV = _mm_set1_epi32((int32_t) mask);
+    const uint32_t numDone = (count / 8) * 8;
+
+    for (uint32_t i = 0; i < numDone; i += 8) {
+        __m128i* const pVec = (__m128i*)(pPixels + i);
+        const __m128i pixels1 = _mm_loadu_si128(pVec);
+        const __m128i pixels2 = _mm_loadu_si128(pVec + 1);
+
+        if constexpr (bInvert) {
+            _mm_storeu_si128(pVec, _mm_andnot_si128(pixels1, maskV));
+            _mm_storeu_si128(pVec + 1, _mm_andnot_si128(pixels2, maskV));
+        } else {
+            _mm_storeu_si128(pVec, _mm_and_si128(pixels1, maskV));
+            _mm_storeu_si128(pVec + 1, _mm_and_si128(pixels2, maskV));
+        }
+    }
+
+    return numDone;
+}
+
+template <bool bInvert>
+BLIT_SIMD_AVX2_FUNC static uint32_t maskPixels_AVX2(uint32_t* const pPixels, const uint32_t count, const uint32_t mask) noexcept {
+    const __m256i maskV = _mm256_set1_epi32((int32_t) mask);
+    const uint32_t numDone = (count / 16) * 16;
+
+    for (uint32_t i = 0; i < numDone; i += 16) {
+        __m256i* const pVec = (__m256i*)(pPixels + i);
+        const __m256i pixels1 = _mm256_loadu_si256(pVec);
+        const __m256i pixels2 = _mm256_loadu_si256(pVec + 1);
+
+        if constexpr (bInvert) {
+            _mm256_storeu_si256(pVec, _mm256_andnot_si256(pixels1, maskV));
+            _mm256_storeu_si256(pVec + 1, _mm256_andnot_si256(pixels2, maskV));
+        } else {
+            _mm256_storeu_si256(pVec, _mm256_and_si256(pixels1, maskV));
+            _mm256_storeu_si256(pVec + 1, _mm256_and_si256(pixels2, maskV));
+        }
+    }
+
+    return numDone;
+}
+#endif  // #if BLIT_SIMD_X86
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Inverts or masks pixels with the best instruction set available, then finishes off any leftover pixels with scalar code
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <bool bInvert>
+static void maskPixels(uint32_t* const pPixels, const uint32_t count, const uint32_t mask) noexcept {
+    BLIT_ASSERT(pPixels || (count == 0));
+    uint32_t numDone = 0;
+
+    #if BLIT_SIMD_X86
+        if (gInstructionSet == InstructionSet::AVX2) {
+            numDone = maskPixels_AVX2<bInvert>(pPixels, count, mask);
+        } else if (gInstructionSet == InstructionSet::SSE2) {
+            numDone = maskPixels_SSE2<bInvert>(pPixels, count, mask);
+        }
+    #endif
+
+    for (uint32_t i = numDone; i < count; ++i) {
+        pPixels[i] = (bInvert) ? (~pPixels[i]) & mask : pPixels[i] & mask;
+    }
+}
+
+void tintPixels(uint32_t* const pPixels, const uint32_t count, const Fixed rMul, const Fixed gMul, const Fixed bMul) noexcept {
+    BLIT_ASSERT(pPixels || (count == 0));
+    BLIT_ASSERT((rMul >= 0) && (rMul < intToFixed16(128)));
+    BLIT_ASSERT((gMul >= 0) && (gMul < intToFixed16(128)));
+    BLIT_ASSERT((bMul >= 0) && (bMul < intToFixed16(128)));
+
+    uint32_t numDone = 0;
+
+    #if BLIT_SIMD_X86
+        if (gInstructionSet == InstructionSet::AVX2) {
+            numDone = tintPixels_AVX2(pPixels, count, rMul, gMul, bMul);
+        } else if (gInstructionSet == InstructionSet::SSE2) {
+            numDone = tintPixels_SSE2(pPixels, count, rMul, gMul, bMul);
+        }
+    #endif
+
+    for (uint32_t i = numDone; i < count; ++i) {
+        pPixels[i] = tintPixel(pPixels[i], rMul, gMul, bMul);
+    }
+}
+
+void invertPixels(uint32_t* const pPixels, const uint32_t count) noexcept {
+    maskPixels<true>(pPixels, count, INVERT_PIXEL_MASK);
+}
+
+void truncatePixelsTo16Bit(uint32_t* const pPixels, const uint32_t count) noexcept {
+    maskPixels<false>(pPixels, count, TRUNCATE_PIXEL_16_BIT_MASK);
+}
+
+END_NAMESPACE(BlitSimd)
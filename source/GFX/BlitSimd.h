@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Blit.h"
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// SIMD versions of the hottest column blitting routines used by the renderer, plus runtime selection of the instruction set to use.
+//
+// Notes:
+//  (1) Every routine here must produce EXACTLY the same output as the scalar equivalent, bit for bit.
+//      Operations are done in the same order and with the same rounding as the scalar code, and 'min'/'max' operands are ordered
+//      so that they give the same result as 'std::min'/'std::max' do.
+//  (2) Texture coordinates for walls and sprites are still stepped serially, one pixel at a time, the same way 'Blit::blitColumn'
+//      does it. Deriving them with a multiply instead would round differently, so only the texel decode, lighting and output pixel
+//      packing is done 4 or 8 pixels at a time for these.
+//  (3) SSE2 is always available on x64 and is used as the baseline there. AVX2 code is compiled in regardless of compiler
+//      settings and is only used if the CPU supports it. On other CPUs (e.g ARM) the scalar code is always used for now; a NEON
+//      version of each routine should slot in alongside the SSE2 and AVX2 ones when needed.
+//  (4) FMA instructions are deliberately NOT used: the scalar code does a separate multiply and add, with two rounding steps.
+//------------------------------------------------------------------------------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define BLIT_SIMD_X86 1
+    #include <immintrin.h>
+#else
+    #define BLIT_SIMD_X86 0
+#endif
+
+// Marks a function as containing AVX2 code.
+// MSVC allows AVX2 intrinsics anywhere, but GCC and Clang must be told that a function is allowed to use them.
+#if BLIT_SIMD_X86
+    #if defined(_MSC_VER) && (!defined(__clang__))
+        #define BLIT_SIMD_AVX2_FUNC
+    #else
+        #define BLIT_SIMD_AVX2_FUNC __attribute__((target("avx2")))
+    #endif
+#endif
+
+BEGIN_NAMESPACE(BlitSimd)
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Instruction sets that the SIMD routines can be implemented with
+//------------------------------------------------------------------------------------------------------------------------------------------
+enum class InstructionSet : uint8_t {
+    NONE,       // Use plain scalar code only
+    SSE2,       // x86 SSE2 (4 pixels at a time)
+    AVX2,       // x86 AVX2 (8 pixels at a time)
+    NEON        // ARM NEON (reserved for future use)
+};
+
+// Detects the best instruction set supported by this CPU and selects it for use.
+// If SIMD is not allowed then the plain scalar code paths will be used instead.
+void init(const bool bAllowSimd) noexcept;
+
+// Returns the instruction set that the SIMD routines should be using
+InstructionSet getInstructionSet() noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Scalar version of the lighting and XRGB8888 conversion of an ARGB1555 texel done by 'Blit::blitColumn' with 'BCF_COLOR_MULT_RGB'.
+// Used to finish off the odd pixels at the end of a column.
+//------------------------------------------------------------------------------------------------------------------------------------------
+inline uint32_t lightARGB1555Texel(const uint16_t srcPixel, const float lightMul) noexcept {
+    const uint8_t texR = (uint8_t)((srcPixel & uint16_t(0b0111110000000000)) >> 7);
+    const uint8_t texG = (uint8_t)((srcPixel & uint16_t(0b0000001111100000)) >> 2);
+    const uint8_t texB = (uint8_t)((srcPixel & uint16_t(0b0000000000011111)) << 3);
+
+    const float r = std::min((float) texR * lightMul, 255.0f);
+    const float g = std::min((float) texG * lightMul, 255.0f);
+    const float b = std::min((float) texB * lightMul, 255.0f);
+
+    return (
+        (uint32_t(r) << 16) |
+        (uint32_t(g) << 8) |
+        (uint32_t(b))
+    );
+}
+
+#if BLIT_SIMD_X86
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    // Lights 4 ARGB1555 texels (in 32-bit lanes) by the given per lane multipliers and converts them to XRGB8888.
+    // Gives the same results as 'lightARGB1555Texel' for each lane.
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    inline __m128i lightARGB1555Texels_SSE2(const __m128i texels, const __m128 lightMul) noexcept {
+        const __m128 r = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_and_si128(texels, _mm_set1_epi32(0b0111110000000000)), 7));
+        const __m128 g = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_and_si128(texels, _mm_set1_epi32(0b0000001111100000)), 2));
+        const __m128 b = _mm_cvtepi32_ps(_mm_slli_epi32(_mm_and_si128(texels, _mm_set1_epi32(0b0000000000011111)), 3));
+
+        // Note: 'std::min(x, 255)' returns 'x' unless '255 < x', which is what '_mm_min_ps(255, x)' does.
+        // Also mask the converted colors to 8-bits: if the light multiplier is NaN (e.g at the exact horizon for a flat) then the
+        // scalar code gets a color of '0' on x64, whereas the SIMD conversion gives '0x80000000'.
+        const __m128 maxColor = _mm_set1_ps(255.0f);
+        const __m128i colorMask = _mm_set1_epi32(0xFF);
+        const __m128i ri = _mm_and_si128(_mm_cvttps_epi32(_mm_min_ps(maxColor, _mm_mul_ps(r, lightMul))), colorMask);
+        const __m128i gi = _mm_and_si128(_mm_cvttps_epi32(_mm_min_ps(maxColor, _mm_mul_ps(g, lightMul))), colorMask);
+        const __m128i bi = _mm_and_si128(_mm_cvttps_epi32(_mm_min_ps(maxColor, _mm_mul_ps(b, lightMul))), colorMask);
+
+        return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(ri, 16), _mm_slli_epi32(gi, 8)), bi);
+    }
+
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    // AVX2 version of 'lightARGB1555Texels_SSE2' which does 8 texels at a time
+    //--------------------------------------------------------------------------------------------------------------------------------------
+    BLIT_SIMD_AVX2_FUNC inline __m256i lightARGB1555Texels_AVX2(const __m256i texels, const __m256 lightMul) noexcept {
+        const __m256 r = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_and_si256(texels, _mm256_set1_epi32(0b0111110000000000)), 7));
+        const __m256 g = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_and_si256(texels, _mm256_set1_epi32(0b0000001111100000)), 2));
+        const __m256 b = _mm256_cvtepi32_ps(_mm256_slli_epi32(_mm256_and_si256(texels, _mm256_set1_epi32(0b0000000000011111)), 3));
+
+        const __m256 maxColor = _mm256_set1_ps(255.0f);
+        const __m256i colorMask = _mm256_set1_epi32(0xFF);
+        const __m256i ri = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_min_ps(maxColor, _mm256_mul_ps(r, lightMul))), colorMask);
+        const __m256i gi = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_min_ps(maxColor, _mm256_mul_ps(g, lightMul))), colorMask);
+        const __m256i bi = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_min_ps(maxColor, _mm256_mul_ps(b, lightMul))), colorMask);
+
+        return _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(ri, 16), _mm256_slli_epi32(gi, 8)), bi);
+    }
+#endif  // #if BLIT_SIMD_X86
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Equivalent to the following for an ARGB1555 source image and no clipping:
+//
+//      Blit::blitColumn<BCF_STEP_Y | BCF_H_WRAP_WRAP | BCF_V_WRAP_WRAP | BCF_COLOR_MULT_RGB>
+//
+// This is the blit used for drawing all wall columns.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void blitWallColumn(
+    const uint16_t* const pSrcPixels,       // Pixel data for source image (column major)
+    const uint32_t srcW,                    // Width of source image
+    const uint32_t srcH,                    // Height of source image
+    const float srcX,                       // Where to start blitting from in the input texture: x & y
+    const float srcY,
+    const float srcYSubPixelAdjustment,     // An adjustment applied to the first stepping of the src Y value
+    uint32_t* const pDstPixels,             // Output image pixels, this must point to the the TOP LEFT pixel of the output image
+    const uint32_t dstW,                    // Output image width and height
+    const uint32_t dstH,
+    const uint32_t dstPixelsPitch,          // The number of pixels that must be skipped to go onto a new row in the output image
+    const int32_t dstX,                     // Where to start blitting to in output image: x & y
+    const int32_t dstY,
+    const uint32_t dstCount,                // How many pixels to blit to the output image
+    const float srcYStep,                   // Texture coordinate y step
+    const float lightMul                    // Color multiply value for red, green and blue
+) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Equivalent to the following for an ARGB1555 source image which is a single column (width '1'):
+//
+//      Blit::blitColumn<BCF_STEP_Y | BCF_ALPHA_TEST | BCF_COLOR_MULT_RGB | BCF_V_WRAP_DISCARD | BCF_V_CLIP>
+//
+// This is the blit used for drawing all non transparent sprite columns.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void blitSpriteColumn(
+    const uint16_t* const pSrcPixels,       // Pixel data for the source image column
+    const uint32_t srcH,                    // Height of source image
+    float srcY,                             // Where to start blitting from in the input texture: y
+    float srcYSubPixelAdjustment,           // An adjustment applied to the first stepping of the src Y value
+    uint32_t* const pDstPixels,             // Output image pixels, this must point to the the TOP LEFT pixel of the output image
+    const uint32_t dstW,                    // Output image width and height
+    const uint32_t dstH,
+    const uint32_t dstPixelsPitch,          // The number of pixels that must be skipped to go onto a new row in the output image
+    const int32_t dstX,                     // Where to start blitting to in output image: x & y
+    int32_t dstY,
+    uint32_t dstCount,                      // How many pixels to blit to the output image
+    const float srcYStep,                   // Texture coordinate y step
+    const float lightMul                    // Color multiply value for red, green and blue
+) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Copies a column major image into a row major one, transposing it as it goes.
+// The transpose is done in square blocks of pixels with SIMD where possible, and the source is consumed one cache line of each column
+// at a time so that source lines are fully used before being evicted. Used to copy a column major 3D view into the framebuffer.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void transposeColumnMajorToRowMajor(
+    const uint32_t* const pSrcPixels,       // Source image pixels (column major)
+    const uint32_t srcPitch,                // The number of pixels that must be skipped to go onto a new column in the source image
+    uint32_t* const pDstPixels,             // Destination image pixels (row major)
+    const uint32_t dstPitch,                // The number of pixels that must be skipped to go onto a new row in the destination image
+    const uint32_t width,                   // Size of the area to copy
+    const uint32_t height
+) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// The same as 'transposeColumnMajorToRowMajor', except that the source pixels are also truncated in place afterwards in the same way as
+// 'truncatePixelsTo16Bit' does; the destination gets the pixels as they were before truncation. A transpose works the same either way
+// round, so this is used to save a row major framebuffer as a column major copy and do the 16-bit simulation in a single sweep.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void transposeAndTruncateSourceTo16Bit(
+    uint32_t* const pSrcPixels,             // Source image pixels: truncated after they are copied
+    const uint32_t srcPitch,                // The number of pixels that must be skipped to go onto a new column in the source image
+    uint32_t* const pDstPixels,             // Destination image pixels
+    const uint32_t dstPitch,                // The number of pixels that must be skipped to go onto a new row in the destination image
+    const uint32_t width,                   // Size of the area to copy
+    const uint32_t height
+) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Post processing of a run of XRGB8888 pixels in place, for the 3D view effects and the 16-bit framebuffer simulation.
+// All of these work on contiguous pixels (e.g a row of the framebuffer) and always output '0' for the unused top 8 bits of each pixel.
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+// Multiplies the red, green and blue of each pixel by the given 16.16 fixed point multipliers and saturates the result to 255.
+// Gives the same result as 'fixed16Mul' followed by a clamp and truncation to an integer. Multipliers must be below 128.0.
+void tintPixels(uint32_t* const pPixels, const uint32_t count, const Fixed rMul, const Fixed gMul, const Fixed bMul) noexcept;
+
+// Inverts the red, green and blue of each pixel
+void invertPixels(uint32_t* const pPixels, const uint32_t count) noexcept;
+
+// Truncates each pixel as if it were stored as XRGB1555 and then converted back to XRGB8888.
+// Note: scaling the 5-bit color back up to 8-bits and truncating again always gives the original 5 bits, so this is just a mask.
+void truncatePixelsTo16Bit(uint32_t* const pPixels, const uint32_t count) noexcept;
+
+END_NAMESPACE(BlitSimd)
@@ -0,0 +1,214 @@
+#include "LitTextureCache.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+BEGIN_NAMESPACE(LitTextureCache)
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// An entry in the cache: the pre-lit pixels for one image at one light level
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Entry {
+    uint64_t                key;
+    uint32_t                resourceNum;
+    uint32_t                lastUsedFrame;
+    std::vector<uint32_t>   pixels;
+};
+
+typedef std::list<Entry> EntryList;
+
+static bool                                                     gbEnabled;
+static uint64_t                                                 gMaxSizeBytes;
+static uint64_t                                                 gCurSizeBytes;
+static uint32_t                                                 gCurFrame;
+static uint32_t                                                 gCurFrameNewBytes;  // How many bytes of new entries have been built this frame
+static EntryList                                                gEntries;           // Ordered by most recently used first
+static std::unordered_map<uint64_t, EntryList::iterator>        gEntryLookup;
+static Entry*                                                   gpLastEntry;        // The last entry looked up: saves a hash lookup when consecutive columns use the same image
+
+// Lookup tables for each light level which convert a 5-bit color component to a lit 8-bit color component
+static uint8_t gLightLUTs[NUM_LIGHT_LEVELS][32];
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes up the key for a cache entry
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t makeKey(const uint32_t resourceNum, const uint32_t subImageNum, const uint32_t lightLevel) noexcept {
+    ASSERT(subImageNum < (1u << 24));
+    ASSERT(lightLevel < NUM_LIGHT_LEVELS);
+    return ((uint64_t) resourceNum << 32) | ((uint64_t) subImageNum << 8) | lightLevel;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Builds the color lookup tables for each light level.
+// The math here is the same as 'Blit::blitColumn' uses with 'BCF_COLOR_MULT_RGB', so the result is identical to lighting a texel
+// with the quantized light multiplier.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void initLightLUTs() noexcept {
+    for (uint32_t lightLevel = 0; lightLevel < NUM_LIGHT_LEVELS; ++lightLevel) {
+        const float lightMul = (float) lightLevel / (float)(NUM_LIGHT_LEVELS - 1);
+
+        for (uint32_t color = 0; color < 32; ++color) {
+            const float litColor = std::min((float)(color << 3) * lightMul, 255.0f);
+            gLightLUTs[lightLevel][color] = (uint8_t) litColor;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Fills in the pixels for a cache entry: expands RGBA5551 pixels to ARGB8888 and lights them via the lookup table for the level
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void makeLitPixels(const uint16_t* const pSrcPixels, const uint32_t numPixels, const uint32_t lightLevel, uint32_t* const pDstPixels) noexcept {
+    const uint8_t* const pLightLUT = gLightLUTs[lightLevel];
+
+    for (uint32_t i = 0; i < numPixels; ++i) {
+        const uint16_t srcPixel = pSrcPixels[i];
+        const uint32_t a = (srcPixel & 0x8000u) ? 0xFFu : 0x00u;
+        const uint32_t r = pLightLUT[(srcPixel >> 10) & 0x1Fu];
+        const uint32_t g = pLightLUT[(srcPixel >> 5) & 0x1Fu];
+        const uint32_t b = pLightLUT[srcPixel & 0x1Fu];
+        pDstPixels[i] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Removes the given entry from the cache
+//------------------------------------------------------------------------------------------------------------------------------------------
+static EntryList::iterator removeEntry(const EntryList::iterator entryIter) noexcept {
+    if (gpLastEntry == &*entryIter) {
+        gpLastEntry = nullptr;
+    }
+
+    gCurSizeBytes -= entryIter->pixels.size() * sizeof(uint32_t);
+    gEntryLookup.erase(entryIter->key);
+    return gEntries.erase(entryIter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Evicts least recently used entries until there is room within the budget for a new entry of the given size.
+// Entries used this frame are never evicted, so returns 'false' if room cannot be made.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool evictEntriesToFit(const uint64_t numBytesNeeded) noexcept {
+    if (numBytesNeeded > gMaxSizeBytes)
+        return false;
+
+    while (gCurSizeBytes + numBytesNeeded > gMaxSizeBytes) {
+        if (gEntries.empty())
+            return false;
+
+        const EntryList::iterator lruEntryIter = std::prev(gEntries.end());
+
+        if (lruEntryIter->lastUsedFrame == gCurFrame)
+            return false;
+
+        removeEntry(lruEntryIter);
+    }
+
+    return true;
+}
+
+void init(const bool bEnabled, const uint32_t maxSizeMB) noexcept {
+    gbEnabled = bEnabled;
+    gMaxSizeBytes = (uint64_t) maxSizeMB * 1024 * 1024;
+    gCurSizeBytes = 0;
+    gCurFrame = 0;
+    gCurFrameNewBytes = 0;
+    initLightLUTs();
+}
+
+void shutdown() noexcept {
+    clear();
+    gbEnabled = false;
+    gMaxSizeBytes = 0;
+    gCurFrame = 0;
+}
+
+bool isEnabled() noexcept {
+    return gbEnabled;
+}
+
+void beginFrame() noexcept {
+    ++gCurFrame;
+    gCurFrameNewBytes = 0;
+}
+
+void clear() noexcept {
+    gEntryLookup.clear();
+    gEntries.clear();
+    gCurSizeBytes = 0;
+    gpLastEntry = nullptr;
+}
+
+void freeResource(const uint32_t resourceNum) noexcept {
+    for (EntryList::iterator entryIter = gEntries.begin(); entryIter != gEntries.end();) {
+        if (entryIter->resourceNum == resourceNum) {
+            entryIter = removeEntry(entryIter);
+        } else {
+            ++entryIter;
+        }
+    }
+}
+
+uint32_t getLightLevel(const float lightMul) noexcept {
+    const float lightMulClamped = std::clamp(lightMul, 0.0f, 1.0f);
+    return (uint32_t)(lightMulClamped * (float)(NUM_LIGHT_LEVELS - 1) + 0.5f);
+}
+
+const uint32_t* getLitPixels(
+    const uint32_t resourceNum,
+    const uint32_t subImageNum,
+    const uint16_t* const pSrcPixels,
+    const uint32_t numPixels,
+    const float lightMul
+) noexcept {
+    if (!gbEnabled)
+        return nullptr;
+
+    ASSERT(pSrcPixels);
+    const uint32_t lightLevel = getLightLevel(lightMul);
+    const uint64_t key = makeKey(resourceNum, subImageNum, lightLevel);
+
+    // Quick check for whether this is the same entry as last time
+    if (gpLastEntry && (gpLastEntry->key == key)) {
+        gpLastEntry->lastUsedFrame = gCurFrame;
+        return gpLastEntry->pixels.data();
+    }
+
+    // See if there is an existing entry, if so then make it the most recently used
+    const auto existingEntryIter = gEntryLookup.find(key);
+
+    if (existingEntryIter != gEntryLookup.end()) {
+        const EntryList::iterator entryIter = existingEntryIter->second;
+        gEntries.splice(gEntries.begin(), gEntries, entryIter);
+        entryIter->lastUsedFrame = gCurFrame;
+        gpLastEntry = &*entryIter;
+        return entryIter->pixels.data();
+    }
+
+    // Otherwise make a new entry, if this frame hasn't already built too many and old entries can be evicted to make room for it
+    const uint64_t entrySizeBytes = (uint64_t) numPixels * sizeof(uint32_t);
+
+    if (gCurFrameNewBytes + entrySizeBytes > MAX_NEW_BYTES_PER_FRAME)
+        return nullptr;
+
+    if (!evictEntriesToFit(entrySizeBytes))
+        return nullptr;
+
+    gEntries.emplace_front();
+    Entry& entry = gEntries.front();
+    entry.key = key;
+    entry.resourceNum = resourceNum;
+    entry.lastUsedFrame = gCurFrame;
+    entry.pixels.resize(numPixels);
+    makeLitPixels(pSrcPixels, numPixels, lightLevel, entry.pixels.data());
+
+    gEntryLookup[key] = gEntries.begin();
+    gCurSizeBytes += entrySizeBytes;
+    gCurFrameNewBytes += (uint32_t) entrySizeBytes;
+    gpLastEntry = &entry;
+
+    return entry.pixels.data();
+}
+
+END_NAMESPACE(LitTextureCache)
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Base/Macros.h"
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// An optional cache of wall and sprite textures which have been expanded from RGBA5551 to ARGB8888 and pre-multiplied by a light level.
+// With this, drawing a lit texel becomes a single load of the pre-lit pixel; no decoding or lighting math per pixel is required.
+//
+// Notes:
+//  (1) Light multipliers are quantized to one of 'NUM_LIGHT_LEVELS' levels, so the output is not quite the same as when textures are
+//      lit per pixel. The cache is therefore off by default.
+//  (2) Entries are keyed by the 'Textures' or 'Sprites' resource number, a sub image number (sprite frame and angle), and light level.
+//  (3) Memory use is bounded by a budget: the least recently used entries are evicted to make room for new ones. Entries used in the
+//      current frame are never evicted however, since fragments queued for drawing may still point to them. If there is no room for
+//      a new entry then no lit pixels are returned, and the caller must fall back to lighting the RGBA5551 texels itself.
+//  (4) Only so many new entries are built per frame ('MAX_NEW_BYTES_PER_FRAME'), so that entering a new area does not stall a frame
+//      while lots of textures are lit at lots of light levels. Past that, no lit pixels are returned for the rest of the frame and
+//      the caller must again fall back to lighting texels itself; the missing entries get built over the following frames.
+//  (5) The cache is NOT thread safe. Entries must be looked up while fragments are being generated (on the main thread), NOT while
+//      they are being drawn in parallel.
+//  (6) The cache must be told whenever source textures or sprites are freed, so stale entries are not used later.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(LitTextureCache)
+
+// How many distinct light levels the light multiplier is quantized to
+static constexpr uint32_t NUM_LIGHT_LEVELS = 64;
+
+// The maximum amount of pre-lit pixel data which will be built in a single frame
+static constexpr uint32_t MAX_NEW_BYTES_PER_FRAME = 1024 * 1024;
+
+void init(const bool bEnabled, const uint32_t maxSizeMB) noexcept;
+void shutdown() noexcept;
+
+// Whether the cache is enabled. If disabled then no lit pixels are ever returned.
+bool isEnabled() noexcept;
+
+// Must be called at the start of each frame, prior to generating fragments.
+// Used to determine which entries are still in use by the current frame.
+void beginFrame() noexcept;
+
+// Free all entries, or just entries for a particular resource
+void clear() noexcept;
+void freeResource(const uint32_t resourceNum) noexcept;
+
+// Get the light level that a light multiplier is quantized to
+uint32_t getLightLevel(const float lightMul) noexcept;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the pre-lit ARGB8888 version of the given RGBA5551 image, creating it if it doesn't exist already.
+// The output has the same layout and dimensions as the source image, and alpha is either '0' or '255'.
+// Returns 'nullptr' if the cache is disabled, or if the entry doesn't exist and can't be created this frame (see notes above).
+//------------------------------------------------------------------------------------------------------------------------------------------
+const uint32_t* getLitPixels(
+    const uint32_t resourceNum,
+    const uint32_t subImageNum,
+    const uint16_t* const pSrcPixels,
+    const uint32_t numPixels,
+    const float lightMul
+) noexcept;
+
+END_NAMESPACE(LitTextureCache)
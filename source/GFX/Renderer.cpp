@@ -1,13 +1,22 @@
 #include "Renderer_Internal.h"
 
+#include "Base/HardwareCounters.h"
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
 #include "Blit.h"
+#include "BlitSimd.h"
 #include "Game/Config.h"
 #include "Game/Data.h"
+#include "LitTextureCache.h"
 #include "Sprites.h"
 #include "Textures.h"
 #include "Things/MapObj.h"
 #include "Video.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 
 BEGIN_NAMESPACE(Renderer)
 
@@ -70,7 +79,17 @@ std::vector<WallFragment>       gWallFragments;
 std::vector<FlatFragment>       gFloorFragments;
 std::vector<FlatFragment>       gCeilFragments;
 std::vector<SkyFragment>        gSkyFragments;
+std::vector<FlatSpan>           gFloorSpans;
+std::vector<FlatSpan>           gCeilSpans;
 std::vector<DrawSprite>         gDrawSprites;
+std::vector<uint32_t>           gSortedDrawSprites;
+float                           gViewRenderScale = 1.0f;
+
+// Where the 3D view is currently being drawn to, the buffer used when drawing it in column major order and the buffer used for the view
+// in row major order when it is drawn at a lower resolution than its area on screen, before it is upscaled.
+static DrawTarget               gViewDrawTarget;
+static std::vector<uint32_t>    gColumnMajorViewBuffer;
+static std::vector<uint32_t>    gLowResViewBuffer;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Load in the "TextureInfo" array so that the game knows all about the wall and sky textures (Width,Height).
@@ -162,6 +181,8 @@ static void setupOccludingColumnsArrayForDraw() noexcept {
 }
 
 static void preDrawSetup() noexcept {
+    PROFILE_SCOPE("preDrawSetup");
+
     // Set the position and angle of the view from the player
     const player_t& player = gPlayer;
     const mobj_t& mapObj = *player.mo;
@@ -211,12 +232,17 @@ static void preDrawSetup() noexcept {
     // Clear render arrays & buffers
     setupSegYClipArrayForDraw();
     setupOccludingColumnsArrayForDraw();
+    beginDrawSegCacheFrame();
 
     gWallFragments.clear();
     gFloorFragments.clear();
     gCeilFragments.clear();
     gSkyFragments.clear();
+    gFloorSpans.clear();
+    gCeilSpans.clear();
     gDrawSprites.clear();
+    gSortedDrawSprites.clear();
+    LitTextureCache::beginFrame();
 
     // Other misc setup
     gExtraLight = player.extralight << 6;       // Init the extra lighting value
@@ -224,6 +250,14 @@ static void preDrawSetup() noexcept {
 
 void init() noexcept {
     initData();     // Init resource managers and all of the lookup tables
+    BlitSimd::init(Config::gbUseSimdRendering);
+    LitTextureCache::init(Config::gbUseLitTextureCache, Config::gLitTextureCacheSizeMB);
+
+    if (Config::gbBenchmarkViewBufferLayouts) {
+        if (!HardwareCounters::init()) {
+            std::printf("View buffer layout benchmark: hardware counters unavailable, cache misses will not be reported.\n");
+        }
+    }
 
     // Fragment reserve
     gWallFragments.reserve(1024 * 8);
@@ -231,20 +265,24 @@ void init() noexcept {
     gCeilFragments.reserve(1024 * 8);
     gSkyFragments.reserve(1024);
     gDrawSprites.reserve(128);
+    gSortedDrawSprites.reserve(128);
 }
 
 void shutdown() noexcept {
-    // Nothing to do here yet...
+    HardwareCounters::shutdown();
+    gColumnMajorViewBuffer.clear();
+    gColumnMajorViewBuffer.shrink_to_fit();
+    gLowResViewBuffer.clear();
+    gLowResViewBuffer.shrink_to_fit();
+    LitTextureCache::shutdown();
 }
 
 void initMathTables() noexcept {
     // Compute stuff based on screen size
     gScaleFactor = (float) Video::gScreenWidth / (float) Video::REFERENCE_SCREEN_WIDTH;
     gInvScaleFactor = 1.0f / gScaleFactor;
-    g3dViewWidth = (uint32_t)((float) REFERENCE_SCREEN_SIZES[gScreenSize].w * gScaleFactor);
-    g3dViewHeight = (uint32_t)((float) REFERENCE_SCREEN_SIZES[gScreenSize].h * gScaleFactor);
-    gCenterX = g3dViewWidth / 2;
-    gCenterY = g3dViewHeight / 2;
+    g3dViewScreenWidth = (uint32_t)((float) REFERENCE_SCREEN_SIZES[gScreenSize].w * gScaleFactor);
+    g3dViewScreenHeight = (uint32_t)((float) REFERENCE_SCREEN_SIZES[gScreenSize].h * gScaleFactor);
 
     #if ASSERTS_ENABLED == 1
         // Sanity check the offset calculation will never underflow!
@@ -259,8 +297,8 @@ void initMathTables() noexcept {
     g3dViewXOffset = (uint32_t)((float) refScreenOffsetX * gScaleFactor);
     g3dViewYOffset = (uint32_t)((float) refScreenOffsetY * gScaleFactor);
 
-    gGunXScale = (float) g3dViewWidth / 320.0f;     // Get the 3DO scale factor for the gun shape and the y scale
-    gGunYScale = (float) g3dViewHeight / 160.0f;
+    gGunXScale = (float) g3dViewScreenWidth / 320.0f;   // Get the 3DO scale factor for the gun shape and the y scale
+    gGunYScale = (float) g3dViewScreenHeight / 160.0f;
 
     // Near plane width and height
     gNearPlaneW = Z_NEAR * std::tan(FOV * 0.5f) * 2.0f;
@@ -281,6 +319,40 @@ void initMathTables() noexcept {
         gProjMatrix.r2c3 = -(Z_NEAR * Z_FAR) / (Z_FAR - Z_NEAR);
     }
 
+    // Compute the size the view is rendered at and everything which depends on it, keeping the current resolution scale.
+    // Make room for the full size of the view in the per column and per row arrays up front, so changing the scale never reallocates them.
+    gScreenXToAngleBAM.reserve(g3dViewScreenWidth);
+    gSegClip.reserve(g3dViewScreenWidth);
+    gOccludingCols.reserve(g3dViewScreenWidth);
+    reserveFlatSpanRows(g3dViewScreenHeight);
+    setViewRenderScale(gViewRenderScale);
+
+    // Create the lighting tables
+    for (uint32_t i = 0; i < 256; ++i) {
+        constexpr float LIGHT_MIN_PERCENT = 1.0f / 5.0f;
+        constexpr float MAX_BRIGHT_RANGE_SCALE = 1.0f;
+        constexpr float LIGHT_COEF_BASE = 16.0f;
+        constexpr float LIGHT_COEF_ADJUST_FACTOR = 13.0f;
+
+        const float lightLevel = (float) i / 255.0f;
+        const float maxBrightRange = lightLevel * MAX_BRIGHT_RANGE_SCALE;
+
+        gLightMins[i] = (float) i * LIGHT_MIN_PERCENT;
+        gLightSubs[i] = maxBrightRange;
+        gLightCoefs[i] = LIGHT_COEF_BASE - lightLevel * LIGHT_COEF_ADJUST_FACTOR;
+    }
+}
+
+void setViewRenderScale(const float scale) noexcept {
+    ASSERT((scale > 0.0f) && (scale <= 1.0f));
+    gViewRenderScale = scale;
+
+    // Note: the angle table below needs at least 2 columns
+    g3dViewWidth = std::clamp((uint32_t) std::lround((float) g3dViewScreenWidth * scale), 2u, g3dViewScreenWidth);
+    g3dViewHeight = std::clamp((uint32_t) std::lround((float) g3dViewScreenHeight * scale), 1u, g3dViewScreenHeight);
+    gCenterX = g3dViewWidth / 2;
+    gCenterY = g3dViewHeight / 2;
+
     // Compute the screen pixel to view angle table
     gScreenXToAngleBAM.resize(g3dViewWidth);
 
@@ -295,31 +367,317 @@ void initMathTables() noexcept {
             gScreenXToAngleBAM[x] = angleBAM;
         }
     }
+}
 
-    // Create the lighting tables
-    for (uint32_t i = 0; i < 256; ++i) {
-        constexpr float LIGHT_MIN_PERCENT = 1.0f / 5.0f;
-        constexpr float MAX_BRIGHT_RANGE_SCALE = 1.0f;
-        constexpr float LIGHT_COEF_BASE = 16.0f;
-        constexpr float LIGHT_COEF_ADJUST_FACTOR = 13.0f;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Benchmarking for the two ways of drawing floors and ceilings: as columns or as horizontal spans.
+//
+// Every frame the floors and ceilings are drawn using both methods on the main thread, one after the other, so both methods are timed
+// for exactly the same view. The method not in use is drawn first, so that the one in use is what ends up on screen. The averaged
+// timings are printed every so often and afterwards the fragments are cleared, so that floors and ceilings are not drawn again.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t     gFlatBenchmarkColumnsNs;
+static uint64_t     gFlatBenchmarkSpansNs;
+static uint32_t     gFlatBenchmarkNumFrames;
+
+static uint64_t drawAllFlatsAndTime(const bool bAsSpans) noexcept {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    if (bAsSpans) {
+        makeAllFlatSpans();
+        drawAllFloorSpans();
+        drawAllCeilingSpans();
+    } else {
+        drawAllFloorFragments();
+        drawAllCeilingFragments();
+    }
 
-        const float lightLevel = (float) i / 255.0f;
-        const float maxBrightRange = lightLevel * MAX_BRIGHT_RANGE_SCALE;
+    const auto endTime = std::chrono::steady_clock::now();
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
 
-        gLightMins[i] = (float) i * LIGHT_MIN_PERCENT;
-        gLightSubs[i] = maxBrightRange;
-        gLightCoefs[i] = LIGHT_COEF_BASE - lightLevel * LIGHT_COEF_ADJUST_FACTOR;
+static void benchmarkFlatDrawModes() noexcept {
+    const bool bUseSpans = Config::gbDrawFlatsAsSpans;
+    const uint64_t otherModeNs = drawAllFlatsAndTime(!bUseSpans);
+    const uint64_t curModeNs = drawAllFlatsAndTime(bUseSpans);
+
+    gFlatBenchmarkColumnsNs += (bUseSpans) ? otherModeNs : curModeNs;
+    gFlatBenchmarkSpansNs += (bUseSpans) ? curModeNs : otherModeNs;
+    gFlatBenchmarkNumFrames++;
+
+    if (gFlatBenchmarkNumFrames >= Config::gPerfCounterNumFramesToAverage) {
+        const double columnsUSec = (double) gFlatBenchmarkColumnsNs / (double) gFlatBenchmarkNumFrames / 1000.0;
+        const double spansUSec = (double) gFlatBenchmarkSpansNs / (double) gFlatBenchmarkNumFrames / 1000.0;
+        std::printf(
+            "Flat draw benchmark (%u frames avg): columns %.1f usec, spans %.1f usec, spans speedup %.2fx\n",
+            gFlatBenchmarkNumFrames,
+            columnsUSec,
+            spansUSec,
+            (spansUSec > 0.0) ? columnsUSec / spansUSec : 0.0
+        );
+
+        gFlatBenchmarkColumnsNs = 0;
+        gFlatBenchmarkSpansNs = 0;
+        gFlatBenchmarkNumFrames = 0;
+    }
+
+    gFloorFragments.clear();
+    gCeilFragments.clear();
+    gFloorSpans.clear();
+    gCeilSpans.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if the 3D view is being drawn at a lower resolution than its area on screen, and must be upscaled into the framebuffer
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool isViewLowRes() noexcept {
+    return ((g3dViewWidth != g3dViewScreenWidth) || (g3dViewHeight != g3dViewScreenHeight));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Resizes one of the offscreen view buffers for the current view size.
+// Room is always made for the full size of the view, so that changing the resolution scale never reallocates.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void resizeViewBuffer(std::vector<uint32_t>& buffer) noexcept {
+    const size_t numPixels = (size_t) g3dViewWidth * g3dViewHeight;
+
+    if (buffer.size() != numPixels) {
+        buffer.reserve((size_t) g3dViewScreenWidth * g3dViewScreenHeight);
+        buffer.resize(numPixels);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Where the 3D view goes in row major order: directly into the framebuffer, or into the low resolution view buffer if it is to be
+// upscaled afterwards.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t* getRowMajorViewPixels() noexcept {
+    if (isViewLowRes()) {
+        resizeViewBuffer(gLowResViewBuffer);
+        return gLowResViewBuffer.data();
+    } else {
+        return Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset;
+    }
+}
+
+static uint32_t getRowMajorViewPitch() noexcept {
+    return (isViewLowRes()) ? g3dViewWidth : Video::gScreenWidth;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sets where the 3D view will be drawn to: either directly to the framebuffer (or low resolution view buffer) or to a separate column
+// major buffer, which must then be transposed afterwards.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void setupViewDrawTarget(const bool bColumnMajor) noexcept {
+    gViewDrawTarget.x = 0;
+    gViewDrawTarget.y = 0;
+    gViewDrawTarget.width = g3dViewWidth;
+    gViewDrawTarget.height = g3dViewHeight;
+    gViewDrawTarget.bColumnMajor = bColumnMajor;
+
+    if (bColumnMajor) {
+        resizeViewBuffer(gColumnMajorViewBuffer);
+        gViewDrawTarget.pPixels = gColumnMajorViewBuffer.data();
+        gViewDrawTarget.pitch = g3dViewHeight;
+    } else {
+        gViewDrawTarget.pPixels = getRowMajorViewPixels();
+        gViewDrawTarget.pitch = getRowMajorViewPitch();
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the sky, floors, ceilings, walls and sprites of the 3D view to the current view draw target
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void drawAllViewFragments() noexcept {
+    if (Config::gbTiledRendering) {
+        drawAllFragmentsInTiles();  // Draw sky, floors, ceilings, walls and sprites in small screen tiles, in parallel if there are multiple threads
+    } else if (JobSystem::getNumThreads() > 1) {
+        drawAllFragmentsInBands();  // Draw sky, floors, ceilings, walls and sprites in parallel, split up into vertical bands of screen columns
+    } else {
+        drawAllSkyFragments();
+
+        if (Config::gbDrawFlatsAsSpans) {
+            drawAllFloorSpans();
+            drawAllCeilingSpans();
+        } else {
+            drawAllFloorFragments();
+            drawAllCeilingFragments();
+        }
+
+        drawAllWallFragments();
+        drawAllSprites();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transposes the 3D view from the column major view buffer into the framebuffer (or low resolution view buffer)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void copyColumnMajorViewToFramebuffer() noexcept {
+    PROFILE_SCOPE("copyColumnMajorViewToFramebuffer");
+
+    BlitSimd::transposeColumnMajorToRowMajor(
+        gColumnMajorViewBuffer.data(),
+        g3dViewHeight,
+        getRowMajorViewPixels(),
+        getRowMajorViewPitch(),
+        g3dViewWidth,
+        g3dViewHeight
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the 3D view to the framebuffer, optionally going via the column major view buffer.
+// The view must be in the framebuffer before weapons and post effects are drawn on top of it, so the transpose is done here rather than
+// when presenting the frame.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void drawView(const bool bColumnMajor) noexcept {
+    setupViewDrawTarget(bColumnMajor);
+    drawAllViewFragments();
+
+    if (bColumnMajor) {
+        copyColumnMajorViewToFramebuffer();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Benchmarking for the two layouts the 3D view can be drawn in: directly to the row major framebuffer, or to a column major buffer
+// which is then transposed into the framebuffer.
+//
+// Every frame the view is drawn using both layouts, one after the other, so both are timed for exactly the same view. The layout not in
+// use is drawn first, so that the one in use is what ends up on screen. Cache misses are counted for the main thread where hardware
+// counters are available. The averaged results are printed every so often.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct ViewLayoutBenchmarkTotals {
+    uint64_t    drawNs;
+    uint64_t    transposeNs;
+    uint64_t    l1dReadMisses;
+    uint64_t    llcMisses;
+};
+
+static ViewLayoutBenchmarkTotals    gViewLayoutBenchmarkRowMajor;
+static ViewLayoutBenchmarkTotals    gViewLayoutBenchmarkColMajor;
+static uint32_t                     gViewLayoutBenchmarkNumFrames;
+
+static void drawViewAndMeasure(const bool bColumnMajor, ViewLayoutBenchmarkTotals& totals) noexcept {
+    const HardwareCounters::CacheMissCounts startMisses = HardwareCounters::readCacheMisses();
+    const auto startTime = std::chrono::steady_clock::now();
+
+    setupViewDrawTarget(bColumnMajor);
+    drawAllViewFragments();
+    const auto drawEndTime = std::chrono::steady_clock::now();
+
+    if (bColumnMajor) {
+        copyColumnMajorViewToFramebuffer();
+    }
+
+    const auto endTime = std::chrono::steady_clock::now();
+    const HardwareCounters::CacheMissCounts endMisses = HardwareCounters::readCacheMisses();
+
+    totals.drawNs += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    totals.transposeNs += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - drawEndTime).count();
+    totals.l1dReadMisses += endMisses.l1dReadMisses - startMisses.l1dReadMisses;
+    totals.llcMisses += endMisses.llcMisses - startMisses.llcMisses;
+}
+
+static void benchmarkViewBufferLayouts() noexcept {
+    // Note: sprites are sorted as part of drawing and the tile/band binning is redone each time, so the view can be drawn twice
+    const bool bUseColMajor = Config::gbColumnMajorViewBuffer;
+    drawViewAndMeasure(!bUseColMajor, (bUseColMajor) ? gViewLayoutBenchmarkRowMajor : gViewLayoutBenchmarkColMajor);
+    drawViewAndMeasure(bUseColMajor, (bUseColMajor) ? gViewLayoutBenchmarkColMajor : gViewLayoutBenchmarkRowMajor);
+    gViewLayoutBenchmarkNumFrames++;
+
+    if (gViewLayoutBenchmarkNumFrames < Config::gPerfCounterNumFramesToAverage)
+        return;
+
+    const double numFrames = (double) gViewLayoutBenchmarkNumFrames;
+    const ViewLayoutBenchmarkTotals& rowMajor = gViewLayoutBenchmarkRowMajor;
+    const ViewLayoutBenchmarkTotals& colMajor = gViewLayoutBenchmarkColMajor;
+    const double rowMajorUSec = (double) rowMajor.drawNs / numFrames / 1000.0;
+    const double colMajorUSec = (double) colMajor.drawNs / numFrames / 1000.0;
+
+    std::printf(
+        "View buffer layout benchmark (%ux scale, %ux%u view, %u frames avg): "
+        "row major %.1f usec, column major %.1f usec (transpose %.1f usec), column major speedup %.2fx\n",
+        (uint32_t) gScaleFactor,
+        g3dViewWidth,
+        g3dViewHeight,
+        gViewLayoutBenchmarkNumFrames,
+        rowMajorUSec,
+        colMajorUSec,
+        (double) colMajor.transposeNs / numFrames / 1000.0,
+        (colMajorUSec > 0.0) ? rowMajorUSec / colMajorUSec : 0.0
+    );
+
+    if (HardwareCounters::isAvailable()) {
+        std::printf(
+            "    Cache misses per frame (main thread): row major L1D %.0f LLC %.0f, column major L1D %.0f LLC %.0f\n",
+            (double) rowMajor.l1dReadMisses / numFrames,
+            (double) rowMajor.llcMisses / numFrames,
+            (double) colMajor.l1dReadMisses / numFrames,
+            (double) colMajor.llcMisses / numFrames
+        );
+    }
+
+    gViewLayoutBenchmarkRowMajor = {};
+    gViewLayoutBenchmarkColMajor = {};
+    gViewLayoutBenchmarkNumFrames = 0;
+}
+
 void drawPlayerView() noexcept {
+    PROFILE_SCOPE("drawPlayerView");
+
+    // Change the resolution the view is drawn at if needed, going by how long previous frames took to draw
+    if (Config::gbDynamicResolution) {
+        updateDynamicResolution();
+    }
+
+    const auto viewStartTime = std::chrono::steady_clock::now();
+
     preDrawSetup();                 // Init variables based on camera angle
     doBspTraversal();               // Traverse the BSP tree and build lists of walls, floors (visplanes) and sprites to render
-    drawAllSkyFragments();
-    drawAllFloorFragments();
-    drawAllCeilingFragments();
-    drawAllWallFragments();
-    drawAllSprites();
+
+    const uint32_t numCulledSprites = cullOccludedSprites();    // Remove sprites which are completely hidden behind walls
+
+    if (Profiler::gbCapturing) {
+        Profiler::setCounter("WallFragments", (int64_t) gWallFragments.size());
+        Profiler::setCounter("FloorFragments", (int64_t) gFloorFragments.size());
+        Profiler::setCounter("CeilFragments", (int64_t) gCeilFragments.size());
+        Profiler::setCounter("SkyFragments", (int64_t) gSkyFragments.size());
+        Profiler::setCounter("Sprites", (int64_t) gDrawSprites.size());
+        Profiler::setCounter("CulledSprites", (int64_t) numCulledSprites);
+        Profiler::setCounter("DrawSegCacheHits", (int64_t) getNumDrawSegCacheHits());
+    }
+
+    if (Config::gbBenchmarkFlatDrawModes) {
+        setupViewDrawTarget(false);
+        benchmarkFlatDrawModes();   // Draw floors and ceilings both as columns and as spans and compare the time taken
+    } else if (Config::gbDrawFlatsAsSpans) {
+        makeAllFlatSpans();         // Join up floor and ceiling columns into horizontal spans
+
+        if (Profiler::gbCapturing) {
+            Profiler::setCounter("FloorSpans", (int64_t) gFloorSpans.size());
+            Profiler::setCounter("CeilSpans", (int64_t) gCeilSpans.size());
+        }
+    }
+
+    if (Config::gbBenchmarkViewBufferLayouts) {
+        benchmarkViewBufferLayouts();   // Draw the view both directly and via a column major buffer and compare the time taken
+    } else {
+        drawView(Config::gbColumnMajorViewBuffer);
+    }
+
+    // Record how long the view took to draw at this resolution and stretch it to fill its area on screen if drawn at a lower resolution
+    if (Config::gbDynamicResolution) {
+        const auto viewEndTime = std::chrono::steady_clock::now();
+        recordDynamicResolutionDrawTime(
+            (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(viewEndTime - viewStartTime).count()
+        );
+    }
+
+    if (isViewLowRes()) {
+        upscaleView(gLowResViewBuffer.data());
+    }
+
     drawWeapons();                  // Draw the weapons on top of the screen
     doPostFx();                     // Draw color overlay if needed
 }
@@ -337,6 +695,10 @@ float LightParams::getLightMulForDist(const float dist) const noexcept {
     return std::max(lightMul, MIN_LIGHT_MUL);
 }
 
+DrawTarget getViewDrawTarget() noexcept {
+    return gViewDrawTarget;
+}
+
 LightParams getLightParams(const uint32_t sectorLightLevel) noexcept {
     const uint32_t lightMax = std::min(sectorLightLevel, (uint32_t) C_ARRAY_SIZE(gLightCoefs) - 1);
 
@@ -0,0 +1,181 @@
+#include "Renderer_Internal.h"
+
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
+#include "Base/Tables.h"
+#include "Blit.h"
+#include "Game/Config.h"
+#include <algorithm>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Code for drawing the fragments of the 3D view in parallel.
+//
+// Every sky, floor, ceiling and wall fragment only ever writes to the single screen column it belongs to, hence the 3D view can be
+// split up into vertical bands of screen columns which can be drawn independently of each other on different threads. Fragments are
+// binned into the band that contains them (preserving submission order) and each band then draws its fragments in exactly the same
+// order that the serial code path would. This means the output is identical to the serial path, regardless of the thread count.
+//
+// When drawing floors and ceilings as horizontal spans, the spans are split at band boundaries so that each band only draws the part
+// of the span that falls inside of it.
+//
+// Sprites are handled in the same way: occlusion info for sprites is also per screen column, so once all the sprites are sorted each
+// band draws just the columns of every sprite which fall inside of it, from back to front.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Renderer)
+
+// How many bands to split the view into per thread available.
+// Using more bands than threads helps balance the load, since some parts of the screen are much more expensive to draw than others.
+static constexpr uint32_t BANDS_PER_THREAD = 4;
+
+// The minimum width of a band in screen columns; making bands too thin just adds overhead
+static constexpr uint32_t MIN_BAND_WIDTH = 8;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Holds all of the fragments to be drawn for one vertical band of screen columns
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct DrawBand {
+    std::vector<SkyFragment>    skyFragments;
+    std::vector<FlatFragment>   floorFragments;
+    std::vector<FlatFragment>   ceilFragments;
+    std::vector<WallFragment>   wallFragments;
+    std::vector<FlatSpan>       floorSpans;
+    std::vector<FlatSpan>       ceilSpans;
+    SpriteClipCache             spriteClipCache;    // Used for sprite clipping by whichever thread draws the band
+
+    void clear() noexcept {
+        skyFragments.clear();
+        floorFragments.clear();
+        ceilFragments.clear();
+        wallFragments.clear();
+        floorSpans.clear();
+        ceilSpans.clear();
+    }
+};
+
+static std::vector<DrawBand>    gDrawBands;         // The bands that the view is currently split into
+static uint32_t                 gDrawBandWidth;     // How many screen columns each band covers (the last band may cover less)
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Decides how many bands to split the view up into and clears them for this frame
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void setupDrawBandsForFrame() noexcept {
+    const uint32_t viewW = g3dViewWidth;
+    const uint32_t maxNumBands = std::max((viewW + MIN_BAND_WIDTH - 1) / MIN_BAND_WIDTH, 1u);
+    const uint32_t wantedNumBands = std::clamp(JobSystem::getNumThreads() * BANDS_PER_THREAD, 1u, maxNumBands);
+
+    gDrawBandWidth = (viewW + wantedNumBands - 1) / wantedNumBands;
+    const uint32_t numBands = (viewW + gDrawBandWidth - 1) / gDrawBandWidth;
+
+    if (gDrawBands.size() != numBands) {
+        gDrawBands.resize(numBands);
+    }
+
+    for (DrawBand& band : gDrawBands) {
+        band.clear();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bins all fragments of a particular type into the band containing their screen column.
+// Fragments keep the same relative order within each band, which keeps the output the same as the serial path.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class FragT>
+static void binFragmentsIntoBands(const std::vector<FragT>& frags, std::vector<FragT> DrawBand::* const pBandFragsMember) noexcept {
+    const uint32_t bandWidth = gDrawBandWidth;
+    DrawBand* const pBands = gDrawBands.data();
+
+    for (const FragT& frag : frags) {
+        const uint32_t bandIdx = (uint32_t) frag.x / bandWidth;
+        BLIT_ASSERT(bandIdx < gDrawBands.size());
+        (pBands[bandIdx].*pBandFragsMember).push_back(frag);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bins floor or ceiling spans into the bands that they overlap, splitting them where they cross band boundaries
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void binFlatSpansIntoBands(const std::vector<FlatSpan>& spans, std::vector<FlatSpan> DrawBand::* const pBandSpansMember) noexcept {
+    const uint32_t bandWidth = gDrawBandWidth;
+    DrawBand* const pBands = gDrawBands.data();
+
+    for (const FlatSpan& span : spans) {
+        const uint32_t startBandIdx = (uint32_t) span.x1 / bandWidth;
+        const uint32_t endBandIdx = ((uint32_t) span.x2 - 1) / bandWidth;
+        BLIT_ASSERT(endBandIdx < gDrawBands.size());
+
+        for (uint32_t bandIdx = startBandIdx; bandIdx <= endBandIdx; ++bandIdx) {
+            const uint32_t bandStartX = bandIdx * bandWidth;
+            const uint32_t bandEndX = bandStartX + bandWidth;
+
+            FlatSpan& bandSpan = (pBands[bandIdx].*pBandSpansMember).emplace_back(span);
+            bandSpan.x1 = (uint16_t) std::max<uint32_t>(span.x1, bandStartX);
+            bandSpan.x2 = (uint16_t) std::min<uint32_t>(span.x2, bandEndX);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Job function which draws all of the fragments in one band.
+// Draws in the same order as 'drawPlayerView' does for the serial path: sky, floors, ceilings, walls and then sprites.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void drawBandJob(const uint32_t bandIdx, [[maybe_unused]] void* const pUserData) noexcept {
+    DrawBand& band = gDrawBands[bandIdx];
+    const DrawTarget target = getViewDrawTarget();
+
+    for (const SkyFragment& skyFrag : band.skyFragments) {
+        drawSkyFragment(skyFrag, target);
+    }
+
+    if (Config::gbDrawFlatsAsSpans) {
+        for (const FlatSpan& span : band.floorSpans) {
+            drawFloorSpan(span, target);
+        }
+
+        for (const FlatFragment& flatFrag : band.floorFragments) {
+            drawFloorFragmentClampedPixel(flatFrag, target);
+        }
+
+        for (const FlatSpan& span : band.ceilSpans) {
+            drawCeilingSpan(span, target);
+        }
+
+        for (const FlatFragment& flatFrag : band.ceilFragments) {
+            drawCeilingFragmentClampedPixel(flatFrag, target);
+        }
+    } else {
+        for (const FlatFragment& flatFrag : band.floorFragments) {
+            drawFloorFragment(flatFrag, target);
+        }
+
+        for (const FlatFragment& flatFrag : band.ceilFragments) {
+            drawCeilingFragment(flatFrag, target);
+        }
+    }
+
+    for (const WallFragment& wallFrag : band.wallFragments) {
+        drawWallFragment(wallFrag, target);
+    }
+
+    const uint32_t bandStartX = bandIdx * gDrawBandWidth;
+    const uint32_t bandEndX = std::min(bandStartX + gDrawBandWidth, g3dViewWidth);
+    drawSpritesInColumnRange(bandStartX, bandEndX, band.spriteClipCache, target);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws all sky, floor, ceiling and wall fragments and sprites for the frame using the job system, split up into vertical bands
+//------------------------------------------------------------------------------------------------------------------------------------------
+void drawAllFragmentsInBands() noexcept {
+    PROFILE_SCOPE("drawAllFragmentsInBands");
+
+    sortAllSprites();
+    setupDrawBandsForFrame();
+    binFragmentsIntoBands(gSkyFragments, &DrawBand::skyFragments);
+    binFragmentsIntoBands(gFloorFragments, &DrawBand::floorFragments);
+    binFragmentsIntoBands(gCeilFragments, &DrawBand::ceilFragments);
+    binFragmentsIntoBands(gWallFragments, &DrawBand::wallFragments);
+    binFlatSpansIntoBands(gFloorSpans, &DrawBand::floorSpans);
+    binFlatSpansIntoBands(gCeilSpans, &DrawBand::ceilSpans);
+    JobSystem::runJobs(drawBandJob, nullptr, (uint32_t) gDrawBands.size());
+}
+
+END_NAMESPACE(Renderer)
@@ -1,10 +1,18 @@
 #include "Renderer_Internal.h"
 
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
+#include "BlitSimd.h"
+#include "Game/Config.h"
 #include "Game/Data.h"
 #include "Map/MapData.h"
 #include "Map/MapUtil.h"
+#include "Map/Pvs.h"
 #include "Things/MapObj.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Module that handles traversing the BSP tree, so we can produce lists of things to draw.
@@ -30,7 +38,7 @@ static void addSectorSpritesToFrame(sector_t& sector) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Given a subsector pointer, pass all walls to the rendering engine. Also pass all the sprites.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void addSubsectorToFrame(subsector_t& sub) noexcept {
+static void addSubsectorToFrame(const subsector_t& sub) noexcept {
     sector_t& sector = *sub.sector;     // Get the front sector
     addSectorSpritesToFrame(sector);    // Prepare sprites for rendering
 
@@ -74,15 +82,51 @@ static inline void transformXYPointToClipSpace(vertexf_t& point) noexcept {
     point.x *= gProjMatrix.r0c0;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Result of checking the bounding box for a BSP node child against the view.
+// If the box is in view then this also holds the (conservative) range of screen columns that it covers.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct ChildBBoxVis {
+    bool        bVisible;
+    uint16_t    x1;
+    uint16_t    x2;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transform a clip space x coordinate to a screen x coordinate, the same way walls are
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline float clipSpaceXToScreenX(const float x, const float w, const float viewW) noexcept {
+    return (x / w * 0.5f + 0.5f) * viewW;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Save the range of screen columns that a visible bounding box covers, given the min and max screen x of its corners.
+// If any corners are behind the near plane then the whole screen width is used, since the projected corners can't be relied on.
+// The range is widened by a column on each side so that rounding differences with how walls are rasterized never matter.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void setBBoxColumnRange(ChildBBoxVis& vis, const bool bAnyPtBehind, const float minX, const float maxX) noexcept {
+    const int32_t maxCol = (int32_t) g3dViewWidth - 1;
+
+    if (bAnyPtBehind) {
+        vis.x1 = 0;
+        vis.x2 = (uint16_t) maxCol;
+    } else {
+        const float clampedMinX = std::clamp(minX, -1.0f, (float) g3dViewWidth);
+        const float clampedMaxX = std::clamp(maxX, -1.0f, (float) g3dViewWidth);
+        vis.x1 = (uint16_t) std::clamp((int32_t) std::floor(clampedMinX) - 1, 0, maxCol);
+        vis.x2 = (uint16_t) std::clamp((int32_t) std::ceil(clampedMaxX) + 1, 0, maxCol);
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Some basic rejection checks to see if we should process a BSP node.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool checkBBox(const Fixed bspcoord[BOXCOUNT]) noexcept {
-    // Get the float coords first
-    const float boxLx = fixed16ToFloat(bspcoord[BOXLEFT]);
-    const float boxRx = fixed16ToFloat(bspcoord[BOXRIGHT]);
-    const float boxTy = fixed16ToFloat(bspcoord[BOXTOP]);
-    const float boxBy = fixed16ToFloat(bspcoord[BOXBOTTOM]);
+static void checkBBox(const BspBBoxF& bbox, ChildBBoxVis& vis) noexcept {
+    // Get the box coords first
+    const float boxLx = bbox.coords[BOXLEFT];
+    const float boxRx = bbox.coords[BOXRIGHT];
+    const float boxTy = bbox.coords[BOXTOP];
+    const float boxBy = bbox.coords[BOXBOTTOM];
 
     // Makeup the 4 box points and transform to view space
     vertexf_t p1 = { boxLx, boxTy };
@@ -95,6 +139,8 @@ static bool checkBBox(const Fixed bspcoord[BOXCOUNT]) noexcept {
     transformXYPointToViewSpace(p4);
 
     // If all are behind the camera then we can ignore completely
+    vis.bVisible = false;
+
     const bool bAllPtsBehind = (
         (p1.y < Z_NEAR) &&
         (p2.y < Z_NEAR) &&
@@ -103,7 +149,7 @@ static bool checkBBox(const Fixed bspcoord[BOXCOUNT]) noexcept {
     );
 
     if (bAllPtsBehind)
-        return false;
+        return;
     
     // Transform to clip space and see if the box is offscreen to the left or right
     transformXYPointToClipSpace(p1);
@@ -121,7 +167,7 @@ static bool checkBBox(const Fixed bspcoord[BOXCOUNT]) noexcept {
     );
 
     if (bAllPtsToLeft)
-        return false;
+        return;
 
     const bool bAllPtsToRight = (
         (p1.x > p1.y) &&
@@ -131,38 +177,391 @@ static bool checkBBox(const Fixed bspcoord[BOXCOUNT]) noexcept {
     );
 
     if (bAllPtsToRight)
-        return false;
+        return;
 
     // If we get to here then the BSP node is in bounds, process it!
+    // Figure out which screen columns it covers too:
+    vis.bVisible = true;
+
+    const bool bAnyPtBehind = ((p1.y < Z_NEAR) || (p2.y < Z_NEAR) || (p3.y < Z_NEAR) || (p4.y < Z_NEAR));
+
+    if (bAnyPtBehind) {
+        setBBoxColumnRange(vis, true, 0.0f, 0.0f);
+    } else {
+        const float viewW = (float) g3dViewWidth - 0.5f;
+        const float sx1 = clipSpaceXToScreenX(p1.x, p1.y, viewW);
+        const float sx2 = clipSpaceXToScreenX(p2.x, p2.y, viewW);
+        const float sx3 = clipSpaceXToScreenX(p3.x, p3.y, viewW);
+        const float sx4 = clipSpaceXToScreenX(p4.x, p4.y, viewW);
+        setBBoxColumnRange(vis, false, std::min(std::min(sx1, sx2), std::min(sx3, sx4)), std::max(std::max(sx1, sx2), std::max(sx3, sx4)));
+    }
+}
+
+#if BLIT_SIMD_X86
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finishes off the check for a single box after its 4 corners have been tested against the view frustum planes with SIMD.
+// Takes the lane masks for the tests plus the screen x coordinate of each corner (only used if none are behind the near plane).
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void finishSimdBBoxCheck(
+    const uint32_t behindMask,
+    const uint32_t leftMask,
+    const uint32_t rightMask,
+    const float screenX[4],
+    ChildBBoxVis& vis
+) noexcept {
+    vis.bVisible = ((behindMask != 0xF) && (leftMask != 0xF) && (rightMask != 0xF));
+
+    if (vis.bVisible) {
+        const float minX = std::min(std::min(screenX[0], screenX[1]), std::min(screenX[2], screenX[3]));
+        const float maxX = std::max(std::max(screenX[0], screenX[1]), std::max(screenX[2], screenX[3]));
+        setBBoxColumnRange(vis, (behindMask != 0), minX, maxX);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// SSE2 version of 'checkBBox' which checks both child boxes of a node at once: 4 corners per vector, both boxes in the same pass.
+// Gives exactly the same results as 'checkBBox', since all operations are done in the same order with no fused multiply-adds.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void checkChildBBoxes_SSE2(const BspBBoxF bboxes[2], ChildBBoxVis vis[2]) noexcept {
+    const __m128 viewX = _mm_set1_ps(gViewX);
+    const __m128 viewY = _mm_set1_ps(gViewY);
+    const __m128 viewCos = _mm_set1_ps(gViewCos);
+    const __m128 viewSin = _mm_set1_ps(gViewSin);
+    const __m128 projX = _mm_set1_ps(gProjMatrix.r0c0);
+    const __m128 zNear = _mm_set1_ps(Z_NEAR);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 viewW = _mm_set1_ps((float) g3dViewWidth - 0.5f);
+
+    __m128 screenX[2];
+    uint32_t behindMask[2];
+    uint32_t leftMask[2];
+    uint32_t rightMask[2];
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        // The corners are in the same order as 'checkBBox': (left, top), (right, top), (right, bottom), (left, bottom)
+        const BspBBoxF& bbox = bboxes[i];
+        const __m128 ptX = _mm_setr_ps(bbox.coords[BOXLEFT], bbox.coords[BOXRIGHT], bbox.coords[BOXRIGHT], bbox.coords[BOXLEFT]);
+        const __m128 ptY = _mm_setr_ps(bbox.coords[BOXTOP], bbox.coords[BOXTOP], bbox.coords[BOXBOTTOM], bbox.coords[BOXBOTTOM]);
+
+        // Transform to view space and then clip space ('y' becomes 'w')
+        const __m128 relX = _mm_sub_ps(ptX, viewX);
+        const __m128 relY = _mm_sub_ps(ptY, viewY);
+        const __m128 rotX = _mm_sub_ps(_mm_mul_ps(viewCos, relX), _mm_mul_ps(viewSin, relY));
+        const __m128 w = _mm_add_ps(_mm_mul_ps(viewSin, relX), _mm_mul_ps(viewCos, relY));
+        const __m128 clipX = _mm_mul_ps(rotX, projX);
+
+        // Test against the near, left and right planes
+        behindMask[i] = (uint32_t) _mm_movemask_ps(_mm_cmplt_ps(w, zNear));
+        leftMask[i] = (uint32_t) _mm_movemask_ps(_mm_cmplt_ps(clipX, _mm_xor_ps(w, signBit)));
+        rightMask[i] = (uint32_t) _mm_movemask_ps(_mm_cmpgt_ps(clipX, w));
+        screenX[i] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(clipX, w), half), half), viewW);
+    }
+
+    alignas(16) float screenXf[2][4];
+    _mm_store_ps(screenXf[0], screenX[0]);
+    _mm_store_ps(screenXf[1], screenX[1]);
+
+    finishSimdBBoxCheck(behindMask[0], leftMask[0], rightMask[0], screenXf[0], vis[0]);
+    finishSimdBBoxCheck(behindMask[1], leftMask[1], rightMask[1], screenXf[1], vis[1]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 version of 'checkBBox' which checks both child boxes of a node at once: all 8 corners in a single vector.
+// Gives exactly the same results as 'checkBBox', since all operations are done in the same order with no fused multiply-adds.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BLIT_SIMD_AVX2_FUNC static void checkChildBBoxes_AVX2(const BspBBoxF bboxes[2], ChildBBoxVis vis[2]) noexcept {
+    const __m256 viewX = _mm256_set1_ps(gViewX);
+    const __m256 viewY = _mm256_set1_ps(gViewY);
+    const __m256 viewCos = _mm256_set1_ps(gViewCos);
+    const __m256 viewSin = _mm256_set1_ps(gViewSin);
+    const __m256 projX = _mm256_set1_ps(gProjMatrix.r0c0);
+    const __m256 zNear = _mm256_set1_ps(Z_NEAR);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 viewW = _mm256_set1_ps((float) g3dViewWidth - 0.5f);
+
+    // The corners of each box are in the same order as 'checkBBox': (left, top), (right, top), (right, bottom), (left, bottom)
+    const BspBBoxF& bbox1 = bboxes[0];
+    const BspBBoxF& bbox2 = bboxes[1];
+
+    const __m256 ptX = _mm256_setr_ps(
+        bbox1.coords[BOXLEFT], bbox1.coords[BOXRIGHT], bbox1.coords[BOXRIGHT], bbox1.coords[BOXLEFT],
+        bbox2.coords[BOXLEFT], bbox2.coords[BOXRIGHT], bbox2.coords[BOXRIGHT], bbox2.coords[BOXLEFT]
+    );
+
+    const __m256 ptY = _mm256_setr_ps(
+        bbox1.coords[BOXTOP], bbox1.coords[BOXTOP], bbox1.coords[BOXBOTTOM], bbox1.coords[BOXBOTTOM],
+        bbox2.coords[BOXTOP], bbox2.coords[BOXTOP], bbox2.coords[BOXBOTTOM], bbox2.coords[BOXBOTTOM]
+    );
+
+    // Transform to view space and then clip space ('y' becomes 'w')
+    const __m256 relX = _mm256_sub_ps(ptX, viewX);
+    const __m256 relY = _mm256_sub_ps(ptY, viewY);
+    const __m256 rotX = _mm256_sub_ps(_mm256_mul_ps(viewCos, relX), _mm256_mul_ps(viewSin, relY));
+    const __m256 w = _mm256_add_ps(_mm256_mul_ps(viewSin, relX), _mm256_mul_ps(viewCos, relY));
+    const __m256 clipX = _mm256_mul_ps(rotX, projX);
+
+    // Test against the near, left and right planes: the low 4 bits of each mask are for the 1st box, the high 4 bits for the 2nd
+    const uint32_t behindMask = (uint32_t) _mm256_movemask_ps(_mm256_cmp_ps(w, zNear, _CMP_LT_OQ));
+    const uint32_t leftMask = (uint32_t) _mm256_movemask_ps(_mm256_cmp_ps(clipX, _mm256_xor_ps(w, signBit), _CMP_LT_OQ));
+    const uint32_t rightMask = (uint32_t) _mm256_movemask_ps(_mm256_cmp_ps(clipX, w, _CMP_GT_OQ));
+    const __m256 screenX = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(clipX, w), half), half), viewW);
+
+    alignas(32) float screenXf[8];
+    _mm256_store_ps(screenXf, screenX);
+
+    finishSimdBBoxCheck(behindMask & 0xF, leftMask & 0xF, rightMask & 0xF, screenXf, vis[0]);
+    finishSimdBBoxCheck(behindMask >> 4, leftMask >> 4, rightMask >> 4, screenXf + 4, vis[1]);
+}
+#endif  // #if BLIT_SIMD_X86
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Checks the bounding boxes of both children of a BSP node against the view, with SIMD if allowed
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void checkChildBBoxes(
+    const BspBBoxF bboxes[2],
+    ChildBBoxVis vis[2],
+    [[maybe_unused]] const BlitSimd::InstructionSet simdInstructionSet
+) noexcept {
+    #if BLIT_SIMD_X86
+        if (simdInstructionSet == BlitSimd::InstructionSet::AVX2) {
+            checkChildBBoxes_AVX2(bboxes, vis);
+            return;
+        } else if (simdInstructionSet == BlitSimd::InstructionSet::SSE2) {
+            checkChildBBoxes_SSE2(bboxes, vis);
+            return;
+        }
+    #endif
+
+    checkBBox(bboxes[0], vis[0]);
+    checkBBox(bboxes[1], vis[1]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if every screen column in the given range is already fully filled by segs, in which case nothing behind can be seen there
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool areSegColumnsFull(const uint32_t x1, const uint32_t x2) noexcept {
+    // Quick early out: no columns are full yet
+    if (gNumFullSegCols == 0)
+        return false;
+
+    const SegClip* const pSegClip = gSegClip.data();
+    ASSERT(x2 < gSegClip.size());
+
+    for (uint32_t x = x1; x <= x2; ++x) {
+        if (pSegClip[x].top < pSegClip[x].bottom)
+            return false;
+    }
+
     return true;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Traverse the BSP tree starting from a tree node (Or sector) and recursively subdivide if needed.
+// Traverse the flattened BSP tree front to back from the root, adding all subsectors which might be visible to the frame.
 // Use a cross product from the line cast from the viewxy to the bspxy and the bsp line itself.
+//
+// This visits nodes in the same order as the original recursive traversal: follow the side closer to the view point first and afterwards
+// visit the other side, if its bounding box is in view. Instead of recursing, the far side of each node passed through is pushed onto a
+// small fixed size stack. Both child boxes of each node are checked against the view frustum together when the node is reached, which
+// also culls the near side if it is out of view. When a far side is popped its columns are checked against the seg clip bounds, and if
+// everything it covers has been filled by the near side already then the whole of it is skipped. Parts of the tree which the potentially
+// visible set for the map says can't be seen from the view point are skipped too.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void addBspNodeToFrame(node_t* const pNode) noexcept {
-    // Is this node actual pointing to a sub sector?
-    if (isBspNodeASubSector(pNode)) {
-        // Process the sub sector.
-        // N.B: Need to fix up the pointer as well due to the lowest bit set as a flag!
-        subsector_t* const pSubSector = (subsector_t*) getActualBspNodePtr(pNode);
-        addSubsectorToFrame(*pSubSector);
-        return;
+static void addBspTreeToFrame() noexcept {
+    // Far side of a node still to be visited, along with the range of screen columns it covers
+    struct BackSide {
+        uint32_t    child;
+        uint16_t    x1;
+        uint16_t    x2;
+    };
+
+    const vector_t* const pLines = gpBspLines;
+    const uint32_t* const pChildren = gpBspChildren;
+    const BspBBoxF* const pChildBBoxes = gpBspChildBBoxes;
+    const BlitSimd::InstructionSet simdInstructionSet = BlitSimd::getInstructionSet();
+
+    Pvs::BspVisibility pvsVisibility;
+    const bool bUsePvs = Pvs::getBspVisibility(gViewXFrac, gViewYFrac, pvsVisibility);
+
+    BackSide backSides[BSP_MAX_DEPTH];
+    uint32_t numBackSides = 0;
+    uint32_t child = gBspRootChild;
+
+    while (true) {
+        // Go down the sides closer to me until a subsector is reached, remembering the far sides which are in view for later
+        bool bReachedSubsector = true;
+
+        while ((child & BSP_CHILD_SUBSECTOR) == 0) {
+            // If we have filled the screen then don't go any further down this part of the tree
+            if (gNumFullSegCols >= g3dViewWidth) {
+                bReachedSubsector = false;
+                break;
+            }
+
+            // Decide which side the view point is on and check if both sides are in view
+            const uint32_t side = PointOnVectorSide(gViewXFrac, gViewYFrac, pLines[child]);
+            ChildBBoxVis childVis[2];
+            checkChildBBoxes(pChildBBoxes + child * 2, childVis, simdInstructionSet);
+
+            const uint32_t frontChild = pChildren[child * 2 + side];
+            const uint32_t backChild = pChildren[child * 2 + (side ^ 1)];
+            const ChildBBoxVis& backVis = childVis[side ^ 1];
+
+            if (backVis.bVisible && ((!bUsePvs) || Pvs::isBspChildVisible(pvsVisibility, backChild))) {
+                ASSERT(numBackSides < BSP_MAX_DEPTH);
+                backSides[numBackSides++] = BackSide{ backChild, backVis.x1, backVis.x2 };
+            }
+
+            if ((!childVis[side].bVisible) || (bUsePvs && (!Pvs::isBspChildVisible(pvsVisibility, frontChild)))) {
+                bReachedSubsector = false;
+                break;
+            }
+
+            child = frontChild;
+        }
+
+        if (bReachedSubsector) {
+            addSubsectorToFrame(gpSubSectors[child & ~BSP_CHILD_SUBSECTOR]);
+        }
+
+        // Render the next far side which isn't already hidden, if any
+        const BackSide* pBackSide;
+
+        do {
+            if (numBackSides == 0)
+                return;
+
+            pBackSide = &backSides[--numBackSides];
+        } while (areSegColumnsFull(pBackSide->x1, pBackSide->x2));
+
+        child = pBackSide->child;
     }
-    
-    // If we have filled the screen then exit now - don't traverse the BSP any further
-    if (gNumFullSegCols >= g3dViewWidth)
-        return;
-    
-    // Decide which side the view point is on
-    uint32_t side = PointOnVectorSide(gViewXFrac, gViewYFrac, pNode->Line);     // Is this the front side?
-    addBspNodeToFrame((node_t*) pNode->Children[side]);                         // Process the side closer to me
-    side ^= 1;                                                                  // Swap the side
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Benchmarking for the flattened BSP tree traversal against the original recursive traversal of 'node_t' pointers.
+//
+// Every frame the traversals are run from the current view, one after the other, doing only the work which depends on the BSP tree
+// layout and the culling method: the side checks, bounding box checks and the stack or recursion. The flattened tree is walked twice,
+// with both child boxes of each node checked using plain scalar code and then using SIMD. Nothing is added to the frame and the seg
+// clip based early outs are not applied, so all of the tree that is in the view frustum is walked. The number of subsectors reached by
+// each method is compared to make sure they all walk the same tree. The averaged timings are printed every so often.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint64_t     gBspBenchmarkRecursiveNs;
+static uint64_t     gBspBenchmarkFlatNs;
+static uint64_t     gBspBenchmarkFlatSimdNs;
+static uint32_t     gBspBenchmarkNumFrames;
+static uint32_t     gBspBenchmarkNumSubsectors;
+static uint32_t     gBspBenchmarkNumMismatches;
+
+static bool checkBBoxFixed(const Fixed bspcoord[BOXCOUNT]) noexcept {
+    BspBBoxF bbox;
 
-    if (checkBBox(pNode->bbox[side])) {                         // Is the viewing rect on both sides?
-        addBspNodeToFrame((node_t*) pNode->Children[side]);     // Render the back side
+    for (uint32_t coordIdx = 0; coordIdx < BOXCOUNT; ++coordIdx) {
+        bbox.coords[coordIdx] = fixed16ToFloat(bspcoord[coordIdx]);
     }
+
+    ChildBBoxVis vis;
+    checkBBox(bbox, vis);
+    return vis.bVisible;
+}
+
+static uint32_t cullBspNodeRecursive(const node_t* const pNode) noexcept {
+    if (isBspNodeASubSector(pNode))
+        return 1;
+
+    const uint32_t side = PointOnVectorSide(gViewXFrac, gViewYFrac, pNode->Line);
+    uint32_t numSubsectors = cullBspNodeRecursive((const node_t*) pNode->Children[side]);
+
+    if (checkBBoxFixed(pNode->bbox[side ^ 1])) {
+        numSubsectors += cullBspNodeRecursive((const node_t*) pNode->Children[side ^ 1]);
+    }
+
+    return numSubsectors;
+}
+
+static uint32_t cullBspTreeFlat(const BlitSimd::InstructionSet simdInstructionSet) noexcept {
+    const vector_t* const pLines = gpBspLines;
+    const uint32_t* const pChildren = gpBspChildren;
+    const BspBBoxF* const pChildBBoxes = gpBspChildBBoxes;
+
+    uint32_t backSides[BSP_MAX_DEPTH];
+    uint32_t numBackSides = 0;
+    uint32_t child = gBspRootChild;
+    uint32_t numSubsectors = 0;
+
+    while (true) {
+        // Note: the near side is never culled here, to walk the same tree as the recursive version
+        while ((child & BSP_CHILD_SUBSECTOR) == 0) {
+            const uint32_t side = PointOnVectorSide(gViewXFrac, gViewYFrac, pLines[child]);
+            ChildBBoxVis childVis[2];
+            checkChildBBoxes(pChildBBoxes + child * 2, childVis, simdInstructionSet);
+
+            if (childVis[side ^ 1].bVisible) {
+                backSides[numBackSides++] = pChildren[child * 2 + (side ^ 1)];
+            }
+
+            child = pChildren[child * 2 + side];
+        }
+
+        ++numSubsectors;
+
+        if (numBackSides == 0)
+            return numSubsectors;
+
+        child = backSides[--numBackSides];
+    }
+}
+
+static uint64_t getElapsedNs(
+    const std::chrono::steady_clock::time_point startTime,
+    const std::chrono::steady_clock::time_point endTime
+) noexcept {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+}
+
+static void benchmarkBspTraversal() noexcept {
+    const auto startTime = std::chrono::steady_clock::now();
+    const uint32_t numSubsectorsRecursive = cullBspNodeRecursive(gpBSPTreeRoot);
+    const auto recursiveEndTime = std::chrono::steady_clock::now();
+    const uint32_t numSubsectorsFlat = cullBspTreeFlat(BlitSimd::InstructionSet::NONE);
+    const auto flatEndTime = std::chrono::steady_clock::now();
+    const uint32_t numSubsectorsFlatSimd = cullBspTreeFlat(BlitSimd::getInstructionSet());
+    const auto endTime = std::chrono::steady_clock::now();
+
+    gBspBenchmarkRecursiveNs += getElapsedNs(startTime, recursiveEndTime);
+    gBspBenchmarkFlatNs += getElapsedNs(recursiveEndTime, flatEndTime);
+    gBspBenchmarkFlatSimdNs += getElapsedNs(flatEndTime, endTime);
+    gBspBenchmarkNumSubsectors += numSubsectorsFlat;
+    gBspBenchmarkNumMismatches += ((numSubsectorsRecursive != numSubsectorsFlat) || (numSubsectorsFlat != numSubsectorsFlatSimd)) ? 1 : 0;
+    gBspBenchmarkNumFrames++;
+
+    if (gBspBenchmarkNumFrames < Config::gPerfCounterNumFramesToAverage)
+        return;
+
+    const double recursiveUSec = (double) gBspBenchmarkRecursiveNs / (double) gBspBenchmarkNumFrames / 1000.0;
+    const double flatUSec = (double) gBspBenchmarkFlatNs / (double) gBspBenchmarkNumFrames / 1000.0;
+    const double flatSimdUSec = (double) gBspBenchmarkFlatSimdNs / (double) gBspBenchmarkNumFrames / 1000.0;
+    std::printf(
+        "BSP traversal benchmark (%u nodes, %u frames avg): %u subsectors, recursive %.1f usec, flat %.1f usec, flat SIMD cull %.1f usec, "
+        "flat SIMD speedup %.2fx%s\n",
+        gNumBspNodes,
+        gBspBenchmarkNumFrames,
+        gBspBenchmarkNumSubsectors / gBspBenchmarkNumFrames,
+        recursiveUSec,
+        flatUSec,
+        flatSimdUSec,
+        (flatSimdUSec > 0.0) ? recursiveUSec / flatSimdUSec : 0.0,
+        (gBspBenchmarkNumMismatches > 0) ? " (MISMATCHED SUBSECTOR COUNTS!)" : ""
+    );
+
+    gBspBenchmarkRecursiveNs = 0;
+    gBspBenchmarkFlatNs = 0;
+    gBspBenchmarkFlatSimdNs = 0;
+    gBspBenchmarkNumFrames = 0;
+    gBspBenchmarkNumSubsectors = 0;
+    gBspBenchmarkNumMismatches = 0;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -170,8 +569,14 @@ static void addBspNodeToFrame(node_t* const pNode) noexcept {
 // screen by placing fake posts on the farthest left and right sides in solidsegs 0 and 1.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void doBspTraversal() noexcept {
-    ++gValidCount;                          // For sprite recursion
-    addBspNodeToFrame(gpBSPTreeRoot);       // Begin traversing the BSP tree for all walls in render range
+    PROFILE_SCOPE("doBspTraversal");
+
+    if (Config::gbBenchmarkBspTraversal) {
+        benchmarkBspTraversal();    // Time the flattened tree traversal against the original recursive one, for the same view
+    }
+
+    ++gValidCount;          // For sprite recursion
+    addBspTreeToFrame();    // Begin traversing the BSP tree for all walls in render range
 }
 
 END_NAMESPACE(Renderer)
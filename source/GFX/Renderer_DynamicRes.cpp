@@ -0,0 +1,196 @@
+#include "Renderer_Internal.h"
+
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
+#include "Base/Tables.h"
+#include "Game/Config.h"
+#include "Video.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Dynamic resolution for the 3D view.
+//
+// The time taken to draw the 3D view is measured every frame and the resolution it is drawn at is adjusted between frames, in order to
+// keep that time close to a target budget. When the view is drawn at less than full resolution it goes to a separate buffer first,
+// which is then stretched (nearest neighbour) to fill the area of the view on screen, before the player's weapon and the post effects
+// are drawn on top at full resolution.
+//
+// Notes:
+//  (1) The resolution scale moves in fixed steps, and the draw time is averaged over several frames. To avoid flip-flopping between
+//      two steps there is a band around the target where nothing changes, and after each change the new scale is left alone for a
+//      few frames while the average time catches up.
+//  (2) The cost of drawing the view is assumed to be proportional to the number of pixels. This is used to jump straight to about the
+//      right scale when going over budget, and to only increase the scale when the next step up is predicted to fit in the budget.
+//      Going down can be several steps at once, but going back up is always done one step at a time.
+//  (3) All of the per screen column arrays are sized for the full resolution view, so changing the scale never reallocates memory.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Renderer)
+
+// The resolution scale is always a whole number of these steps
+static constexpr uint32_t NUM_SCALE_STEPS = 16;
+
+// How much weight a new frame's draw time gets in the running average
+static constexpr double DRAW_TIME_AVG_WEIGHT = 0.125;
+
+// Only decrease the scale when over this fraction of the target and only increase it when under this fraction of the target
+static constexpr double DECREASE_SCALE_THRESHOLD = 1.1;
+static constexpr double INCREASE_SCALE_THRESHOLD = 0.8;
+
+// When increasing the scale, the predicted draw time at the new scale must be within this fraction of the target
+static constexpr double INCREASE_SCALE_MAX_PREDICTED = 0.95;
+
+// How many frames to leave the scale alone for after changing it
+static constexpr uint32_t MIN_FRAMES_BETWEEN_SCALE_CHANGES = 8;
+
+// Don't bother splitting up the upscale any finer than this
+static constexpr uint32_t MIN_PIXELS_PER_UPSCALE_JOB = 64 * 1024;
+
+static uint32_t     gScaleSteps = NUM_SCALE_STEPS;      // The current resolution scale, in steps
+static double       gAvgDrawTimeMs;                     // Running average of the time taken to draw the view
+static bool         gbHaveDrawTime;                     // Has any draw time been recorded yet?
+static uint32_t     gNumFramesSinceScaleChange;         // How many draw times have been recorded since the scale last changed
+
+// For each column of the view on screen, which column of the low resolution view it comes from.
+// Rebuilt whenever the width of either changes.
+static std::vector<uint32_t>    gUpscaleSrcXs;
+static uint32_t                 gUpscaleSrcWidth;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Work to be done for upscaling the view, split into bands of rows
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct UpscaleJobs {
+    const uint32_t*     pSrcPixels;     // The low resolution view, row major
+    uint32_t*           pDstPixels;     // The top left of the view in the framebuffer
+    uint32_t            rowsPerJob;     // How many rows of the view on screen each job does
+};
+
+static void upscaleViewJob(const uint32_t jobIdx, void* const pUserData) noexcept {
+    const UpscaleJobs& jobs = *(const UpscaleJobs*) pUserData;
+    const uint32_t srcW = g3dViewWidth;
+    const uint32_t srcH = g3dViewHeight;
+    const uint32_t dstW = g3dViewScreenWidth;
+    const uint32_t dstH = g3dViewScreenHeight;
+    const uint32_t dstPitch = Video::gScreenWidth;
+    const uint32_t* const pSrcXs = gUpscaleSrcXs.data();
+
+    const uint32_t startY = jobIdx * jobs.rowsPerJob;
+    const uint32_t endY = std::min(startY + jobs.rowsPerJob, dstH);
+    uint32_t prevSrcY = UINT32_MAX;
+
+    for (uint32_t y = startY; y < endY; ++y) {
+        // Sample from the center of each pixel, the same as for the columns
+        const uint32_t srcY = (uint32_t)(((uint64_t) y * 2 + 1) * srcH / ((uint64_t) dstH * 2));
+        uint32_t* const pDstRow = jobs.pDstPixels + (size_t) y * dstPitch;
+
+        // Rows which come from the same source row as the last one are just a copy of it
+        if (srcY == prevSrcY) {
+            std::memcpy(pDstRow, pDstRow - dstPitch, dstW * sizeof(uint32_t));
+            continue;
+        }
+
+        const uint32_t* const pSrcRow = jobs.pSrcPixels + (size_t) srcY * srcW;
+
+        for (uint32_t x = 0; x < dstW; ++x) {
+            pDstRow[x] = pSrcRow[pSrcXs[x]];
+        }
+
+        prevSrcY = srcY;
+    }
+}
+
+void updateDynamicResolution() noexcept {
+    const uint32_t minScaleSteps = std::clamp(
+        (uint32_t) std::ceil(Config::gDynamicResolutionMinScale * (float) NUM_SCALE_STEPS),
+        1u,
+        NUM_SCALE_STEPS
+    );
+
+    // Decide on the new scale, if it's time to change it
+    uint32_t newScaleSteps = std::max(gScaleSteps, minScaleSteps);
+
+    if (gbHaveDrawTime && (gNumFramesSinceScaleChange >= MIN_FRAMES_BETWEEN_SCALE_CHANGES)) {
+        const double targetMs = Config::gDynamicResolutionTargetMs;
+        const double avgMs = gAvgDrawTimeMs;
+
+        if ((avgMs > targetMs * DECREASE_SCALE_THRESHOLD) && (gScaleSteps > minScaleSteps)) {
+            // Over budget: go to the scale which is predicted to fit the budget, which is always at least one step down
+            const double wantedScaleSteps = (double) gScaleSteps * std::sqrt(targetMs / avgMs);
+            newScaleSteps = std::clamp((uint32_t) wantedScaleSteps, minScaleSteps, gScaleSteps - 1);
+        }
+        else if ((avgMs < targetMs * INCREASE_SCALE_THRESHOLD) && (gScaleSteps < NUM_SCALE_STEPS)) {
+            // Under budget: go up one step, but only if that is predicted to stay within the budget
+            const double areaRatio = (double)((gScaleSteps + 1) * (gScaleSteps + 1)) / (double)(gScaleSteps * gScaleSteps);
+
+            if (avgMs * areaRatio <= targetMs * INCREASE_SCALE_MAX_PREDICTED) {
+                newScaleSteps = gScaleSteps + 1;
+            }
+        }
+    }
+
+    // Apply the new scale if it changed. Predict the new average draw time so that it doesn't start over from nothing.
+    if (newScaleSteps != gScaleSteps) {
+        const double areaRatio = (double)(newScaleSteps * newScaleSteps) / (double)(gScaleSteps * gScaleSteps);
+        gAvgDrawTimeMs *= areaRatio;
+        gNumFramesSinceScaleChange = 0;
+        gScaleSteps = newScaleSteps;
+    }
+
+    const float scale = (float) gScaleSteps / (float) NUM_SCALE_STEPS;
+
+    if (scale != gViewRenderScale) {
+        setViewRenderScale(scale);
+    }
+
+    if (Profiler::gbCapturing) {
+        Profiler::setCounter("DynamicResScalePct", (int64_t)(gScaleSteps * 100 / NUM_SCALE_STEPS));
+    }
+}
+
+void recordDynamicResolutionDrawTime(const uint64_t drawTimeNs) noexcept {
+    const double drawTimeMs = (double) drawTimeNs / 1000000.0;
+
+    if (gbHaveDrawTime) {
+        gAvgDrawTimeMs += (drawTimeMs - gAvgDrawTimeMs) * DRAW_TIME_AVG_WEIGHT;
+    } else {
+        gAvgDrawTimeMs = drawTimeMs;
+        gbHaveDrawTime = true;
+    }
+
+    gNumFramesSinceScaleChange++;
+}
+
+void upscaleView(const uint32_t* const pSrcPixels) noexcept {
+    PROFILE_SCOPE("upscaleView");
+    ASSERT(pSrcPixels);
+    ASSERT((g3dViewWidth <= g3dViewScreenWidth) && (g3dViewHeight <= g3dViewScreenHeight));
+
+    // Figure out which source column each column on screen comes from, sampling from the center of each pixel
+    const uint32_t srcW = g3dViewWidth;
+    const uint32_t dstW = g3dViewScreenWidth;
+
+    if ((gUpscaleSrcXs.size() != dstW) || (gUpscaleSrcWidth != srcW)) {
+        gUpscaleSrcXs.resize(dstW);
+        gUpscaleSrcWidth = srcW;
+
+        for (uint32_t x = 0; x < dstW; ++x) {
+            gUpscaleSrcXs[x] = (uint32_t)(((uint64_t) x * 2 + 1) * srcW / ((uint64_t) dstW * 2));
+        }
+    }
+
+    // Split the rows up amongst the available threads, if the view is big enough to make that worthwhile
+    const uint32_t dstH = g3dViewScreenHeight;
+    const uint32_t maxJobs = std::max((dstW * dstH) / MIN_PIXELS_PER_UPSCALE_JOB, 1u);
+    const uint32_t numJobsWanted = std::min(JobSystem::getNumThreads(), maxJobs);
+
+    UpscaleJobs jobs = {};
+    jobs.pSrcPixels = pSrcPixels;
+    jobs.pDstPixels = Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset;
+    jobs.rowsPerJob = (dstH + numJobsWanted - 1) / numJobsWanted;
+
+    const uint32_t numJobs = (dstH + jobs.rowsPerJob - 1) / jobs.rowsPerJob;
+    JobSystem::runJobs(upscaleViewJob, &jobs, numJobs);
+}
+
+END_NAMESPACE(Renderer)
@@ -1,9 +1,12 @@
 #include "Renderer_Internal.h"
 
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
 #include "Blit.h"
+#include "BlitSimd.h"
 #include "Textures.h"
-#include "Video.h"
+#include <algorithm>
+#include <functional>
 
 BEGIN_NAMESPACE(Renderer)
 
@@ -16,21 +19,10 @@ enum class DrawFlatMode {
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Does the intersection of a ray against a floor or ceiling plane
+// Gives the time at which a ray intersects a floor or ceiling plane
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawFlatMode MODE>
-static inline void doRayFlatPlaneIntersection(
-    const float flatPlaneZ,
-    const float rayOriginX,
-    const float rayOriginY,
-    const float rayOriginZ,
-    const float rayDirX,
-    const float rayDirY,
-    const float rayDirZ,
-    float& intersectX,
-    float& intersectY,
-    float& intersectZ
-) noexcept {
+static inline float getRayFlatPlaneIntersectT(const float flatPlaneZ, const float rayOriginZ, const float rayDirZ) noexcept {
     // Calculate first: AXd + BYd + CZd
     // I.E - The dot product of the plane normal (0, 0, 1) or (0, 0, -1) with the ray direction:
     float divisor;
@@ -53,7 +45,26 @@ static inline void doRayFlatPlaneIntersection(
     }
 
     // Compute the ray intersection time: -(AX0 + BY0 + CZ0 + D) / (AXd + BYd + CZd)
-    const float intersectT = -dividend / divisor;
+    return -dividend / divisor;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does the intersection of a ray against a floor or ceiling plane
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawFlatMode MODE>
+static inline void doRayFlatPlaneIntersection(
+    const float flatPlaneZ,
+    const float rayOriginX,
+    const float rayOriginY,
+    const float rayOriginZ,
+    const float rayDirX,
+    const float rayDirY,
+    const float rayDirZ,
+    float& intersectX,
+    float& intersectY,
+    float& intersectZ
+) noexcept {
+    const float intersectT = getRayFlatPlaneIntersectT<MODE>(flatPlaneZ, rayOriginZ, rayDirZ);
 
     // Using the intersect time, compute the world intersect point
     intersectX = rayOriginX + rayDirX * intersectT;
@@ -61,26 +72,455 @@ static inline void doRayFlatPlaneIntersection(
     intersectZ = rayOriginZ + rayDirZ * intersectT;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Values that are constant for every pixel in a column or span of a flat.
+// Note: the near plane and ray direction values are only used when drawing columns.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct FlatDrawParams {
+    float               viewX;              // Camera position
+    float               viewY;
+    float               viewZ;
+    float               flatPlaneZ;         // Height of the floor or ceiling plane
+    float               nearPlaneTz;        // Near plane top z and the z step per pixel going down the screen
+    float               nearPlaneZStep;
+    float               rayDirX;            // XY direction of the ray going from the view through the screen column
+    float               rayDirY;
+    LightParams         lightParams;        // Light parameters for the flat
+    const uint16_t*     pSrcPixels;         // The 64x64 flat texture
+    uint32_t            dstPitch;           // Distance between pixels going down a column in the output image
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a single pixel of a flat using the given point of intersection with the flat plane
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline void drawFlatPixel(
+    const FlatDrawParams& params,
+    const float intersectX,
+    const float intersectY,
+    const float intersectZ,
+    uint32_t* const pDstPixel
+) noexcept {
+    // Get the source pixel (ARGB1555 format).
+    // Note that the flat texture is always expected to be 64x64, hence we can wraparound with a simple bitwise AND:
+    const uint32_t curSrcXInt = (uint32_t) intersectX & 63;
+    const uint32_t curSrcYInt = (uint32_t) intersectY & 63;
+    const uint16_t srcPixelARGB1555 = params.pSrcPixels[curSrcYInt * 64 + curSrcXInt];
+
+    // Extract RGB components and shift such that the maximum value is 255 instead of 31.
+    const uint16_t texR = (uint16_t)((srcPixelARGB1555 & uint16_t(0b0111110000000000)) >> 7);
+    const uint16_t texG = (uint16_t)((srcPixelARGB1555 & uint16_t(0b0000001111100000)) >> 2);
+    const uint16_t texB = (uint16_t)((srcPixelARGB1555 & uint16_t(0b0000000000011111)) << 3);
+
+    // Get the distance to the view point and light multiplier for that distance
+    const float distToView = FMath::distance3d(intersectX, intersectY, intersectZ, params.viewX, params.viewY, params.viewZ);
+    const float lightMul = params.lightParams.getLightMulForDist(distToView);
+
+    // Get the texture colors in 0-255 float format.
+    // Note that if we are not doing any color multiply these conversions would be redundant, but I'm guessing
+    // that the compiler would be smart enough to optimize out the useless operations in those cases (hopefully)!
+    const float r = std::min((float) texR * lightMul, 255.0f);
+    const float g = std::min((float) texG * lightMul, 255.0f);
+    const float b = std::min((float) texB * lightMul, 255.0f);
+
+    // Write out the pixel value
+    *pDstPixel = (
+        (uint32_t(r) << 16) |
+        (uint32_t(g) << 8) |
+        (uint32_t(b))
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws a single pixel of a flat at the given screen y coordinate, doing a ray/plane intersection to find the texture coordinate
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawFlatMode MODE>
+static inline void drawFlatPixelAtY(const FlatDrawParams& params, const int32_t dstY, uint32_t* const pDstPixel) noexcept {
+    // Note: take the vertical center position of the pixel to improve accuracy, hence + 0.5 here!
+    const float nearPlaneZ = params.nearPlaneTz + params.nearPlaneZStep * ((float) dstY + 0.5f);
+    const float rayDirZ = nearPlaneZ - params.viewZ;
+
+    float intersectX;
+    float intersectY;
+    float intersectZ;
+
+    doRayFlatPlaneIntersection<MODE>(
+        params.flatPlaneZ,
+        params.viewX,
+        params.viewY,
+        params.viewZ,
+        params.rayDirX,
+        params.rayDirY,
+        rayDirZ,
+        intersectX,
+        intersectY,
+        intersectZ
+    );
+
+    drawFlatPixel(params, intersectX, intersectY, intersectZ, pDstPixel);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Values that are constant for every pixel in a single row of a flat span.
+// The ray/plane intersection time is the same for every pixel in the row, so the intersection point steps by a constant amount.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct FlatSpanRowParams {
+    float   intersectX;         // Intersection point for the first pixel in the span
+    float   intersectY;
+    float   intersectZ;         // Note: the same for every pixel in the span
+    float   intersectXStep;     // How much the intersection point moves for each pixel in the span
+    float   intersectYStep;
+};
+
+#if BLIT_SIMD_X86
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Fetches the flat texels (ARGB1555, in 32-bit lanes) for 4 points of intersection with the flat plane.
+// Mirrors what 'drawFlatPixel' does exactly.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline __m128i fetchFlatTexels_SSE2(const FlatDrawParams& params, const __m128 intersectX, const __m128 intersectY) noexcept {
+    const __m128i texCoordMask = _mm_set1_epi32(63);
+    const __m128i texX = _mm_and_si128(_mm_cvttps_epi32(intersectX), texCoordMask);
+    const __m128i texY = _mm_and_si128(_mm_cvttps_epi32(intersectY), texCoordMask);
+    alignas(16) int32_t texelIndexes[4];
+    _mm_store_si128((__m128i*) texelIndexes, _mm_or_si128(_mm_slli_epi32(texY, 6), texX));
+
+    return _mm_set_epi32(
+        params.pSrcPixels[texelIndexes[3]],
+        params.pSrcPixels[texelIndexes[2]],
+        params.pSrcPixels[texelIndexes[1]],
+        params.pSrcPixels[texelIndexes[0]]
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the light multiplier for 4 points of intersection with the flat plane, based on their distance to the view point.
+// Mirrors what 'LightParams::getLightMulForDist' does exactly.
+// Note: 'std::max(a, b)' and 'std::min(a, b)' are done with '_mm_max_ps(b, a)' and '_mm_min_ps(b, a)' to get the same result.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline __m128 getFlatLightMul_SSE2(
+    const FlatDrawParams& params,
+    const __m128 intersectX,
+    const __m128 intersectY,
+    const __m128 intersectZ
+) noexcept {
+    const __m128 dx = _mm_sub_ps(_mm_set1_ps(params.viewX), intersectX);
+    const __m128 dy = _mm_sub_ps(_mm_set1_ps(params.viewY), intersectY);
+    const __m128 dz = _mm_sub_ps(_mm_set1_ps(params.viewZ), intersectZ);
+    const __m128 distToView = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+    const __m128 distFactorLinear = _mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(distToView, _mm_set1_ps(params.lightParams.lightSub)));
+    const __m128 distFactorQuad = _mm_sqrt_ps(distFactorLinear);
+    const __m128 lightDiminish = _mm_mul_ps(distFactorQuad, _mm_set1_ps(params.lightParams.lightCoef));
+    __m128 lightValue = _mm_sub_ps(_mm_set1_ps(255.0f), lightDiminish);
+    lightValue = _mm_max_ps(_mm_set1_ps(params.lightParams.lightMin), lightValue);
+    lightValue = _mm_min_ps(_mm_set1_ps(params.lightParams.lightMax), lightValue);
+    return _mm_max_ps(_mm_set1_ps(MIN_LIGHT_MUL), _mm_mul_ps(lightValue, _mm_set1_ps(1.0f / MAX_LIGHT_VALUE)));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// SSE2 version of 'drawFlatPixelAtY' which draws 4 pixels of a flat column at a time.
+// Draws as many groups of 4 as it can, updating the given y coordinate, output pointer and count.
+//
+// Every pixel in a flat column is computed independently of the others, so the entire calculation can be done in parallel here.
+// The operations done mirror exactly what the scalar code does so that the results are the same, bit for bit.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawFlatMode MODE>
+static void drawFlatPixels_SSE2(
+    const FlatDrawParams& params,
+    int32_t& curDstY,
+    uint32_t*& pDstPixel,
+    uint32_t& numPixelsLeft
+) noexcept {
+    // What to step the screen y coordinate and output pixel pointer by each pixel
+    constexpr int32_t Y_STEP = (MODE == DrawFlatMode::FLOOR) ? +1 : -1;
+    const intptr_t dstPixelStep = (intptr_t) params.dstPitch * Y_STEP;
+
+    // Setup constants
+    const __m128i laneYOffsets = _mm_set_epi32(3 * Y_STEP, 2 * Y_STEP, 1 * Y_STEP, 0);
+    const __m128 viewX = _mm_set1_ps(params.viewX);
+    const __m128 viewY = _mm_set1_ps(params.viewY);
+    const __m128 viewZ = _mm_set1_ps(params.viewZ);
+    const __m128 nearPlaneTz = _mm_set1_ps(params.nearPlaneTz);
+    const __m128 nearPlaneZStep = _mm_set1_ps(params.nearPlaneZStep);
+    const __m128 rayDirX = _mm_set1_ps(params.rayDirX);
+    const __m128 rayDirY = _mm_set1_ps(params.rayDirY);
+
+    // The numerator for the ray/plane intersection time is the same for every pixel.
+    // See 'getRayFlatPlaneIntersectT' for more details.
+    float negDividend;
+
+    if constexpr (MODE == DrawFlatMode::FLOOR) {
+        negDividend = -(params.viewZ - params.flatPlaneZ);
+    } else {
+        negDividend = -(-params.viewZ + params.flatPlaneZ);
+    }
+
+    const __m128 negDividendV = _mm_set1_ps(negDividend);
+
+    while (numPixelsLeft >= 4) {
+        // Compute the ray/plane intersection for all 4 pixels
+        const __m128i dstY = _mm_add_epi32(_mm_set1_epi32(curDstY), laneYOffsets);
+        const __m128 nearPlaneZ = _mm_add_ps(nearPlaneTz, _mm_mul_ps(nearPlaneZStep, _mm_add_ps(_mm_cvtepi32_ps(dstY), _mm_set1_ps(0.5f))));
+        const __m128 rayDirZ = _mm_sub_ps(nearPlaneZ, viewZ);
+        __m128 divisor;
+
+        if constexpr (MODE == DrawFlatMode::FLOOR) {
+            divisor = rayDirZ;
+        } else {
+            divisor = _mm_xor_ps(rayDirZ, _mm_set1_ps(-0.0f));
+        }
+
+        const __m128 intersectT = _mm_div_ps(negDividendV, divisor);
+        const __m128 intersectX = _mm_add_ps(viewX, _mm_mul_ps(rayDirX, intersectT));
+        const __m128 intersectY = _mm_add_ps(viewY, _mm_mul_ps(rayDirY, intersectT));
+        const __m128 intersectZ = _mm_add_ps(viewZ, _mm_mul_ps(rayDirZ, intersectT));
+
+        // Fetch the texels, do the lighting and write out all the pixels
+        const __m128i texels = fetchFlatTexels_SSE2(params, intersectX, intersectY);
+        const __m128 lightMul = getFlatLightMul_SSE2(params, intersectX, intersectY, intersectZ);
+
+        alignas(16) uint32_t pixels[4];
+        _mm_store_si128((__m128i*) pixels, BlitSimd::lightARGB1555Texels_SSE2(texels, lightMul));
+
+        for (uint32_t i = 0; i < 4; ++i) {
+            *pDstPixel = pixels[i];
+            pDstPixel += dstPixelStep;
+        }
+
+        curDstY += 4 * Y_STEP;
+        numPixelsLeft -= 4;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws 4 pixels at a time of a flat span row, starting at the given pixel index within the span.
+// Draws as many groups of 4 as it can and updates the pixel index, output pointer and count.
+// The output pixels are contiguous in memory so they can be written out with a single store.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void drawFlatSpanPixels_SSE2(
+    const FlatDrawParams& params,
+    const FlatSpanRowParams& row,
+    uint32_t& curPixelIdx,
+    uint32_t*& pDstPixel,
+    uint32_t& numPixelsLeft
+) noexcept {
+    const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 intersectX0 = _mm_set1_ps(row.intersectX);
+    const __m128 intersectY0 = _mm_set1_ps(row.intersectY);
+    const __m128 intersectZ = _mm_set1_ps(row.intersectZ);
+    const __m128 intersectXStep = _mm_set1_ps(row.intersectXStep);
+    const __m128 intersectYStep = _mm_set1_ps(row.intersectYStep);
+
+    while (numPixelsLeft >= 4) {
+        const __m128 pixelIdx = _mm_add_ps(_mm_set1_ps((float) curPixelIdx), laneOffsets);
+        const __m128 intersectX = _mm_add_ps(intersectX0, _mm_mul_ps(intersectXStep, pixelIdx));
+        const __m128 intersectY = _mm_add_ps(intersectY0, _mm_mul_ps(intersectYStep, pixelIdx));
+
+        const __m128i texels = fetchFlatTexels_SSE2(params, intersectX, intersectY);
+        const __m128 lightMul = getFlatLightMul_SSE2(params, intersectX, intersectY, intersectZ);
+        _mm_storeu_si128((__m128i*) pDstPixel, BlitSimd::lightARGB1555Texels_SSE2(texels, lightMul));
+
+        curPixelIdx += 4;
+        pDstPixel += 4;
+        numPixelsLeft -= 4;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 version of 'fetchFlatTexels_SSE2' which fetches 8 texels at a time
+//------------------------------------------------------------------------------------------------------------------------------------------
+BLIT_SIMD_AVX2_FUNC static inline __m256i fetchFlatTexels_AVX2(
+    const FlatDrawParams& params,
+    const __m256 intersectX,
+    const __m256 intersectY
+) noexcept {
+    const __m256i texCoordMask = _mm256_set1_epi32(63);
+    const __m256i texX = _mm256_and_si256(_mm256_cvttps_epi32(intersectX), texCoordMask);
+    const __m256i texY = _mm256_and_si256(_mm256_cvttps_epi32(intersectY), texCoordMask);
+    alignas(32) int32_t texelIndexes[8];
+    _mm256_store_si256((__m256i*) texelIndexes, _mm256_or_si256(_mm256_slli_epi32(texY, 6), texX));
+
+    return _mm256_set_epi32(
+        params.pSrcPixels[texelIndexes[7]],
+        params.pSrcPixels[texelIndexes[6]],
+        params.pSrcPixels[texelIndexes[5]],
+        params.pSrcPixels[texelIndexes[4]],
+        params.pSrcPixels[texelIndexes[3]],
+        params.pSrcPixels[texelIndexes[2]],
+        params.pSrcPixels[texelIndexes[1]],
+        params.pSrcPixels[texelIndexes[0]]
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 version of 'getFlatLightMul_SSE2' which does 8 points at a time
+//------------------------------------------------------------------------------------------------------------------------------------------
+BLIT_SIMD_AVX2_FUNC static inline __m256 getFlatLightMul_AVX2(
+    const FlatDrawParams& params,
+    const __m256 intersectX,
+    const __m256 intersectY,
+    const __m256 intersectZ
+) noexcept {
+    const __m256 dx = _mm256_sub_ps(_mm256_set1_ps(params.viewX), intersectX);
+    const __m256 dy = _mm256_sub_ps(_mm256_set1_ps(params.viewY), intersectY);
+    const __m256 dz = _mm256_sub_ps(_mm256_set1_ps(params.viewZ), intersectZ);
+    const __m256 distToView = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+
+    const __m256 distFactorLinear = _mm256_max_ps(_mm256_setzero_ps(), _mm256_sub_ps(distToView, _mm256_set1_ps(params.lightParams.lightSub)));
+    const __m256 distFactorQuad = _mm256_sqrt_ps(distFactorLinear);
+    const __m256 lightDiminish = _mm256_mul_ps(distFactorQuad, _mm256_set1_ps(params.lightParams.lightCoef));
+    __m256 lightValue = _mm256_sub_ps(_mm256_set1_ps(255.0f), lightDiminish);
+    lightValue = _mm256_max_ps(_mm256_set1_ps(params.lightParams.lightMin), lightValue);
+    lightValue = _mm256_min_ps(_mm256_set1_ps(params.lightParams.lightMax), lightValue);
+    return _mm256_max_ps(_mm256_set1_ps(MIN_LIGHT_MUL), _mm256_mul_ps(lightValue, _mm256_set1_ps(1.0f / MAX_LIGHT_VALUE)));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 version of 'drawFlatPixels_SSE2' which draws 8 pixels of a flat column at a time
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawFlatMode MODE>
+BLIT_SIMD_AVX2_FUNC static void drawFlatPixels_AVX2(
+    const FlatDrawParams& params,
+    int32_t& curDstY,
+    uint32_t*& pDstPixel,
+    uint32_t& numPixelsLeft
+) noexcept {
+    constexpr int32_t Y_STEP = (MODE == DrawFlatMode::FLOOR) ? +1 : -1;
+    const intptr_t dstPixelStep = (intptr_t) params.dstPitch * Y_STEP;
+
+    const __m256i laneYOffsets = _mm256_set_epi32(7 * Y_STEP, 6 * Y_STEP, 5 * Y_STEP, 4 * Y_STEP, 3 * Y_STEP, 2 * Y_STEP, 1 * Y_STEP, 0);
+    const __m256 viewX = _mm256_set1_ps(params.viewX);
+    const __m256 viewY = _mm256_set1_ps(params.viewY);
+    const __m256 viewZ = _mm256_set1_ps(params.viewZ);
+    const __m256 nearPlaneTz = _mm256_set1_ps(params.nearPlaneTz);
+    const __m256 nearPlaneZStep = _mm256_set1_ps(params.nearPlaneZStep);
+    const __m256 rayDirX = _mm256_set1_ps(params.rayDirX);
+    const __m256 rayDirY = _mm256_set1_ps(params.rayDirY);
+
+    float negDividend;
+
+    if constexpr (MODE == DrawFlatMode::FLOOR) {
+        negDividend = -(params.viewZ - params.flatPlaneZ);
+    } else {
+        negDividend = -(-params.viewZ + params.flatPlaneZ);
+    }
+
+    const __m256 negDividendV = _mm256_set1_ps(negDividend);
+
+    while (numPixelsLeft >= 8) {
+        const __m256i dstY = _mm256_add_epi32(_mm256_set1_epi32(curDstY), laneYOffsets);
+        const __m256 nearPlaneZ = _mm256_add_ps(nearPlaneTz, _mm256_mul_ps(nearPlaneZStep, _mm256_add_ps(_mm256_cvtepi32_ps(dstY), _mm256_set1_ps(0.5f))));
+        const __m256 rayDirZ = _mm256_sub_ps(nearPlaneZ, viewZ);
+        __m256 divisor;
+
+        if constexpr (MODE == DrawFlatMode::FLOOR) {
+            divisor = rayDirZ;
+        } else {
+            divisor = _mm256_xor_ps(rayDirZ, _mm256_set1_ps(-0.0f));
+        }
+
+        const __m256 intersectT = _mm256_div_ps(negDividendV, divisor);
+        const __m256 intersectX = _mm256_add_ps(viewX, _mm256_mul_ps(rayDirX, intersectT));
+        const __m256 intersectY = _mm256_add_ps(viewY, _mm256_mul_ps(rayDirY, intersectT));
+        const __m256 intersectZ = _mm256_add_ps(viewZ, _mm256_mul_ps(rayDirZ, intersectT));
+
+        const __m256i texels = fetchFlatTexels_AVX2(params, intersectX, intersectY);
+        const __m256 lightMul = getFlatLightMul_AVX2(params, intersectX, intersectY, intersectZ);
+
+        alignas(32) uint32_t pixels[8];
+        _mm256_store_si256((__m256i*) pixels, BlitSimd::lightARGB1555Texels_AVX2(texels, lightMul));
+
+        for (uint32_t i = 0; i < 8; ++i) {
+            *pDstPixel = pixels[i];
+            pDstPixel += dstPixelStep;
+        }
+
+        curDstY += 8 * Y_STEP;
+        numPixelsLeft -= 8;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// AVX2 version of 'drawFlatSpanPixels_SSE2' which draws 8 pixels of a flat span row at a time
+//------------------------------------------------------------------------------------------------------------------------------------------
+BLIT_SIMD_AVX2_FUNC static void drawFlatSpanPixels_AVX2(
+    const FlatDrawParams& params,
+    const FlatSpanRowParams& row,
+    uint32_t& curPixelIdx,
+    uint32_t*& pDstPixel,
+    uint32_t& numPixelsLeft
+) noexcept {
+    const __m256 laneOffsets = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+    const __m256 intersectX0 = _mm256_set1_ps(row.intersectX);
+    const __m256 intersectY0 = _mm256_set1_ps(row.intersectY);
+    const __m256 intersectZ = _mm256_set1_ps(row.intersectZ);
+    const __m256 intersectXStep = _mm256_set1_ps(row.intersectXStep);
+    const __m256 intersectYStep = _mm256_set1_ps(row.intersectYStep);
+
+    while (numPixelsLeft >= 8) {
+        const __m256 pixelIdx = _mm256_add_ps(_mm256_set1_ps((float) curPixelIdx), laneOffsets);
+        const __m256 intersectX = _mm256_add_ps(intersectX0, _mm256_mul_ps(intersectXStep, pixelIdx));
+        const __m256 intersectY = _mm256_add_ps(intersectY0, _mm256_mul_ps(intersectYStep, pixelIdx));
+
+        const __m256i texels = fetchFlatTexels_AVX2(params, intersectX, intersectY);
+        const __m256 lightMul = getFlatLightMul_AVX2(params, intersectX, intersectY, intersectZ);
+        _mm256_storeu_si256((__m256i*) pDstPixel, BlitSimd::lightARGB1555Texels_AVX2(texels, lightMul));
+
+        curPixelIdx += 8;
+        pDstPixel += 8;
+        numPixelsLeft -= 8;
+    }
+}
+#endif  // #if BLIT_SIMD_X86
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes up the values used for drawing every pixel of a flat for the current view
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline FlatDrawParams makeFlatDrawParams(
+    const float flatPlaneZ,
+    const uint8_t sectorLightLevel,
+    const ImageData& image,
+    const DrawTarget& target
+) noexcept {
+    FlatDrawParams params;
+    params.viewX = gViewX;
+    params.viewY = gViewY;
+    params.viewZ = gViewZ;
+    params.flatPlaneZ = flatPlaneZ;
+    params.nearPlaneTz = gNearPlaneTz;
+    params.nearPlaneZStep = gNearPlaneZStepPerViewColPixel;
+    params.rayDirX = 0.0f;
+    params.rayDirY = 0.0f;
+    params.lightParams = getLightParams(sectorLightLevel);
+    params.pSrcPixels = image.pPixels;
+    params.dstPitch = target.getColumnPixelStep();
+    return params;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draw one vertical column of a flat.
 //
 // Unlike the original version of 3DO Doom (and PC Doom) I do not bother with visplanes, or converting vertical floor
-// columns into horizontal floor columns. These days it seems to make sense to lean more on the fast arithmetic
+// columns into horizontal floor columns by default. These days it seems to make sense to lean more on the fast arithmetic
 // performance of the CPU instead of trawling through memory (slow) trying to match up visplanes and convert vertical
-// columns into horizontal ones.
+// columns into horizontal ones. Drawing flats as horizontal spans is available as an option however, see 'makeAllFlatSpans'.
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <DrawFlatMode MODE>
-static inline void drawFlatColumn(const FlatFragment flatFrag) noexcept {
-    // Cache some useful values
-    const float viewX = gViewX;
-    const float viewY = gViewY;
-    const float viewZ = gViewZ;
-    const float flatPlaneZ = flatFrag.worldZ;
-    const float nearPlaneTz = gNearPlaneTz;
-    const float nearPlaneZStep = gNearPlaneZStepPerViewColPixel;
+static inline void drawFlatColumn(const FlatFragment flatFrag, const DrawTarget& target) noexcept {
+    // Nothing to do if the column is empty
+    if (flatFrag.height <= 0)
+        return;
+
+    // Figure out which rows of the column are within the draw target, and bail if there are none
+    const int32_t fragTy = flatFrag.y;
+    const int32_t fragBy = (int32_t) flatFrag.y + (int32_t) flatFrag.height - 1;
+    const int32_t clippedTy = std::max(fragTy, target.y);
+    const int32_t clippedBy = std::min(fragBy, target.y + (int32_t) target.height - 1);
 
-    const LightParams& lightParams = getLightParams(flatFrag.sectorLightLevel);
-    const uint16_t* const pSrcPixels = flatFrag.pImageData->pPixels;
+    if (clippedTy > clippedBy)
+        return;
+
+    // Cache some useful values
+    FlatDrawParams params = makeFlatDrawParams(flatFrag.worldZ, flatFrag.sectorLightLevel, *flatFrag.pImageData, target);
 
     // The x and y coordinate in world space of the screen column being drawn.
     // Note: take the horizontal center position of the pixel to improve accuracy, hence + 0.5 here:
@@ -89,142 +529,389 @@ static inline void drawFlatColumn(const FlatFragment flatFrag) noexcept {
 
     // Compute the xz direction of the ray going from the view through this screen column.
     // Since this is constant per screen column pixel, we only need to do this once here:
-    const float rayDirX = nearPlaneX - viewX;
-    const float rayDirY = nearPlaneY - viewY;
+    params.rayDirX = nearPlaneX - params.viewX;
+    params.rayDirY = nearPlaneY - params.viewY;
 
-    // Where to start outputting to and where we end outputting.
+    // Where to start outputting to.
     // Note that floors rendered in a top to bottom direction, while ceilings are bottom to top:
+    int32_t firstDstY;
     int32_t curDstY;
-    int32_t endDstY;
 
     if constexpr (MODE == DrawFlatMode::FLOOR) {
-        curDstY = (int32_t)(flatFrag.y);
-        endDstY = (int32_t)(flatFrag.y + flatFrag.height);
+        firstDstY = fragTy;
+        curDstY = clippedTy;
     } else {
-        curDstY = (int32_t)(flatFrag.y + flatFrag.height - 1);
-        endDstY = (int32_t)(flatFrag.y - 1);
+        firstDstY = fragBy;
+        curDstY = clippedBy;
     }
 
-    const uint32_t startScreenX = g3dViewXOffset + flatFrag.x;
-    const uint32_t startScreenY = g3dViewYOffset + (uint32_t) curDstY;
+    const int32_t targetX = (int32_t) flatFrag.x - target.x;
+    BLIT_ASSERT((targetX >= 0) && (targetX < (int32_t) target.width));
 
-    // This is where we store the intersection of a ray going from the view point to the flat plane.
-    // The ray passes through whatever near plane pixel on the screen we are rendering and we update
-    // the ray and location of intersection for whatever pixel we are drawing...
-    float intersectX;
-    float intersectY;
-    float intersectZ;
+    const uint32_t dstPitch = params.dstPitch;
+    uint32_t* pDstPixel = target.getPixel((uint32_t) targetX, (uint32_t)(curDstY - target.y));
+    uint32_t numPixelsLeft = (uint32_t)(clippedBy - clippedTy + 1);
 
     // If clamp was specified for the first pixel then use the world position of where the column starts to figure out
-    // the texture coordinate for the first column pixel, otherwise do a ray/plane intersection like we do in the column loop.
+    // the texture coordinate for the first column pixel, otherwise do a ray/plane intersection like we do for the other pixels.
     // The clamp is used to prevent over-runs of textures that are sensitive to repeating, such as 64x64 teleporters.
     BLIT_ASSERT(flatFrag.depth >= 0.0f);
 
-    if (flatFrag.bClampFirstPixel) {
-        intersectX = flatFrag.worldX;
-        intersectY = flatFrag.worldY;
-        intersectZ = flatFrag.worldZ;
-    } else {
-        const float nearPlaneZ = nearPlaneTz + nearPlaneZStep * ((float) curDstY + 0.5f);   // Note: take the center position of the pixel to improve accuracy, hence + 0.5 here!
-        const float rayDirZ = nearPlaneZ - viewZ;
-
-        doRayFlatPlaneIntersection<MODE>(
-            flatPlaneZ,
-            viewX,
-            viewY,
-            viewZ,
-            rayDirX,
-            rayDirY,
-            rayDirZ,
-            intersectX,
-            intersectY,
-            intersectZ
-        );
-    }
-
-    // Draw the column!
-    const uint32_t screenWidth = Video::gScreenWidth;
-    uint32_t* pDstPixel = Video::gpFrameBuffer + (uintptr_t) startScreenY * screenWidth + startScreenX;
-
-    while (true) {
-        // Are we done?
+    if (flatFrag.bClampFirstPixel && (curDstY == firstDstY)) {
+        drawFlatPixel(params, flatFrag.worldX, flatFrag.worldY, flatFrag.worldZ, pDstPixel);
+
+        // Move onto the next pixel
         if constexpr (MODE == DrawFlatMode::FLOOR) {
-            if (curDstY >= endDstY)
-                break;
+            ++curDstY;
+            pDstPixel += dstPitch;
         } else {
-            if (curDstY <= endDstY)
-                break;
+            --curDstY;
+            pDstPixel -= dstPitch;
         }
 
-        // Get the source pixel (ARGB1555 format).
-        // Note that the flat texture is always expected to be 64x64, hence we can wraparound with a simple bitwise AND:
-        const uint32_t curSrcXInt = (uint32_t) intersectX & 63;
-        const uint32_t curSrcYInt = (uint32_t) intersectY & 63;
-        const uint16_t srcPixelARGB1555 = pSrcPixels[curSrcYInt * 64 + curSrcXInt];
-
-        // Extract RGB components and shift such that the maximum value is 255 instead of 31.
-        const uint16_t texR = (uint16_t)((srcPixelARGB1555 & uint16_t(0b0111110000000000)) >> 7);
-        const uint16_t texG = (uint16_t)((srcPixelARGB1555 & uint16_t(0b0000001111100000)) >> 2);
-        const uint16_t texB = (uint16_t)((srcPixelARGB1555 & uint16_t(0b0000000000011111)) << 3);
-
-        // Get the distance to the view point and light multiplier for that distance
-        const float distToView = FMath::distance3d(intersectX, intersectY, intersectZ, viewX, viewY, viewZ);
-        const float lightMul = lightParams.getLightMulForDist(distToView);
-
-        // Get the texture colors in 0-255 float format.
-        // Note that if we are not doing any color multiply these conversions would be redundant, but I'm guessing
-        // that the compiler would be smart enough to optimize out the useless operations in those cases (hopefully)!
-        const float r = std::min((float) texR * lightMul, 255.0f);
-        const float g = std::min((float) texG * lightMul, 255.0f);
-        const float b = std::min((float) texB * lightMul, 255.0f);
-
-        // Write out the pixel value
-        *pDstPixel = (
-            (uint32_t(r) << 16) |
-            (uint32_t(g) << 8) |
-            (uint32_t(b))
-        );
+        --numPixelsLeft;
+    }
+
+    // Draw the rest of the column!
+    // Use SIMD to do multiple pixels at once if available, and finish off any leftover pixels one at a time:
+    #if BLIT_SIMD_X86
+        const BlitSimd::InstructionSet simdInstructionSet = BlitSimd::getInstructionSet();
+
+        if (simdInstructionSet == BlitSimd::InstructionSet::AVX2) {
+            drawFlatPixels_AVX2<MODE>(params, curDstY, pDstPixel, numPixelsLeft);
+        } else if (simdInstructionSet == BlitSimd::InstructionSet::SSE2) {
+            drawFlatPixels_SSE2<MODE>(params, curDstY, pDstPixel, numPixelsLeft);
+        }
+    #endif
+
+    while (numPixelsLeft > 0) {
+        drawFlatPixelAtY<MODE>(params, curDstY, pDstPixel);
 
-        // Move onto the next pixel
         if constexpr (MODE == DrawFlatMode::FLOOR) {
             ++curDstY;
-            pDstPixel += screenWidth;
+            pDstPixel += dstPitch;
         } else {
             --curDstY;
-            pDstPixel -= screenWidth;
+            pDstPixel -= dstPitch;
+        }
+
+        --numPixelsLeft;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Joins up the columns of a list of floor or ceiling fragments into horizontal spans, wherever fragments in adjacent screen columns
+// are for the same plane (same height, texture and light level). Each span can then be drawn along a row of the framebuffer, with
+// the texture coordinate stepping by a constant amount for each pixel.
+//
+// Notes:
+//  (1) The first pixel of a fragment which has 'bClampFirstPixel' set is left out of the spans: it is drawn separately afterwards
+//      with the clamped texture coordinate, the same as in column mode.
+//  (2) A plane may have more than one fragment in the same screen column (non overlapping), so spans are tracked per row.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::vector<const FlatFragment*>     gSortedFlatFrags;       // Flat fragments sorted by plane and then screen x
+static std::vector<uint32_t>                gRowSpanPlaneIds;       // Per view row: the id of the plane for the span currently being built in the row
+static std::vector<uint16_t>                gRowSpanStartX;         // Per view row: start and end x of the span currently being built (end is exclusive)
+static std::vector<uint16_t>                gRowSpanEndX;
+static uint32_t                             gNextFlatPlaneId;       // Id to give to the next plane that spans are made for
+
+static inline bool isSameFlatPlane(const FlatFragment& frag1, const FlatFragment& frag2) noexcept {
+    return (
+        (frag1.worldZ == frag2.worldZ) &&
+        (frag1.pImageData == frag2.pImageData) &&
+        (frag1.sectorLightLevel == frag2.sectorLightLevel)
+    );
+}
+
+template <DrawFlatMode MODE>
+static void makeFlatSpans(const std::vector<FlatFragment>& flatFrags, std::vector<FlatSpan>& spans) noexcept {
+    spans.clear();
+
+    // Sort the fragments by plane, and by screen x within each plane
+    gSortedFlatFrags.clear();
+
+    for (const FlatFragment& flatFrag : flatFrags) {
+        gSortedFlatFrags.push_back(&flatFrag);
+    }
+
+    std::sort(
+        gSortedFlatFrags.begin(),
+        gSortedFlatFrags.end(),
+        [](const FlatFragment* const pFrag1, const FlatFragment* const pFrag2) noexcept {
+            if (pFrag1->worldZ != pFrag2->worldZ)
+                return (pFrag1->worldZ < pFrag2->worldZ);
+
+            if (pFrag1->pImageData != pFrag2->pImageData)
+                return std::less<const ImageData*>()(pFrag1->pImageData, pFrag2->pImageData);
+
+            if (pFrag1->sectorLightLevel != pFrag2->sectorLightLevel)
+                return (pFrag1->sectorLightLevel < pFrag2->sectorLightLevel);
+
+            return (pFrag1->x < pFrag2->x);
+        }
+    );
+
+    // Emits the span currently being built for a row
+    const FlatFragment* pPlaneFrag = nullptr;
+    uint32_t planeId = 0;
+    int32_t planeMinY = 0;
+    int32_t planeMaxY = -1;
+
+    const auto emitRowSpan = [&](const int32_t y) noexcept {
+        FlatSpan& span = spans.emplace_back();
+        span.y = (uint16_t) y;
+        span.x1 = gRowSpanStartX[y];
+        span.x2 = gRowSpanEndX[y];
+        span.sectorLightLevel = pPlaneFrag->sectorLightLevel;
+        span.worldZ = pPlaneFrag->worldZ;
+        span.pImageData = pPlaneFrag->pImageData;
+    };
+
+    // Emits all the spans still being built for the current plane
+    const auto emitPlaneSpans = [&]() noexcept {
+        for (int32_t y = planeMinY; y <= planeMaxY; ++y) {
+            if (gRowSpanPlaneIds[y] == planeId) {
+                emitRowSpan(y);
+            }
+        }
+    };
+
+    for (const FlatFragment* const pFrag : gSortedFlatFrags) {
+        const FlatFragment& frag = *pFrag;
+
+        // Starting a new plane?
+        if ((!pPlaneFrag) || (!isSameFlatPlane(*pPlaneFrag, frag))) {
+            if (pPlaneFrag) {
+                emitPlaneSpans();
+            }
+
+            pPlaneFrag = &frag;
+            planeId = gNextFlatPlaneId++;
+            planeMinY = INT32_MAX;
+            planeMaxY = -1;
+        }
+
+        // Figure out which rows the fragment covers, leaving out the clamped first pixel if there is one.
+        // Note that floors are drawn top to bottom and ceilings bottom to top, so the first pixel is at a different end.
+        int32_t fragTy = frag.y;
+        int32_t fragBy = (int32_t) frag.y + (int32_t) frag.height - 1;
+
+        if (frag.bClampFirstPixel) {
+            if constexpr (MODE == DrawFlatMode::FLOOR) {
+                ++fragTy;
+            } else {
+                --fragBy;
+            }
+        }
+
+        if (fragTy > fragBy)
+            continue;
+
+        BLIT_ASSERT((fragTy >= 0) && (fragBy < (int32_t) gRowSpanPlaneIds.size()));
+        planeMinY = std::min(planeMinY, fragTy);
+        planeMaxY = std::max(planeMaxY, fragBy);
+
+        // Extend the span in each row if this column follows on from it, otherwise start a new span
+        const uint16_t x = frag.x;
+
+        for (int32_t y = fragTy; y <= fragBy; ++y) {
+            if (gRowSpanPlaneIds[y] == planeId) {
+                if (gRowSpanEndX[y] == x) {
+                    gRowSpanEndX[y] = x + 1;
+                    continue;
+                }
+
+                emitRowSpan(y);
+            }
+
+            gRowSpanPlaneIds[y] = planeId;
+            gRowSpanStartX[y] = x;
+            gRowSpanEndX[y] = x + 1;
         }
+    }
+
+    if (pPlaneFrag) {
+        emitPlaneSpans();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes room in the per row span building state for the given number of view rows, so that changing the resolution scale never
+// reallocates it mid frame.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void reserveFlatSpanRows(const uint32_t maxViewHeight) noexcept {
+    gRowSpanPlaneIds.reserve(maxViewHeight);
+    gRowSpanStartX.reserve(maxViewHeight);
+    gRowSpanEndX.reserve(maxViewHeight);
+}
+
+void makeAllFlatSpans() noexcept {
+    PROFILE_SCOPE("makeAllFlatSpans");
+
+    // Reset the per row span building state
+    gRowSpanPlaneIds.assign(g3dViewHeight, UINT32_MAX);
+    gRowSpanStartX.resize(g3dViewHeight);
+    gRowSpanEndX.resize(g3dViewHeight);
+    gNextFlatPlaneId = 0;
+
+    makeFlatSpans<DrawFlatMode::FLOOR>(gFloorFragments, gFloorSpans);
+    makeFlatSpans<DrawFlatMode::CEILING>(gCeilFragments, gCeilSpans);
+}
 
-        // Compute the ray/plane intersection for the upcoming pixel to get its texture coordinate
-        {
-            // Note: take the vertical center position of the pixel to improve accuracy, hence + 0.5 here!
-            const float nearPlaneZ = nearPlaneTz + nearPlaneZStep * ((float) curDstY + 0.5f);
-            const float rayDirZ = nearPlaneZ - viewZ;
-
-            doRayFlatPlaneIntersection<MODE>(
-                flatPlaneZ,
-                viewX,
-                viewY,
-                viewZ,
-                rayDirX,
-                rayDirY,
-                rayDirZ,
-                intersectX,
-                intersectY,
-                intersectZ
-            );
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draw one horizontal span of a flat.
+// The ray/plane intersection is only done once for the span, after which the texture coordinate steps by a constant amount.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawFlatMode MODE>
+static void drawFlatSpan(const FlatSpan& span, const DrawTarget& target) noexcept {
+    BLIT_ASSERT(span.x1 < span.x2);
+    BLIT_ASSERT((span.x1 >= target.x) && (span.x2 <= target.x + (int32_t) target.width));
+    BLIT_ASSERT((span.y >= target.y) && (span.y < target.y + (int32_t) target.height));
+
+    const FlatDrawParams params = makeFlatDrawParams(span.worldZ, span.sectorLightLevel, *span.pImageData, target);
+
+    // Get the ray going through the center of the first pixel in the span and where it intersects the plane
+    const float nearPlaneX = gNearPlaneP1x + ((float) span.x1 + 0.5f) * gNearPlaneXStepPerViewCol;
+    const float nearPlaneY = gNearPlaneP1y + ((float) span.x1 + 0.5f) * gNearPlaneYStepPerViewCol;
+    const float nearPlaneZ = params.nearPlaneTz + params.nearPlaneZStep * ((float) span.y + 0.5f);
+    const float rayDirX = nearPlaneX - params.viewX;
+    const float rayDirY = nearPlaneY - params.viewY;
+    const float rayDirZ = nearPlaneZ - params.viewZ;
+    const float intersectT = getRayFlatPlaneIntersectT<MODE>(params.flatPlaneZ, params.viewZ, rayDirZ);
+
+    // Moving one pixel along the row moves the ray by a fixed amount on the near plane, and since the intersect time is the same
+    // for the whole row this means the intersection point also moves by a fixed amount:
+    FlatSpanRowParams row;
+    row.intersectX = params.viewX + rayDirX * intersectT;
+    row.intersectY = params.viewY + rayDirY * intersectT;
+    row.intersectZ = params.viewZ + rayDirZ * intersectT;
+    row.intersectXStep = gNearPlaneXStepPerViewCol * intersectT;
+    row.intersectYStep = gNearPlaneYStepPerViewCol * intersectT;
+
+    // Draw all the pixels, using SIMD for as many as possible.
+    // Note: the SIMD routines can only be used if the pixels in the span are adjacent in memory (i.e not a column major target).
+    const uint32_t targetX = (uint32_t)(span.x1 - target.x);
+    const uint32_t targetY = (uint32_t)(span.y - target.y);
+    uint32_t* pDstPixel = target.getPixel(targetX, targetY);
+    const uint32_t dstPixelStep = target.getRowPixelStep();
+    uint32_t curPixelIdx = 0;
+    uint32_t numPixelsLeft = (uint32_t) span.x2 - span.x1;
+
+    #if BLIT_SIMD_X86
+        const BlitSimd::InstructionSet simdInstructionSet = BlitSimd::getInstructionSet();
+
+        if (dstPixelStep == 1) {
+            if (simdInstructionSet == BlitSimd::InstructionSet::AVX2) {
+                drawFlatSpanPixels_AVX2(params, row, curPixelIdx, pDstPixel, numPixelsLeft);
+            } else if (simdInstructionSet == BlitSimd::InstructionSet::SSE2) {
+                drawFlatSpanPixels_SSE2(params, row, curPixelIdx, pDstPixel, numPixelsLeft);
+            }
         }
+    #endif
+
+    while (numPixelsLeft > 0) {
+        const float intersectX = row.intersectX + row.intersectXStep * (float) curPixelIdx;
+        const float intersectY = row.intersectY + row.intersectYStep * (float) curPixelIdx;
+        drawFlatPixel(params, intersectX, intersectY, row.intersectZ, pDstPixel);
+
+        ++curPixelIdx;
+        pDstPixel += dstPixelStep;
+        --numPixelsLeft;
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the first pixel of a flat fragment with a clamped texture coordinate, if the fragment requires that.
+// Used when drawing flats as spans, since spans leave these pixels out.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <DrawFlatMode MODE>
+static void drawFlatFragmentClampedPixel(const FlatFragment& flatFrag, const DrawTarget& target) noexcept {
+    if ((!flatFrag.bClampFirstPixel) || (flatFrag.height <= 0))
+        return;
+
+    // Ignore the pixel if it is outside of the draw target
+    const int32_t dstY = (MODE == DrawFlatMode::FLOOR) ? flatFrag.y : flatFrag.y + flatFrag.height - 1;
+    const uint32_t targetX = (uint32_t)(flatFrag.x - target.x);
+    const uint32_t targetY = (uint32_t)(dstY - target.y);
+
+    if ((targetX >= target.width) || (targetY >= target.height))    // Note: a < 0 check is also done here via the unsigned cast
+        return;
+
+    const FlatDrawParams params = makeFlatDrawParams(flatFrag.worldZ, flatFrag.sectorLightLevel, *flatFrag.pImageData, target);
+    uint32_t* const pDstPixel = target.getPixel(targetX, targetY);
+
+    drawFlatPixel(params, flatFrag.worldX, flatFrag.worldY, flatFrag.worldZ, pDstPixel);
+}
+
+void drawFloorFragment(const FlatFragment& flatFrag, const DrawTarget& target) noexcept {
+    drawFlatColumn<DrawFlatMode::FLOOR>(flatFrag, target);
+}
+
+void drawCeilingFragment(const FlatFragment& flatFrag, const DrawTarget& target) noexcept {
+    drawFlatColumn<DrawFlatMode::CEILING>(flatFrag, target);
+}
+
 void drawAllFloorFragments() noexcept {
+    PROFILE_SCOPE("drawAllFloorFragments");
+
+    const DrawTarget target = getViewDrawTarget();
+
     for (const FlatFragment& flatFrag : gFloorFragments) {
-        drawFlatColumn<DrawFlatMode::FLOOR>(flatFrag);
+        drawFlatColumn<DrawFlatMode::FLOOR>(flatFrag, target);
     }
 }
 
 void drawAllCeilingFragments() noexcept {
+    PROFILE_SCOPE("drawAllCeilingFragments");
+
+    const DrawTarget target = getViewDrawTarget();
+
+    for (const FlatFragment& flatFrag : gCeilFragments) {
+        drawFlatColumn<DrawFlatMode::CEILING>(flatFrag, target);
+    }
+}
+
+void drawFloorSpan(const FlatSpan& span, const DrawTarget& target) noexcept {
+    drawFlatSpan<DrawFlatMode::FLOOR>(span, target);
+}
+
+void drawCeilingSpan(const FlatSpan& span, const DrawTarget& target) noexcept {
+    drawFlatSpan<DrawFlatMode::CEILING>(span, target);
+}
+
+void drawFloorFragmentClampedPixel(const FlatFragment& flatFrag, const DrawTarget& target) noexcept {
+    drawFlatFragmentClampedPixel<DrawFlatMode::FLOOR>(flatFrag, target);
+}
+
+void drawCeilingFragmentClampedPixel(const FlatFragment& flatFrag, const DrawTarget& target) noexcept {
+    drawFlatFragmentClampedPixel<DrawFlatMode::CEILING>(flatFrag, target);
+}
+
+void drawAllFloorSpans() noexcept {
+    PROFILE_SCOPE("drawAllFloorSpans");
+
+    const DrawTarget target = getViewDrawTarget();
+
+    for (const FlatSpan& span : gFloorSpans) {
+        drawFlatSpan<DrawFlatMode::FLOOR>(span, target);
+    }
+
+    for (const FlatFragment& flatFrag : gFloorFragments) {
+        drawFlatFragmentClampedPixel<DrawFlatMode::FLOOR>(flatFrag, target);
+    }
+}
+
+void drawAllCeilingSpans() noexcept {
+    PROFILE_SCOPE("drawAllCeilingSpans");
+
+    const DrawTarget target = getViewDrawTarget();
+
+    for (const FlatSpan& span : gCeilSpans) {
+        drawFlatSpan<DrawFlatMode::CEILING>(span, target);
+    }
+
     for (const FlatFragment& flatFrag : gCeilFragments) {
-        drawFlatColumn<DrawFlatMode::CEILING>(flatFrag);
+        drawFlatFragmentClampedPixel<DrawFlatMode::CEILING>(flatFrag, target);
     }
 }
 
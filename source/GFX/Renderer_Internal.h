@@ -176,6 +176,7 @@ namespace Renderer {
     //------------------------------------------------------------------------------------------------------------------
     struct DrawSprite {
         const uint16_t*     pPixels;            // Pixels for the sprite (in column major format)
+        const uint32_t*     pLitPixels;         // Pre-lit pixels for the sprite from the lit texture cache, or 'nullptr' if not available
         float               worldX;             // World center X position of the sprite (used for occlusion tests)
         float               worldY;             // World center Y position of the sprite (used for occlusion tests)
         float               screenLx;           // Left and right screen X values
@@ -204,6 +205,7 @@ namespace Renderer {
         float               texYStep;               // Stepping to use for the 'Y' texture coordinate
         float               texYSubPixelAdjust;     // Sub-pixel adjustment for 'Y' texture coordinate. Applied to every pixel after the first.
         const uint16_t*     pSpriteColPixels;       // The image data for the sprite (in column major format)
+        const uint32_t*     pLitSpriteColPixels;    // The pre-lit image data for the sprite column, or 'nullptr' if not available
         float               spriteWorldX;           // World center of the sprite: X
         float               spriteWorldY;           // World center of the sprite: Y
     };
@@ -237,6 +239,21 @@ namespace Renderer {
         Bounds bounds[MAX_ENTRIES];
     };
 
+    //------------------------------------------------------------------------------------------------------------------
+    // Remembers which lines have been tested to see if they are in front of the sprite currently being drawn.
+    // Saves repeating the same test for every column of a sprite that the line occludes.
+    //
+    // Each thread drawing sprites has its own one of these so that sprite clipping doesn't write to the shared map
+    // data, which allows sprites to be drawn in parallel over different vertical bands of the screen.
+    //------------------------------------------------------------------------------------------------------------------
+    struct SpriteClipCache {
+        std::vector<uint32_t>   lineSpriteIds;      // For each line: the id of the sprite that the 'in front' test was last done for
+        std::vector<uint8_t>    lineInFrontFlags;   // For each line: whether the line was found to be in front of that sprite
+        uint32_t                curSpriteId;        // Id of the sprite currently being drawn: incremented for every sprite
+
+        void beginSprite() noexcept;
+    };
+
     //------------------------------------------------------------------------------------------------------------------
     // Describes a column of a wall to be drawn
     //------------------------------------------------------------------------------------------------------------------
@@ -250,6 +267,7 @@ namespace Renderer {
         float               texcoordYStep;
         float               lightMul;                   // Multiply value for lighting
         const ImageData*    pImageData;
+        const uint32_t*     pLitPixels;                 // Pre-lit pixels for the texture from the lit texture cache, or 'nullptr' if not available
     };
 
     //------------------------------------------------------------------------------------------------------------------
@@ -276,6 +294,45 @@ namespace Renderer {
         const ImageData*    pImageData;
     };
 
+    //------------------------------------------------------------------------------------------------------------------
+    // Describes a horizontal span of a floor or ceiling to be drawn.
+    // These are only used when drawing flats as spans: they are made by joining up flat fragments for the same plane.
+    //------------------------------------------------------------------------------------------------------------------
+    struct FlatSpan {
+        uint16_t            y;
+        uint16_t            x1;                     // Start and end screen x (end is exclusive)
+        uint16_t            x2;
+        uint8_t             sectorLightLevel;
+        float               worldZ;                 // Height of the floor or ceiling plane
+        const ImageData*    pImageData;
+    };
+
+    //------------------------------------------------------------------------------------------------------------------
+    // Describes an area of pixels that the fragments of the 3D view are drawn to.
+    // Normally this is the entire 3D view within the framebuffer, but when drawing in tiles it is a small buffer which
+    // holds just one tile of the view. It may also be a column major buffer holding the entire view, which is later
+    // transposed into the framebuffer. Fragment coordinates are always relative to the 3D view and are converted to
+    // be relative to the draw target (and clipped to it) at the point of drawing.
+    //------------------------------------------------------------------------------------------------------------------
+    struct DrawTarget {
+        uint32_t*   pPixels;        // Pixels for the target area: the first pixel is the top left corner of the area
+        uint32_t    pitch;          // Distance between rows of pixels, or columns if the target is column major (in pixels)
+        int32_t     x;              // Where the top left corner of the target area is in the 3D view
+        int32_t     y;
+        uint32_t    width;          // Size of the target area
+        uint32_t    height;
+        bool        bColumnMajor;   // If true then the pixels are stored column by column instead of row by row
+
+        // Distance between adjacent pixels going down a column and going along a row (in pixels)
+        uint32_t getColumnPixelStep() const noexcept { return (bColumnMajor) ? 1 : pitch; }
+        uint32_t getRowPixelStep() const noexcept { return (bColumnMajor) ? pitch : 1; }
+
+        // Get the pixel at the given coordinate, relative to the top left corner of the target area
+        uint32_t* getPixel(const uint32_t targetX, const uint32_t targetY) const noexcept {
+            return pPixels + (uintptr_t) targetX * getRowPixelStep() + (uintptr_t) targetY * getColumnPixelStep();
+        }
+    };
+
     //==================================================================================================================
     // Globals shared throughout the renderer - defined in Renderer.cpp
     //==================================================================================================================
@@ -320,24 +377,61 @@ namespace Renderer {
     extern std::vector<FlatFragment>        gFloorFragments;                    // Floor fragments to be drawn
     extern std::vector<FlatFragment>        gCeilFragments;                     // Ceiling fragments to be drawn
     extern std::vector<SkyFragment>         gSkyFragments;                      // Sky fragments to be drawn
+    extern std::vector<FlatSpan>            gFloorSpans;                        // Floor spans to be drawn (if drawing flats as spans)
+    extern std::vector<FlatSpan>            gCeilSpans;                         // Ceiling spans to be drawn (if drawing flats as spans)
     extern std::vector<DrawSprite>          gDrawSprites;                       // Sprites to be drawn that will later be turned into fragments (after depth sort)
+    extern std::vector<uint32_t>            gSortedDrawSprites;                 // Indexes into 'gDrawSprites' sorted from back to front, with ties in submission order
+    extern float                            gViewRenderScale;                   // Fraction of its size on screen that the 3D view is drawn at (1.0 = full resolution)
     
     //==================================================================================================================
     // Functions
     //==================================================================================================================
 
     void doBspTraversal() noexcept;
+    void beginDrawSegCacheFrame() noexcept;
+    uint32_t getNumDrawSegCacheHits() noexcept;
     void addSegToFrame(seg_t& seg) noexcept;
     void addSpriteToFrame(const mobj_t& thing) noexcept;
     void drawAllLineSegs() noexcept;
+    void drawWallFragment(const WallFragment& wallFrag, const DrawTarget& target) noexcept;
+    void drawFloorFragment(const FlatFragment& flatFrag, const DrawTarget& target) noexcept;
+    void drawCeilingFragment(const FlatFragment& flatFrag, const DrawTarget& target) noexcept;
+    void drawSkyFragment(const SkyFragment& skyFrag, const DrawTarget& target) noexcept;
     void drawAllWallFragments() noexcept;
     void drawAllFloorFragments() noexcept;
     void drawAllCeilingFragments() noexcept;
     void drawAllSkyFragments() noexcept;
+    void reserveFlatSpanRows(const uint32_t maxViewHeight) noexcept;
+    void makeAllFlatSpans() noexcept;
+    void drawFloorSpan(const FlatSpan& span, const DrawTarget& target) noexcept;
+    void drawCeilingSpan(const FlatSpan& span, const DrawTarget& target) noexcept;
+    void drawFloorFragmentClampedPixel(const FlatFragment& flatFrag, const DrawTarget& target) noexcept;
+    void drawCeilingFragmentClampedPixel(const FlatFragment& flatFrag, const DrawTarget& target) noexcept;
+    void drawAllFloorSpans() noexcept;
+    void drawAllCeilingSpans() noexcept;
+    void drawAllFragmentsInBands() noexcept;
+    void drawAllFragmentsInTiles() noexcept;
+    uint32_t cullOccludedSprites() noexcept;
+    void sortAllSprites() noexcept;
+    bool getSpriteScreenBounds(const DrawSprite& sprite, uint32_t& lx, uint32_t& rx, uint32_t& ty, uint32_t& by) noexcept;
+    void drawSpriteListInColumnRange(const uint32_t* const pSpriteIndexes, const uint32_t numSprites, const uint32_t startX, const uint32_t endX, SpriteClipCache& clipCache, const DrawTarget& target) noexcept;
+    void drawSpritesInColumnRange(const uint32_t startX, const uint32_t endX, SpriteClipCache& clipCache, const DrawTarget& target) noexcept;
     void drawAllSprites() noexcept;
     void drawWeapons() noexcept;
     void doPostFx() noexcept;
 
+    // Change the resolution the 3D view is drawn at, as a fraction of its size on screen, and recompute everything depending on it
+    void setViewRenderScale(const float scale) noexcept;
+
+    // Dynamic resolution: picks the resolution scale for the next frame, records the time taken to draw the view for a frame and
+    // stretches the low resolution view (row major, with one pixel per view column in each row) to fill its area in the framebuffer.
+    void updateDynamicResolution() noexcept;
+    void recordDynamicResolutionDrawTime(const uint64_t drawTimeNs) noexcept;
+    void upscaleView(const uint32_t* const pSrcPixels) noexcept;
+
+    // Get the draw target covering the entire 3D view within the framebuffer
+    DrawTarget getViewDrawTarget() noexcept;
+
     // Get light parameters for a floor or wall at the given light level
     LightParams getLightParams(const uint32_t sectorLightLevel) noexcept;
 }
@@ -1,28 +1,26 @@
 #include "Renderer_Internal.h"
 
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
+#include "BlitSimd.h"
 #include "Game/Data.h"
 #include "Video.h"
 #include <algorithm>
 
 BEGIN_NAMESPACE(Renderer)
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns a pointer to the first pixel of the given row of the 3D view in the framebuffer
+//------------------------------------------------------------------------------------------------------------------------------------------
+static uint32_t* getViewRowPixels(const uint32_t y) noexcept {
+    return &Video::gpFrameBuffer[g3dViewXOffset + (g3dViewYOffset + y) * Video::gScreenWidth];
+}
+
 static void doInvulnerabilityEffect() noexcept {
     // The invunerability effect in 3DO Doom was a simple bit inverse.
     // The 3DO game did not use the palette switching technique that the PC version did because there was no palette...
-    const uint32_t viewH = g3dViewHeight;
-    const uint32_t screenH = Video::gScreenWidth;
-
-    for (uint32_t y = 0; y <= viewH; ++y) {
-        // Process this row of pixels and invert RGB values
-        uint32_t* pPixel = &Video::gpFrameBuffer[g3dViewXOffset + (g3dViewYOffset + y) * screenH];
-        uint32_t* const pEndPixel = pPixel + g3dViewWidth;
-
-        while (pPixel < pEndPixel) {
-            const uint32_t color = *pPixel;
-            *pPixel = (~color) & 0x00FFFFFFu;
-            ++pPixel;
-        }
+    for (uint32_t y = 0; y < g3dViewScreenHeight; ++y) {
+        BlitSimd::invertPixels(getViewRowPixels(y), g3dViewScreenWidth);
     }
 }
 
@@ -33,43 +31,15 @@ static void doTintEffect(const uint32_t r5, const uint32_t g5, const uint32_t b5
 
     // Create a fixed point multiplier for RGB values
     constexpr Fixed COL5_MAX_FRAC = intToFixed16(31);
-    constexpr Fixed COL8_MAX_FRAC = intToFixed16(255);
     constexpr Fixed EFFECT_STRENGHT = intToFixed16(2);
 
     const Fixed rMul = FRACUNIT + fixed16Mul(fixed16Div(intToFixed16((int32_t) r5), COL5_MAX_FRAC), EFFECT_STRENGHT);
     const Fixed gMul = FRACUNIT + fixed16Mul(fixed16Div(intToFixed16((int32_t) g5), COL5_MAX_FRAC), EFFECT_STRENGHT);
     const Fixed bMul = FRACUNIT + fixed16Mul(fixed16Div(intToFixed16((int32_t) b5), COL5_MAX_FRAC), EFFECT_STRENGHT);
 
-    // Modulate all of the RGB values in the framebuffer
-    const uint32_t screenH = g3dViewHeight;
-
-    for (uint32_t y = 0; y <= screenH; ++y) {
-        // Process this row of pixels
-        uint32_t* pPixel = &Video::gpFrameBuffer[g3dViewXOffset + (g3dViewYOffset + y) * Video::gScreenWidth];
-        uint32_t* const pEndPixel = pPixel + g3dViewWidth;
-
-        while (pPixel < pEndPixel) {
-            // Get the old colors from 0-1
-            const uint32_t color = *pPixel;
-            const Fixed oldRFrac = intToFixed16((color >> 16) & 0xFFu);
-            const Fixed oldGFrac = intToFixed16((color >> 8) & 0xFFu);
-            const Fixed oldBFrac = intToFixed16(color & 0xFFu);
-
-            // Modulate and clamp
-            const Fixed rFrac = std::min(fixed16Mul(oldRFrac, rMul), COL8_MAX_FRAC);
-            const Fixed gFrac = std::min(fixed16Mul(oldGFrac, gMul), COL8_MAX_FRAC);
-            const Fixed bFrac = std::min(fixed16Mul(oldBFrac, bMul), COL8_MAX_FRAC);
-
-            // Make a framebuffer color
-            const uint32_t finalColor = (
-                ((uint32_t) fixed16ToInt(rFrac) << 16) |
-                ((uint32_t) fixed16ToInt(gFrac) << 8) |
-                ((uint32_t) fixed16ToInt(bFrac))
-            );
-
-            *pPixel = finalColor;
-            ++pPixel;
-        }
+    // Modulate and clamp all of the RGB values in the 3D view
+    for (uint32_t y = 0; y < g3dViewScreenHeight; ++y) {
+        BlitSimd::tintPixels(getViewRowPixels(y), g3dViewScreenWidth, rMul, gMul, bMul);
     }
 }
 
@@ -77,6 +47,8 @@ static void doTintEffect(const uint32_t r5, const uint32_t g5, const uint32_t b5
 // Does post processing fx on the entire 3D view
 //------------------------------------------------------------------------------------------------------------------------------------------
 void doPostFx() noexcept {
+    PROFILE_SCOPE("doPostFx");
+
     const player_t& player = gPlayer;
 
     // See if we are to do the invulnerability effect.
@@ -1,17 +1,24 @@
 #include "Renderer_Internal.h"
 
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
 #include "Blit.h"
+#include "BlitSimd.h"
+#include "LitTextureCache.h"
 #include "Game/Data.h"
 #include "Map/MapData.h"
 #include "Map/MapUtil.h"
 #include "Sprites.h"
 #include "Things/Info.h"
 #include "Things/MapObj.h"
-#include "Video.h"
+#include <cmath>
+#include <cstring>
 
 BEGIN_NAMESPACE(Renderer)
 
+// Sprite clipping cache used when drawing sprites serially
+static SpriteClipCache gSpriteClipCache;
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Transforms a sprite world position into viewspace and tells if it should be culled due to being behind the camera
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -86,13 +93,14 @@ static void getSpriteDetailsForMapObj(
     const Fixed viewXFrac,
     const Fixed viewYFrac,
     const SpriteFrameAngle*& pSpriteFrameAngle,
+    uint32_t& spriteResourceNum,
+    uint32_t& spriteSubImageNum,
     bool& bIsSpriteFullBright,
     bool& bIsSpriteTransparent
 ) noexcept {
     // Figure out the sprite that we want
     const state_t* const pStatePtr = thing.state;
 
-    uint32_t spriteResourceNum;
     uint32_t spriteFrameNum;
     state_t::decomposeSpriteFrameFieldComponents(
         pStatePtr->SpriteFrame,
@@ -110,6 +118,7 @@ static void getSpriteDetailsForMapObj(
 
     const SpriteFrame* const pSpriteFrame = &pSprite->pFrames[spriteFrameNum];
     pSpriteFrameAngle = &pSpriteFrame->angles[spriteAngle];
+    spriteSubImageNum = spriteFrameNum * NUM_SPRITE_DIRECTIONS + spriteAngle;
 
     // Figure out other sprite flags
     bIsSpriteTransparent = ((thing.flags & MF_SHADOW) != 0);
@@ -214,7 +223,18 @@ void addSpriteToFrame(const mobj_t& thing) noexcept {
     bool bIsSpriteFullBright;
     bool bIsSpriteTransparent;
     const SpriteFrameAngle* spriteFrameAngle;
-    getSpriteDetailsForMapObj(thing, gViewXFrac, gViewYFrac, spriteFrameAngle, bIsSpriteFullBright, bIsSpriteTransparent);
+    uint32_t spriteResourceNum;
+    uint32_t spriteSubImageNum;
+    getSpriteDetailsForMapObj(
+        thing,
+        gViewXFrac,
+        gViewYFrac,
+        spriteFrameAngle,
+        spriteResourceNum,
+        spriteSubImageNum,
+        bIsSpriteFullBright,
+        bIsSpriteTransparent
+    );
 
     ASSERT(spriteFrameAngle->width > 0);
     ASSERT(spriteFrameAngle->height > 0);
@@ -258,6 +278,19 @@ void addSpriteToFrame(const mobj_t& thing) noexcept {
     // Makeup the draw sprite and add to the list
     DrawSprite drawSprite;
     drawSprite.pPixels = spriteFrameAngle->pTexture;
+    drawSprite.pLitPixels = nullptr;
+
+    // Transparent sprites have extra color multiplication and blending applied, so don't use the lit texture cache for those
+    if (!bIsSpriteTransparent) {
+        drawSprite.pLitPixels = LitTextureCache::getLitPixels(
+            spriteResourceNum,
+            spriteSubImageNum,
+            spriteFrameAngle->pTexture,
+            (uint32_t) spriteFrameAngle->width * spriteFrameAngle->height,
+            lightMul
+        );
+    }
+
     drawSprite.worldX = worldX;
     drawSprite.worldY = worldY;
     drawSprite.screenLx = screenLx;
@@ -275,16 +308,164 @@ void addSpriteToFrame(const mobj_t& thing) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Sorts all sprites in the 3d view submitted to the renderer from back to front
+// Sprite depth sorting.
+//
+// Rather than moving the sprites themselves around, a 32-bit key is made from the depth of each sprite and the keys are sorted along with
+// the index of each sprite using an LSD radix sort, one byte at a time. The sort is stable, so sprites at exactly the same depth are
+// always drawn in the order they were submitted in and the result does not depend on how the sort happens to shuffle them.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SpriteSortEntry {
+    uint32_t    key;        // Sort key made from the sprite depth: lower keys are further away and are drawn first
+    uint32_t    spriteIdx;  // Index of the sprite in 'gDrawSprites'
+};
+
+static std::vector<SpriteSortEntry> gSpriteSortEntries;
+static std::vector<SpriteSortEntry> gSpriteSortTmpEntries;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes a sort key for a sprite which orders it from back to front.
+// The bits of the float are flipped so that they compare the same as the float as an unsigned integer, then inverted for descending order.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static inline uint32_t getSpriteSortKey(const float depth) noexcept {
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    const uint32_t orderedBits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return ~orderedBits;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void sortAllSprites() noexcept {
-    std::sort(
-        gDrawSprites.begin(),
-        gDrawSprites.end(),
-        [](const DrawSprite& s1, const DrawSprite& s2) noexcept {
-            return (s1.depth > s2.depth);
+// Sorts all sprites in the 3d view submitted to the renderer from back to front.
+// Fills in 'gSortedDrawSprites' with the order to draw the sprites in; the sprites in 'gDrawSprites' are left where they are.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void sortAllSprites() noexcept {
+    const uint32_t numSprites = (uint32_t) gDrawSprites.size();
+    gSpriteSortEntries.resize(numSprites);
+    gSpriteSortTmpEntries.resize(numSprites);
+
+    // Make the keys and count how many of each byte value there are for all 4 bytes of the key, in one pass
+    uint32_t byteCounts[4][256] = {};
+
+    for (uint32_t i = 0; i < numSprites; ++i) {
+        const uint32_t key = getSpriteSortKey(gDrawSprites[i].depth);
+        gSpriteSortEntries[i] = { key, i };
+
+        byteCounts[0][key & 0xFF]++;
+        byteCounts[1][(key >> 8) & 0xFF]++;
+        byteCounts[2][(key >> 16) & 0xFF]++;
+        byteCounts[3][key >> 24]++;
+    }
+
+    // Do a counting sort pass for each byte of the key, lowest first.
+    // Bytes which are the same for every sprite (usually the highest ones) don't change the order, so the pass can be skipped.
+    SpriteSortEntry* pSrc = gSpriteSortEntries.data();
+    SpriteSortEntry* pDst = gSpriteSortTmpEntries.data();
+
+    for (uint32_t byteIdx = 0; byteIdx < 4; ++byteIdx) {
+        uint32_t (&counts)[256] = byteCounts[byteIdx];
+        const uint32_t shift = byteIdx * 8;
+
+        if ((numSprites == 0) || (counts[(pSrc[0].key >> shift) & 0xFF] == numSprites))
+            continue;
+
+        uint32_t offset = 0;
+
+        for (uint32_t& count : counts) {
+            const uint32_t thisCount = count;
+            count = offset;
+            offset += thisCount;
         }
-    );
+
+        for (uint32_t i = 0; i < numSprites; ++i) {
+            const SpriteSortEntry& entry = pSrc[i];
+            pDst[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+
+        std::swap(pSrc, pDst);
+    }
+
+    // Save the final draw order
+    gSortedDrawSprites.resize(numSprites);
+
+    for (uint32_t i = 0; i < numSprites; ++i) {
+        gSortedDrawSprites[i] = pSrc[i].spriteIdx;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Coarse occlusion culling of sprites against the occluding columns, done before the sprites are sorted and split into fragments.
+//
+// If a sprite is deeper than both ends of a line then that line's occluding column bounds always apply to the sprite when it is clipped
+// (see 'clipSpriteFragmentAgainstOccludingCols'). So for each screen column, the sprite can't be seen if it is deeper than one of these
+// lines whose bounds leave no rows visible. For each group of columns the maximum of this 'hidden' depth is kept, and a sprite which is
+// deeper than that for every group it touches is removed. This is conservative: the groups at the edges of the sprite may include
+// columns which it doesn't cover, and anything which is only partly hidden is left to the per column clipping.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr uint32_t SPRITE_CULL_GROUP_SHIFT = 3;      // Columns are grouped in 8s
+
+static std::vector<float> gSpriteCullGroupDepths;           // For each group of columns: sprites deeper than this are hidden
+
+static float getOccludingColsHiddenDepth(const OccludingColumns& cols) noexcept {
+    float hiddenDepth = INFINITY;
+
+    for (uint32_t i = 0; i < cols.count; ++i) {
+        const OccludingColumns::Bounds bounds = cols.bounds[i];
+
+        if ((int32_t) bounds.bottom - (int32_t) bounds.top > 1)
+            continue;   // Some rows still visible
+
+        const line_t& line = *cols.pLines[i];
+        hiddenDepth = std::min(hiddenDepth, std::max(line.v1DrawDepth, line.v2DrawDepth));
+    }
+
+    return hiddenDepth;
+}
+
+static void buildSpriteCullGroupDepths() noexcept {
+    const uint32_t numGroups = (g3dViewWidth + (1 << SPRITE_CULL_GROUP_SHIFT) - 1) >> SPRITE_CULL_GROUP_SHIFT;
+    gSpriteCullGroupDepths.resize(numGroups);
+
+    for (uint32_t groupIdx = 0; groupIdx < numGroups; ++groupIdx) {
+        const uint32_t startX = groupIdx << SPRITE_CULL_GROUP_SHIFT;
+        const uint32_t endX = std::min(startX + (1 << SPRITE_CULL_GROUP_SHIFT), g3dViewWidth);
+        float groupDepth = 0.0f;
+
+        for (uint32_t x = startX; x < endX; ++x) {
+            groupDepth = std::max(groupDepth, getOccludingColsHiddenDepth(gOccludingCols[x]));
+        }
+
+        gSpriteCullGroupDepths[groupIdx] = groupDepth;
+    }
+}
+
+static bool isSpriteHidden(const DrawSprite& sprite) noexcept {
+    // The range of columns that 'drawSprite' might touch, including an extra column at the end
+    const int32_t startX = std::max((int32_t) sprite.screenLx, 0);
+    const int32_t endX = std::min((int32_t) sprite.screenRx + 1, (int32_t) g3dViewWidth - 1);
+
+    if (startX > endX)
+        return false;
+
+    const uint32_t endGroupIdx = (uint32_t) endX >> SPRITE_CULL_GROUP_SHIFT;
+
+    for (uint32_t groupIdx = (uint32_t) startX >> SPRITE_CULL_GROUP_SHIFT; groupIdx <= endGroupIdx; ++groupIdx) {
+        if (sprite.depth <= gSpriteCullGroupDepths[groupIdx])
+            return false;
+    }
+
+    return true;
+}
+
+uint32_t cullOccludedSprites() noexcept {
+    PROFILE_SCOPE("cullOccludedSprites");
+
+    if (gDrawSprites.empty())
+        return 0;
+
+    buildSpriteCullGroupDepths();
+
+    const size_t numSprites = gDrawSprites.size();
+    gDrawSprites.erase(std::remove_if(gDrawSprites.begin(), gDrawSprites.end(), isSpriteHidden), gDrawSprites.end());
+    return (uint32_t)(numSprites - gDrawSprites.size());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -295,6 +476,27 @@ enum class SpriteFlipMode {
     FLIPPED
 };
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prepares the clip cache for drawing a new sprite: invalidates all of the 'in front' tests done for the previous sprite
+//------------------------------------------------------------------------------------------------------------------------------------------
+void SpriteClipCache::beginSprite() noexcept {
+    // Ensure there is an entry for every line in the map
+    if (lineSpriteIds.size() != gNumLines) {
+        lineSpriteIds.clear();
+        lineSpriteIds.resize(gNumLines, 0);
+        lineInFrontFlags.resize(gNumLines);
+        curSpriteId = 0;
+    }
+
+    // Move onto the next sprite id, clearing all the ids if we happen to wrap around (so old results are not mistaken as current)
+    ++curSpriteId;
+
+    if (curSpriteId == 0) {
+        std::fill(lineSpriteIds.begin(), lineSpriteIds.end(), 0);
+        curSpriteId = 1;
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Clips the given sprite column against the given set of occluding columns.
 // Modifies the given top and bottom y clip bounds.
@@ -302,18 +504,23 @@ enum class SpriteFlipMode {
 static void clipSpriteFragmentAgainstOccludingCols(
     const SpriteFragment& frag,
     const OccludingColumns& cols,
+    SpriteClipCache& clipCache,
     int16_t& yClipT,
     int16_t& yClipB
 ) noexcept {
-    const uint32_t validCount = gValidCount;
+    const uint32_t spriteId = clipCache.curSpriteId;
+    uint32_t* const pLineSpriteIds = clipCache.lineSpriteIds.data();
+    uint8_t* const pLineInFrontFlags = clipCache.lineInFrontFlags.data();
     const uint32_t numCols = cols.count;
     BLIT_ASSERT(numCols <= OccludingColumns::MAX_ENTRIES);
     
     for (uint32_t i = 0; i < numCols; ++i) {
         // Grab the line associated with this column and see if we did an 'in front' test against this column
-        line_t& line = *cols.pLines[i];
+        const line_t& line = *cols.pLines[i];
+        const uint32_t lineIdx = (uint32_t)(&line - gpLines);
+        BLIT_ASSERT(lineIdx < clipCache.lineSpriteIds.size());
 
-        if (line.validCount != validCount) {
+        if (pLineSpriteIds[lineIdx] != spriteId) {
             // Get the min and max depths of the line. These are used for tests that take precedence over
             // the cross-product test determining whether the sprite is in front of the line:
             //
@@ -332,10 +539,10 @@ static void clipSpriteFragmentAgainstOccludingCols(
             const float lineMaxDepth = std::max(line.v1DrawDepth, line.v2DrawDepth);
 
             if (frag.depth > lineMaxDepth) {
-                line.bIsInFrontOfSprite = true;
+                pLineInFrontFlags[lineIdx] = true;
             } 
             else if (frag.depth < lineMinDepth) {
-                line.bIsInFrontOfSprite = false;
+                pLineInFrontFlags[lineIdx] = false;
             }
             else {
                 // Okay, this is where we do the magic cross product check to see if the sprite is in 'front' of the line.
@@ -356,15 +563,15 @@ static void clipSpriteFragmentAgainstOccludingCols(
 
                 const float a = spriteRx * lineDy;
                 const float b = spriteRy * lineDx;
-                line.bIsInFrontOfSprite = (a < b);
+                pLineInFrontFlags[lineIdx] = (a < b);
             }
 
             // Don't run this calculation again for this sprite
-            line.validCount = validCount;
+            pLineSpriteIds[lineIdx] = spriteId;
         }
 
         // Ignore this line if it is not in front of the sprite
-        if (!line.bIsInFrontOfSprite)
+        if (!pLineInFrontFlags[lineIdx])
             continue;
         
         // This line occludes the sprite: update the clip bounds
@@ -377,16 +584,21 @@ static void clipSpriteFragmentAgainstOccludingCols(
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Clips and draws a single sprite fragment
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void clipAndDrawSpriteFragment(const SpriteFragment& frag) noexcept {
+static void clipAndDrawSpriteFragment(const SpriteFragment& frag, SpriteClipCache& clipCache, const DrawTarget& target) noexcept {
     BLIT_ASSERT(frag.x < g3dViewWidth);
+    BLIT_ASSERT((frag.x >= target.x) && (frag.x < target.x + (int32_t) target.width));
+
+    // Firstly figure out the top and bottom clip bounds for the sprite fragment, starting with the bounds of the draw target.
+    // Skip the occlusion tests if the fragment is entirely outside of the draw target.
+    int16_t yClipT = (int16_t)(target.y - 1);
+    int16_t yClipB = (int16_t)(target.y + (int32_t) target.height);
 
-    // Firstly figure out the top and bottom clip bounds for the sprite fragment
-    int16_t yClipT = -1;
-    int16_t yClipB = (int16_t) g3dViewHeight;
+    if ((frag.y >= yClipB) || (frag.y + (int32_t) frag.height <= yClipT + 1))
+        return;
 
     {
         const OccludingColumns& occludingCols = gOccludingCols[frag.x];
-        clipSpriteFragmentAgainstOccludingCols(frag, occludingCols, yClipT, yClipB);
+        clipSpriteFragmentAgainstOccludingCols(frag, occludingCols, clipCache, yClipT, yClipB);
     }
 
     // If we are drawing nothing then bail
@@ -426,32 +638,46 @@ static void clipAndDrawSpriteFragment(const SpriteFragment& frag) noexcept {
     }
 
     // Draw the actual sprite column
-    if (!frag.isTransparent) {
+    uint32_t* const pDstColumn = target.getPixel((uint32_t)(frag.x - target.x), 0);
+
+    if (frag.pLitSpriteColPixels) {
         Blit::blitColumn<
             Blit::BCF_STEP_Y |
             Blit::BCF_ALPHA_TEST |
-            Blit::BCF_COLOR_MULT_RGB |
             Blit::BCF_V_WRAP_DISCARD |
             Blit::BCF_V_CLIP
         >(
-            frag.pSpriteColPixels,
+            frag.pLitSpriteColPixels,
             1,
             frag.texH,
             0.0f,
             srcTexY,
             0.0f,
             srcTexYSubPixelAdjust,
-            Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset,
-            g3dViewWidth,
-            g3dViewHeight,
-            Video::gScreenWidth,
-            frag.x,
-            dstY,
+            pDstColumn,
+            1,
+            target.height,
+            target.getColumnPixelStep(),
+            0,
+            dstY - target.y,
             dstCount,
             0.0f,
+            frag.texYStep
+        );
+    } else if (!frag.isTransparent) {
+        BlitSimd::blitSpriteColumn(
+            frag.pSpriteColPixels,
+            frag.texH,
+            srcTexY,
+            srcTexYSubPixelAdjust,
+            pDstColumn,
+            1,
+            target.height,
+            target.getColumnPixelStep(),
+            0,
+            dstY - target.y,
+            dstCount,
             frag.texYStep,
-            frag.lightMul,
-            frag.lightMul,
             frag.lightMul
         );
     } else {
@@ -471,12 +697,12 @@ static void clipAndDrawSpriteFragment(const SpriteFragment& frag) noexcept {
             srcTexY,
             0.0f,
             srcTexYSubPixelAdjust,
-            Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset,
-            g3dViewWidth,
-            g3dViewHeight,
-            Video::gScreenWidth,
-            frag.x,
-            dstY,
+            pDstColumn,
+            1,
+            target.height,
+            target.getColumnPixelStep(),
+            0,
+            dstY - target.y,
             dstCount,
             0.0f,
             frag.texYStep,
@@ -489,10 +715,17 @@ static void clipAndDrawSpriteFragment(const SpriteFragment& frag) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Emit the sprite fragments for one draw sprite
+// Emit the sprite fragments for one draw sprite.
+// Only columns within the given screen column range are drawn, the rest of the sprite is ignored.
 //------------------------------------------------------------------------------------------------------------------------------------------
 template <SpriteFlipMode FLIP_MODE>
-static void drawSprite(const DrawSprite& sprite) noexcept {
+static void drawSprite(
+    const DrawSprite& sprite,
+    const int32_t rangeStartX,
+    const int32_t rangeEndX,
+    SpriteClipCache& clipCache,
+    const DrawTarget& target
+) noexcept {
     BLIT_ASSERT(sprite.screenRx >= sprite.screenLx);
     BLIT_ASSERT(sprite.screenBy >= sprite.screenTy);
 
@@ -508,6 +741,10 @@ static void drawSprite(const DrawSprite& sprite) noexcept {
     int32_t spriteWInt = spriteRxInt - spriteLxInt + 1;
     int32_t spriteHInt = spriteByInt - spriteTyInt + 1;
 
+    // Bail if the sprite is entirely above or below the draw target
+    if ((spriteByInt < target.y) || (spriteTyInt >= target.y + (int32_t) target.height))
+        return;
+
     // Figure out x and y texcoord stepping
     const uint16_t texWInt = sprite.texW;
     const uint16_t texHInt = sprite.texH;
@@ -555,8 +792,16 @@ static void drawSprite(const DrawSprite& sprite) noexcept {
         endScreenX = spriteRxInt + 1;
     }
 
-    // Increment this marker for clipping checks
-    ++gValidCount;
+    // Bail if the sprite (including the extra column) is entirely outside of the range of columns being drawn
+    {
+        const int32_t lastScreenX = (bDoExtraCol) ? endScreenX : endScreenX - 1;
+
+        if ((lastScreenX < rangeStartX) || (curScreenX >= rangeEndX))
+            return;
+    }
+
+    // Start a new set of line 'in front' tests for clipping
+    clipCache.beginSprite();
 
     // Emit the columns
     {
@@ -568,6 +813,24 @@ static void drawSprite(const DrawSprite& sprite) noexcept {
             texXf = 0.0f;
         }
 
+        // Skip past columns that are to the left of the range being drawn.
+        // Note that the first column of the sprite drawn always uses the initial texture coordinate above, even if it was clipped
+        // by the screen edge - hence we only recompute the coordinate if we're skipping over columns for the range.
+        // Skipping these columns is the same as stepping through them one by one, since the texture coordinate only ever moves
+        // in one direction and so any column causing the loop below to exit early would also cause an exit here.
+        if (curScreenX < rangeStartX) {
+            curColNum += (uint32_t)(rangeStartX - curScreenX);
+            curScreenX = rangeStartX;
+
+            if constexpr (FLIP_MODE == SpriteFlipMode::FLIPPED) {
+                texXf = texW - std::max(texXStep * (float) curColNum + texSubPixelXAdjust, 0.5f);
+            } else {
+                texXf = std::max(texXStep * (float) curColNum + texSubPixelXAdjust, 0.0f);
+            }
+        }
+
+        endScreenX = std::min(endScreenX, rangeEndX);
+
         while (curScreenX < endScreenX) {
             BLIT_ASSERT(curScreenX >= 0 && curScreenX < (int32_t) g3dViewWidth);
             const uint16_t texX = (uint16_t) texXf;
@@ -586,10 +849,11 @@ static void drawSprite(const DrawSprite& sprite) noexcept {
             frag.texYStep = texYStep;
             frag.texYSubPixelAdjust = texSubPixelYAdjust;
             frag.pSpriteColPixels = sprite.pPixels + (uintptr_t) texX * texHInt;
+            frag.pLitSpriteColPixels = (sprite.pLitPixels) ? sprite.pLitPixels + (uintptr_t) texX * texHInt : nullptr;
             frag.spriteWorldX = sprite.worldX;
             frag.spriteWorldY = sprite.worldY;
 
-            clipAndDrawSpriteFragment(frag);
+            clipAndDrawSpriteFragment(frag, clipCache, target);
 
             ++curScreenX;
             ++curColNum;
@@ -606,7 +870,7 @@ static void drawSprite(const DrawSprite& sprite) noexcept {
     if (bDoExtraCol) {
         curScreenX = spriteRxInt + 1;
 
-        if (curScreenX < (int32_t) g3dViewWidth) {
+        if ((curScreenX < (int32_t) g3dViewWidth) && (curScreenX >= rangeStartX) && (curScreenX < rangeEndX)) {
             const uint16_t texX = (FLIP_MODE == SpriteFlipMode::FLIPPED) ? 0 : texWInt - 1;
 
             SpriteFragment frag;
@@ -620,27 +884,78 @@ static void drawSprite(const DrawSprite& sprite) noexcept {
             frag.texYStep = texYStep;
             frag.texYSubPixelAdjust = texSubPixelYAdjust;
             frag.pSpriteColPixels = sprite.pPixels + (uintptr_t) texX * texHInt;
+            frag.pLitSpriteColPixels = (sprite.pLitPixels) ? sprite.pLitPixels + (uintptr_t) texX * texHInt : nullptr;
             frag.spriteWorldX = sprite.worldX;
             frag.spriteWorldY = sprite.worldY;
 
-            clipAndDrawSpriteFragment(frag);
+            clipAndDrawSpriteFragment(frag, clipCache, target);
         }
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Draw all the sprites in the 3D view from back to front
+// Gets the range of screen rows and columns that 'drawSprite' might touch for the given sprite, including the extra column at the end.
+// All bounds are inclusive and clamped to the 3D view. Returns 'false' if the sprite does not touch the view at all.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void drawAllSprites() noexcept {
-    sortAllSprites();
+bool getSpriteScreenBounds(const DrawSprite& sprite, uint32_t& lx, uint32_t& rx, uint32_t& ty, uint32_t& by) noexcept {
+    const int32_t startX = std::max((int32_t) sprite.screenLx, 0);
+    const int32_t endX = std::min((int32_t) sprite.screenRx + 1, (int32_t) g3dViewWidth - 1);
+    const int32_t startY = std::max((int32_t) sprite.screenTy, 0);
+    const int32_t endY = std::min((int32_t) sprite.screenBy + 2, (int32_t) g3dViewHeight - 1);   // Same 2 extra rows as 'drawSprite'
+
+    if ((startX > endX) || (startY > endY))
+        return false;
+
+    lx = (uint32_t) startX;
+    rx = (uint32_t) endX;
+    ty = (uint32_t) startY;
+    by = (uint32_t) endY;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the parts of the given sprites that fall within the given range of screen columns, in the order given (back to front).
+// Each column is only ever touched by sprites within the range, so this can be called in parallel for ranges that don't overlap;
+// each caller must supply its own clip cache however. The draw target must contain the entire column range.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void drawSpriteListInColumnRange(
+    const uint32_t* const pSpriteIndexes,
+    const uint32_t numSprites,
+    const uint32_t startX,
+    const uint32_t endX,
+    SpriteClipCache& clipCache,
+    const DrawTarget& target
+) noexcept {
+    BLIT_ASSERT(startX <= endX);
+    BLIT_ASSERT(endX <= g3dViewWidth);
+    BLIT_ASSERT(((int32_t) startX >= target.x) && ((int32_t) endX <= target.x + (int32_t) target.width));
+
+    for (uint32_t i = 0; i < numSprites; ++i) {
+        const DrawSprite& sprite = gDrawSprites[pSpriteIndexes[i]];
 
-    for (const DrawSprite& sprite : gDrawSprites) {
         if (sprite.bFlip) {
-            drawSprite<SpriteFlipMode::FLIPPED>(sprite);
+            drawSprite<SpriteFlipMode::FLIPPED>(sprite, (int32_t) startX, (int32_t) endX, clipCache, target);
         } else {
-            drawSprite<SpriteFlipMode::NOT_FLIPPED>(sprite);
+            drawSprite<SpriteFlipMode::NOT_FLIPPED>(sprite, (int32_t) startX, (int32_t) endX, clipCache, target);
         }
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the parts of all sorted sprites that fall within the given range of screen columns, from back to front
+//------------------------------------------------------------------------------------------------------------------------------------------
+void drawSpritesInColumnRange(const uint32_t startX, const uint32_t endX, SpriteClipCache& clipCache, const DrawTarget& target) noexcept {
+    drawSpriteListInColumnRange(gSortedDrawSprites.data(), (uint32_t) gSortedDrawSprites.size(), startX, endX, clipCache, target);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draw all the sprites in the 3D view from back to front
+//------------------------------------------------------------------------------------------------------------------------------------------
+void drawAllSprites() noexcept {
+    PROFILE_SCOPE("drawAllSprites");
+
+    sortAllSprites();
+    drawSpritesInColumnRange(0, g3dViewWidth, gSpriteClipCache, getViewDrawTarget());
+}
+
 END_NAMESPACE(Renderer)
@@ -0,0 +1,321 @@
+#include "Renderer_Internal.h"
+
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
+#include "Base/Tables.h"
+#include "Blit.h"
+#include "Game/Config.h"
+#include <algorithm>
+#include <cstring>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Code for drawing the fragments of the 3D view in small screen tiles.
+//
+// Drawing columns straight into the framebuffer touches a different cache line (and often a different page) for every pixel, which
+// gets slow at high resolutions where the rows of the framebuffer are far apart. Instead the view is split up into small square tiles
+// and every fragment is binned into each tile that it overlaps. Each tile is then drawn into a small buffer which fits easily within
+// the L1 cache, after which the tile is copied out to the framebuffer in one burst, a whole row at a time.
+//
+// Notes:
+//  (1) Tiles are independent of each other and are drawn as jobs, so they are also the unit of parallel work when there are multiple
+//      threads. Each thread has its own tile buffer and sprite clip cache.
+//  (2) Within a tile, fragments are drawn in exactly the same order as the serial path: sky, floors, ceilings, walls and then sprites.
+//      Sprites are binned by index into every tile that their screen bounds overlap, keeping their back to front order.
+//  (3) Column fragments are clipped vertically to the tile when drawn. Flats work out the texture coordinate for every pixel from
+//      scratch so are unaffected by this, but wall, sky and sprite columns crossing the top of a tile have their texture coordinate
+//      computed at the tile edge instead of being stepped there. This means the odd texel may come out very slightly different to
+//      when not drawing in tiles.
+//  (4) The framebuffer contents are loaded into the tile before drawing, so any pixels not covered by fragments are left untouched.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Renderer)
+
+// The width and height of a tile in pixels.
+// A 32x32 tile of 32-bit pixels is 4 KiB, which leaves plenty of room in the L1 cache for textures.
+static constexpr uint32_t TILE_SIZE = 32;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Holds all of the fragments to be drawn for one tile of the view
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct DrawTile {
+    std::vector<SkyFragment>    skyFragments;
+    std::vector<FlatFragment>   floorFragments;
+    std::vector<FlatFragment>   ceilFragments;
+    std::vector<WallFragment>   wallFragments;
+    std::vector<FlatSpan>       floorSpans;
+    std::vector<FlatSpan>       ceilSpans;
+    std::vector<uint32_t>       spriteIndexes;      // Indexes into 'gDrawSprites' of sprites overlapping the tile, from back to front
+
+    void clear() noexcept {
+        skyFragments.clear();
+        floorFragments.clear();
+        ceilFragments.clear();
+        wallFragments.clear();
+        floorSpans.clear();
+        ceilSpans.clear();
+        spriteIndexes.clear();
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Memory used by one thread for drawing tiles
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct TileThreadData {
+    alignas(64) uint32_t    pixels[TILE_SIZE * TILE_SIZE];      // The tile currently being drawn by the thread
+    SpriteClipCache         spriteClipCache;                    // Used for sprite clipping by the thread
+};
+
+static std::vector<DrawTile>            gDrawTiles;             // The tiles that the view is currently split into, in row major order
+static uint32_t                         gNumTileCols;           // How many tiles there are horizontally and vertically
+static uint32_t                         gNumTileRows;
+static std::vector<TileThreadData>      gTileThreadData;        // Tile drawing memory for each thread that can run jobs
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Figures out how many tiles the view is split into and clears them for this frame
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void setupDrawTilesForFrame() noexcept {
+    gNumTileCols = (g3dViewWidth + TILE_SIZE - 1) / TILE_SIZE;
+    gNumTileRows = (g3dViewHeight + TILE_SIZE - 1) / TILE_SIZE;
+    const uint32_t numTiles = gNumTileCols * gNumTileRows;
+
+    if (gDrawTiles.size() != numTiles) {
+        gDrawTiles.resize(numTiles);
+    }
+
+    for (DrawTile& tile : gDrawTiles) {
+        tile.clear();
+    }
+
+    const uint32_t numThreads = JobSystem::getNumThreads();
+
+    if (gTileThreadData.size() != numThreads) {
+        gTileThreadData.resize(numThreads);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bins a column fragment into every tile that the given range of rows in the column overlaps.
+// Fragments keep the same relative order within each tile, which keeps the output in the same draw order as the serial path.
+//------------------------------------------------------------------------------------------------------------------------------------------
+template <class FragT>
+static void binColumnFragmentIntoTiles(
+    const FragT& frag,
+    const uint32_t y,
+    const uint32_t height,
+    std::vector<FragT> DrawTile::* const pTileFragsMember
+) noexcept {
+    if (height <= 0)
+        return;
+
+    const uint32_t tileCol = (uint32_t) frag.x / TILE_SIZE;
+    const uint32_t startTileRow = y / TILE_SIZE;
+    const uint32_t endTileRow = std::min((y + height - 1) / TILE_SIZE, gNumTileRows - 1);
+    BLIT_ASSERT(tileCol < gNumTileCols);
+
+    DrawTile* pTile = gDrawTiles.data() + (uintptr_t) startTileRow * gNumTileCols + tileCol;
+
+    for (uint32_t tileRow = startTileRow; tileRow <= endTileRow; ++tileRow, pTile += gNumTileCols) {
+        (pTile->*pTileFragsMember).push_back(frag);
+    }
+}
+
+static void binSkyFragmentsIntoTiles() noexcept {
+    for (const SkyFragment& frag : gSkyFragments) {
+        binColumnFragmentIntoTiles(frag, 0, frag.height, &DrawTile::skyFragments);
+    }
+}
+
+static void binFlatFragmentsIntoTiles(const std::vector<FlatFragment>& frags, std::vector<FlatFragment> DrawTile::* const pTileFragsMember) noexcept {
+    for (const FlatFragment& frag : frags) {
+        binColumnFragmentIntoTiles(frag, frag.y, frag.height, pTileFragsMember);
+    }
+}
+
+static void binWallFragmentsIntoTiles() noexcept {
+    for (const WallFragment& frag : gWallFragments) {
+        binColumnFragmentIntoTiles(frag, frag.y, frag.height, &DrawTile::wallFragments);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bins floor or ceiling spans into the tiles that they overlap, splitting them where they cross tile boundaries
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void binFlatSpansIntoTiles(const std::vector<FlatSpan>& spans, std::vector<FlatSpan> DrawTile::* const pTileSpansMember) noexcept {
+    for (const FlatSpan& span : spans) {
+        const uint32_t tileRow = (uint32_t) span.y / TILE_SIZE;
+        const uint32_t startTileCol = (uint32_t) span.x1 / TILE_SIZE;
+        const uint32_t endTileCol = ((uint32_t) span.x2 - 1) / TILE_SIZE;
+        BLIT_ASSERT(tileRow < gNumTileRows);
+        BLIT_ASSERT(endTileCol < gNumTileCols);
+
+        DrawTile* const pTileRow = gDrawTiles.data() + (uintptr_t) tileRow * gNumTileCols;
+
+        for (uint32_t tileCol = startTileCol; tileCol <= endTileCol; ++tileCol) {
+            const uint32_t tileStartX = tileCol * TILE_SIZE;
+            const uint32_t tileEndX = tileStartX + TILE_SIZE;
+
+            FlatSpan& tileSpan = (pTileRow[tileCol].*pTileSpansMember).emplace_back(span);
+            tileSpan.x1 = (uint16_t) std::max<uint32_t>(span.x1, tileStartX);
+            tileSpan.x2 = (uint16_t) std::min<uint32_t>(span.x2, tileEndX);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bins the sorted sprites into the tiles that they overlap.
+// Sprites are visited from back to front so they stay in the same draw order within each tile.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void binSpritesIntoTiles() noexcept {
+    for (const uint32_t spriteIdx : gSortedDrawSprites) {
+        uint32_t lx, rx, ty, by;
+
+        if (!getSpriteScreenBounds(gDrawSprites[spriteIdx], lx, rx, ty, by))
+            continue;
+
+        const uint32_t startTileCol = lx / TILE_SIZE;
+        const uint32_t endTileCol = rx / TILE_SIZE;
+        const uint32_t startTileRow = ty / TILE_SIZE;
+        const uint32_t endTileRow = by / TILE_SIZE;
+        BLIT_ASSERT(endTileCol < gNumTileCols);
+        BLIT_ASSERT(endTileRow < gNumTileRows);
+
+        for (uint32_t tileRow = startTileRow; tileRow <= endTileRow; ++tileRow) {
+            DrawTile* const pTileRow = gDrawTiles.data() + (uintptr_t) tileRow * gNumTileCols;
+
+            for (uint32_t tileCol = startTileCol; tileCol <= endTileCol; ++tileCol) {
+                pTileRow[tileCol].spriteIndexes.push_back(spriteIdx);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Copy a tile sized area of pixels between the target for the whole view (framebuffer or column major view buffer) and a tile's target.
+// Tile targets are always row major.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void copyViewPixelsToTile(const DrawTarget& viewTarget, const DrawTarget& tileTarget) noexcept {
+    BLIT_ASSERT(!tileTarget.bColumnMajor);
+    const uint32_t viewPixelStep = viewTarget.getRowPixelStep();
+
+    for (uint32_t y = 0; y < tileTarget.height; ++y) {
+        const uint32_t* pSrcPixel = viewTarget.getPixel((uint32_t) tileTarget.x, (uint32_t) tileTarget.y + y);
+        uint32_t* const pDstRow = tileTarget.getPixel(0, y);
+
+        if (viewPixelStep == 1) {
+            std::memcpy(pDstRow, pSrcPixel, tileTarget.width * sizeof(uint32_t));
+        } else {
+            for (uint32_t x = 0; x < tileTarget.width; ++x, pSrcPixel += viewPixelStep) {
+                pDstRow[x] = *pSrcPixel;
+            }
+        }
+    }
+}
+
+static void copyTilePixelsToView(const DrawTarget& tileTarget, const DrawTarget& viewTarget) noexcept {
+    BLIT_ASSERT(!tileTarget.bColumnMajor);
+    const uint32_t viewPixelStep = viewTarget.getRowPixelStep();
+
+    for (uint32_t y = 0; y < tileTarget.height; ++y) {
+        const uint32_t* const pSrcRow = tileTarget.getPixel(0, y);
+        uint32_t* pDstPixel = viewTarget.getPixel((uint32_t) tileTarget.x, (uint32_t) tileTarget.y + y);
+
+        if (viewPixelStep == 1) {
+            std::memcpy(pDstPixel, pSrcRow, tileTarget.width * sizeof(uint32_t));
+        } else {
+            for (uint32_t x = 0; x < tileTarget.width; ++x, pDstPixel += viewPixelStep) {
+                *pDstPixel = pSrcRow[x];
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Job function which draws all of the fragments in one tile into the current thread's tile buffer and then copies it to the screen.
+// Draws in the same order as 'drawPlayerView' does for the serial path: sky, floors, ceilings, walls and then sprites.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void drawTileJob(const uint32_t tileIdx, [[maybe_unused]] void* const pUserData) noexcept {
+    DrawTile& tile = gDrawTiles[tileIdx];
+    TileThreadData& threadData = gTileThreadData[JobSystem::getThreadIdx()];
+
+    // Figure out the area of the view covered by the tile: tiles on the right and bottom edges might be cut short
+    const uint32_t tileX = (tileIdx % gNumTileCols) * TILE_SIZE;
+    const uint32_t tileY = (tileIdx / gNumTileCols) * TILE_SIZE;
+
+    DrawTarget tileTarget;
+    tileTarget.pPixels = threadData.pixels;
+    tileTarget.pitch = TILE_SIZE;
+    tileTarget.x = (int32_t) tileX;
+    tileTarget.y = (int32_t) tileY;
+    tileTarget.width = std::min(TILE_SIZE, g3dViewWidth - tileX);
+    tileTarget.height = std::min(TILE_SIZE, g3dViewHeight - tileY);
+    tileTarget.bColumnMajor = false;
+
+    const DrawTarget viewTarget = getViewDrawTarget();
+    copyViewPixelsToTile(viewTarget, tileTarget);
+
+    // Draw everything in the tile
+    for (const SkyFragment& skyFrag : tile.skyFragments) {
+        drawSkyFragment(skyFrag, tileTarget);
+    }
+
+    if (Config::gbDrawFlatsAsSpans) {
+        for (const FlatSpan& span : tile.floorSpans) {
+            drawFloorSpan(span, tileTarget);
+        }
+
+        for (const FlatFragment& flatFrag : tile.floorFragments) {
+            drawFloorFragmentClampedPixel(flatFrag, tileTarget);
+        }
+
+        for (const FlatSpan& span : tile.ceilSpans) {
+            drawCeilingSpan(span, tileTarget);
+        }
+
+        for (const FlatFragment& flatFrag : tile.ceilFragments) {
+            drawCeilingFragmentClampedPixel(flatFrag, tileTarget);
+        }
+    } else {
+        for (const FlatFragment& flatFrag : tile.floorFragments) {
+            drawFloorFragment(flatFrag, tileTarget);
+        }
+
+        for (const FlatFragment& flatFrag : tile.ceilFragments) {
+            drawCeilingFragment(flatFrag, tileTarget);
+        }
+    }
+
+    for (const WallFragment& wallFrag : tile.wallFragments) {
+        drawWallFragment(wallFrag, tileTarget);
+    }
+
+    drawSpriteListInColumnRange(
+        tile.spriteIndexes.data(),
+        (uint32_t) tile.spriteIndexes.size(),
+        tileX,
+        tileX + tileTarget.width,
+        threadData.spriteClipCache,
+        tileTarget
+    );
+
+    // Write out the finished tile
+    copyTilePixelsToView(tileTarget, viewTarget);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws all sky, floor, ceiling and wall fragments and sprites for the frame in tiles, using the job system
+//------------------------------------------------------------------------------------------------------------------------------------------
+void drawAllFragmentsInTiles() noexcept {
+    PROFILE_SCOPE("drawAllFragmentsInTiles");
+
+    sortAllSprites();
+    setupDrawTilesForFrame();
+    binSkyFragmentsIntoTiles();
+    binFlatFragmentsIntoTiles(gFloorFragments, &DrawTile::floorFragments);
+    binFlatFragmentsIntoTiles(gCeilFragments, &DrawTile::ceilFragments);
+    binWallFragmentsIntoTiles();
+    binFlatSpansIntoTiles(gFloorSpans, &DrawTile::floorSpans);
+    binFlatSpansIntoTiles(gCeilSpans, &DrawTile::ceilSpans);
+    binSpritesIntoTiles();
+    JobSystem::runJobs(drawTileJob, nullptr, (uint32_t) gDrawTiles.size());
+}
+
+END_NAMESPACE(Renderer)
@@ -1,10 +1,12 @@
 #include "Renderer_Internal.h"
 
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
 #include "Blit.h"
+#include "BlitSimd.h"
 #include "Map/Setup.h"
 #include "Textures.h"
-#include "Video.h"
+#include <algorithm>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Code for drawing walls and skies in the game.
@@ -16,10 +18,46 @@
 //------------------------------------------------------------------------------------------------------------------------------------------
 BEGIN_NAMESPACE(Renderer)
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Converts the vertical range of a wall or sky column to be relative to the given draw target and clips it against the target.
+// If pixels are clipped off the top then the texture coordinate is moved on to the first pixel still being drawn.
+// Returns 'false' if the column is entirely outside of the draw target.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool clipColumnToDrawTarget(
+    const DrawTarget& target,
+    int32_t& dstY,
+    uint32_t& dstCount,
+    float& srcY,
+    float& srcYSubPixelAdjust,
+    const float srcYStep
+) noexcept {
+    dstY -= target.y;
+
+    // Clip against the top of the draw target
+    if (dstY < 0) {
+        const uint32_t numPixelsOutOfBounds = (uint32_t) -dstY;
+
+        if (numPixelsOutOfBounds >= dstCount)
+            return false;
+
+        srcY = srcY + srcYStep * (float) numPixelsOutOfBounds + srcYSubPixelAdjust;
+        srcYSubPixelAdjust = 0.0f;
+        dstY = 0;
+        dstCount -= numPixelsOutOfBounds;
+    }
+
+    // Clip against the bottom of the draw target
+    if ((uint32_t) dstY >= target.height)
+        return false;
+
+    dstCount = std::min(dstCount, target.height - (uint32_t) dstY);
+    return true;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Draws a single column of the sky
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void drawSkyColumn(const uint32_t viewX, const uint32_t maxColHeight) noexcept {
+static void drawSkyColumn(const uint32_t viewX, const uint32_t maxColHeight, const DrawTarget& target) noexcept {
     // Figure out the angle this sky column is at.
     // From that figure out the texture coordinate: the sky texture is 256 pixels wide and repeats 4 times over a circle.
     const angle_t angle = gViewAngleBAM + gScreenXToAngleBAM[viewX];
@@ -38,6 +76,15 @@ static void drawSkyColumn(const uint32_t viewX, const uint32_t maxColHeight) noe
 
     const float texYStep = fixed16ToFloat(Blit::calcTexelStep(skyTexH, colHeight));
 
+    // Clip the sky column to the draw target
+    int32_t dstY = 0;
+    uint32_t dstCount = std::min(colHeight, maxColHeight);
+    float texY = 0.0f;
+    float texYSubPixelAdjust = 0.0f;
+
+    if ((dstCount <= 0) || (!clipColumnToDrawTarget(target, dstY, dstCount, texY, texYSubPixelAdjust, texYStep)))
+        return;
+
     // Draw the sky column
     Blit::blitColumn<
         Blit::BCF_STEP_Y
@@ -46,57 +93,105 @@ static void drawSkyColumn(const uint32_t viewX, const uint32_t maxColHeight) noe
         texImg.width,
         texImg.height,
         (float) texX,
+        texY,
         0.0f,
-        0.0f,
-        0.0f,
-        Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset,
-        g3dViewWidth,
-        g3dViewHeight,
-        Video::gScreenWidth,
-        (int32_t) viewX,
+        texYSubPixelAdjust,
+        target.getPixel(viewX - (uint32_t) target.x, 0),
+        1,
+        target.height,
+        target.getColumnPixelStep(),
         0,
-        std::min(colHeight, maxColHeight),
+        dstY,
+        dstCount,
         0,
         texYStep
     );
 }
 
-void drawAllWallFragments() noexcept {
-    for (const WallFragment& wallFrag : gWallFragments) {
-        const ImageData& wallImage = *wallFrag.pImageData;
+void drawWallFragment(const WallFragment& wallFrag, const DrawTarget& target) noexcept {
+    const ImageData& wallImage = *wallFrag.pImageData;
+
+    // Clip the wall column to the draw target
+    int32_t dstY = wallFrag.y;
+    uint32_t dstCount = wallFrag.height;
+    float texY = wallFrag.texcoordY;
+    float texYSubPixelAdjust = wallFrag.texcoordYSubPixelAdjust;
+
+    if ((dstCount <= 0) || (!clipColumnToDrawTarget(target, dstY, dstCount, texY, texYSubPixelAdjust, wallFrag.texcoordYStep)))
+        return;
 
+    const int32_t dstX = (int32_t) wallFrag.x - target.x;
+    BLIT_ASSERT((dstX >= 0) && (dstX < (int32_t) target.width));
+    uint32_t* const pDstColumn = target.getPixel((uint32_t) dstX, 0);
+
+    // If the texture has been pre-lit then just copy the lit texels, otherwise light them as we go
+    if (wallFrag.pLitPixels) {
         Blit::blitColumn<
             Blit::BCF_STEP_Y |
             Blit::BCF_H_WRAP_WRAP |
-            Blit::BCF_V_WRAP_WRAP |
-            Blit::BCF_COLOR_MULT_RGB
+            Blit::BCF_V_WRAP_WRAP
         >(
-            wallImage.pPixels,
+            wallFrag.pLitPixels,
             wallImage.width,
             wallImage.height,
             (float) wallFrag.texcoordX,
-            wallFrag.texcoordY,
+            texY,
             0.0f,
-            wallFrag.texcoordYSubPixelAdjust,
-            Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset,
-            g3dViewWidth,
-            g3dViewHeight,
-            Video::gScreenWidth,
-            wallFrag.x,
-            wallFrag.y,
-            wallFrag.height,
+            texYSubPixelAdjust,
+            pDstColumn,
+            1,
+            target.height,
+            target.getColumnPixelStep(),
+            0,
+            dstY,
+            dstCount,
             0,
-            wallFrag.texcoordYStep,
-            wallFrag.lightMul,
-            wallFrag.lightMul,
-            wallFrag.lightMul
+            wallFrag.texcoordYStep
         );
+
+        return;
     }
+
+    BlitSimd::blitWallColumn(
+        wallImage.pPixels,
+        wallImage.width,
+        wallImage.height,
+        (float) wallFrag.texcoordX,
+        texY,
+        texYSubPixelAdjust,
+        pDstColumn,
+        1,
+        target.height,
+        target.getColumnPixelStep(),
+        0,
+        dstY,
+        dstCount,
+        wallFrag.texcoordYStep,
+        wallFrag.lightMul
+    );
+}
+
+void drawAllWallFragments() noexcept {
+    PROFILE_SCOPE("drawAllWallFragments");
+
+    const DrawTarget target = getViewDrawTarget();
+
+    for (const WallFragment& wallFrag : gWallFragments) {
+        drawWallFragment(wallFrag, target);
+    }
+}
+
+void drawSkyFragment(const SkyFragment& skyFrag, const DrawTarget& target) noexcept {
+    drawSkyColumn(skyFrag.x, skyFrag.height, target);
 }
 
 void drawAllSkyFragments() noexcept {
+    PROFILE_SCOPE("drawAllSkyFragments");
+
+    const DrawTarget target = getViewDrawTarget();
+
     for (const SkyFragment& skyFrag : gSkyFragments) {
-        drawSkyColumn(skyFrag.x, skyFrag.height);
+        drawSkyColumn(skyFrag.x, skyFrag.height, target);
     }
 }
 
@@ -1,9 +1,11 @@
 ﻿#include "Renderer_Internal.h"
 
 #include "Base/Tables.h"
+#include "Game/Config.h"
 #include "Map/MapData.h"
 #include "Textures.h"
 #include "Blit.h"
+#include "LitTextureCache.h"
 
 BEGIN_NAMESPACE(Renderer)
 
@@ -478,7 +480,7 @@ static uint32_t clipAndEmitWallColumn(
     SegClip& clipBounds,
     const LightParams& lightParams,
     const float segLightMul,
-    const ImageData& texImage
+    const Texture& tex
 ) noexcept {
     ASSERT(x < g3dViewWidth);
 
@@ -558,7 +560,14 @@ static uint32_t clipAndEmitWallColumn(
         frag.texcoordYSubPixelAdjust = texYSubPixelAdjustment;
         frag.texcoordYStep = texYStep;
         frag.lightMul = lightParams.getLightMulForDist(depth) * segLightMul;
-        frag.pImageData = &texImage;
+        frag.pImageData = &tex.data;
+        frag.pLitPixels = LitTextureCache::getLitPixels(
+            tex.resourceNum,
+            0,
+            tex.data.pPixels,
+            tex.data.width * tex.data.height,
+            frag.lightMul
+        );
 
         gWallFragments.push_back(frag);
         numColumnsEmitted = 1;
@@ -1317,7 +1326,7 @@ static uint32_t emitDrawSegColumns(const DrawSeg& drawSeg, seg_t& seg) noexcept
                 clipBounds,
                 lightParams,
                 seg.lightMul,
-                pMidTex->data
+                *pMidTex
             );
         }
 
@@ -1333,7 +1342,7 @@ static uint32_t emitDrawSegColumns(const DrawSeg& drawSeg, seg_t& seg) noexcept
                 clipBounds,
                 lightParams,
                 seg.lightMul,
-                pLowerTex->data
+                *pLowerTex
             );
         }
 
@@ -1349,7 +1358,7 @@ static uint32_t emitDrawSegColumns(const DrawSeg& drawSeg, seg_t& seg) noexcept
                 clipBounds,
                 lightParams,
                 seg.lightMul,
-                pUpperTex->data
+                *pUpperTex
             );
         }
 
@@ -1383,9 +1392,12 @@ static uint32_t emitDrawSegColumns(const DrawSeg& drawSeg, seg_t& seg) noexcept
     return numWallAndFlatCols;
 }
 
-void addSegToFrame(seg_t& seg) noexcept {
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Transforms the given seg to screen space, clipping it against the view frustum.
+// Returns 'false' if the seg is not visible because it is outside of the view or back facing.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool transformSegToScreenSpace(const seg_t& seg, DrawSeg& drawSeg) noexcept {
     // First transform the seg into viewspace and populate vertex attributes
-    DrawSeg drawSeg;
     populateSegVertexAttribs(seg, drawSeg);
     transformSegXYToViewSpace(seg, drawSeg);
 
@@ -1393,13 +1405,13 @@ void addSegToFrame(seg_t& seg) noexcept {
     transformSegXYWToClipSpace(drawSeg);
 
     if (!clipSegAgainstFrontPlane(drawSeg))
-        return;
+        return false;
 
     if (!clipSegAgainstLeftPlane(drawSeg))
-        return;
+        return false;
 
     if (!clipSegAgainstRightPlane(drawSeg))
-        return;
+        return false;
 
     // Now that the seg is not rejected fill in the height values.
     // This function and also determines if we can draw the ceiling/floor and emit occluders based on those z values.
@@ -1410,9 +1422,146 @@ void addSegToFrame(seg_t& seg) noexcept {
     transformSegXZToScreenSpace(drawSeg);
 
     // Determine if the seg is back facing and cull if it is
-    if (isScreenSpaceSegBackFacing(drawSeg))
+    return (!isScreenSpaceSegBackFacing(drawSeg));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Cache of segs transformed to screen space, so that segs don't need to be transformed again every frame if the view doesn't move.
+//
+// The cache is keyed on the view: if anything about it changes from one frame to the next then every entry is invalidated at once, by
+// moving onto a new view stamp. Otherwise an entry is still good if the heights of the sectors on either side of the seg have not been
+// changed by a mover since (see 'markSectorHeightsChanged') and the texture offset for the seg's side is the same (it can be scrolled).
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct CachedDrawSeg {
+    uint32_t    viewStamp;                  // The view that this was cached for, or '0' if not valid
+    uint32_t    frontHeightsVersion;        // Heights versions for the front and back sectors when this was cached
+    uint32_t    backHeightsVersion;
+    float       sideTexXOffset;             // Texture offset of the seg's side when this was cached
+    bool        bVisible;                   // Whether the seg was visible, if not then the draw seg is undefined
+    DrawSeg     drawSeg;
+};
+
+// Everything about the view that affects how segs are transformed
+struct DrawSegCacheView {
+    float               viewX;
+    float               viewY;
+    float               viewZ;
+    float               viewCos;
+    float               viewSin;
+    ProjectionMatrix    projMatrix;
+    uint32_t            viewWidth;
+    uint32_t            viewHeight;
+
+    bool operator == (const DrawSegCacheView& other) const noexcept {
+        return (
+            (viewX == other.viewX) &&
+            (viewY == other.viewY) &&
+            (viewZ == other.viewZ) &&
+            (viewCos == other.viewCos) &&
+            (viewSin == other.viewSin) &&
+            (projMatrix.r0c0 == other.projMatrix.r0c0) &&
+            (projMatrix.r1c1 == other.projMatrix.r1c1) &&
+            (projMatrix.r2c2 == other.projMatrix.r2c2) &&
+            (projMatrix.r2c3 == other.projMatrix.r2c3) &&
+            (viewWidth == other.viewWidth) &&
+            (viewHeight == other.viewHeight)
+        );
+    }
+};
+
+static std::vector<CachedDrawSeg>   gCachedDrawSegs;
+static DrawSegCacheView             gDrawSegCacheView;
+static uint32_t                     gDrawSegCacheViewStamp;
+static uint32_t                     gNumDrawSegCacheHits;
+
+void beginDrawSegCacheFrame() noexcept {
+    gNumDrawSegCacheHits = 0;
+
+    if (!Config::gbCacheSegTransforms)
         return;
-    
+
+    // Ensure there is an entry for every seg in the map: start over with a new view if the map has changed
+    bool bNewView = false;
+
+    if (gCachedDrawSegs.size() != gNumLineSegs) {
+        gCachedDrawSegs.clear();
+        gCachedDrawSegs.resize(gNumLineSegs);
+        bNewView = true;
+    }
+
+    // Has the view changed since last frame?
+    const DrawSegCacheView view = { gViewX, gViewY, gViewZ, gViewCos, gViewSin, gProjMatrix, g3dViewWidth, g3dViewHeight };
+
+    if (!(view == gDrawSegCacheView)) {
+        gDrawSegCacheView = view;
+        bNewView = true;
+    }
+
+    // Move onto the next view stamp if required, clearing all the stamps if we happen to wrap around (so old entries are not mistaken as current)
+    if (bNewView) {
+        ++gDrawSegCacheViewStamp;
+
+        if (gDrawSegCacheViewStamp == 0) {
+            for (CachedDrawSeg& cachedSeg : gCachedDrawSegs) {
+                cachedSeg.viewStamp = 0;
+            }
+
+            gDrawSegCacheViewStamp = 1;
+        }
+    }
+}
+
+uint32_t getNumDrawSegCacheHits() noexcept {
+    return gNumDrawSegCacheHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the screen space version of the given seg, from the cache if possible.
+// Returns 'false' if the seg is not visible because it is outside of the view or back facing.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool getScreenSpaceSeg(const seg_t& seg, DrawSeg& drawSeg) noexcept {
+    if (!Config::gbCacheSegTransforms)
+        return transformSegToScreenSpace(seg, drawSeg);
+
+    const uint32_t segIdx = (uint32_t)(&seg - gpLineSegs);
+    ASSERT(segIdx < gCachedDrawSegs.size());
+    CachedDrawSeg& cachedSeg = gCachedDrawSegs[segIdx];
+
+    const uint32_t frontHeightsVersion = seg.frontsector->heightsVersion;
+    const uint32_t backHeightsVersion = (seg.backsector) ? seg.backsector->heightsVersion : 0;
+    const float sideTexXOffset = seg.sidedef->texXOffset;
+
+    const bool bCacheHit = (
+        (cachedSeg.viewStamp == gDrawSegCacheViewStamp) &&
+        (cachedSeg.frontHeightsVersion == frontHeightsVersion) &&
+        (cachedSeg.backHeightsVersion == backHeightsVersion) &&
+        (cachedSeg.sideTexXOffset == sideTexXOffset)
+    );
+
+    if (bCacheHit) {
+        ++gNumDrawSegCacheHits;
+    } else {
+        cachedSeg.viewStamp = gDrawSegCacheViewStamp;
+        cachedSeg.frontHeightsVersion = frontHeightsVersion;
+        cachedSeg.backHeightsVersion = backHeightsVersion;
+        cachedSeg.sideTexXOffset = sideTexXOffset;
+        cachedSeg.bVisible = transformSegToScreenSpace(seg, cachedSeg.drawSeg);
+    }
+
+    if (!cachedSeg.bVisible)
+        return false;
+
+    drawSeg = cachedSeg.drawSeg;
+    return true;
+}
+
+void addSegToFrame(seg_t& seg) noexcept {
+    // First transform the seg to screen space, or reuse the result from a previous frame if nothing has changed
+    DrawSeg drawSeg;
+
+    if (!getScreenSpaceSeg(seg, drawSeg))
+        return;
+
     // Line: mark what side of the line we are drawing and get the depths of the two endpoints
     line_t& line = *seg.linedef;
     line.drawnSideIndex = seg.getLineSideIndex();
@@ -1,5 +1,6 @@
 #include "Renderer_Internal.h"
 
+#include "Base/Profiler.h"
 #include "Base/Tables.h"
 #include "Blit.h"
 #include "CelImages.h"
@@ -67,8 +68,8 @@ static void DrawAWeapon(const pspdef_t& psp, const bool bShadow) noexcept {
             (float) img.width,
             (float) img.height,
             Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset,
-            g3dViewWidth,
-            g3dViewHeight,
+            g3dViewScreenWidth,
+            g3dViewScreenHeight,
             Video::gScreenWidth,
             (float) gunX,
             (float) gunY,
@@ -95,8 +96,8 @@ static void DrawAWeapon(const pspdef_t& psp, const bool bShadow) noexcept {
             (float) img.width,
             (float) img.height,
             Video::gpFrameBuffer + (uintptr_t) g3dViewYOffset * Video::gScreenWidth + g3dViewXOffset,
-            g3dViewWidth,
-            g3dViewHeight,
+            g3dViewScreenWidth,
+            g3dViewScreenHeight,
             Video::gScreenWidth,
             (float) gunX,
             (float) gunY,
@@ -115,6 +116,8 @@ static void DrawAWeapon(const pspdef_t& psp, const bool bShadow) noexcept {
 // Draw the player's weapon in the foreground
 //------------------------------------------------------------------------------------------------------------------------------------------
 void drawWeapons() noexcept {
+    PROFILE_SCOPE("drawWeapons");
+
     // Determine whether to draw the weapon partially invisible
     bool bShadow = false;
     if (gPlayer.mo->flags & MF_SHADOW) {
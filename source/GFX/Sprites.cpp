@@ -5,6 +5,7 @@
 #include "Base/Resource.h"
 #include "Game/DoomRez.h"
 #include "Game/Resources.h"
+#include "LitTextureCache.h"
 #include "ThreeDO/CelUtils.h"
 #include <algorithm>
 #include <map>
@@ -130,6 +131,8 @@ void freeAll() noexcept {
     for (Sprite& sprite : gSprites) {
         freeSprite(sprite);
     }
+
+    LitTextureCache::clear();
 }
 
 uint32_t getNumSprites() noexcept {
@@ -313,6 +316,7 @@ const Sprite* load(const uint32_t resourceNum) noexcept {
 void free(const uint32_t resourceNum) noexcept {
     Sprite& sprite = getSpriteForResourceNum(resourceNum);
     freeSprite(sprite);
+    LitTextureCache::freeResource(resourceNum);
 }
 
 END_NAMESPACE(Sprites)
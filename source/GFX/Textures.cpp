@@ -3,6 +3,7 @@
 #include "Base/Endian.h"
 #include "Game/DoomRez.h"
 #include "Game/Resources.h"
+#include "LitTextureCache.h"
 #include <vector>
 
 BEGIN_NAMESPACE(Textures)
@@ -223,6 +224,7 @@ void init() noexcept {
 }
 
 void shutdown() noexcept {
+    LitTextureCache::clear();
     clearTextures(gWallTextures);
     clearTextures(gFlatTextures);
     gFirstWallTexResourceNum = 0;
@@ -232,6 +234,7 @@ void shutdown() noexcept {
 void freeAll() noexcept {
     freeTextures(gWallTextures);
     freeTextures(gFlatTextures);
+    LitTextureCache::clear();
 }
 
 uint32_t getNumWallTextures() noexcept {
@@ -273,11 +276,13 @@ void loadFlat(const uint32_t num) noexcept {
 void freeWall(const uint32_t num) noexcept {
     ASSERT(num < gWallTextures.size());
     freeTexture(gWallTextures[num]);
+    LitTextureCache::freeResource(gWallTextures[num].resourceNum);
 }
 
 void freeFlat(const uint32_t num) noexcept {
     ASSERT(num < gFlatTextures.size());
     freeTexture(gFlatTextures[num]);
+    LitTextureCache::freeResource(gFlatTextures[num].resourceNum);
 }
 
 void setWallAnimTexNum(const uint32_t num, const uint32_t animTexNum) noexcept {
@@ -1,9 +1,18 @@
 #include "Video.h"
 
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
+#include "BlitSimd.h"
 #include "Game/Config.h"
 #include "Game/DoomDefines.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
 #include <SDL2/SDL.h>
 
 BEGIN_NAMESPACE(Video)
@@ -12,6 +21,10 @@ static SDL_Window*      gWindow;
 static SDL_Renderer*    gRenderer;
 static SDL_Texture*     gFramebufferTexture;
 static SDL_Rect         gOutputRect;
+static bool             gbIsHeadless;
+static bool             gbAsyncPresent;
+static uint32_t*        gpStagingPixels;        // Async present: the locked framebuffer texture, which the copy thread writes to
+static uint32_t         gStagingPitch;          // Async present: pitch of the locked framebuffer texture in bytes
 
 uint32_t    gScreenWidth;
 uint32_t    gScreenHeight;
@@ -22,22 +35,200 @@ uint32_t*   gpFrameBuffer;
 uint32_t*   gpSavedFrameBuffer;
 
 static void lockFramebufferTexture() noexcept {
+    // Note: in async present mode the game draws to its own framebuffer and the texture is only written to by the present copy thread
+    void* pPixels = nullptr;
     int pitch = 0;
-    if (SDL_LockTexture(gFramebufferTexture, nullptr, reinterpret_cast<void**>(&Video::gpFrameBuffer), &pitch) != 0) {
+
+    if (SDL_LockTexture(gFramebufferTexture, nullptr, &pPixels, &pitch) != 0) {
         FATAL_ERROR("Failed to lock the framebuffer texture for writing!");
     }
+
+    if (gbAsyncPresent) {
+        gpStagingPixels = static_cast<uint32_t*>(pPixels);
+        gStagingPitch = (uint32_t) pitch;
+    } else {
+        gpFrameBuffer = static_cast<uint32_t*>(pPixels);
+    }
 }
 
 static void unlockFramebufferTexture() noexcept {
     SDL_UnlockTexture(gFramebufferTexture);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Creates the SDL renderer for the window.
+// Falls back to a software renderer if an accelerated one is not available, for example with the 'dummy' or 'offscreen' video drivers.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static SDL_Renderer* createRenderer() noexcept {
+    SDL_Renderer* pRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+
+    if (!pRenderer) {
+        pRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_PRESENTVSYNC);
+    }
+
+    return pRenderer;
+}
+
+static SDL_Texture* createFramebufferTexture() noexcept {
+    return SDL_CreateTexture(
+        gRenderer,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING,
+        (int32_t) gScreenWidth,
+        (int32_t) gScreenHeight
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Asynchronous present.
+//
+// SDL only supports its rendering API on the thread which owns the window (the main thread), so all SDL calls stay on the main thread in
+// this mode too. What moves off the main thread is copying the finished frame into the locked streaming texture: the end of frame pass
+// copies the truncated frame out to one of two 'present buffers' as it goes, and a dedicated copy thread then copies that buffer into the
+// texture while the main thread goes on to simulate and draw the next frame. The next time the main thread presents, it shows the frame
+// which was copied into the texture before handing over the new one. This costs a frame of latency, which the 'PresentLatencyUSec' counter
+// shows. The main thread keeps drawing to its own framebuffer, which persists from one frame to the next exactly as normal.
+//
+// Handing a frame over is lock free, using an atomic buffer index which the copy thread resets once it is done with the buffer. Since the
+// main thread always waits for the previous copy to finish before presenting, two buffers are enough: one being copied into the texture
+// and one being filled by the end of frame pass. A mutex and condition variable are only used to put a thread to sleep while it waits.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr uint32_t NUM_PRESENT_BUFFERS = 2;
+static constexpr uint32_t NO_PRESENT_BUFFER = UINT32_MAX;
+
+typedef std::chrono::steady_clock PresentClock;
+
+static std::thread                      gPresentCopyThread;
+static std::atomic<bool>                gbPresentCopyThreadQuit;
+static std::mutex                       gPresentWakeMutex;
+static std::condition_variable          gPresentWakeCV;
+static uint32_t*                        gpPresentBuffers[NUM_PRESENT_BUFFERS];
+static uint32_t                         gNextPresentBufferIdx;          // Which present buffer the next frame is copied out to
+static std::atomic<uint32_t>            gCopyingPresentBufferIdx;       // The buffer being copied into the texture, if any
+static bool                             gbHaveStagedFrame;              // True if a frame was handed over which has not been presented yet
+static PresentClock::time_point         gStagedFrameSubmitTime;         // When that frame was handed over, for the latency stat
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Main loop for the present copy thread: copies frames into the locked framebuffer texture as they are handed over until told to quit.
+// Note: this thread must never make any SDL calls.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void presentCopyThreadMain() noexcept {
+    while (true) {
+        // Wait until there is a frame to copy or until told to quit
+        const uint32_t bufferIdx = gCopyingPresentBufferIdx.load();
+
+        if (bufferIdx == NO_PRESENT_BUFFER) {
+            std::unique_lock<std::mutex> lock(gPresentWakeMutex);
+            gPresentWakeCV.wait(lock, []() noexcept {
+                return (gbPresentCopyThreadQuit || (gCopyingPresentBufferIdx.load() != NO_PRESENT_BUFFER));
+            });
+
+            if (gbPresentCopyThreadQuit)
+                break;
+
+            continue;
+        }
+
+        // Copy the frame into the texture a row at a time, since the texture rows might be padded
+        const uint32_t* pSrcRow = gpPresentBuffers[bufferIdx];
+        uint8_t* pDstRow = reinterpret_cast<uint8_t*>(gpStagingPixels);
+
+        for (uint32_t y = 0; y < gScreenHeight; ++y, pSrcRow += gScreenWidth, pDstRow += gStagingPitch) {
+            std::memcpy(pDstRow, pSrcRow, gScreenWidth * sizeof(uint32_t));
+        }
+
+        // Free up the buffer and wake the main thread if it is waiting on the copy.
+        // Lock briefly so the wakeup can't be missed by the main thread while it is checking whether to go to sleep.
+        gCopyingPresentBufferIdx = NO_PRESENT_BUFFER;
+
+        {
+            std::lock_guard<std::mutex> lock(gPresentWakeMutex);
+        }
+
+        gPresentWakeCV.notify_one();
+    }
+}
+
+static void initAsyncPresent() noexcept {
+    const size_t numPixels = (size_t) gScreenWidth * gScreenHeight;
+
+    for (uint32_t i = 0; i < NUM_PRESENT_BUFFERS; ++i) {
+        gpPresentBuffers[i] = new uint32_t[numPixels];
+        std::memset(gpPresentBuffers[i], 0, numPixels * sizeof(uint32_t));
+    }
+
+    // The main thread draws to its own framebuffer in this mode
+    gpFrameBuffer = new uint32_t[numPixels];
+
+    gNextPresentBufferIdx = 0;
+    gCopyingPresentBufferIdx = NO_PRESENT_BUFFER;
+    gbHaveStagedFrame = false;
+    gbPresentCopyThreadQuit = false;
+    gPresentCopyThread = std::thread(presentCopyThreadMain);
+}
+
+static void shutdownAsyncPresent() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(gPresentWakeMutex);
+        gbPresentCopyThreadQuit = true;
+    }
+
+    gPresentWakeCV.notify_one();
+
+    if (gPresentCopyThread.joinable()) {
+        gPresentCopyThread.join();
+    }
+
+    for (uint32_t i = 0; i < NUM_PRESENT_BUFFERS; ++i) {
+        delete[] gpPresentBuffers[i];
+        gpPresentBuffers[i] = nullptr;
+    }
+
+    gpStagingPixels = nullptr;
+    gStagingPitch = 0;
+    gbHaveStagedFrame = false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Waits for the copy thread to finish copying the last frame handed over into the framebuffer texture, if it has not done so already
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void waitForPresentCopy() noexcept {
+    if (gCopyingPresentBufferIdx.load() == NO_PRESENT_BUFFER)
+        return;
+
+    PROFILE_SCOPE("Video::waitForPresentCopy");
+    std::unique_lock<std::mutex> lock(gPresentWakeMutex);
+    gPresentWakeCV.wait(lock, []() noexcept {
+        return (gCopyingPresentBufferIdx.load() == NO_PRESENT_BUFFER);
+    });
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Hands a finished frame over to the copy thread.
+// The copy of the previous frame must be finished and the framebuffer texture must be locked.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void submitPresentBuffer(const uint32_t bufferIdx) noexcept {
+    ASSERT(gCopyingPresentBufferIdx.load() == NO_PRESENT_BUFFER);
+    ASSERT(gpStagingPixels);
+
+    gbHaveStagedFrame = true;
+    gStagedFrameSubmitTime = PresentClock::now();
+    gCopyingPresentBufferIdx = bufferIdx;
+
+    // Lock briefly so the wakeup can't be missed by the copy thread while it is checking whether to go to sleep
+    {
+        std::lock_guard<std::mutex> lock(gPresentWakeMutex);
+    }
+
+    gPresentWakeCV.notify_one();
+}
+
 static void determineTargetVideoMode() noexcept {
     // Fullscreen mode and game render resolution
     gbIsFullscreen = Config::gbFullscreen;
 
-    gScreenWidth = REFERENCE_SCREEN_WIDTH;
-    gScreenHeight = REFERENCE_SCREEN_HEIGHT;
+    gScreenWidth = REFERENCE_SCREEN_WIDTH * Config::gRenderScale;
+    gScreenHeight = REFERENCE_SCREEN_HEIGHT * Config::gRenderScale;
 
     // Get the current screen resolution.
     // Note: MAY not be correct for multiple monitors, but a user can specify manually in those cases.
@@ -116,51 +307,28 @@ static void determineTargetVideoMode() noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Truncates an XRGB8888 color as if it were stored as an XRGB1555 color, and converts back to XRGB8888.
-// Used for 16-bit framebuffer simulation.
+// Setup for headless mode: the game renders into a plain offscreen framebuffer and nothing is ever shown
 //------------------------------------------------------------------------------------------------------------------------------------------
-static inline uint32_t truncateFramebufferColorTo16Bit(const uint32_t colorIn) noexcept {
-    uint32_t r = (colorIn & 0x00F80000);
-    uint32_t g = (colorIn & 0x0000F800);
-    uint32_t b = (colorIn & 0x000000F8);
-    r = ((r * 255) / 248) & 0x00F80000;
-    g = ((g * 255) / 248) & 0x0000F800;
-    b = ((b * 255) / 248) & 0x000000F8;
-    return (r | g | b);
+static void initHeadless() noexcept {
+    gbIsFullscreen = false;
+    gScreenWidth = REFERENCE_SCREEN_WIDTH * Config::gRenderScale;
+    gScreenHeight = REFERENCE_SCREEN_HEIGHT * Config::gRenderScale;
+    gVideoOutputWidth = gScreenWidth;
+    gVideoOutputHeight = gScreenHeight;
+    gOutputRect = { 0, 0, (int) gScreenWidth, (int) gScreenHeight };
+
+    gpFrameBuffer = new uint32_t[(size_t) gScreenWidth * gScreenHeight];
+    gpSavedFrameBuffer = new uint32_t[(size_t) gScreenWidth * gScreenHeight];
 }
 
-//------------------------------------------------------------------------------------------------------------------------------------------
-// Truncates framebuffer colors to RGB555 - similar to the framebuffer format used by the original 3DO game
-//------------------------------------------------------------------------------------------------------------------------------------------
-static void do16BitFramebufferSimulation() noexcept {
-    // Truncate 8 pixels at a time first
-    const uint32_t numPixels = gScreenWidth * gScreenHeight;
-    const uint32_t numPixels8 = (numPixels / 8u) * 8u;
-
-    uint32_t* pCurPixel = gpFrameBuffer;
-    uint32_t* const pEndPixel = gpFrameBuffer + numPixels;
-    uint32_t* const pEndPixel8 = gpFrameBuffer + numPixels8;
-
-    while (pCurPixel < pEndPixel8) {
-        pCurPixel[0] = truncateFramebufferColorTo16Bit(pCurPixel[0]);
-        pCurPixel[1] = truncateFramebufferColorTo16Bit(pCurPixel[1]);
-        pCurPixel[2] = truncateFramebufferColorTo16Bit(pCurPixel[2]);
-        pCurPixel[3] = truncateFramebufferColorTo16Bit(pCurPixel[3]);
-        pCurPixel[4] = truncateFramebufferColorTo16Bit(pCurPixel[4]);
-        pCurPixel[5] = truncateFramebufferColorTo16Bit(pCurPixel[5]);
-        pCurPixel[6] = truncateFramebufferColorTo16Bit(pCurPixel[6]);
-        pCurPixel[7] = truncateFramebufferColorTo16Bit(pCurPixel[7]);
-        pCurPixel += 8;
-    }
+void init(const bool bHeadless) noexcept {
+    gbIsHeadless = bHeadless;
 
-    // Do the rest
-    while (pCurPixel < pEndPixel) {
-        pCurPixel[0] = truncateFramebufferColorTo16Bit(pCurPixel[0]);
-        ++pCurPixel;
+    if (bHeadless) {
+        initHeadless();
+        return;
     }
-}
 
-void init() noexcept {
     // Initialize SDL subsystems
     if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
         FATAL_ERROR("Unable to initialize SDL!");
@@ -190,19 +358,13 @@ void init() noexcept {
     }
 
     // Create the renderer and framebuffer texture
-    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    gRenderer = createRenderer();
 
     if (!gRenderer) {
         FATAL_ERROR("Failed to create renderer!");
     }
 
-    gFramebufferTexture = SDL_CreateTexture(
-        gRenderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_STREAMING,
-        (int32_t) gScreenWidth,
-        (int32_t) gScreenHeight
-    );
+    gFramebufferTexture = createFramebufferTexture();
 
     if (!gFramebufferTexture) {
         FATAL_ERROR("Failed to create a framebuffer texture!");
@@ -212,9 +374,14 @@ void init() noexcept {
     SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 0);
     SDL_RenderClear(gRenderer);
 
-    // Immediately lock the framebuffer texture for updating
+    // Immediately lock the framebuffer texture for updating, then start the present copy thread if doing async present
+    gbAsyncPresent = Config::gbAsyncPresent;
     lockFramebufferTexture();
 
+    if (gbAsyncPresent) {
+        initAsyncPresent();
+    }
+
     // This can be used to take a screenshot for the screen wipe effect
     gpSavedFrameBuffer = new uint32_t[(size_t) gScreenWidth * gScreenHeight];
 
@@ -224,10 +391,19 @@ void init() noexcept {
 }
 
 void shutdown() noexcept {
+    if (gbAsyncPresent) {
+        shutdownAsyncPresent();
+    }
+
     delete[] gpSavedFrameBuffer;
     gpSavedFrameBuffer = nullptr;
+
+    if (gbIsHeadless || gbAsyncPresent) {
+        delete[] gpFrameBuffer;
+    }
+
     gpFrameBuffer = nullptr;
-    
+
     if (gRenderer) {
         SDL_DestroyRenderer(gRenderer);
         gRenderer = nullptr;
@@ -239,7 +415,9 @@ void shutdown() noexcept {
         gWindow = nullptr;
     }
 
-    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    if (!gbIsHeadless) {
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    }
 
     gScreenWidth = 0;
     gScreenHeight = 0;
@@ -247,6 +425,8 @@ void shutdown() noexcept {
     gVideoOutputHeight = 0;
     gOutputRect = {};
     gbIsFullscreen = false;
+    gbIsHeadless = false;
+    gbAsyncPresent = false;
 }
 
 void clearScreen(const uint8_t r, const uint8_t g, const uint8_t b) noexcept {
@@ -295,77 +475,153 @@ void debugClearScreen() noexcept {
     #endif
 }
 
+bool isHeadless() noexcept {
+    return gbIsHeadless;
+}
+
 SDL_Window* getWindow() noexcept {
     return gWindow;
 }
 
-void saveFrameBuffer() noexcept {
-    ASSERT(gpSavedFrameBuffer);
-    ASSERT(gpFrameBuffer);
+//------------------------------------------------------------------------------------------------------------------------------------------
+// End of frame work on the framebuffer, done in a single sweep over it:
+//
+//  (1) Optionally saving a column major copy of the framebuffer, for screen wipes. This is always the framebuffer as it was drawn,
+//      before any truncation to 16-bit colors.
+//  (2) Optionally truncating the framebuffer colors to RGB555 - similar to the framebuffer format used by the original 3DO game.
+//      Normally the framebuffer is the locked streaming texture itself, so this is also what gets uploaded when presenting.
+//  (3) In async present mode, copying the truncated framebuffer out to a present buffer. This is done a few rows at a time, while the
+//      rows are still in the cache.
+//
+// The framebuffer is split into bands of rows which are done in parallel using the job system, if the framebuffer is big enough to make
+// that worthwhile.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct EndFramePass {
+    bool        bSave;          // Save the framebuffer to the saved framebuffer?
+    bool        bTruncate;      // Truncate the framebuffer colors to 16-bits?
+    uint32_t    rowsPerJob;     // How many rows of the framebuffer each job does
+    uint32_t*   pCopyOut;       // If not null, copy the framebuffer to here after truncating
+};
+
+// Don't bother splitting up the work any finer than this
+static constexpr uint32_t MIN_PIXELS_PER_END_FRAME_JOB = 64 * 1024;
+
+// How many rows to do at a time before copying them out: enough for the transposes to write whole 64-byte lines of the saved framebuffer
+static constexpr uint32_t END_FRAME_COPY_OUT_ROWS = 16;
+
+static void doEndFramePassForRows(const EndFramePass& pass, const uint32_t startY, const uint32_t endY) noexcept {
+    const uint32_t numRows = endY - startY;
+    uint32_t* const pRows = gpFrameBuffer + (size_t) startY * gScreenWidth;
+    uint32_t* const pSavedRows = gpSavedFrameBuffer + startY;
+
+    // Note: the transposes are given the rows of the framebuffer as their source 'columns' since it is row major
+    if (pass.bSave && pass.bTruncate) {
+        BlitSimd::transposeAndTruncateSourceTo16Bit(pRows, gScreenWidth, pSavedRows, gScreenHeight, numRows, gScreenWidth);
+    } else if (pass.bSave) {
+        BlitSimd::transposeColumnMajorToRowMajor(pRows, gScreenWidth, pSavedRows, gScreenHeight, numRows, gScreenWidth);
+    } else if (pass.bTruncate) {
+        BlitSimd::truncatePixelsTo16Bit(pRows, numRows * gScreenWidth);
+    }
 
-    // Note: the output framebuffer is saved in column major format.
-    // This allows us to do screen wipes more efficiently due to better cache usage.
-    const uint32_t screenWidth = gScreenWidth;
-    const uint32_t screenWidth8 = (screenWidth / 8) * 8;
-    const uint32_t screenHeight = gScreenHeight;
-
-    for (uint32_t y = 0; y < screenHeight; ++y) {
-        const uint32_t* const pSrcRow = &gpFrameBuffer[y * screenWidth];
-        uint32_t* const pDstRow = &gpSavedFrameBuffer[y];
-
-        // Copy 8 pixels at a time, then mop up the rest
-        for (uint32_t x = 0; x < screenWidth8; x += 8) {
-            const uint32_t x1 = x + 0;
-            const uint32_t x2 = x + 1;
-            const uint32_t x3 = x + 2;
-            const uint32_t x4 = x + 3;
-            const uint32_t x5 = x + 4;
-            const uint32_t x6 = x + 5;
-            const uint32_t x7 = x + 6;
-            const uint32_t x8 = x + 7;
-
-            const uint32_t pix1 = pSrcRow[x1];
-            const uint32_t pix2 = pSrcRow[x2];
-            const uint32_t pix3 = pSrcRow[x3];
-            const uint32_t pix4 = pSrcRow[x4];
-            const uint32_t pix5 = pSrcRow[x5];
-            const uint32_t pix6 = pSrcRow[x6];
-            const uint32_t pix7 = pSrcRow[x7];
-            const uint32_t pix8 = pSrcRow[x8];
-
-            pDstRow[x1 * screenHeight] = pix1;
-            pDstRow[x2 * screenHeight] = pix2;
-            pDstRow[x3 * screenHeight] = pix3;
-            pDstRow[x4 * screenHeight] = pix4;
-            pDstRow[x5 * screenHeight] = pix5;
-            pDstRow[x6 * screenHeight] = pix6;
-            pDstRow[x7 * screenHeight] = pix7;
-            pDstRow[x8 * screenHeight] = pix8;
-        }
+    if (pass.pCopyOut) {
+        const size_t rowsOffset = (size_t) startY * gScreenWidth;
+        std::memcpy(pass.pCopyOut + rowsOffset, pRows, (size_t) numRows * gScreenWidth * sizeof(uint32_t));
+    }
+}
+
+static void endFramePassJob(const uint32_t jobIdx, void* const pUserData) noexcept {
+    const EndFramePass& pass = *(const EndFramePass*) pUserData;
+    const uint32_t startY = jobIdx * pass.rowsPerJob;
+    const uint32_t endY = std::min(startY + pass.rowsPerJob, gScreenHeight);
 
-        for (uint32_t x = screenWidth8; x < screenWidth; x++) {
-            const uint32_t pix = pSrcRow[x];
-            pDstRow[x * screenHeight] = pix;
+    if (pass.pCopyOut) {
+        for (uint32_t y = startY; y < endY; y += END_FRAME_COPY_OUT_ROWS) {
+            doEndFramePassForRows(pass, y, std::min(y + END_FRAME_COPY_OUT_ROWS, endY));
         }
+    } else {
+        doEndFramePassForRows(pass, startY, endY);
     }
 }
 
-void present() noexcept {
-    do16BitFramebufferSimulation();
+static void doEndFramePass(const bool bSave, const bool bTruncate, uint32_t* const pCopyOut) noexcept {
+    ASSERT(gpFrameBuffer);
+    ASSERT(gpSavedFrameBuffer || (!bSave));
+
+    if ((!bSave) && (!bTruncate) && (!pCopyOut))
+        return;
+
+    // Figure out how many jobs to split the work into: keep the bands a multiple of 8 rows so the transposes can use whole blocks
+    const uint32_t numPixels = gScreenWidth * gScreenHeight;
+    const uint32_t maxJobs = std::max(numPixels / MIN_PIXELS_PER_END_FRAME_JOB, 1u);
+    const uint32_t numJobsWanted = std::min(JobSystem::getNumThreads(), maxJobs);
+
+    EndFramePass pass = {};
+    pass.bSave = bSave;
+    pass.bTruncate = bTruncate;
+    pass.rowsPerJob = (((gScreenHeight + numJobsWanted - 1) / numJobsWanted) + 7) & ~7u;
+    pass.pCopyOut = pCopyOut;
+
+    const uint32_t numJobs = (gScreenHeight + pass.rowsPerJob - 1) / pass.rowsPerJob;
+    JobSystem::runJobs(endFramePassJob, &pass, numJobs);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Does the end of frame pass over the framebuffer and then shows it on screen if required.
+// In async present mode the frame is handed over to the present thread to show, otherwise it is shown right away.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void finishFrame(const bool bSave, const bool bPresent) noexcept {
+    if (bPresent && gbAsyncPresent) {
+        const uint32_t bufferIdx = gNextPresentBufferIdx;
+        gNextPresentBufferIdx = (gNextPresentBufferIdx + 1) % NUM_PRESENT_BUFFERS;
+        doEndFramePass(bSave, true, gpPresentBuffers[bufferIdx]);
+
+        // Show the previous frame once it has been copied into the texture, then hand this frame over to be copied in turn
+        waitForPresentCopy();
+
+        if (gbHaveStagedFrame) {
+            unlockFramebufferTexture();
+            SDL_RenderCopy(gRenderer, gFramebufferTexture, nullptr, &gOutputRect);
+            SDL_RenderPresent(gRenderer);
+            lockFramebufferTexture();
+
+            if (Profiler::gbCapturing) {
+                const auto latency = PresentClock::now() - gStagedFrameSubmitTime;
+                Profiler::setCounter("PresentLatencyUSec", (int64_t) std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+            }
+        }
+
+        submitPresentBuffer(bufferIdx);
+        return;
+    }
+
+    doEndFramePass(bSave, bPresent, nullptr);
+
+    // Note: still do the 16-bit simulation in headless mode, so the cost of the frame is as close as possible to normal
+    if ((!bPresent) || gbIsHeadless)
+        return;
+
     unlockFramebufferTexture();
     SDL_RenderCopy(gRenderer, gFramebufferTexture, nullptr, &gOutputRect);
     SDL_RenderPresent(gRenderer);
     lockFramebufferTexture();
 }
 
+void saveFrameBuffer() noexcept {
+    // Note: the output framebuffer is saved in column major format.
+    // This allows us to do screen wipes more efficiently due to better cache usage.
+    finishFrame(true, false);
+}
+
+void present() noexcept {
+    PROFILE_SCOPE("Video::present");
+    finishFrame(false, true);
+}
+
 void endFrame(const bool bPresent, const bool bSaveFrameBuffer) noexcept {
-    if (bSaveFrameBuffer) {
-        saveFrameBuffer();
-    }
+    PROFILE_SCOPE("Video::endFrame");
 
-    if (bPresent) {
-        present();
-    }
+    // Save and truncate in the same sweep over the framebuffer, then present if required
+    finishFrame(bSaveFrameBuffer, bPresent);
 }
 
 END_NAMESPACE(Video)
@@ -29,10 +29,14 @@ extern bool gbIsFullscreen;
 extern uint32_t* gpFrameBuffer;
 extern uint32_t* gpSavedFrameBuffer;
 
-// Create and destroy the display
-void init() noexcept;
+// Create and destroy the display.
+// In headless mode no window is created: the game renders to an offscreen framebuffer which is never shown.
+void init(const bool bHeadless = false) noexcept;
 void shutdown() noexcept;
 
+// Tells if the display was created in headless mode
+bool isHeadless() noexcept;
+
 // Clear the screen to the specified RGB color   
 void clearScreen(const uint8_t r, const uint8_t g, const uint8_t b) noexcept;
 
@@ -40,7 +44,7 @@ void clearScreen(const uint8_t r, const uint8_t g, const uint8_t b) noexcept;
 // Used to identify issues where parts of the screen are not being drawn to.
 void debugClearScreen() noexcept;
 
-// Get a handle to the underlying SDL window
+// Get a handle to the underlying SDL window, which is null in headless mode
 SDL_Window* getWindow() noexcept;
 
 // Saves a copy of the current framebuffer to the 'saved' framebuffer.
@@ -51,7 +55,7 @@ void saveFrameBuffer() noexcept;
 void present() noexcept;
 
 // Helper that combines various end of frame operations.
-// Saves the framebuffer if required and presents if required.
+// Saves the framebuffer if required and presents if required, doing both in a single sweep over the framebuffer.
 void endFrame(const bool bPresent, const bool bSaveFrameBuffer) noexcept;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -59,6 +59,22 @@ CDImagePath = Doom3DO.img
 UseDataDirectory = 0
 DataDirectoryPath = C:\Users\<MY_NAME>\<WHATEVER>\Doom3DO_DiscExtracted
 
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then the potentially visible set (PVS) for each map is used to skip parts of the map
+# which can't be seen when rendering. This does not affect gameplay.
+# The PVS is built the first time each map is played and saved to a '.pvs' file in the game data
+# directory, or in the same folder as the CD-ROM image.
+# The files are rebuilt automatically if they don't match the map data.
+#
+# If 'UsePvsForSight' is set to '1' then the PVS is also used to quickly rule out sight between
+# monsters and the player, without tracing through the map. This is only correct if the PVS never
+# misses anything that can be seen, so it is off by default: it is not recorded in demos and if the
+# PVS were ever wrong then monsters could miss the player and demos could play back differently.
+# See 'VerifyPvs' for checking it.
+#---------------------------------------------------------------------------------------------------
+UsePvs = 1
+UsePvsForSight = 0
+
 )";
 
 static constexpr const char* const DEFAULT_CONFIG_INI_SECTION_3 =
@@ -83,6 +99,81 @@ Fullscreen = 1
 OutputResolutionW = -1
 OutputResolutionH = -1
 
+#---------------------------------------------------------------------------------------------------
+# Integer multiple of the original 320x200 resolution to render the game at (1-8).
+# For example '4' renders at 1280x800. The output resolution must be at least this large.
+#---------------------------------------------------------------------------------------------------
+RenderScale = 1
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then the 3D view is drawn at a lower resolution whenever it takes too long to draw,
+# and is then stretched to fill its area on screen. The resolution is adjusted gradually between
+# frames to keep the time taken to draw the 3D view close to 'DynamicResolutionTargetMs'.
+# 'DynamicResolutionMinScale' is the lowest resolution allowed, as a fraction of the full resolution
+# of the 3D view (0.25-1.0). The HUD, menus and player weapon are always drawn at full resolution.
+#---------------------------------------------------------------------------------------------------
+DynamicResolution = 0
+DynamicResolutionTargetMs = 4.0
+DynamicResolutionMinScale = 0.5
+
+#---------------------------------------------------------------------------------------------------
+# The number of threads to use for drawing the 3D view, including the main game thread.
+# Set to '0' to use one thread per CPU core (auto), or '1' to draw everything on the main thread.
+# The rendered image is exactly the same regardless of what this is set to.
+#---------------------------------------------------------------------------------------------------
+RenderThreads = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then finished frames are copied into the video texture by a separate thread while
+# the game goes on to the next frame. The frame is then shown at the next present, which adds one
+# frame of latency. Uploading and presenting still happen on the main thread, as SDL requires.
+#---------------------------------------------------------------------------------------------------
+AsyncPresent = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then wall and sprite textures are lit ahead of time at a fixed number of light
+# levels and cached, which makes drawing them cheaper. Since light levels are rounded to the nearest
+# cached level, lighting will be very slightly different to when this is disabled.
+# The cache size is in megabytes: when full, the least recently used textures are discarded.
+#---------------------------------------------------------------------------------------------------
+UseLitTextureCache = 0
+LitTextureCacheSizeMB = 64
+
+#---------------------------------------------------------------------------------------------------
+# How floors and ceilings are drawn:
+#   0 = As vertical columns, with a ray/plane intersection done for every pixel (default)
+#   1 = As horizontal spans along screen rows, with a constant texture coordinate step per span.
+#       This accesses memory in a more cache friendly way, but the texture coordinates for each
+#       pixel are very slightly different to when drawing columns.
+#---------------------------------------------------------------------------------------------------
+DrawFlatsAsSpans = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then the 3D view is split up into small 32x32 pixel tiles, and each tile is drawn
+# into a small buffer which stays in the CPU cache before being copied out to the screen in one go.
+# This avoids drawing columns of pixels directly to the screen (which is slow at high resolutions)
+# and tiles are also spread across all of the render threads (see 'RenderThreads').
+# Note: texture coordinates for wall, sky and sprite columns crossing the top of a tile are worked
+# out differently, so a handful of pixels may be very slightly different when this is enabled.
+#---------------------------------------------------------------------------------------------------
+TiledRendering = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then the 3D view is drawn into a separate column major buffer (where pixels going
+# down a screen column are next to each other in memory) and then copied to the screen in one go,
+# transposing it with SIMD instructions. Since the view is mostly drawn in vertical columns this is
+# more cache friendly at high resolutions (see 'RenderScale'). The output is exactly the same.
+#---------------------------------------------------------------------------------------------------
+ColumnMajorViewBuffer = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then walls which have been transformed to the screen are remembered from one frame
+# to the next, and reused while the view stays exactly the same (e.g standing still, paused or in
+# the menus). Walls next to moving floors, ceilings and doors or with scrolling textures are still
+# redone as needed. The output is exactly the same either way.
+#---------------------------------------------------------------------------------------------------
+CacheSegTransforms = 1
+
 )";
 
 static constexpr const char* const DEFAULT_CONFIG_INI_SECTION_4 =
@@ -251,6 +342,60 @@ AllowCameraUpDownMovement = 0
 #---------------------------------------------------------------------------------------------------
 PerfCounterNumFramesToAverage = 15
 
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then SIMD (SSE2/AVX2) versions of the wall, floor, ceiling and sprite drawing code
+# are used where the CPU supports them. The output is identical either way; this setting is only
+# useful for comparing performance or ruling out SIMD related problems.
+#---------------------------------------------------------------------------------------------------
+UseSimdRendering = 1
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then floors and ceilings are drawn both as columns and as spans every frame (see
+# 'DrawFlatsAsSpans') and the average time taken for each is printed to standard output.
+# Both methods are timed for exactly the same view and on the same thread.
+# The averages are updated every 'PerfCounterNumFramesToAverage' frames.
+#---------------------------------------------------------------------------------------------------
+BenchmarkFlatDrawModes = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then the 3D view is drawn both directly to the screen and via a column major buffer
+# every frame (see 'ColumnMajorViewBuffer'), and the average time taken for each is printed to
+# standard output along with cache miss counts where available (Linux only).
+# Cache misses are only counted for the main thread, so use 'RenderThreads = 1' for accurate counts.
+# Don't enable this at the same time as 'BenchmarkFlatDrawModes'.
+# The averages are updated every 'PerfCounterNumFramesToAverage' frames.
+#---------------------------------------------------------------------------------------------------
+BenchmarkViewBufferLayouts = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then the BSP tree is walked every frame both with the flattened node arrays used for
+# rendering and with the original recursive traversal of the tree, and the average time taken for
+# each is printed to standard output. Only the side and bounding box checks are timed.
+# Sight checks between things are also run both ways, with the average timings and any differences
+# in the results printed every 4096 checks.
+# Best used on the largest maps, where the BSP tree is deepest.
+# The rendering averages are updated every 'PerfCounterNumFramesToAverage' frames.
+#---------------------------------------------------------------------------------------------------
+BenchmarkBspTraversal = 0
+
+#---------------------------------------------------------------------------------------------------
+# If set to '1' then sight checks ruled out by the potentially visible set (see 'UsePvs') are still
+# done in full, and a message is printed to standard output if the full check finds that the things
+# can see each other after all. The game plays exactly as if the PVS was not used for sight.
+# Stats are also printed whenever the PVS for a map has to be built.
+#---------------------------------------------------------------------------------------------------
+VerifyPvs = 0
+
+#---------------------------------------------------------------------------------------------------
+# Files to write per frame profiling results to, for every frame of gameplay.
+# The CSV file has one row per timed stage or counter per frame. The trace file is in the Chrome
+# trace event format, which can be viewed with 'chrome://tracing' or 'ui.perfetto.dev'.
+# Leave these blank to disable; the on-screen profiler overlay (reached by toggling the performance
+# counter display) works regardless.
+#---------------------------------------------------------------------------------------------------
+ProfilerCsvFile =
+ProfilerTraceFile =
+
 ####################################################################################################
 [CheatKeySequences]
 ####################################################################################################
@@ -486,9 +631,23 @@ static std::string gTmpActionStr;   // Re-use this buffer during parsing to prev
 std::string                 gGameDataCDImagePath;
 bool                        gbUseGameDataDirectory;
 std::string                 gGameDataDirectoryPath;
+bool                        gbUsePvs;
+bool                        gbUsePvsForSight;
 bool                        gbFullscreen;
 int32_t                     gOutputResolutionW;
 int32_t                     gOutputResolutionH;
+uint32_t                    gRenderScale;
+bool                        gbDynamicResolution;
+float                       gDynamicResolutionTargetMs;
+float                       gDynamicResolutionMinScale;
+int32_t                     gRenderThreads;
+bool                        gbAsyncPresent;
+bool                        gbUseLitTextureCache;
+uint32_t                    gLitTextureCacheSizeMB;
+bool                        gbDrawFlatsAsSpans;
+bool                        gbTiledRendering;
+bool                        gbColumnMajorViewBuffer;
+bool                        gbCacheSegTransforms;
 float                       gInputAnalogToDigitalThreshold;
 bool                        gbDefaultAlwaysRun;
 Controls::MenuActionBits    gKeyboardMenuActions[Input::NUM_KEYBOARD_KEYS];
@@ -505,6 +664,13 @@ Controls::GameActionBits    gGamepadGameActions[NUM_CONTROLLER_INPUTS];
 Controls::AxisBits          gGamepadAxisBindings[NUM_CONTROLLER_INPUTS];
 bool                        gbAllowDebugCameraUpDownMovement;
 uint32_t                    gPerfCounterNumFramesToAverage;
+bool                        gbUseSimdRendering;
+bool                        gbBenchmarkFlatDrawModes;
+bool                        gbBenchmarkViewBufferLayouts;
+bool                        gbBenchmarkBspTraversal;
+bool                        gbVerifyPvs;
+std::string                 gProfilerCsvFilePath;
+std::string                 gProfilerTraceFilePath;
 CheatKeySequence            gCheatKeys_GodMode;
 CheatKeySequence            gCheatKeys_NoClip;
 CheatKeySequence            gCheatKeys_MapAndThingsRevealToggle;
@@ -954,6 +1120,12 @@ static void handleConfigEntry(const IniUtils::Entry& entry) noexcept {
         else if (entry.key == "DataDirectoryPath") {
             gGameDataDirectoryPath = entry.value;
         }
+        else if (entry.key == "UsePvs") {
+            gbUsePvs = entry.getBoolValue(gbUsePvs);
+        }
+        else if (entry.key == "UsePvsForSight") {
+            gbUsePvsForSight = entry.getBoolValue(gbUsePvsForSight);
+        }
     }
     else if (entry.section == "Video") {
         if (entry.key == "Fullscreen") {
@@ -965,6 +1137,42 @@ static void handleConfigEntry(const IniUtils::Entry& entry) noexcept {
         else if (entry.key == "OutputResolutionH") {
             gOutputResolutionH = entry.getIntValue(gOutputResolutionH);
         }
+        else if (entry.key == "RenderScale") {
+            gRenderScale = std::clamp(entry.getUintValue(gRenderScale), 1u, 8u);
+        }
+        else if (entry.key == "DynamicResolution") {
+            gbDynamicResolution = entry.getBoolValue(gbDynamicResolution);
+        }
+        else if (entry.key == "DynamicResolutionTargetMs") {
+            gDynamicResolutionTargetMs = std::max(entry.getFloatValue(gDynamicResolutionTargetMs), 0.1f);
+        }
+        else if (entry.key == "DynamicResolutionMinScale") {
+            gDynamicResolutionMinScale = std::clamp(entry.getFloatValue(gDynamicResolutionMinScale), 0.25f, 1.0f);
+        }
+        else if (entry.key == "RenderThreads") {
+            gRenderThreads = entry.getIntValue(gRenderThreads);
+        }
+        else if (entry.key == "AsyncPresent") {
+            gbAsyncPresent = entry.getBoolValue(gbAsyncPresent);
+        }
+        else if (entry.key == "UseLitTextureCache") {
+            gbUseLitTextureCache = entry.getBoolValue(gbUseLitTextureCache);
+        }
+        else if (entry.key == "LitTextureCacheSizeMB") {
+            gLitTextureCacheSizeMB = entry.getUintValue(gLitTextureCacheSizeMB);
+        }
+        else if (entry.key == "DrawFlatsAsSpans") {
+            gbDrawFlatsAsSpans = entry.getBoolValue(gbDrawFlatsAsSpans);
+        }
+        else if (entry.key == "TiledRendering") {
+            gbTiledRendering = entry.getBoolValue(gbTiledRendering);
+        }
+        else if (entry.key == "ColumnMajorViewBuffer") {
+            gbColumnMajorViewBuffer = entry.getBoolValue(gbColumnMajorViewBuffer);
+        }
+        else if (entry.key == "CacheSegTransforms") {
+            gbCacheSegTransforms = entry.getBoolValue(gbCacheSegTransforms);
+        }
     }
     else if (entry.section == "InputGeneral") {
         if (entry.key == "AnalogToDigitalThreshold") {
@@ -1017,6 +1225,27 @@ static void handleConfigEntry(const IniUtils::Entry& entry) noexcept {
         else if (entry.key == "PerfCounterNumFramesToAverage") {
             gPerfCounterNumFramesToAverage = std::max(entry.getUintValue(gPerfCounterNumFramesToAverage), 1u);
         }
+        else if (entry.key == "UseSimdRendering") {
+            gbUseSimdRendering = entry.getBoolValue(gbUseSimdRendering);
+        }
+        else if (entry.key == "BenchmarkFlatDrawModes") {
+            gbBenchmarkFlatDrawModes = entry.getBoolValue(gbBenchmarkFlatDrawModes);
+        }
+        else if (entry.key == "BenchmarkViewBufferLayouts") {
+            gbBenchmarkViewBufferLayouts = entry.getBoolValue(gbBenchmarkViewBufferLayouts);
+        }
+        else if (entry.key == "BenchmarkBspTraversal") {
+            gbBenchmarkBspTraversal = entry.getBoolValue(gbBenchmarkBspTraversal);
+        }
+        else if (entry.key == "VerifyPvs") {
+            gbVerifyPvs = entry.getBoolValue(gbVerifyPvs);
+        }
+        else if (entry.key == "ProfilerCsvFile") {
+            gProfilerCsvFilePath = entry.value;
+        }
+        else if (entry.key == "ProfilerTraceFile") {
+            gProfilerTraceFilePath = entry.value;
+        }
     }
     else if (entry.section == "CheatKeySequences") {
         parseCheatKeySequence(entry.key, entry.value.c_str());
@@ -1030,10 +1259,24 @@ static void clear() noexcept {
     gGameDataCDImagePath = "Doom3DO.img";
     gbUseGameDataDirectory = false;
     gGameDataDirectoryPath.clear();
+    gbUsePvs = true;
+    gbUsePvsForSight = false;
 
     gbFullscreen = true;
     gOutputResolutionW = -1;
     gOutputResolutionH = -1;
+    gRenderScale = 1;
+    gbDynamicResolution = false;
+    gDynamicResolutionTargetMs = 4.0f;
+    gDynamicResolutionMinScale = 0.5f;
+    gRenderThreads = 0;
+    gbAsyncPresent = false;
+    gbUseLitTextureCache = false;
+    gLitTextureCacheSizeMB = 64;
+    gbDrawFlatsAsSpans = false;
+    gbTiledRendering = false;
+    gbColumnMajorViewBuffer = false;
+    gbCacheSegTransforms = true;
 
     gInputAnalogToDigitalThreshold = 0.5f;
     gbDefaultAlwaysRun = false;
@@ -1055,6 +1298,13 @@ static void clear() noexcept {
     
     gbAllowDebugCameraUpDownMovement = false;
     gPerfCounterNumFramesToAverage = 15;
+    gbUseSimdRendering = true;
+    gbBenchmarkFlatDrawModes = false;
+    gbBenchmarkViewBufferLayouts = false;
+    gbBenchmarkBspTraversal = false;
+    gbVerifyPvs = false;
+    gProfilerCsvFilePath.clear();
+    gProfilerTraceFilePath.clear();
 
     setCheatKeySequence(gCheatKeys_GodMode,                     "IDDQD");
     setCheatKeySequence(gCheatKeys_NoClip,                      "IDCLIP");
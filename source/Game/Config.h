@@ -10,11 +10,25 @@ BEGIN_NAMESPACE(Config)
 extern std::string  gGameDataCDImagePath;
 extern bool         gbUseGameDataDirectory;
 extern std::string  gGameDataDirectoryPath;
+extern bool         gbUsePvs;
+extern bool         gbUsePvsForSight;
 
 // Video settings
 extern bool         gbFullscreen;
 extern int32_t      gOutputResolutionW;
 extern int32_t      gOutputResolutionH;
+extern uint32_t     gRenderScale;
+extern bool         gbDynamicResolution;
+extern float        gDynamicResolutionTargetMs;
+extern float        gDynamicResolutionMinScale;
+extern int32_t      gRenderThreads;
+extern bool         gbAsyncPresent;
+extern bool         gbUseLitTextureCache;
+extern uint32_t     gLitTextureCacheSizeMB;
+extern bool         gbDrawFlatsAsSpans;
+extern bool         gbTiledRendering;
+extern bool         gbColumnMajorViewBuffer;
+extern bool         gbCacheSegTransforms;
 
 // Input general settings
 extern float    gInputAnalogToDigitalThreshold;
@@ -41,6 +55,13 @@ extern Controls::AxisBits           gGamepadAxisBindings[NUM_CONTROLLER_INPUTS];
 // Debug stuff
 extern bool         gbAllowDebugCameraUpDownMovement;
 extern uint32_t     gPerfCounterNumFramesToAverage;
+extern bool         gbUseSimdRendering;
+extern bool         gbBenchmarkFlatDrawModes;
+extern bool         gbBenchmarkViewBufferLayouts;
+extern bool         gbBenchmarkBspTraversal;
+extern bool         gbVerifyPvs;
+extern std::string  gProfilerCsvFilePath;
+extern std::string  gProfilerTraceFilePath;
 
 // Cheat key sequences: an array of up to 16 SDL scan codes.
 // Unused key slots in the sequence will be set to '0'.
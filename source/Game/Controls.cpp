@@ -19,6 +19,7 @@ static float gAxis_AutomapZoomInOut;
 static float gAxis_MenuUpDown;
 static float gAxis_MenuLeftRight;
 static float gAxis_WeaponNextPrev;
+static float gMouseTurn;
 
 static void clearAllActionBits() noexcept {
     gGameActionsActive       = GameActions::NONE;
@@ -37,6 +38,7 @@ static void clearAllAxes() noexcept {
     gAxis_MenuUpDown        = 0.0f;
     gAxis_MenuLeftRight     = 0.0f;
     gAxis_WeaponNextPrev    = 0.0f;
+    gMouseTurn              = 0.0f;
 }
 
 static void clearAllInputs() noexcept {
@@ -222,6 +224,9 @@ static void updateAxesFromMouseInput() noexcept {
 
     handleAnalogInput(xAxisMovement, xAxisBindings);
     handleAnalogInput(yAxisMovement, yAxisBindings);
+
+    // Regular mouse movement is used for turning only
+    gMouseTurn = Input::getMouseXMovement() * Config::gMouseTurnSensitivity;
 }
 
 static void updateAxesFromControllerInput() noexcept {    
@@ -310,6 +315,46 @@ void update() noexcept {
     updateAxesFromControllerInput();
 }
 
+float getMouseTurn() noexcept {
+    return gMouseTurn;
+}
+
+TickInputs getTickInputs() noexcept {
+    TickInputs inputs = {};
+    inputs.gameActionsActive = gGameActionsActive;
+    inputs.gameActionsJustStarted = gGameActionsJustStarted;
+    inputs.gameActionsJustEnded = gGameActionsJustEnded;
+    inputs.menuActionsActive = gMenuActionsActive;
+    inputs.menuActionsJustStarted = gMenuActionsJustStarted;
+    inputs.menuActionsJustEnded = gMenuActionsJustEnded;
+    inputs.axisTurnLeftRight = gAxis_TurnLeftRight;
+    inputs.axisMoveForwardBack = gAxis_MoveForwardBack;
+    inputs.axisStrafeLeftRight = gAxis_StrafeLeftRight;
+    inputs.axisAutomapZoomInOut = gAxis_AutomapZoomInOut;
+    inputs.axisMenuUpDown = gAxis_MenuUpDown;
+    inputs.axisMenuLeftRight = gAxis_MenuLeftRight;
+    inputs.axisWeaponNextPrev = gAxis_WeaponNextPrev;
+    inputs.mouseTurn = gMouseTurn;
+    return inputs;
+}
+
+void setTickInputs(const TickInputs& inputs) noexcept {
+    gGameActionsActive = inputs.gameActionsActive;
+    gGameActionsJustStarted = inputs.gameActionsJustStarted;
+    gGameActionsJustEnded = inputs.gameActionsJustEnded;
+    gMenuActionsActive = inputs.menuActionsActive;
+    gMenuActionsJustStarted = inputs.menuActionsJustStarted;
+    gMenuActionsJustEnded = inputs.menuActionsJustEnded;
+    gAxis_TurnLeftRight = inputs.axisTurnLeftRight;
+    gAxis_MoveForwardBack = inputs.axisMoveForwardBack;
+    gAxis_StrafeLeftRight = inputs.axisStrafeLeftRight;
+    gAxis_AutomapZoomInOut = inputs.axisAutomapZoomInOut;
+    gAxis_MenuUpDown = inputs.axisMenuUpDown;
+    gAxis_MenuLeftRight = inputs.axisMenuLeftRight;
+    gAxis_WeaponNextPrev = inputs.axisWeaponNextPrev;
+    gMouseTurn = inputs.mouseTurn;
+}
+
 void gatherAnalogAndDigitalMenuMovements(int32_t& menuMoveX, int32_t& menuMoveY) noexcept {
     // Gather the inputs
     float menuMoveXF = INPUT_AXIS(MENU_LEFT_RIGHT);
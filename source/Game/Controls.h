@@ -100,6 +100,27 @@ namespace Axis {
     #define INPUT_AXIS(NAME) Controls::Axis::getValue(Controls::Axis::NAME)
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// The state of all controls for one game tick: everything that the game reads from this module while it is running.
+// Used to record the inputs for each tick and to play them back again later.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct TickInputs {
+    GameActionBits  gameActionsActive;
+    GameActionBits  gameActionsJustStarted;
+    GameActionBits  gameActionsJustEnded;
+    MenuActionBits  menuActionsActive;
+    MenuActionBits  menuActionsJustStarted;
+    MenuActionBits  menuActionsJustEnded;
+    float           axisTurnLeftRight;
+    float           axisMoveForwardBack;
+    float           axisStrafeLeftRight;
+    float           axisAutomapZoomInOut;
+    float           axisMenuUpDown;
+    float           axisMenuLeftRight;
+    float           axisWeaponNextPrev;
+    float           mouseTurn;
+};
+
 // Startup and shutdown control processing
 void init() noexcept;
 void shutdown() noexcept;
@@ -107,6 +128,14 @@ void shutdown() noexcept;
 // Updates what actions are currently active, have just been activated or deactivated
 void update() noexcept;
 
+// Gives the amount of horizontal mouse movement to turn by this tick, with the mouse turn sensitivity applied
+float getMouseTurn() noexcept;
+
+// Get or override the state of all controls for the current tick.
+// Any overridden state stays in effect until the next call to 'update'.
+TickInputs getTickInputs() noexcept;
+void setTickInputs(const TickInputs& inputs) noexcept;
+
 // Helper that gathers menu movements (up/down, left/right) from digital and analog sources.
 // The X and Y movement values returned will range from -1 to +1.
 void gatherAnalogAndDigitalMenuMovements(int32_t& menuMoveX, int32_t& menuMoveY) noexcept;
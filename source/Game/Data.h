@@ -52,7 +52,8 @@ extern uint32_t                 gValidCount;                    // Increment eve
 enum class PerfCounterMode {
     NONE,
     FPS,
-    USEC
+    USEC,
+    PROFILE     // Show the profiler overlay with per stage timings
 };
 
 extern PerfCounterMode  gPerfCounterMode;           // What mode the performance counter is in
@@ -0,0 +1,497 @@
+#include "Demo.h"
+
+#include "Base/CommandLine.h"
+#include "Base/FileUtils.h"
+#include "Base/Random.h"
+#include "Controls.h"
+#include "Data.h"
+#include "DoomDefines.h"
+#include "Map/MapData.h"
+#include "Things/Info.h"
+#include "Things/MapObj.h"
+#include "Things/MObjTable.h"
+#include "Tick.h"
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Demo file format (all values are little endian):
+//
+//  'DDEM'          File identifier
+//  u32             Format version
+//  u32             Map number
+//  u32             Skill
+//  u32             Random seed
+//  u32             Flags (bit 0 = 'always run' enabled)
+//  u32             Number of ticks
+//  u32             Checksum interval, in ticks
+//
+//  For each tick:
+//      u16         Bit mask of which 'TickInputs' fields changed from the previous tick (all fields start out as zero)
+//      u32 * N     The new values for the changed fields, in field order. Floats are stored as their raw bits.
+//      u32         Checksum of the game state before the tick runs: only present when the tick number is a non zero multiple of the
+//                  checksum interval.
+//
+// Since inputs rarely change from one tick to the next most ticks take just 2 bytes to store.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Demo)
+
+static constexpr uint8_t    FILE_ID[4]                  = { 'D', 'D', 'E', 'M' };
+static constexpr uint32_t   FORMAT_VERSION              = 2;
+static constexpr uint32_t   DEFAULT_CHECKSUM_INTERVAL   = TICKSPERSEC;
+
+// Tick inputs are stored as a series of 32-bit fields which are only written when they change
+static constexpr uint32_t NUM_INPUT_FIELDS = sizeof(Controls::TickInputs) / sizeof(uint32_t);
+
+static_assert(sizeof(Controls::TickInputs) == NUM_INPUT_FIELDS * sizeof(uint32_t));
+static_assert(NUM_INPUT_FIELDS <= 16, "Change masks must fit in 16-bits!");
+
+typedef std::array<uint32_t, NUM_INPUT_FIELDS> InputFields;
+
+static DemoHeader                           gHeader;                // Header for the demo being recorded or played
+static std::vector<Controls::TickInputs>    gTickInputs;            // Inputs for each tick of the demo being recorded or played
+static std::vector<uint32_t>                gChecksums;             // Game state checksums for each checksum interval in the demo
+static std::string                          gRecordFilePath;        // Where to save a recording to, if one was requested
+static bool                                 gbRecording;            // True if a demo is being recorded
+static bool                                 gbPlaybackPending;      // True if a demo is loaded and waiting for a new game to start
+static bool                                 gbPlaying;              // True if a demo is being played
+static bool                                 gbPlaybackFinished;     // True if all of the ticks in the demo have been played
+static uint32_t                             gNextTickIdx;           // Next tick to record or play in the demo
+static bool                                 gbDesynced;             // True if a desync was detected during playback
+static uint32_t                             gDesyncTick;            // Which tick the desync was first detected on
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Helpers to convert tick inputs to and from an array of 32-bit fields
+//------------------------------------------------------------------------------------------------------------------------------------------
+static InputFields tickInputsToFields(const Controls::TickInputs& inputs) noexcept {
+    InputFields fields;
+    std::memcpy(fields.data(), &inputs, sizeof(Controls::TickInputs));
+    return fields;
+}
+
+static Controls::TickInputs fieldsToTickInputs(const InputFields& fields) noexcept {
+    Controls::TickInputs inputs;
+    std::memcpy(&inputs, fields.data(), sizeof(Controls::TickInputs));
+    return inputs;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes little endian values to the end of the given byte buffer
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void writeU16(std::vector<std::byte>& bytes, const uint16_t value) noexcept {
+    bytes.push_back((std::byte)(value));
+    bytes.push_back((std::byte)(value >> 8));
+}
+
+static void writeU32(std::vector<std::byte>& bytes, const uint32_t value) noexcept {
+    bytes.push_back((std::byte)(value));
+    bytes.push_back((std::byte)(value >> 8));
+    bytes.push_back((std::byte)(value >> 16));
+    bytes.push_back((std::byte)(value >> 24));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads little endian values from a demo file's data.
+// If there is not enough data left then '0' is returned and the reader is flagged as having failed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct DemoReader {
+    const std::byte*    pCurByte;
+    const std::byte*    pEndByte;
+    bool                bFailed;
+
+    uint16_t readU16() noexcept {
+        if (pEndByte - pCurByte < 2) {
+            bFailed = true;
+            return 0;
+        }
+
+        const uint16_t value = (uint16_t)((uint32_t) pCurByte[0] | ((uint32_t) pCurByte[1] << 8));
+        pCurByte += 2;
+        return value;
+    }
+
+    uint32_t readU32() noexcept {
+        if (pEndByte - pCurByte < 4) {
+            bFailed = true;
+            return 0;
+        }
+
+        const uint32_t value = (
+            ((uint32_t) pCurByte[0]) |
+            ((uint32_t) pCurByte[1] << 8) |
+            ((uint32_t) pCurByte[2] << 16) |
+            ((uint32_t) pCurByte[3] << 24)
+        );
+
+        pCurByte += 4;
+        return value;
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if a game state checksum is taken before the given tick runs
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool isChecksumTick(const uint32_t tickIdx) noexcept {
+    return ((tickIdx > 0) && (gHeader.checksumInterval > 0) && (tickIdx % gHeader.checksumInterval == 0));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Computes a checksum (FNV-1a hash) of the parts of the game state which would be affected by a desync.
+// This covers the state of the random number generator, the player, all map objects and all sector heights.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void addToChecksum(uint32_t& checksum, const uint32_t value) noexcept {
+    for (uint32_t byteIdx = 0; byteIdx < 4; ++byteIdx) {
+        checksum ^= (value >> (byteIdx * 8)) & 0xFFu;
+        checksum *= 16777619u;
+    }
+}
+
+static uint32_t computeGameStateChecksum() noexcept {
+    uint32_t checksum = 2166136261u;
+    addToChecksum(checksum, Random::getStateHash());
+
+    // Player state
+    const player_t& player = gPlayer;
+    addToChecksum(checksum, player.armorpoints);
+    addToChecksum(checksum, player.armortype);
+    addToChecksum(checksum, player.killcount);
+    addToChecksum(checksum, player.itemcount);
+    addToChecksum(checksum, player.secretcount);
+    addToChecksum(checksum, (uint32_t) player.readyweapon);
+
+    for (const uint32_t ammo : player.ammo) {
+        addToChecksum(checksum, ammo);
+    }
+
+    for (const uint32_t power : player.powers) {
+        addToChecksum(checksum, power);
+    }
+
+    // Map objects
+    const uint32_t numMObjs = MObjTable::getNumEntries();
+
+    for (uint32_t orderIdx = 0; orderIdx < numMObjs; ++orderIdx) {
+        const mobj_t* const pMObj = MObjTable::getEntry(orderIdx);
+
+        if (!pMObj)
+            continue;
+
+        addToChecksum(checksum, (uint32_t) pMObj->x);
+        addToChecksum(checksum, (uint32_t) pMObj->y);
+        addToChecksum(checksum, (uint32_t) pMObj->z);
+        addToChecksum(checksum, (uint32_t) pMObj->angle);
+        addToChecksum(checksum, (uint32_t) pMObj->momx);
+        addToChecksum(checksum, (uint32_t) pMObj->momy);
+        addToChecksum(checksum, (uint32_t) pMObj->momz);
+        addToChecksum(checksum, (uint32_t)(pMObj->InfoPtr - gMObjInfo));
+        addToChecksum(checksum, (uint32_t)(pMObj->state - gStates));
+        addToChecksum(checksum, pMObj->tics);
+        addToChecksum(checksum, pMObj->flags);
+        addToChecksum(checksum, pMObj->MObjHealth);
+    }
+
+    // Sector heights (for doors, lifts etc.)
+    for (uint32_t sectorIdx = 0; sectorIdx < gNumSectors; ++sectorIdx) {
+        const sector_t& sector = gpSectors[sectorIdx];
+        addToChecksum(checksum, (uint32_t) sector.floorheight);
+        addToChecksum(checksum, (uint32_t) sector.ceilingheight);
+    }
+
+    return checksum;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Writes the demo that has been recorded to the file requested on the command line
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void saveRecording() noexcept {
+    gHeader.numTicks = (uint32_t) gTickInputs.size();
+
+    // Write the header
+    std::vector<std::byte> fileData;
+    fileData.reserve(64 + gTickInputs.size() * 4);
+
+    for (const uint8_t idChar : FILE_ID) {
+        fileData.push_back((std::byte) idChar);
+    }
+
+    writeU32(fileData, FORMAT_VERSION);
+    writeU32(fileData, gHeader.map);
+    writeU32(fileData, gHeader.skill);
+    writeU32(fileData, gHeader.randomSeed);
+    writeU32(fileData, (gHeader.bAlwaysRun) ? 1 : 0);
+    writeU32(fileData, gHeader.numTicks);
+    writeU32(fileData, gHeader.checksumInterval);
+
+    // Write the fields that changed for each tick, followed by a checksum if this tick has one
+    InputFields prevFields = {};
+
+    for (uint32_t tickIdx = 0; tickIdx < gHeader.numTicks; ++tickIdx) {
+        const InputFields fields = tickInputsToFields(gTickInputs[tickIdx]);
+        uint16_t changeMask = 0;
+
+        for (uint32_t fieldIdx = 0; fieldIdx < NUM_INPUT_FIELDS; ++fieldIdx) {
+            if (fields[fieldIdx] != prevFields[fieldIdx]) {
+                changeMask |= (uint16_t)(1u << fieldIdx);
+            }
+        }
+
+        writeU16(fileData, changeMask);
+
+        for (uint32_t fieldIdx = 0; fieldIdx < NUM_INPUT_FIELDS; ++fieldIdx) {
+            if (changeMask & (1u << fieldIdx)) {
+                writeU32(fileData, fields[fieldIdx]);
+            }
+        }
+
+        if (isChecksumTick(tickIdx)) {
+            const uint32_t checksumIdx = tickIdx / gHeader.checksumInterval - 1;
+            writeU32(fileData, gChecksums[checksumIdx]);
+        }
+
+        prevFields = fields;
+    }
+
+    if (FileUtils::writeDataToFile(gRecordFilePath.c_str(), fileData.data(), fileData.size())) {
+        std::printf("Demo: recorded %u ticks (%u bytes) to '%s'\n", gHeader.numTicks, (uint32_t) fileData.size(), gRecordFilePath.c_str());
+    } else {
+        std::printf("Demo: failed to write the recording to '%s'!\n", gRecordFilePath.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reads the header, inputs and checksums for a demo from the given file data, returning 'false' if the data is not valid
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool readDemo(const std::byte* const pFileData, const size_t fileSize) noexcept {
+    if ((fileSize < sizeof(FILE_ID)) || (std::memcmp(pFileData, FILE_ID, sizeof(FILE_ID)) != 0))
+        return false;
+
+    DemoReader reader = { pFileData + sizeof(FILE_ID), pFileData + fileSize, false };
+
+    if (reader.readU32() != FORMAT_VERSION)
+        return false;
+
+    DemoHeader header = {};
+    header.map = reader.readU32();
+    header.skill = reader.readU32();
+    header.randomSeed = reader.readU32();
+    header.bAlwaysRun = ((reader.readU32() & 1) != 0);
+    header.numTicks = reader.readU32();
+    header.checksumInterval = reader.readU32();
+
+    // Sanity check the tick count against the data size before allocating anything: each tick needs at least 2 bytes
+    const size_t numBytesLeft = (size_t)(reader.pEndByte - reader.pCurByte);
+
+    if (reader.bFailed || (header.skill > sk_nightmare) || ((size_t) header.numTicks * 2 > numBytesLeft))
+        return false;
+
+    gHeader = header;
+    gTickInputs.clear();
+    gTickInputs.reserve(header.numTicks);
+    gChecksums.clear();
+
+    // Read the fields that changed for each tick and any checksums
+    InputFields fields = {};
+
+    for (uint32_t tickIdx = 0; tickIdx < header.numTicks; ++tickIdx) {
+        const uint16_t changeMask = reader.readU16();
+
+        for (uint32_t fieldIdx = 0; fieldIdx < NUM_INPUT_FIELDS; ++fieldIdx) {
+            if (changeMask & (1u << fieldIdx)) {
+                fields[fieldIdx] = reader.readU32();
+            }
+        }
+
+        gTickInputs.push_back(fieldsToTickInputs(fields));
+
+        if (isChecksumTick(tickIdx)) {
+            gChecksums.push_back(reader.readU32());
+        }
+
+        if (reader.bFailed)
+            return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Verifies the game state checksum for the current tick against what was recorded (if there is one for this tick)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void verifyChecksum(const uint32_t tickIdx) noexcept {
+    if (gbDesynced || (!isChecksumTick(tickIdx)))
+        return;
+
+    const uint32_t checksumIdx = tickIdx / gHeader.checksumInterval - 1;
+
+    if (checksumIdx >= gChecksums.size())
+        return;
+
+    if (computeGameStateChecksum() != gChecksums[checksumIdx]) {
+        gbDesynced = true;
+        gDesyncTick = tickIdx;
+        std::printf("Demo: playback desynced! Game state checksum mismatch at tick %u.\n", tickIdx);
+    }
+}
+
+void init() noexcept {
+    gHeader = {};
+    gTickInputs.clear();
+    gChecksums.clear();
+    gRecordFilePath = CommandLine::getArgValue("-record", "");
+    gbRecording = false;
+    gbPlaybackPending = false;
+    gbPlaying = false;
+    gbPlaybackFinished = false;
+    gNextTickIdx = 0;
+    gbDesynced = false;
+    gDesyncTick = 0;
+}
+
+void shutdown() noexcept {
+    stopPlayback();
+
+    gHeader = {};
+    gTickInputs.clear();
+    gTickInputs.shrink_to_fit();
+    gChecksums.clear();
+    gChecksums.shrink_to_fit();
+    gRecordFilePath.clear();
+    gRecordFilePath.shrink_to_fit();
+    gbRecording = false;
+}
+
+bool startPlayback(const char* const filePath) noexcept {
+    ASSERT(filePath);
+    stopPlayback();
+
+    // Read the file and parse it
+    std::byte* pFileData = nullptr;
+    size_t fileSize = 0;
+
+    if (!FileUtils::getContentsOfFile(filePath, pFileData, fileSize))
+        return false;
+
+    std::unique_ptr<std::byte[]> pFileDataOwner(pFileData);
+
+    if (!readDemo(pFileData, fileSize)) {
+        gHeader = {};
+        gTickInputs.clear();
+        gChecksums.clear();
+        return false;
+    }
+
+    // Make the random number generator repeatable for the demo
+    Random::setFixedSeed(gHeader.randomSeed);
+    gbPlaybackPending = true;
+    return true;
+}
+
+void stopPlayback() noexcept {
+    if (gbPlaybackPending || gbPlaying) {
+        Random::clearFixedSeed();
+    }
+
+    gbPlaybackPending = false;
+    gbPlaying = false;
+    gbPlaybackFinished = false;
+    gNextTickIdx = 0;
+    gbDesynced = false;
+    gDesyncTick = 0;
+}
+
+bool isPlaying() noexcept {
+    return gbPlaying;
+}
+
+bool isPlaybackFinished() noexcept {
+    return (gbPlaybackFinished || (gbPlaying && (gNextTickIdx >= gHeader.numTicks)));
+}
+
+const DemoHeader& getPlaybackHeader() noexcept {
+    return gHeader;
+}
+
+bool hasDesynced() noexcept {
+    return gbDesynced;
+}
+
+uint32_t getDesyncTick() noexcept {
+    return gDesyncTick;
+}
+
+void onNewGame(const skill_e skill, const uint32_t map) noexcept {
+    // Playing back a demo that was loaded?
+    if (gbPlaybackPending) {
+        gbPlaybackPending = false;
+        gbPlaying = true;
+        gbPlaybackFinished = false;
+        gNextTickIdx = 0;
+        gbDesynced = false;
+        gDesyncTick = 0;
+        gbAlwaysRun = gHeader.bAlwaysRun;
+        return;
+    }
+
+    // Otherwise start recording if that was requested and not already done.
+    // Pick a random seed to use for the entire level so that it can be repeated exactly.
+    if (gRecordFilePath.empty() || gbRecording || gbPlaying)
+        return;
+
+    std::random_device randomDevice;
+
+    gHeader = {};
+    gHeader.map = map;
+    gHeader.skill = skill;
+    gHeader.randomSeed = randomDevice();
+    gHeader.bAlwaysRun = gbAlwaysRun;
+    gHeader.checksumInterval = DEFAULT_CHECKSUM_INTERVAL;
+    gTickInputs.clear();
+    gChecksums.clear();
+    gNextTickIdx = 0;
+    gbRecording = true;
+
+    Random::setFixedSeed(gHeader.randomSeed);
+}
+
+void onTick() noexcept {
+    if (gbRecording) {
+        if (isChecksumTick(gNextTickIdx)) {
+            gChecksums.push_back(computeGameStateChecksum());
+        }
+
+        gTickInputs.push_back(Controls::getTickInputs());
+        ++gNextTickIdx;
+    }
+    else if (gbPlaying) {
+        // Once the demo runs out of inputs just feed in no input
+        if (gNextTickIdx < gHeader.numTicks) {
+            verifyChecksum(gNextTickIdx);
+            Controls::setTickInputs(gTickInputs[gNextTickIdx]);
+            ++gNextTickIdx;
+        } else {
+            Controls::setTickInputs({});
+            gbPlaybackFinished = true;
+        }
+    }
+}
+
+void onLevelEnd() noexcept {
+    // Only one level is recorded or played per demo
+    if (gbRecording) {
+        saveRecording();
+        gRecordFilePath.clear();
+        gbRecording = false;
+        Random::clearFixedSeed();
+    }
+    else if (gbPlaying) {
+        gbPlaying = false;
+        gbPlaybackFinished = true;
+        Random::clearFixedSeed();
+    }
+}
+
+END_NAMESPACE(Demo)
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Base/Macros.h"
+#include <cstdint>
+
+enum skill_e : uint8_t;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Recording and playback of the inputs for a game.
+//
+// A demo holds the control state for every tick of one level, starting from a new game, along with the random seed and other settings
+// needed to make the game simulation repeat exactly. Passing '-record <file>' on the command line records the first level of the next
+// new game started to that file. Demos are played back at normal speed with '-playdemo <file>' or as fast as possible by the timedemo.
+//
+// A checksum of the game state is also saved every so often while recording. These are verified during playback to detect desyncs,
+// i.e the game simulation not playing out the same way as when the demo was recorded.
+//
+// Notes:
+//  (1) Playback is only guaranteed to match the recording for the same build of the game, since the random number distributions used
+//      are implementation defined. The config settings which affect gameplay (e.g analog to digital thresholds) must also match.
+//  (2) Cheats are not recorded since they are read directly from the keyboard rather than from the controls.
+//  (3) Playback does not depend on the screen resolution or render scale: randomness used only for presentation (e.g. screen wipes)
+//      comes from a separate random number stream to the game simulation, so it never shifts the random numbers seen by the game.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Demo)
+
+// Settings for a demo, which are saved at the start of the demo file
+struct DemoHeader {
+    uint32_t    map;                    // Which map and skill the demo is for
+    uint32_t    skill;
+    uint32_t    randomSeed;             // The random number generator seed to use for the whole demo
+    bool        bAlwaysRun;             // Whether 'always run' was enabled at the start of the demo
+    uint32_t    numTicks;               // How many ticks of input are in the demo
+    uint32_t    checksumInterval;       // How many ticks there are between each saved checksum of the game state
+};
+
+// Startup and shutdown demo recording and playback
+void init() noexcept;
+void shutdown() noexcept;
+
+// Load a demo from the given file and prepare to play it on the next new game, returning 'false' on failure.
+// The fixed random seed for the demo takes effect immediately.
+bool startPlayback(const char* const filePath) noexcept;
+void stopPlayback() noexcept;
+
+// Query the state of playback and the header for the demo being played.
+// Playback is finished once all of the ticks in the demo have been played.
+bool isPlaying() noexcept;
+bool isPlaybackFinished() noexcept;
+const DemoHeader& getPlaybackHeader() noexcept;
+
+// Tells if the demo being played has desynced and the first tick where that was detected
+bool hasDesynced() noexcept;
+uint32_t getDesyncTick() noexcept;
+
+// Hooks for the game: called at the start of a new game, at the start of each game tick and when a level ends
+void onNewGame(const skill_e skill, const uint32_t map) noexcept;
+void onTick() noexcept;
+void onLevelEnd() noexcept;
+
+END_NAMESPACE(Demo)
@@ -1,9 +1,14 @@
 #include "DoomMain.h"
 
 #include "Audio/Audio.h"
+#include "Base/CommandLine.h"
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
 #include "Config.h"
 #include "Data.h"
+#include "Demo.h"
 #include "DoomRez.h"
+#include "Game.h"
 #include "GameDataFS.h"
 #include "GFX/CelImages.h"
 #include "GFX/Renderer.h"
@@ -11,12 +16,15 @@
 #include "Map/Setup.h"
 #include "Prefs.h"
 #include "Resources.h"
+#include "Tick.h"
 #include "TickCounter.h"
+#include "TimeDemo.h"
 #include "UI/IntroLogos.h"
 #include "UI/IntroMovies.h"
 #include "UI/OptionsMenu.h"
 #include "UI/TitleScreens.h"
 #include "UI/WipeFx.h"
+#include <algorithm>
 #include <SDL2/SDL.h>
 #include <thread>
 
@@ -27,9 +35,12 @@ static uint64_t gPerfProfileStartClockCount;
 
 static void startTickPerfProfile() noexcept {
     gPerfProfileStartClockCount = SDL_GetPerformanceCounter();
+    Profiler::beginFrame();
 }
 
 static void endTickPerfProfile() noexcept {
+    Profiler::endFrame(Config::gPerfCounterNumFramesToAverage);
+
     // Performance profiling: add to the running total
     const uint64_t perfEndClock = SDL_GetPerformanceCounter();
     const uint64_t perfNumClocks = perfEndClock - gPerfProfileStartClockCount;
@@ -56,10 +67,15 @@ static void checkForPerfProfileToggle() noexcept {
         }
         else if (gPerfCounterMode == PerfCounterMode::FPS) {
             gPerfCounterMode = PerfCounterMode::USEC;
-        } 
+        }
+        else if (gPerfCounterMode == PerfCounterMode::USEC) {
+            gPerfCounterMode = PerfCounterMode::PROFILE;
+        }
         else {
             gPerfCounterMode = PerfCounterMode::NONE;
         }
+
+        Profiler::setOverlayEnabled(gPerfCounterMode == PerfCounterMode::PROFILE);
     }
 }
 
@@ -106,7 +122,11 @@ gameaction_e RunGameLoop(
         // Possibly doing a tick: update input and controls and if a quit was requested then exit immediately
         startTickPerfProfile();
 
-        Input::update();
+        {
+            PROFILE_SCOPE("Input::update");
+            Input::update();
+        }
+
         Controls::update();
         checkForPerfProfileToggle();    // Allow the FPS counter to be toggled
 
@@ -122,6 +142,11 @@ gameaction_e RunGameLoop(
                 --ticksLeftToSimulate;
                 nextGameAction = ticker();      // Process the keypad commands
 
+                // If playing back a demo then stop once it runs out of inputs
+                if ((nextGameAction == ga_nothing) && Demo::isPlaybackFinished()) {
+                    nextGameAction = ga_exitdemo;
+                }
+
                 if (ticksLeftToSimulate > 0) {
                     Input::consumeEvents();     // Don't allow any more keypress events if we do more than 1 tick
                     Controls::update();         // Update controls based on that for the next tick
@@ -137,6 +162,7 @@ gameaction_e RunGameLoop(
         // Sync up with the refresh - draw the screen.
         // Also save the framebuffer for each game loop transition, so we can do a wipe if needed.
         if (drawer) {
+            PROFILE_SCOPE("Draw");
             const bool bPresent = true;
             const bool bSaveFrameBuffer = (nextGameAction != ga_nothing);
             drawer(bPresent, bSaveFrameBuffer);
@@ -160,17 +186,23 @@ gameaction_e RunGameLoop(
 // Game initialization
 //------------------------------------------------------------------------------------------------------------------------------------------
 static void D_DoomInit() noexcept {
+    // Timedemos run without a window or audio device
+    const bool bHeadless = TimeDemo::isRequested();
+
     // Init main subsystems
     Config::init();
+    JobSystem::init((uint32_t) std::max(Config::gRenderThreads, 0));
+    Profiler::init(Config::gProfilerCsvFilePath.c_str(), Config::gProfilerTraceFilePath.c_str());
     Prefs::load();
     GameDataFS::init();
     Resources::init();
     CelImages::init();
-    Video::init();
+    Video::init(bHeadless);
     Input::init();
-    Audio::init();
+    Audio::init(bHeadless);
     Audio::loadAllSounds();
     Controls::init();
+    Demo::init();
     Renderer::init();
 
     // Other initialization
@@ -185,6 +217,7 @@ static void D_DoomInit() noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 static void D_DoomShutdown() noexcept {
     Renderer::shutdown();
+    Demo::shutdown();
     Controls::shutdown();
     Audio::shutdown();
     Input::shutdown();
@@ -193,15 +226,52 @@ static void D_DoomShutdown() noexcept {
     Resources::shutdown();
     GameDataFS::shutdown();
     Prefs::save();
+    Profiler::shutdown();
+    JobSystem::shutdown();
     Config::shutdown();
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Plays back a recorded demo at normal speed, as requested via '-playdemo <file>'
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void D_PlayDemo(const char* const demoFilePath) noexcept {
+    if (!Demo::startPlayback(demoFilePath)) {
+        FATAL_ERROR_F("Failed to load the demo file '%s'!", demoFilePath);
+    }
+
+    const Demo::DemoHeader& header = Demo::getPlaybackHeader();
+    G_InitNew((skill_e) header.skill, header.map);
+    RunGameLoop(P_Start, P_Stop, P_Ticker, P_Drawer);
+
+    if (Demo::hasDesynced()) {
+        std::printf("Demo: '%s' desynced at tick %u!\n", demoFilePath, Demo::getDesyncTick());
+    } else {
+        std::printf("Demo: '%s' played back without any desyncs detected\n", demoFilePath);
+    }
+
+    Demo::stopPlayback();
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Main entry point for DOOM!!!!
 //------------------------------------------------------------------------------------------------------------------------------------------
-void D_DoomMain() noexcept {
+void D_DoomMain(const int argc, const char* const* const argv) noexcept {
+    CommandLine::init(argc, argv);
     D_DoomInit();
-    
+
+    // Just run the benchmark and exit if doing a timedemo
+    if (TimeDemo::isRequested()) {
+        TimeDemo::run();
+        D_DoomShutdown();
+        CommandLine::shutdown();
+        return;
+    }
+
+    // Play a demo first if requested, then carry on to the title screen as normal
+    if (const char* const demoFilePath = CommandLine::getArgValue("-playdemo")) {
+        D_PlayDemo(demoFilePath);
+    }
+
     IntroLogos::run();
     IntroMovies::run();
 
@@ -214,4 +284,5 @@ void D_DoomMain() noexcept {
     }
 
     D_DoomShutdown();
+    CommandLine::shutdown();
 }
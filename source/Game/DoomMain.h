@@ -20,4 +20,5 @@ gameaction_e RunGameLoop(
     const GameLoopDrawFunc drawer
 ) noexcept;
 
-void D_DoomMain() noexcept;
+// Main entry point for the game, which is given the program's command line arguments
+void D_DoomMain(const int argc, const char* const* const argv) noexcept;
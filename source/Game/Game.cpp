@@ -4,6 +4,7 @@
 #include "Base/Mem.h"
 #include "Base/Random.h"
 #include "Data.h"
+#include "Demo.h"
 #include "DoomMain.h"
 #include "Map/Setup.h"
 #include "Prefs.h"
@@ -90,7 +91,8 @@ void G_SecretExitLevel() noexcept {
 // Init variables for a new game
 //------------------------------------------------------------------------------------------------------------------------------------------
 void G_InitNew(const skill_e skill, const uint32_t map) noexcept {
-    Random::init();     // Reset the random number generator
+    Demo::onNewGame(skill, map);    // Start recording or playing back a demo, if requested
+    Random::init();                 // Reset the random number generator
 
     gGameMap = map;
     gGameSkill = skill;
@@ -365,4 +365,22 @@ std::unique_ptr<InputStream> openFile(const char* const pFilePath) noexcept {
     }
 }
 
+std::string getHostFilePath(const char* const pFileName) noexcept {
+    ASSERT(pFileName);
+
+    if (Config::gbUseGameDataDirectory) {
+        return gGameDataDir + pFileName;
+    }
+
+    // Use the folder that the CD image is in, which is just the current working directory if the image path has no folders
+    const std::string& cdImagePath = Config::gGameDataCDImagePath;
+    size_t dirPathLen = cdImagePath.size();
+
+    while ((dirPathLen > 0) && (!isPathSeparatorChar(cdImagePath[dirPathLen - 1]))) {
+        --dirPathLen;
+    }
+
+    return cdImagePath.substr(0, dirPathLen) + pFileName;
+}
+
 END_NAMESPACE(GameDataFS)
@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Game Data File System: provides access to the assets used by the game.
@@ -35,6 +36,12 @@ bool getContentsOfFile(
 //------------------------------------------------------------------------------------------------------------------------------------------
 std::unique_ptr<InputStream> openFile(const char* const pFilePath) noexcept;
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the path to a file on the host machine which is kept alongside the game data: in the game data directory if that is being used,
+// otherwise in the same folder as the CD-ROM image. Used for files which are derived from the game data and cached between runs.
+//------------------------------------------------------------------------------------------------------------------------------------------
+std::string getHostFilePath(const char* const pFileName) noexcept;
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // An abstracted file input stream that reads game data from either a file on disk or a file embedded in a CD-ROM image.
 // The file is closed (and can only be closed) by simply destroying it - you must cleanup the returned stream fully!
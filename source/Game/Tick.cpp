@@ -3,11 +3,13 @@
 #include "Audio/Audio.h"
 #include "Audio/Sound.h"
 #include "Audio/Sounds.h"
-#include "Base/Mem.h"
+#include "Base/Profiler.h"
 #include "Base/Random.h"
+#include "Base/SlabPool.h"
 #include "Cheats.h"
 #include "Controls.h"
 #include "Data.h"
+#include "Demo.h"
 #include "DoomDefines.h"
 #include "DoomRez.h"
 #include "Game.h"
@@ -16,10 +18,11 @@
 #include "Map/Ceiling.h"
 #include "Map/Platforms.h"
 #include "Map/Setup.h"
+#include "Map/Sight.h"
 #include "Map/Specials.h"
 #include "Things/Base.h"
 #include "Things/MapObj.h"
-#include "Things/Shoot.h"
+#include "Things/MObjTable.h"
 #include "Things/Slide.h"
 #include "Things/User.h"
 #include "UI/Automap.h"
@@ -32,8 +35,29 @@ struct thinker_t {
     thinker_t*      next;
     thinker_t*      prev;
     ThinkerFunc     function;
+    uint32_t        poolIdx;    // Which of the thinker pools the memory for the thinker came from
 };
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Memory for map objects and thinkers lasts for the duration of a level, so it comes from pools which are emptied all at once when the
+// level is over instead of going through the system allocator for each one. Thinkers come in a few different sizes, so there is a pool
+// for each size class and a thinker goes in the smallest one that fits it.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr uint32_t THINKER_POOL_SLOT_SIZES[] = { 64, 128, 256 };
+static constexpr uint32_t NUM_THINKER_POOLS = C_ARRAY_SIZE(THINKER_POOL_SLOT_SIZES);
+
+static SlabPool gMObjPool(sizeof(mobj_t));
+
+static SlabPool gThinkerPools[NUM_THINKER_POOLS] = {
+    SlabPool(THINKER_POOL_SLOT_SIZES[0]),
+    SlabPool(THINKER_POOL_SLOT_SIZES[1]),
+    SlabPool(THINKER_POOL_SLOT_SIZES[2]),
+};
+
+// Allocation totals as of the last time the profiler counters were set, for counting allocations per tick
+static uint64_t gLastNumMObjAllocs;
+static uint64_t gLastNumThinkerAllocs;
+
 static uint32_t     gTimeMark1;         // Timer for ticks
 static uint32_t     gTimeMark2;         // Timer for ticks
 static uint32_t     gTimeMark4;         // Timer for ticks
@@ -46,7 +70,6 @@ bool    gbTick4;
 bool    gbTick2;
 bool    gbTick1;
 bool    gbGamePaused;
-mobj_t  gMObjHead;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Remove a thinker structure from the linked list and from memory.
@@ -59,40 +82,27 @@ static void RemoveMeThink(thinker_t& thinker) noexcept {
     ASSERT(pPrev);
     pNext->prev = pPrev;            // Unlink it
     pPrev->next = pNext;
-    MemFree(pActualThinker);        // Release the memory
+    gThinkerPools[pActualThinker->poolIdx].free(pActualThinker);    // Release the memory
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Init the mobj list and the thinker list.
-// I use a circular linked list with a mobjhead and thinkercap structure used only as an anchor point.
-// These header structures are not used in actual gameplay, only for a referance point.
-// If this is the first time through (!thinkercap.next) then just init the vars, else follow the memory chain and
-// dispose of the memory.
+// Init the mobj table and the thinker list.
+// I use a circular linked list with a thinkercap structure used only as an anchor point.
+// This header structure is not used in actual gameplay, only for a referance point.
+// All of the memory for map objects and thinkers is disposed of at once by emptying the pools it came from.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void InitThinkers() noexcept {
     ResetPlats();           // Reset the platforms
     ResetCeilings();        // Reset the ceilings
 
-    if (gMObjHead.next) {   // Initialized before?
-        mobj_t* pMObj = gMObjHead.next;
-        while (pMObj != &gMObjHead) {                   // Any player object
-            mobj_t* const pNextMObj = pMObj->next;      // Get the next record
-            MemFree(pMObj);                             // Delete the object from the list
-            pMObj = pNextMObj;
-        }
-    }
+    gMObjPool.reset();
 
-    if (gThinkerCap.next) {
-        thinker_t* pThinker = gThinkerCap.next;
-        while (pThinker != &gThinkerCap) {                      // Is there a think struct here?
-            thinker_t* const pNextThinker = pThinker->next;
-            MemFree(pThinker);                                  // Delete it from memory
-            pThinker = pNextThinker;
-        }
+    for (SlabPool& pool : gThinkerPools) {
+        pool.reset();
     }
 
     gThinkerCap.prev = gThinkerCap.next  = &gThinkerCap;    // Loop around
-    gMObjHead.next = gMObjHead.prev = &gMObjHead;           // Loop around
+    MObjTable::clear();                                     // No map objects
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -100,9 +110,20 @@ void InitThinkers() noexcept {
 // This way, I can get my code executed before the think execute routine finishes.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void* AddThinker(const ThinkerFunc funcProc, const uint32_t memSize) noexcept {
-    const uint32_t allocSize = memSize + sizeof(thinker_t);         // Add size for the thinker prestructure
-    thinker_t* const pThinker = (thinker_t*) MemAlloc(allocSize);   // Get memory
-    memset(pThinker, 0, allocSize);                                 // Blank it out
+    const uint32_t allocSize = memSize + sizeof(thinker_t);     // Add size for the thinker prestructure
+    uint32_t poolIdx = 0;
+
+    while (allocSize > THINKER_POOL_SLOT_SIZES[poolIdx]) {      // Find the smallest pool it fits in
+        ++poolIdx;
+
+        if (poolIdx >= NUM_THINKER_POOLS) {
+            FATAL_ERROR_F("AddThinker: thinker size %u is too big for the thinker pools!", memSize);
+        }
+    }
+
+    thinker_t* const pThinker = (thinker_t*) gThinkerPools[poolIdx].alloc();   // Get memory
+    memset(pThinker, 0, allocSize);                                             // Blank it out
+    pThinker->poolIdx = poolIdx;
 
     thinker_t* const pPrevLastThinker = gThinkerCap.prev;   // Get the last thinker in the list
     ASSERT(pPrevLastThinker);
@@ -116,6 +137,17 @@ void* AddThinker(const ThinkerFunc funcProc, const uint32_t memSize) noexcept {
     return pThinker + 1;            // Index AFTER the thinker structure
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Allocate and free the memory for a map object
+//------------------------------------------------------------------------------------------------------------------------------------------
+mobj_t& AllocMObj() noexcept {
+    return *(mobj_t*) gMObjPool.alloc();
+}
+
+void FreeMObj(mobj_t& mobj) noexcept {
+    gMObjPool.free(&mobj);
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Deallocation is lazy - it will not actually be freed until its thinking turn comes up
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -150,6 +182,31 @@ void RunThinkers() noexcept {
     }
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reports how many map objects and thinkers there are and how many were allocated since the last time, for the profiler
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void setLevelMemoryCounters() noexcept {
+    uint32_t numLiveThinkers = 0;
+    uint64_t numThinkerAllocs = 0;
+    size_t numBytesReserved = gMObjPool.getNumBytesReserved();
+
+    for (const SlabPool& pool : gThinkerPools) {
+        numLiveThinkers += pool.getNumLiveSlots();
+        numThinkerAllocs += pool.getNumAllocs();
+        numBytesReserved += pool.getNumBytesReserved();
+    }
+
+    const uint64_t numMObjAllocs = gMObjPool.getNumAllocs();
+    Profiler::setCounter("MObjs", (int64_t) gMObjPool.getNumLiveSlots());
+    Profiler::setCounter("MObjAllocs", (int64_t)(numMObjAllocs - gLastNumMObjAllocs));
+    Profiler::setCounter("Thinkers", (int64_t) numLiveThinkers);
+    Profiler::setCounter("ThinkerAllocs", (int64_t)(numThinkerAllocs - gLastNumThinkerAllocs));
+    Profiler::setCounter("LevelPoolKB", (int64_t)(numBytesReserved / 1024));
+
+    gLastNumMObjAllocs = numMObjAllocs;
+    gLastNumThinkerAllocs = numThinkerAllocs;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Check for the pause button
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -174,6 +231,11 @@ static void checkForPauseButton() noexcept {
 // Code that gets executed every game frame
 //------------------------------------------------------------------------------------------------------------------------------------------
 gameaction_e P_Ticker() noexcept {
+    PROFILE_SCOPE("P_Ticker");
+
+    // Record the controls for this tick or substitute them for those in the demo being played
+    Demo::onTick();
+
     // If we are to quit then abort
     if (gbQuitToMainRequested) {
         gGameAction = ga_quit;
@@ -207,6 +269,7 @@ gameaction_e P_Ticker() noexcept {
 
     // Handle cheat codes
     Cheats::update();
+    BeginSightTick();
 
     // If warping then don't do any other logic
     if (gGameAction == ga_warped)
@@ -237,6 +300,11 @@ gameaction_e P_Ticker() noexcept {
     P_UpdateSpecials();     // Handle wall and floor animations
     ST_Ticker();            // Update status bar    
 
+    if (Profiler::gbCapturing) {
+        setLevelMemoryCounters();
+        SetSightCounters();
+    }
+
     return gGameAction;     // May have been set to 'ga_died', 'ga_completed', or 'ga_secretexit'
 }
 
@@ -284,7 +352,6 @@ void P_Start() noexcept {
     ST_Start();                     // Init the status bar this level
     G_DoLoadLevel();                // Load a level into memory
     Slide::init();
-    Shoot::init();
     Random::init();                 // Reset the random number generator
     Cheats::init();                 // Cheat keypress checking
     PlayerCalcHeight(gPlayer);      // Required for the view to be at the right height for the screen wipe
@@ -301,10 +368,10 @@ void P_Start() noexcept {
 // Shut down a game
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_Stop() noexcept {
+    Demo::onLevelEnd();
     Cheats::shutdown();
     S_StopSong();
     Slide::shutdown();
-    Shoot::shutdown();
     ST_Stop();                  // Release the status bar memory
     ReleaseMapMemory();         // Release all the map's memory
     PurgeLineSpecials();        // Release the memory for line specials
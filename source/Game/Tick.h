@@ -12,13 +12,14 @@ extern bool     gbTick4;                    // True 4 times a second
 extern bool     gbTick2;                    // True 2 times a second
 extern bool     gbTick1;                    // True 1 time a second
 extern bool     gbGamePaused;               // True if the game is currently paused
-extern mobj_t   gMObjHead;                  // Head and tail of mobj list
 
 typedef void (*ThinkerFunc)(thinker_t&) noexcept;
 
 void InitThinkers() noexcept;
 void* AddThinker(const ThinkerFunc funcProc, const uint32_t memSize) noexcept;
 void RemoveThinker(void* const pThinker) noexcept;
+mobj_t& AllocMObj() noexcept;
+void FreeMObj(mobj_t& mobj) noexcept;
 void ChangeThinkCode(void* const pThinker, const ThinkerFunc funcProc) noexcept;
 void RunThinkers() noexcept;
 gameaction_e P_Ticker() noexcept;
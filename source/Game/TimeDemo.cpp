@@ -0,0 +1,157 @@
+#include "TimeDemo.h"
+
+#include "Base/CommandLine.h"
+#include "Base/Profiler.h"
+#include "Config.h"
+#include "Data.h"
+#include "Demo.h"
+#include "Game.h"
+#include "Tick.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+BEGIN_NAMESPACE(TimeDemo)
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Timings for one frame of the timedemo, in milliseconds
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct FrameTimes {
+    double  tickMs;
+    double  drawMs;
+    double  totalMs;
+};
+
+static double getElapsedMs(
+    const std::chrono::steady_clock::time_point startTime,
+    const std::chrono::steady_clock::time_point endTime
+) noexcept {
+    return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Computes and prints the statistics for all the frames of the timedemo
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printResults(const char* const demoFilePath, const std::vector<FrameTimes>& frameTimes) noexcept {
+    const Demo::DemoHeader& header = Demo::getPlaybackHeader();
+    const size_t numFrames = frameTimes.size();
+
+    if (numFrames == 0) {
+        std::printf("Timedemo '%s': no frames were run!\n", demoFilePath);
+        return;
+    }
+
+    // Get the total and average times, and sort the frame times to get the min, max and percentiles
+    double totalTickMs = 0.0;
+    double totalDrawMs = 0.0;
+    double totalMs = 0.0;
+    std::vector<double> sortedFrameMs;
+    sortedFrameMs.reserve(numFrames);
+
+    for (const FrameTimes& times : frameTimes) {
+        totalTickMs += times.tickMs;
+        totalDrawMs += times.drawMs;
+        totalMs += times.totalMs;
+        sortedFrameMs.push_back(times.totalMs);
+    }
+
+    std::sort(sortedFrameMs.begin(), sortedFrameMs.end());
+
+    const size_t p99Idx = std::min((size_t) std::ceil((double) numFrames * 0.99), numFrames) - 1;
+    const double avgMs = totalMs / (double) numFrames;
+
+    std::printf(
+        "Timedemo '%s': map %u, skill %u, %u frames in %.3f sec (%.1f FPS)\n",
+        demoFilePath,
+        header.map,
+        header.skill,
+        (uint32_t) numFrames,
+        totalMs / 1000.0,
+        (avgMs > 0.0) ? 1000.0 / avgMs : 0.0
+    );
+
+    std::printf(
+        "Frame time (ms): min %.3f, avg %.3f, p99 %.3f, max %.3f\n",
+        sortedFrameMs.front(),
+        avgMs,
+        sortedFrameMs[p99Idx],
+        sortedFrameMs.back()
+    );
+
+    std::printf(
+        "Average tick %.3f ms, average draw %.3f ms\n",
+        totalTickMs / (double) numFrames,
+        totalDrawMs / (double) numFrames
+    );
+
+    // A desync means the workload was not the same as when the demo was recorded, so the timings can't be compared
+    if (Demo::hasDesynced()) {
+        std::printf("WARNING: the demo desynced at tick %u! Timings are not comparable with other runs.\n", Demo::getDesyncTick());
+    }
+}
+
+bool isRequested() noexcept {
+    return CommandLine::hasArg("-timedemo");
+}
+
+void run() noexcept {
+    // Load the demo and figure out how many frames at most to run ('0' means no limit)
+    const char* const demoFilePath = CommandLine::getArgValue("-timedemo");
+
+    if (!demoFilePath) {
+        FATAL_ERROR("No demo file was specified for '-timedemo'!");
+    }
+
+    if (!Demo::startPlayback(demoFilePath)) {
+        FATAL_ERROR_F("Failed to load the demo file '%s' for the timedemo!", demoFilePath);
+    }
+
+    const uint32_t maxFrames = (uint32_t) std::strtoul(CommandLine::getArgValue("-timedemoframes", "0"), nullptr, 10);
+
+    // Start up the level for the demo: this is normally done via 'RunGameLoop'
+    const Demo::DemoHeader& header = Demo::getPlaybackHeader();
+    G_InitNew((skill_e) header.skill, header.map);
+
+    gTotalGameTicks = 0;
+    P_Start();
+
+    // Simulate and draw one tick at a time as fast as possible, until the demo runs out or the level ends
+    std::vector<FrameTimes> frameTimes;
+    frameTimes.reserve(header.numTicks);
+
+    while (!Demo::isPlaybackFinished()) {
+        if ((maxFrames > 0) && (frameTimes.size() >= maxFrames))
+            break;
+
+        Profiler::beginFrame();
+        const auto frameStartTime = std::chrono::steady_clock::now();
+
+        ++gTotalGameTicks;
+        const gameaction_e gameAction = P_Ticker();
+        const auto tickEndTime = std::chrono::steady_clock::now();
+
+        {
+            PROFILE_SCOPE("Draw");
+            P_Drawer(true, false);
+        }
+
+        const auto frameEndTime = std::chrono::steady_clock::now();
+        Profiler::endFrame(Config::gPerfCounterNumFramesToAverage);
+
+        FrameTimes& times = frameTimes.emplace_back();
+        times.tickMs = getElapsedMs(frameStartTime, tickEndTime);
+        times.drawMs = getElapsedMs(tickEndTime, frameEndTime);
+        times.totalMs = getElapsedMs(frameStartTime, frameEndTime);
+
+        if (gameAction != ga_nothing)
+            break;
+    }
+
+    P_Stop();
+    printResults(demoFilePath, frameTimes);
+    Demo::stopPlayback();
+}
+
+END_NAMESPACE(TimeDemo)
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Base/Macros.h"
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Headless benchmark which plays back a recorded demo as fast as possible and reports frame time statistics.
+//
+// Usage:
+//      -timedemo <demo file> [-timedemoframes <max frames>]
+//
+// Every tick of the demo is simulated and then drawn into the offscreen framebuffer, one frame per tick with no waiting between frames.
+// No window or audio device is opened so this can be run on a build machine to catch performance regressions in the renderer and game
+// simulation. The profiler config settings still apply, so the per stage timings for every frame can also be written out to a file.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(TimeDemo)
+
+// Tells if a timedemo was requested on the command line, in which case the game should be initialized in headless mode
+bool isRequested() noexcept;
+
+// Runs the requested timedemo and prints the results to standard output
+void run() noexcept;
+
+END_NAMESPACE(TimeDemo)
@@ -2,7 +2,7 @@
 
 int main(int argc, char* argv[]) noexcept {
     @autoreleasepool {
-        D_DoomMain();
+        D_DoomMain(argc, argv);
     }
 
     return 0;
@@ -1,6 +1,6 @@
 #include "Game/DoomMain.h"
 
-int main() noexcept {
-    D_DoomMain();
+int main(int argc, char* argv[]) noexcept {
+    D_DoomMain(argc, argv);
     return 0;
 }
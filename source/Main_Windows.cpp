@@ -2,6 +2,35 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <shellapi.h>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Converts the wide character command line for the program into UTF-8 arguments
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::vector<std::string> getUtf8CommandLineArgs() noexcept {
+    std::vector<std::string> args;
+    int numArgs = 0;
+    LPWSTR* const pWideArgs = CommandLineToArgvW(GetCommandLineW(), &numArgs);
+
+    if (!pWideArgs)
+        return args;
+
+    for (int argIdx = 0; argIdx < numArgs; ++argIdx) {
+        const int utf8Size = WideCharToMultiByte(CP_UTF8, 0, pWideArgs[argIdx], -1, nullptr, 0, nullptr, nullptr);
+        std::string& arg = args.emplace_back();
+
+        if (utf8Size > 1) {
+            arg.resize((size_t) utf8Size);
+            WideCharToMultiByte(CP_UTF8, 0, pWideArgs[argIdx], -1, arg.data(), utf8Size, nullptr, nullptr);
+            arg.resize((size_t) utf8Size - 1);  // Drop the null terminator
+        }
+    }
+
+    LocalFree(pWideArgs);
+    return args;
+}
 
 int WINAPI wWinMain(
     [[maybe_unused]] HINSTANCE hInstance,
@@ -9,6 +38,13 @@ int WINAPI wWinMain(
     [[maybe_unused]] LPWSTR lpCmdLine,
     [[maybe_unused]] int nCmdShow
 ) {
-    D_DoomMain();
+    const std::vector<std::string> args = getUtf8CommandLineArgs();
+    std::vector<const char*> argv;
+
+    for (const std::string& arg : args) {
+        argv.push_back(arg.c_str());
+    }
+
+    D_DoomMain((int) argv.size(), argv.data());
     return 0;
 }
@@ -5,11 +5,11 @@
 #include "Game/Tick.h"
 #include "Map.h"
 #include "MapData.h"
+#include "MapQueryContext.h"
 #include "MapUtil.h"
 #include "Things/Info.h"
 #include "Things/Interactions.h"
 #include "Things/MapObj.h"
-#include "Things/Move.h"
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // SECTOR HEIGHT CHANGING
@@ -23,25 +23,22 @@
 // ChangeSector again to undo the changes
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-static bool gbCrushChange;      // If true, then crush bodies to blood
-static bool gbNoFit;            // Set to true if something is blocking
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Takes a valid thing and adjusts the thing->floorz, thing->ceilingz, and possibly thing->z.
 // This is called for all nearby monsters whenever a sector changes height.
 //
 // If the thing doesn't fit, the z will be set to the lowest value and false will be returned.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool ThingHeightClip(mobj_t& thing) noexcept {
+static bool ThingHeightClip(MapQueryContext& ctx, mobj_t& thing) noexcept {
     const bool bOnfloor = (thing.z == thing.floorz);    // Already on the floor?
 
     // Get the floor and ceilingz from the monsters position
-    P_CheckPosition(thing, thing.x, thing.y);
+    P_CheckPosition(ctx, thing, thing.x, thing.y);
 
     // What about stranding a monster partially off an edge?
 
-    thing.floorz = gTmpFloorZ;       // Save off the variables
-    thing.ceilingz = gTmpCeilingZ;
+    thing.floorz = ctx.tmpFloorZ;       // Save off the variables
+    thing.ceilingz = ctx.tmpCeilingZ;
 
     if (bOnfloor) {                 // Walking monsters rise and fall with the floor
         thing.z = thing.floorz;     // Pin to the floor
@@ -62,9 +59,9 @@ static bool ThingHeightClip(mobj_t& thing) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // This is called from BlockThingsIterator
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PIT_ChangeSector(mobj_t& thing) noexcept {
-    if (ThingHeightClip(thing)) {       // Too small?
-        return true;                    // Keep checking
+static bool PIT_ChangeSector(MapQueryContext& ctx, mobj_t& thing) noexcept {
+    if (ThingHeightClip(ctx, thing)) {      // Too small?
+        return true;                        // Keep checking
     }
 
     // Crunch bodies to giblets
@@ -86,9 +83,9 @@ static bool PIT_ChangeSector(mobj_t& thing) noexcept {
         return true;                            // assume it is bloody gibs or something
     }
 
-    gbNoFit = true;     // Can't fit
+    ctx.bNoFit = true;      // Can't fit
 
-    if (gbCrushChange && gbTick4) {                 // Crush it?
+    if (ctx.bCrushChange && gbTick4) {              // Crush it?
         DamageMObj(thing, nullptr, nullptr, 10);    // Take some damage
 
         // Spray blood in a random direction and have it jump out
@@ -104,9 +101,11 @@ static bool PIT_ChangeSector(mobj_t& thing) noexcept {
 // Scan all items that are on a specific block to see if it can be crushed.
 //------------------------------------------------------------------------------------------------------------------------------------------
 bool ChangeSector(sector_t& sector, bool bCrunch) noexcept {
+    MapQueryContext& ctx = gMapQueryContext;
+
     gPlayer.lastsoundsector = nullptr;      // Force next sound to reflood
-    gbNoFit = false;                        // Assume that it's ok
-    gbCrushChange = bCrunch;                // Can I crush bodies
+    ctx.bNoFit = false;                     // Assume that it's ok
+    ctx.bCrushChange = bCrunch;             // Can I crush bodies
 
     // Recheck heights for all things near the moving sector
     uint32_t x2 = sector.blockbox[BOXRIGHT];
@@ -116,9 +115,9 @@ bool ChangeSector(sector_t& sector, bool bCrunch) noexcept {
     do {
         uint32_t y = sector.blockbox[BOXBOTTOM];
         do {
-            BlockThingsIterator(x, y, PIT_ChangeSector);    // Test everything
+            BlockThingsIterator(ctx, x, y, PIT_ChangeSector);       // Test everything
         } while (++y < y2);
     } while (++x < x2);
 
-    return gbNoFit;     // Return flag
+    return ctx.bNoFit;      // Return flag
 }
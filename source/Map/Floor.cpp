@@ -38,6 +38,7 @@ result_e T_MovePlane(
     const bool bCeiling,
     const int32_t direction
 ) noexcept {
+    markSectorHeightsChanged(sector);   // Let the renderer know the plane may have moved
     Fixed lastpos;      // Previous height
 
     if (!bCeiling) {
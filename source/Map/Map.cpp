@@ -6,6 +6,7 @@
 #include "Base/Tables.h"
 #include "Game/Data.h"
 #include "MapData.h"
+#include "MapQueryContext.h"
 #include "MapUtil.h"
 #include "Sight.h"
 #include "Specials.h"
@@ -17,25 +18,6 @@
 #include "Things/Shoot.h"
 #include <algorithm>
 
-mobj_t*     gpLineTarget;
-mobj_t*     gpTmpThing;
-Fixed       gTmpX;
-Fixed       gTmpY;
-bool        gbCheckPosOnly;
-mobj_t*     gpShooter;
-angle_t     gAttackAngle;
-Fixed       gAttackRange;
-Fixed       gAimTopSlope;
-Fixed       gAimBottomSlope;
-
-static int32_t      gUseBBox[4];        // Local box for BSP traversing
-static vector_t     gUseLine;           // Temp subdivided line for targeting
-static line_t*      gpCloseLine;        // Line to target
-static Fixed        gCloseDist;         // Distance to target
-static mobj_t*      gpBombSource;       // Explosion source
-static mobj_t*      gpBombSpot;         // Explosion position
-static uint32_t     gBombDamage;        // Damage done by explosion
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Input:
 //  tmthing a mobj_t (can be valid or invalid)
@@ -49,32 +31,32 @@ static uint32_t     gBombDamage;        // Damage done by explosion
 //  tmdropoffz  the lowest point contacted (monsters won't move to a dropoff)
 //  movething   thing collision
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool P_CheckPosition(mobj_t& thing, const Fixed x, const Fixed y) noexcept {
-    gpTmpThing = &thing;        // Copy parms to globals
-    gTmpX = x;
-    gTmpY = y;
-    gbCheckPosOnly = true;      // Only check the position
-    P_TryMove2();               // See if I can move there...
-    return gbTryMove2;          // Return the result
+bool P_CheckPosition(MapQueryContext& ctx, mobj_t& thing, const Fixed x, const Fixed y) noexcept {
+    ctx.pTmpThing = &thing;         // Copy parms to the context
+    ctx.tmpX = x;
+    ctx.tmpY = y;
+    ctx.bCheckPosOnly = true;       // Only check the position
+    P_TryMove2(ctx);                // See if I can move there...
+    return ctx.bTryMove2;           // Return the result
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Try to move to a new position and trigger special events.
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool P_TryMove(mobj_t& thing, const Fixed x, const Fixed y) noexcept {
-    gpTmpThing = &thing;    // Source xy
-    gTmpX = x;              // New x,y
-    gTmpY = y;
-    P_TryMove2();           // Move to the new spot
+bool P_TryMove(MapQueryContext& ctx, mobj_t& thing, const Fixed x, const Fixed y) noexcept {
+    ctx.pTmpThing = &thing;     // Source xy
+    ctx.tmpX = x;               // New x,y
+    ctx.tmpY = y;
+    P_TryMove2(ctx);            // Move to the new spot
 
     // Pick up the specials
-    mobj_t* pLatchedMoveThing = gpMoveThing;
+    mobj_t* pLatchedMoveThing = ctx.pMoveThing;
 
     if (pLatchedMoveThing) { // Hit something?
         if ((thing.flags & MF_MISSILE) != 0) {
             // Missile bash into a monster
             const uint32_t damage = (Random::nextU32(7) + 1) * thing.InfoPtr->damage;      // Ouch!
-            DamageMObj(*pLatchedMoveThing, &thing, thing.target, damage);
+            DamageMObj(*pLatchedMoveThing, &thing, getTarget(thing), damage);
         }
         else if ((thing.flags & MF_SKULLFLY) != 0) {
             // Skull bash into a monster
@@ -89,19 +71,19 @@ bool P_TryMove(mobj_t& thing, const Fixed x, const Fixed y) noexcept {
         }
     }
 
-    return gbTryMove2;
+    return ctx.bTryMove2;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Routine used by BlockLinesIterator to check for line collision.
 // I always return TRUE to check ALL lines.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PIT_UseLines(line_t& li) noexcept {
+static bool PIT_UseLines(MapQueryContext& ctx, line_t& li) noexcept {
     // Check bounding box first
-    if ((gUseBBox[BOXRIGHT] <= li.bbox[BOXLEFT]) ||  // Within the bounding box?
-        (gUseBBox[BOXLEFT] >= li.bbox[BOXRIGHT]) ||
-        (gUseBBox[BOXTOP] <= li.bbox[BOXBOTTOM]) ||
-        (gUseBBox[BOXBOTTOM] >= li.bbox[BOXTOP])
+    if ((ctx.useBBox[BOXRIGHT] <= li.bbox[BOXLEFT]) ||      // Within the bounding box?
+        (ctx.useBBox[BOXLEFT] >= li.bbox[BOXRIGHT]) ||
+        (ctx.useBBox[BOXTOP] <= li.bbox[BOXBOTTOM]) ||
+        (ctx.useBBox[BOXBOTTOM] >= li.bbox[BOXTOP])
     ) {
         return true;    // Nope, they don't collide
     }
@@ -109,8 +91,8 @@ static bool PIT_UseLines(line_t& li) noexcept {
     // Find distance along usetrace
     vector_t dl;
     MakeVector(li, dl);                                     // Convert true line to a divline struct
-    const Fixed frac = InterceptVector(gUseLine, dl);       // How much do they intercept
-    if ((frac < 0) || (frac > gCloseDist)) {                // Behind source or too far away?
+    const Fixed frac = InterceptVector(ctx.useLine, dl);    // How much do they intercept
+    if ((frac < 0) || (frac > ctx.closeDist)) {             // Behind source or too far away?
         return true;                                        // No collision
     }
 
@@ -121,72 +103,72 @@ static bool PIT_UseLines(line_t& li) noexcept {
         }
     }
 
-    gpCloseLine = &li;      // This is the line of travel
-    gCloseDist = frac;      // This is the length of the line
-    return true;            // Can't use for than one special line in a row
+    ctx.pCloseLine = &li;       // This is the line of travel
+    ctx.closeDist = frac;       // This is the length of the line
+    return true;                // Can't use for than one special line in a row
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Looks for special lines in front of the player to activate.
 // Used when the player presses "Use" to open a door or such.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void P_UseLines(player_t& player) noexcept {
+void P_UseLines(MapQueryContext& ctx, player_t& player) noexcept {
     const uint32_t angle = player.mo->angle >> ANGLETOFINESHIFT;
     const Fixed x1 = player.mo->x;                                          // Get the source x,y
     const Fixed y1 = player.mo->y;
     const Fixed x2 = x1 + (USERANGE >> FRACBITS) * gFineCosine[angle];      // Get the dest X,Y
     const Fixed y2 = y1 + (USERANGE >> FRACBITS) * gFineSine[angle];
 
-    gUseLine.x = x1;            // Create the useline record
-    gUseLine.y = y1;
-    gUseLine.dx = x2 - x1;      // Delta x and y
-    gUseLine.dy = y2 - y1;
+    ctx.useLine.x = x1;             // Create the useline record
+    ctx.useLine.y = y1;
+    ctx.useLine.dx = x2 - x1;       // Delta x and y
+    ctx.useLine.dy = y2 - y1;
 
-    if (gUseLine.dx >= 0) {
-        gUseBBox[BOXRIGHT] = x2;    // Create the bounding box
-        gUseBBox[BOXLEFT] = x1;
+    if (ctx.useLine.dx >= 0) {
+        ctx.useBBox[BOXRIGHT] = x2;     // Create the bounding box
+        ctx.useBBox[BOXLEFT] = x1;
     } else {
-        gUseBBox[BOXRIGHT] = x1;
-        gUseBBox[BOXLEFT] = x2;
+        ctx.useBBox[BOXRIGHT] = x1;
+        ctx.useBBox[BOXLEFT] = x2;
     }
 
-    if (gUseLine.dy >= 0) {         // Create the bounding box
-        gUseBBox[BOXTOP] = y2;
-        gUseBBox[BOXBOTTOM] = y1;
+    if (ctx.useLine.dy >= 0) {      // Create the bounding box
+        ctx.useBBox[BOXTOP] = y2;
+        ctx.useBBox[BOXBOTTOM] = y1;
     } else {
-        gUseBBox[BOXTOP] = y1;
-        gUseBBox[BOXBOTTOM] = y2;
+        ctx.useBBox[BOXTOP] = y1;
+        ctx.useBBox[BOXBOTTOM] = y2;
     }
 
-    int32_t yh = (gUseBBox[BOXTOP] - gBlockMapOriginY) >> MAPBLOCKSHIFT;        // Bounding box
-    int32_t yl = (gUseBBox[BOXBOTTOM] - gBlockMapOriginY) >> MAPBLOCKSHIFT;
-    int32_t xh = (gUseBBox[BOXRIGHT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
-    int32_t xl = (gUseBBox[BOXLEFT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
+    int32_t yh = (ctx.useBBox[BOXTOP] - gBlockMapOriginY) >> MAPBLOCKSHIFT;     // Bounding box
+    int32_t yl = (ctx.useBBox[BOXBOTTOM] - gBlockMapOriginY) >> MAPBLOCKSHIFT;
+    int32_t xh = (ctx.useBBox[BOXRIGHT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
+    int32_t xl = (ctx.useBBox[BOXLEFT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
     ++xh;   // For < compare later
     ++yh;
     
     xl = std::max(xl, 0);
     yl = std::max(yl, 0);
     
-    gpCloseLine = nullptr;      // No line found
-    gCloseDist = FRACUNIT;      // 1.0 units distance
-    ++gValidCount;              // Make unique sector mark
+    ctx.pCloseLine = nullptr;       // No line found
+    ctx.closeDist = FRACUNIT;       // 1.0 units distance
+    ctx.beginVisits();              // Make unique line marks
 
     // Check the lines
     if (xh >= 0 && yh >= 0) {
         for (uint32_t y = (uint32_t) yl; y < (uint32_t) yh; ++y) {
             for (uint32_t x = (uint32_t) xl; x < (uint32_t) xh; ++x) {
-                BlockLinesIterator(x, y, PIT_UseLines);
+                BlockLinesIterator(ctx, x, y, PIT_UseLines);
             }
         }
     }
 
     // Check closest line
-    if (gpCloseLine) {                                      // Line nearby?
-        if (gpCloseLine->special <= 0) {                    // Is it special?
-            S_StartSound(&player.mo->x, sfx_noway);         // Make the grunt sound
+    if (ctx.pCloseLine) {                                       // Line nearby?
+        if (ctx.pCloseLine->special <= 0) {                     // Is it special?
+            S_StartSound(&player.mo->x, sfx_noway);             // Make the grunt sound
         } else {
-            P_UseSpecialLine(*player.mo, *gpCloseLine);     // Activate the special
+            P_UseSpecialLine(*player.mo, *ctx.pCloseLine);      // Activate the special
         }
     }
 }
@@ -196,16 +178,16 @@ void P_UseLines(player_t& player) noexcept {
 // Source is the creature that caused the explosion at spot.
 // Always returns TRUE to check ALL lines
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PIT_RadiusAttack(mobj_t& thing) noexcept {
-    ASSERT(gpBombSpot);
+static bool PIT_RadiusAttack(MapQueryContext& ctx, mobj_t& thing) noexcept {
+    ASSERT(ctx.pBombSpot);
 
     if ((thing.flags & MF_SHOOTABLE) == 0) {    // Can this item be hit?
         return true;                            // Next thing...
     }
 
-    const Fixed dx = std::abs(thing.x - gpBombSpot->x);     // Absolute distance from BOOM
-    const Fixed dy = std::abs(thing.y - gpBombSpot->y);
-    Fixed dist = (dx >= dy) ? dx : dy;                      // Get the greater of the two
+    const Fixed dx = std::abs(thing.x - ctx.pBombSpot->x);      // Absolute distance from BOOM
+    const Fixed dy = std::abs(thing.y - ctx.pBombSpot->y);
+    Fixed dist = (dx >= dy) ? dx : dy;                          // Get the greater of the two
     dist = (dist - thing.radius) >> FRACBITS;
 
     if (dist < 0) {     // Within the blast?
@@ -213,11 +195,11 @@ static bool PIT_RadiusAttack(mobj_t& thing) noexcept {
     }
 
     // Is the blast within range?
-    if (dist < (int32_t) gBombDamage) {
+    if (dist < (int32_t) ctx.bombDamage) {
         // DC: Bugfix to the original 3DO Doom: check for line of sight before applying damage.
         // In the original 3DO Doom you could damage stuff through walls with rockets! (wasn't like that in PC Doom)
-        if (CheckSight(thing, *gpBombSpot, false)) {
-            DamageMObj(thing, gpBombSpot, gpBombSource, gBombDamage - (uint32_t) dist);
+        if (CheckSight(thing, *ctx.pBombSpot, false, nullptr)) {
+            DamageMObj(thing, ctx.pBombSpot, ctx.pBombSource, ctx.bombDamage - (uint32_t) dist);
         }
     }
 
@@ -228,7 +210,7 @@ static bool PIT_RadiusAttack(mobj_t& thing) noexcept {
 // Inflict damage to all items within blast range.
 // Source is the creature that casued the explosion at spot.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void RadiusAttack(mobj_t& spot, mobj_t* source, const uint32_t damage) noexcept {
+void RadiusAttack(MapQueryContext& ctx, mobj_t& spot, mobj_t* source, const uint32_t damage) noexcept {
     const Fixed dist = intToFixed16((int32_t) damage);
 
     int32_t yh = (spot.y + dist - gBlockMapOriginY) >> MAPBLOCKSHIFT;
@@ -238,9 +220,9 @@ void RadiusAttack(mobj_t& spot, mobj_t* source, const uint32_t damage) noexcept
     ++xh;
     ++yh;
     
-    gpBombSpot = &spot;         // Copy to globals so PIT_Radius can see it
-    gpBombSource = source;
-    gBombDamage = damage;
+    ctx.pBombSpot = &spot;      // Copy to the context so PIT_Radius can see it
+    ctx.pBombSource = source;
+    ctx.bombDamage = damage;
 
     // Damage all things in collision range
     xl = std::max(xl, 0);
@@ -249,7 +231,7 @@ void RadiusAttack(mobj_t& spot, mobj_t* source, const uint32_t damage) noexcept
     if (yh >= 0 && xh >= 0) {
         for (uint32_t y = (uint32_t) yl; y < (uint32_t) yh; ++y) {
             for (uint32_t x = (uint32_t) xl; x < (uint32_t) xh; ++x) {
-                BlockThingsIterator(x, y, PIT_RadiusAttack);
+                BlockThingsIterator(ctx, x, y, PIT_RadiusAttack);
             }
         }
     }
@@ -261,19 +243,17 @@ void RadiusAttack(mobj_t& spot, mobj_t* source, const uint32_t damage) noexcept
 // mobj is within the visible aimtopslope / aimbottomslope range, or a solid wall blocks further tracing.
 // If no thing is targeted along the entire range, the first line that blocks the midpoint of the trace will be hit.
 //------------------------------------------------------------------------------------------------------------------------------------------
-Fixed AimLineAttack(mobj_t& t1, const angle_t angle, const Fixed distance) noexcept {
-    gpShooter = &t1;
-    gAttackRange = distance;
-    gAttackAngle = angle;
-    gAimTopSlope = 100 * FRACUNIT / 160;    // Can't shoot outside view angles
-    gAimBottomSlope = -100 * FRACUNIT / 160;
-    ++gValidCount;
-
-    Shoot::P_Shoot2();                      // Call other code
-    gpLineTarget = Shoot::gpShootMObj;
-
-    if (gpLineTarget) {                     // Was there a valid hit?
-        return Shoot::gShootSlope;          // Return the slope of target
+Fixed AimLineAttack(MapQueryContext& ctx, mobj_t& t1, const angle_t angle, const Fixed distance) noexcept {
+    ctx.pShooter = &t1;
+    ctx.attackRange = distance;
+    ctx.attackAngle = angle;
+    ctx.aimTopSlope = 100 * FRACUNIT / 160;    // Can't shoot outside view angles
+    ctx.aimBottomSlope = -100 * FRACUNIT / 160;
+    Shoot::P_Shoot2(ctx);                      // Call other code
+    ctx.pLineTarget = ctx.pShootMObj;
+
+    if (ctx.pLineTarget) {                     // Was there a valid hit?
+        return ctx.shootSlope;                 // Return the slope of target
     }
 
     return 0;   // No target
@@ -285,42 +265,42 @@ Fixed AimLineAttack(mobj_t& t1, const angle_t angle, const Fixed distance) noexc
 // If slope == FIXED_MAX, use screen bounds for attacking.
 //------------------------------------------------------------------------------------------------------------------------------------------
 void LineAttack(
+    MapQueryContext& ctx,
     mobj_t& t1,
     const angle_t angle,
     const Fixed distance,
     const Fixed slope,
     const uint32_t damage
 ) noexcept {
-    gpShooter = &t1;
-    gAttackRange = distance;
-    gAttackAngle = angle;
+    ctx.pShooter = &t1;
+    ctx.attackRange = distance;
+    ctx.attackAngle = angle;
 
     if (slope == FRACMAX) {
-        gAimTopSlope = 100 * FRACUNIT / 160;        // Can't shoot outside view angles
-        gAimBottomSlope = -100 * FRACUNIT / 160;
+        ctx.aimTopSlope = 100 * FRACUNIT / 160;     // Can't shoot outside view angles
+        ctx.aimBottomSlope = -100 * FRACUNIT / 160;
     } else {
-        gAimTopSlope = slope + 1;
-        gAimBottomSlope = slope - 1;
+        ctx.aimTopSlope = slope + 1;
+        ctx.aimBottomSlope = slope - 1;
     }
 
-    ++gValidCount;
-    Shoot::P_Shoot2();                      // Perform the calculations
-    gpLineTarget = Shoot::gpShootMObj;      // Get the result
+    Shoot::P_Shoot2(ctx);                          // Perform the calculations
+    ctx.pLineTarget = ctx.pShootMObj;              // Get the result
 
-    const Fixed shootx2 = Shoot::gShootX;
-    const Fixed shooty2 = Shoot::gShootY;
-    const Fixed shootz2 = Shoot::gShootZ;
-    line_t* const pShootline2 = Shoot::gpShootLine;
+    const Fixed shootx2 = ctx.shootX;
+    const Fixed shooty2 = ctx.shootY;
+    const Fixed shootz2 = ctx.shootZ;
+    line_t* const pShootline2 = ctx.pShootLine;
 
     // Shooting things: did we hit a thing?
-    if (gpLineTarget) {
-        if (gpLineTarget->flags & MF_NOBLOOD) {
-            P_SpawnPuff(shootx2, shooty2, shootz2);             // Make a spark on the target
+    if (ctx.pLineTarget) {
+        if (ctx.pLineTarget->flags & MF_NOBLOOD) {
+            P_SpawnPuff(shootx2, shooty2, shootz2, ctx.attackRange);    // Make a spark on the target
         } else {
-            P_SpawnBlood(shootx2, shooty2, shootz2, damage);    // Squirt some blood!
+            P_SpawnBlood(shootx2, shooty2, shootz2, damage);            // Squirt some blood!
         }
 
-        DamageMObj(*gpLineTarget, &t1, &t1, damage);    // Do the damage
+        DamageMObj(*ctx.pLineTarget, &t1, &t1, damage);     // Do the damage
         return;
     }
 
@@ -340,6 +320,6 @@ void LineAttack(
             }
         }
 
-        P_SpawnPuff(shootx2, shooty2, shootz2);     // Make a puff of smoke
+        P_SpawnPuff(shootx2, shooty2, shootz2, ctx.attackRange);    // Make a puff of smoke
     }
 }
@@ -70,6 +70,9 @@ static std::vector<line_t>          gLines;
 static std::vector<seg_t>           gLineSegs;
 static std::vector<subsector_t>     gSubSectors;
 static std::vector<node_t>          gNodes;
+static std::vector<vector_t>        gBspLines;
+static std::vector<uint32_t>        gBspChildren;
+static std::vector<BspBBoxF>        gBspChildBBoxes;
 static uint32_t                     gLoadedRejectMatrixResourceNum;
 static std::vector<line_t*>         gBlockMapLines;
 static std::vector<line_t**>        gBlockMapLineLists;
@@ -125,6 +128,7 @@ static void loadSectors(const uint32_t lumpResourceNum) noexcept {
         pDstSector->lightlevel = Endian::bigToHost(pSrcSector->lightLevel);
         pDstSector->special = Endian::bigToHost(pSrcSector->special);
         pDstSector->tag  = Endian::bigToHost(pSrcSector->tag);
+        markSectorHeightsChanged(*pDstSector);
 
         ++pSrcSector;
         ++pDstSector;
@@ -360,6 +364,41 @@ static void loadSubSectors(const uint32_t lumpResourceNum) noexcept {
     Resources::free(lumpResourceNum);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes sure the flattened BSP tree is no deeper than the fixed size stacks used to traverse it.
+// Also guards against malformed node data that contains cycles, which would otherwise hang traversal.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void verifyBspTreeDepth() noexcept {
+    struct StackEntry {
+        uint32_t    nodeIdx;
+        uint32_t    depth;
+    };
+
+    if ((gBspRootChild & BSP_CHILD_SUBSECTOR) != 0)
+        return;
+
+    std::vector<StackEntry> stack;
+    stack.push_back({ gBspRootChild, 1 });
+
+    while (!stack.empty()) {
+        const StackEntry entry = stack.back();
+        stack.pop_back();
+
+        if (entry.depth > BSP_MAX_DEPTH) {
+            FATAL_ERROR_F("The BSP tree for the map is too deep! The maximum supported depth is %u.", BSP_MAX_DEPTH);
+        }
+
+        for (uint32_t side = 0; side < 2; ++side) {
+            const uint32_t child = gBspChildren[entry.nodeIdx * 2 + side];
+
+            if ((child & BSP_CHILD_SUBSECTOR) == 0) {
+                ASSERT(child < gNumBspNodes);
+                stack.push_back({ child, entry.depth + 1 });
+            }
+        }
+    }
+}
+
 static void loadNodes(const uint32_t lumpResourceNum) noexcept {
     // Load the nodes resource
     ASSERT_LOG(gSubSectors.size() > 0, "Sub sectors must be loaded first!");
@@ -375,8 +414,15 @@ static void loadNodes(const uint32_t lumpResourceNum) noexcept {
 
     gNodes.clear();
     gNodes.resize(numNodes);
+    gBspLines.clear();
+    gBspLines.resize(numNodes);
+    gBspChildren.clear();
+    gBspChildren.resize((size_t) numNodes * 2);
+    gBspChildBBoxes.clear();
+    gBspChildBBoxes.resize((size_t) numNodes * 2);
 
     node_t* pDstNode = gNodes.data();
+    uint32_t nodeIdx = 0;
 
     while (pSrcNode < pEndSrcNode) {
         pDstNode->Line.x = Endian::bigToHost(pSrcNode->x);
@@ -404,19 +450,37 @@ static void loadNodes(const uint32_t lumpResourceNum) noexcept {
                 std::byte* pChildPtr = (std::byte*) &gSubSectors[subSectorIdx];
                 pChildPtr += 1;
                 pDstNode->Children[childNum] = pChildPtr;
+                gBspChildren[nodeIdx * 2 + childNum] = subSectorIdx | BSP_CHILD_SUBSECTOR;
             }
             else {
                 // Child is another node
                 pDstNode->Children[childNum] = &gNodes[childNodeOrSubSecIdx];
+                gBspChildren[nodeIdx * 2 + childNum] = childNodeOrSubSecIdx;
+            }
+
+            // Save the bounding box in float format for the flattened tree
+            BspBBoxF& bboxF = gBspChildBBoxes[nodeIdx * 2 + childNum];
+
+            for (uint32_t coordIdx = 0; coordIdx < BOXCOUNT; ++coordIdx) {
+                bboxF.coords[coordIdx] = fixed16ToFloat(pDstNode->bbox[childNum][coordIdx]);
             }
         }
 
+        gBspLines[nodeIdx] = pDstNode->Line;
+
         ++pSrcNode;
         ++pDstNode;
+        ++nodeIdx;
     }
 
     // The last node in the nodes array is the root of the BSP tree
     gpBSPTreeRoot = &gNodes.back();
+    gpBspLines = gBspLines.data();
+    gpBspChildren = gBspChildren.data();
+    gpBspChildBBoxes = gBspChildBBoxes.data();
+    gNumBspNodes = numNodes;
+    gBspRootChild = (numNodes > 0) ? numNodes - 1 : BSP_CHILD_SUBSECTOR;   // A map with no nodes is a single subsector
+    verifyBspTreeDepth();
 
     // Don't need this anymore
     Resources::free(lumpResourceNum);
@@ -535,6 +599,11 @@ uint32_t            gNumLineSegs;
 const subsector_t*  gpSubSectors;
 uint32_t            gNumSubSectors;
 node_t*             gpBSPTreeRoot;
+const vector_t*     gpBspLines;
+const uint32_t*     gpBspChildren;
+const BspBBoxF*     gpBspChildBBoxes;
+uint32_t            gNumBspNodes;
+uint32_t            gBspRootChild;
 const uint8_t*      gpRejectMatrix;
 line_t***           gpBlockMapLineLists;
 mobj_t**            gpBlockMapThingLists;
@@ -542,6 +611,7 @@ uint32_t            gBlockMapWidth;
 uint32_t            gBlockMapHeight;
 Fixed               gBlockMapOriginX;
 Fixed               gBlockMapOriginY;
+uint32_t            gLastSectorHeightsVersion;
 
 void mapDataInit(const uint32_t mapNum) {
     // Load all the map data.
@@ -590,6 +660,15 @@ void mapDataShutdown() {
     gNodes.clear();
     gpBSPTreeRoot = nullptr;
 
+    gBspLines.clear();
+    gBspChildren.clear();
+    gBspChildBBoxes.clear();
+    gpBspLines = nullptr;
+    gpBspChildren = nullptr;
+    gpBspChildBBoxes = nullptr;
+    gNumBspNodes = 0;
+    gBspRootChild = 0;
+
     if (gLoadedRejectMatrixResourceNum > 0) {
         Resources::free(gLoadedRejectMatrixResourceNum);
         gLoadedRejectMatrixResourceNum = 0;
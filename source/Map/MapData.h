@@ -3,6 +3,7 @@
 #include "Base/Angle.h"
 #include "Base/Macros.h"
 #include "Game/DoomDefines.h"
+#include "Things/MObjTable.h"
 
 struct line_t;
 struct mobj_t;
@@ -39,7 +40,7 @@ struct sector_t {
     uint32_t    special;                // Special event number
     uint32_t    tag;                    // Event tag
     uint32_t    soundtraversed;         // 0 = untraversed, 1,2 = sndlines -1
-    mobj_t*     soundtarget;            // thing that made a sound (or null)
+    MObjHandle  soundtarget;            // thing that made a sound (or null)
     uint32_t    blockbox[BOXCOUNT];     // mapblock bounding box for height changes
     Fixed       SoundX;                 // For any sounds played by the sector
     Fixed       SoundY;                 // For any sounds played by the sector
@@ -48,6 +49,7 @@ struct sector_t {
     void*       specialdata;            // Thinker struct for reversable actions
     uint32_t    linecount;              // Number of lines in polygon
     line_t**    lines;                  // [linecount] size
+    uint32_t    heightsVersion;         // Changed whenever the floor or ceiling is moved: used to invalidate cached render data
 };
 
 // Data for a line side
@@ -93,7 +95,6 @@ struct line_t {
     float       v1DrawDepth;            // Depth of v1 and v2 when drawn
     float       v2DrawDepth;
     uint8_t     drawnSideIndex;         // Which side of the line is being rendered
-    bool        bIsInFrontOfSprite;     // Used during sprite clipping: stores if the line is considered in front of the sprite
 };
 
 // Flags that can be applied to a line
@@ -165,6 +166,24 @@ inline void* getActualBspNodePtr(void* const pPtr) {
     return (void*)(((uintptr_t) pPtr) & mask);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A flattened copy of the BSP tree which is built at load time, for faster traversal by the renderer and sight checks.
+// Nodes are referred to by index and their fields are split into separate arrays, so that each traversal only pulls what it actually
+// needs into the cache. For node 'i' the children and child bounding boxes are at index 'i * 2 + side', where side '0' is the front.
+// The partition lines are kept in fixed point, so that side checks give exactly the same results as the 'node_t' version of the tree.
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+// If this bit is set on a BSP child then the rest of the value is a subsector index, otherwise it's a node index
+static constexpr uint32_t BSP_CHILD_SUBSECTOR = 0x80000000u;
+
+// Maximum supported depth of the BSP tree: allows traversals to use a fixed size stack instead of recursion
+static constexpr uint32_t BSP_MAX_DEPTH = 256;
+
+// Bounding box for a BSP node child, pre-converted to float
+struct BspBBoxF {
+    float   coords[BOXCOUNT];
+};
+
 // Pointers to global map data for ease of access
 extern const vertex_t*      gpVertexes;
 extern uint32_t             gNumVertexes;
@@ -179,6 +198,11 @@ extern uint32_t             gNumLineSegs;
 extern const subsector_t*   gpSubSectors;
 extern uint32_t             gNumSubSectors;
 extern node_t*              gpBSPTreeRoot;
+extern const vector_t*      gpBspLines;             // Flattened BSP tree: partition line for each node
+extern const uint32_t*      gpBspChildren;          // Flattened BSP tree: 2 children per node (front, back)
+extern const BspBBoxF*      gpBspChildBBoxes;       // Flattened BSP tree: 2 child bounding boxes per node (front, back)
+extern uint32_t             gNumBspNodes;
+extern uint32_t             gBspRootChild;          // Root of the flattened BSP tree, in the same format as a node child
 extern const uint8_t*       gpRejectMatrix;         // For fast sight rejection
 extern line_t***            gpBlockMapLineLists;    // For each blockmap entry, a pointer to a list of line pointers (all lines in the block)
 extern mobj_t**             gpBlockMapThingLists;   // For each blockmap entry, a pointer to the first thing in a linked list of things (all things in the block)
@@ -187,6 +211,16 @@ extern uint32_t             gBlockMapHeight;
 extern Fixed                gBlockMapOriginX;
 extern Fixed                gBlockMapOriginY;
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Marks the floor and/or ceiling height of a sector as changed, so that any render data cached for the sector is recalculated.
+// Versions come from a global counter which is never reset, so data cached for a previous map can never match a sector in a new one.
+//------------------------------------------------------------------------------------------------------------------------------------------
+extern uint32_t gLastSectorHeightsVersion;
+
+inline void markSectorHeightsChanged(sector_t& sector) noexcept {
+    sector.heightsVersion = ++gLastSectorHeightsVersion;
+}
+
 // Load all map data for the specified map and release it
 void mapDataInit(const uint32_t mapNum);
 void mapDataShutdown();
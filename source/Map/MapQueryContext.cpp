@@ -0,0 +1,60 @@
+#include "MapQueryContext.h"
+
+MapQueryContext gMapQueryContext;
+
+VisitSet::VisitSet() noexcept
+    : mBits()
+    , mDirtyWordIdxs()
+    , mNumElems(0)
+{
+}
+
+void VisitSet::init(const uint32_t numElems) noexcept {
+    const uint32_t numWords = (numElems + 63) / 64;
+
+    mBits.clear();
+    mBits.resize(numWords, 0);
+    mDirtyWordIdxs.clear();
+    mDirtyWordIdxs.reserve(numWords);
+    mNumElems = numElems;
+}
+
+void VisitSet::shutdown() noexcept {
+    mBits.clear();
+    mBits.shrink_to_fit();
+    mDirtyWordIdxs.clear();
+    mDirtyWordIdxs.shrink_to_fit();
+    mNumElems = 0;
+}
+
+void VisitSet::clear() noexcept {
+    uint64_t* const pBits = mBits.data();
+
+    for (const uint32_t wordIdx : mDirtyWordIdxs) {
+        pBits[wordIdx] = 0;
+    }
+
+    mDirtyWordIdxs.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sizes the visit sets for the map which has just been loaded
+//------------------------------------------------------------------------------------------------------------------------------------------
+void MapQueryContext::init() noexcept {
+    visitedLines.init(gNumLines);
+    visitedSectors.init(gNumSectors);
+    intercepts.clear();
+    intercepts.reserve(64);
+}
+
+void MapQueryContext::shutdown() noexcept {
+    visitedLines.shutdown();
+    visitedSectors.shutdown();
+    intercepts.clear();
+    intercepts.shrink_to_fit();
+}
+
+void MapQueryContext::beginVisits() noexcept {
+    visitedLines.clear();
+    visitedSectors.clear();
+}
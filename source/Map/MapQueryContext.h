@@ -0,0 +1,177 @@
+#pragma once
+
+#include "Base/Angle.h"
+#include "Base/Fixed.h"
+#include "Base/Macros.h"
+#include "MapData.h"
+#include <cstdint>
+#include <vector>
+
+struct mobj_t;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A set of map elements (lines or sectors, by index) which have been visited by a query.
+//
+// This replaces stamping 'gValidCount' into the elements themselves, which meant only one query could be in progress at a time.
+// Clearing the set only touches the words of the bitset which had something marked in them, so clearing after visiting just a few
+// elements is cheap, even on big maps.
+//------------------------------------------------------------------------------------------------------------------------------------------
+class VisitSet {
+public:
+    VisitSet() noexcept;
+
+    void init(const uint32_t numElems) noexcept;
+    void shutdown() noexcept;
+    void clear() noexcept;
+
+    // Marks the element as visited and returns 'true' if it was ALREADY visited
+    inline bool testAndMark(const uint32_t elemIdx) noexcept {
+        ASSERT(elemIdx < mNumElems);
+        uint64_t& word = mBits[elemIdx >> 6];
+        const uint64_t bit = (uint64_t) 1 << (elemIdx & 63);
+
+        if (word & bit)
+            return true;
+
+        if (word == 0) {
+            mDirtyWordIdxs.push_back(elemIdx >> 6);     // Note: never reallocates, since enough room for every word was reserved
+        }
+
+        word |= bit;
+        return false;
+    }
+
+private:
+    std::vector<uint64_t>   mBits;              // 1 bit per element: set if visited
+    std::vector<uint32_t>   mDirtyWordIdxs;     // Which words in the bitset have bits set, so need clearing
+    uint32_t                mNumElems;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A possible hit for a line attack, with a line or a thing.
+// Sorts by the fraction along the line of fire, so that the closest hit can be processed first.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Intercept {
+    Fixed   frac;
+    void*   pObj;
+    bool    bIsLine;
+
+    inline bool operator < (const Intercept& other) const noexcept {
+        return (frac < other.frac);
+    }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Holds all of the inputs, outputs and scratch state for queries against the map: checking and moving to positions, using lines, radius
+// and line attacks and changing sector heights. These used to be file level globals shared by all queries.
+//
+// Queries take the context to use and only touch the state in that context, so separate contexts could be used to run queries on
+// several threads at once. The game simulation itself currently runs on the main thread using 'gMapQueryContext'.
+//
+// Notes:
+//  (1) Where a query used to bump 'gValidCount' it now clears the visit sets of its context instead. A query started in the middle of
+//      another one using the same context (e.g. checking the position of something while crushing things) therefore affects the outer
+//      one in exactly the same way as before, which matters for demo compatibility.
+//  (2) Things which need the current map (the visit sets) must be (re)initialized with 'init' after each map is loaded.
+//  (3) A new context should be value initialized (e.g. 'MapQueryContext ctx = {};') so that it starts off zeroed, like the globals
+//      it replaces.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct MapQueryContext {
+    // Which lines and sectors the current query has visited
+    VisitSet        visitedLines;
+    VisitSet        visitedSectors;
+
+    // Inputs and outputs for 'P_CheckPosition' and 'P_TryMove'
+    mobj_t*         pTmpThing;          // mobj_t to be checked
+    Fixed           tmpX;               // Temp x,y for a position to be checked
+    Fixed           tmpY;
+    bool            bCheckPosOnly;      // If true, just check the position, no actions
+    bool            bTryMove2;          // Result from P_TryMove2
+    bool            bFloatOk;           // If true, move would be ok if within tmfloorz - tmceilingz
+    Fixed           tmpFloorZ;          // Current floor z for P_TryMove2
+    Fixed           tmpCeilingZ;        // Current ceiling z for P_TryMove2
+    mobj_t*         pMoveThing;         // Either a skull/missile target or a special pickup
+    line_t*         pBlockLine;         // Might be a door that can be opened
+
+    // Scratch state for 'P_TryMove2' and 'PM_CheckPosition'
+    Fixed           oldX;
+    Fixed           oldY;
+    Fixed           tmpBBox[4];
+    uint32_t        tmpFlags;
+    Fixed           tmpDropoffZ;        // Lowest point contacted
+    subsector_t*    pNewSubSec;         // Dest subsector
+
+    // Inputs, outputs and scratch state for moving critters under momentum ('PB_TryMove' and 'PB_CheckPosition')
+    mobj_t*         pCheckThingMo;      // Used for PB_CheckThing
+    Fixed           testX;
+    Fixed           testY;
+    Fixed           testFloorZ;
+    Fixed           testCeilingZ;
+    Fixed           testDropoffZ;
+    subsector_t*    pTestSubSec;
+    line_t*         pCeilingLine;
+    mobj_t*         pHitThing;
+    Fixed           testBBox[4];        // Bounding box for tests
+    uint32_t        testFlags;
+
+    // Scratch state for 'P_UseLines'
+    int32_t         useBBox[4];         // Local box for BSP traversing
+    vector_t        useLine;            // Temp subdivided line for targeting
+    line_t*         pCloseLine;         // Line to target
+    Fixed           closeDist;          // Distance to target
+
+    // Inputs for 'RadiusAttack'
+    mobj_t*         pBombSource;        // Explosion source
+    mobj_t*         pBombSpot;          // Explosion position
+    uint32_t        bombDamage;         // Damage done by explosion
+
+    // Inputs for 'ChangeSector'
+    bool            bCrushChange;       // If true, then crush bodies to blood
+    bool            bNoFit;             // Set to true if something is blocking
+
+    // Inputs and outputs for 'AimLineAttack' and 'LineAttack'
+    mobj_t*         pLineTarget;        // Object that was targeted
+    mobj_t*         pShooter;           // Source of a direct line shot
+    angle_t         attackAngle;        // Angle to target
+    Fixed           attackRange;        // Range to target
+    Fixed           aimTopSlope;        // Range of slope to target weapon
+    Fixed           aimBottomSlope;
+
+    // Outputs from 'Shoot::P_Shoot2'
+    line_t*         pShootLine;
+    mobj_t*         pShootMObj;
+    Fixed           shootSlope;         // Between aimtop and aimbottom
+    Fixed           shootX;             // Location for puff/blood
+    Fixed           shootY;
+    Fixed           shootZ;
+
+    // Scratch state for 'Shoot::P_Shoot2'
+    std::vector<Intercept>  intercepts;
+    Fixed                   aimMidSlope;            // For detecting first wall hit
+    vector_t                shootDiv;
+    Fixed                   shootX2;
+    Fixed                   shootY2;
+    Fixed                   firstLineFrac;
+    bool                    bShootDivPositive;
+    int32_t                 ssx1;
+    int32_t                 ssy1;
+    int32_t                 ssx2;
+    int32_t                 ssy2;
+
+    void init() noexcept;
+    void shutdown() noexcept;
+
+    // Starts a new query which needs to know which lines and sectors it has visited (what used to be '++gValidCount')
+    void beginVisits() noexcept;
+
+    inline bool testAndMarkLine(const line_t& line) noexcept {
+        return visitedLines.testAndMark((uint32_t)(&line - gpLines));
+    }
+
+    inline bool testAndMarkSector(const sector_t& sector) noexcept {
+        return visitedSectors.testAndMark((uint32_t)(&sector - gpSectors));
+    }
+};
+
+// The context used for all map queries done by the game simulation on the main thread
+extern MapQueryContext gMapQueryContext;
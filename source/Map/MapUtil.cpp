@@ -3,6 +3,7 @@
 #include "Base/Tables.h"
 #include "Game/Data.h"
 #include "MapData.h"
+#include "MapQueryContext.h"
 #include "Things/MapObj.h"
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -329,10 +330,10 @@ void SetThingPosition(mobj_t& thing) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// The validcount flags are used to avoid checking lines that are marked in multiple mapblocks,
-// so increment validcount before the first call to BlockLinesIterator, then make one or more calls to it.
+// The visited lines of the context are used to avoid checking lines that are marked in multiple mapblocks,
+// so call 'beginVisits' on the context before the first call to BlockLinesIterator, then make one or more calls to it.
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool BlockLinesIterator(const uint32_t x, const uint32_t y, const BlockLinesIterCallback func) noexcept {
+bool BlockLinesIterator(MapQueryContext& ctx, const uint32_t x, const uint32_t y, const BlockLinesIterCallback func) noexcept {
     if (x < gBlockMapWidth && y < gBlockMapHeight) {            // On the map?
         const uint32_t blockIdx = y * gBlockMapWidth + x;
         line_t** ppLineList = gpBlockMapLineLists[blockIdx];    // Get the first line pointer
@@ -343,10 +344,9 @@ bool BlockLinesIterator(const uint32_t x, const uint32_t y, const BlockLinesIter
                 break;                          // Get out of the loop
             }
 
-            if (pLine->validCount != gValidCount) {     // Line not checked?
-                pLine->validCount = gValidCount;        // Mark it
-                if (!func(*pLine)) {                    // Call the line proc
-                    return false;                       // I have a match?
+            if (!ctx.testAndMarkLine(*pLine)) {     // Line not checked? (marks it)
+                if (!func(ctx, *pLine)) {           // Call the line proc
+                    return false;                   // I have a match?
                 }
             }
 
@@ -360,7 +360,7 @@ bool BlockLinesIterator(const uint32_t x, const uint32_t y, const BlockLinesIter
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Scan all objects standing on this map block.
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool BlockThingsIterator(const uint32_t x, const uint32_t y, const BlockThingsIterCallback func) noexcept {
+bool BlockThingsIterator(MapQueryContext& ctx, const uint32_t x, const uint32_t y, const BlockThingsIterCallback func) noexcept {
     // Check if we are off the map or not
     if (x < gBlockMapWidth && y < gBlockMapHeight) {
         const uint32_t blockIdx = y * gBlockMapWidth + x;
@@ -372,8 +372,8 @@ bool BlockThingsIterator(const uint32_t x, const uint32_t y, const BlockThingsIt
             // as the callback might invalidate the map object!
             mobj_t* const pNextMObj = pMObj->bnext;
 
-            if (!func(*pMObj)) {    // Call function
-                return false;       // I found it!
+            if (!func(ctx, *pMObj)) {       // Call function
+                return false;               // I found it!
             }
 
             pMObj = pNextMObj;  // Next object in list
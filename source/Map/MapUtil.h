@@ -4,12 +4,13 @@
 #include "Base/Fixed.h"
 
 struct line_t;
+struct MapQueryContext;
 struct mobj_t;
 struct subsector_t;
 struct vector_t;
 
-typedef bool (*BlockLinesIterCallback)(line_t&);
-typedef bool (*BlockThingsIterCallback)(mobj_t&);
+typedef bool (*BlockLinesIterCallback)(MapQueryContext&, line_t&);
+typedef bool (*BlockThingsIterCallback)(MapQueryContext&, mobj_t&);
 
 angle_t SlopeAngle(uint32_t num, uint32_t den) noexcept;
 angle_t PointToAngle(Fixed x1, Fixed y1, Fixed x2, Fixed y2) noexcept;
@@ -21,5 +22,5 @@ Fixed InterceptVector(const vector_t& first, const vector_t& second) noexcept;
 uint32_t LineOpening(const line_t& linedef) noexcept;
 void UnsetThingPosition(mobj_t& thing) noexcept;
 void SetThingPosition(mobj_t& thing) noexcept;
-bool BlockLinesIterator(const uint32_t x, const uint32_t y, const BlockLinesIterCallback func) noexcept;
-bool BlockThingsIterator(const uint32_t x, const uint32_t y, const BlockThingsIterCallback func) noexcept;
+bool BlockLinesIterator(MapQueryContext& ctx, const uint32_t x, const uint32_t y, const BlockLinesIterCallback func) noexcept;
+bool BlockThingsIterator(MapQueryContext& ctx, const uint32_t x, const uint32_t y, const BlockThingsIterCallback func) noexcept;
@@ -0,0 +1,1215 @@
+#include "Pvs.h"
+
+#include "Base/FileUtils.h"
+#include "Game/Config.h"
+#include "Game/GameDataFS.h"
+#include "MapUtil.h"
+#include "Things/MapObj.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(Pvs)
+
+// Header for a PVS cache file
+static constexpr uint8_t    FILE_ID[4]                  = { 'D', 'P', 'V', 'S' };
+static constexpr uint32_t   FORMAT_VERSION              = 1;
+
+// Tolerances used when building the PVS, in map units
+static constexpr double     CLIP_EPSILON                = 1.0 / 1024.0;     // Points this close to a clipping line are kept
+static constexpr double     COLLINEAR_EPSILON           = 1.0 / 16.0;       // Walls this close to a polygon edge are treated as on it
+static constexpr double     MIN_PORTAL_LENGTH           = 1.0 / 8.0;        // Gaps between walls smaller than this are ignored
+static constexpr double     PORTAL_PROBE_OFFSET         = 1.0 / 16.0;       // How far outside a leaf to look for the neighbouring leaf
+static constexpr double     MIN_CLIPPED_PORTAL_LENGTH   = 1.0 / 1024.0;     // Portals clipped smaller than this can't be seen through
+static constexpr double     PORTAL_FRONT_EPSILON        = 1.0 / 128.0;      // How far in front of a portal something must be to be seen
+static constexpr double     MAP_BOUNDS_PADDING          = 64.0;             // Extra space added around the map bounds
+
+// Tolerances used when checking if a point is inside a leaf at runtime, in map units.
+// The sight check tolerance allows for sight checks moving their start and end points to the nearest odd map unit (up to 1 unit on
+// each axis) and the dilation of the sight sets is greater than that.
+static constexpr float      RENDER_LEAF_TOLERANCE       = 1.0f / 16.0f;
+static constexpr float      SIGHT_LEAF_TOLERANCE        = 2.0f;
+static constexpr double     SIGHT_DILATION              = 4.0;
+
+// Limit on how much work is done finding what can be seen through any one portal.
+// If exceeded then everything that might be seen through the portal (going by a quicker rough check) is treated as visible.
+static constexpr uint32_t   MAX_FLOW_STEPS_PER_PORTAL   = 1 << 20;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Geometry used while building the PVS.
+// Double precision is used throughout, since errors in clipping could make the PVS wrongly exclude things.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Vec2 {
+    double x;
+    double y;
+};
+
+static Vec2 operator + (const Vec2 a, const Vec2 b) noexcept { return Vec2{ a.x + b.x, a.y + b.y }; }
+static Vec2 operator - (const Vec2 a, const Vec2 b) noexcept { return Vec2{ a.x - b.x, a.y - b.y }; }
+static Vec2 operator * (const Vec2 a, const double s) noexcept { return Vec2{ a.x * s, a.y * s }; }
+
+static double dot(const Vec2 a, const Vec2 b) noexcept { return a.x * b.x + a.y * b.y; }
+static double cross(const Vec2 a, const Vec2 b) noexcept { return a.x * b.y - a.y * b.x; }
+static double length(const Vec2 v) noexcept { return std::sqrt(dot(v, v)); }
+
+// A line which things can be on the inside (positive distance) or outside of
+struct ClipLine {
+    Vec2    normal;     // Unit length, points to the inside
+    double  dist;       // Distance of the line from the origin along the normal
+
+    double getDist(const Vec2 p) const noexcept { return dot(normal, p) - dist; }
+};
+
+// Makes a clip line from a point on it and its direction: the inside is to the left of the direction.
+// Returns 'false' if the direction is too short to give a line.
+static bool makeClipLine(const Vec2 origin, const Vec2 dir, ClipLine& line) noexcept {
+    const double len = length(dir);
+
+    if (len < 1e-9)
+        return false;
+
+    line.normal = Vec2{ -dir.y / len, dir.x / len };
+    line.dist = dot(line.normal, origin);
+    return true;
+}
+
+static ClipLine flipClipLine(const ClipLine& line) noexcept {
+    return ClipLine{ Vec2{ -line.normal.x, -line.normal.y }, -line.dist };
+}
+
+// A line segment, which for portals goes from the left end to the right end when looking through the portal
+struct Seg2 {
+    Vec2    a;
+    Vec2    b;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Clips a convex polygon against a line, keeping what is on the inside of it (within tolerance)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void clipPolygon(const std::vector<Vec2>& inPoly, const ClipLine& line, std::vector<Vec2>& outPoly) noexcept {
+    outPoly.clear();
+    const size_t numPoints = inPoly.size();
+
+    for (size_t i = 0; i < numPoints; ++i) {
+        const Vec2 p1 = inPoly[i];
+        const Vec2 p2 = inPoly[(i + 1) % numPoints];
+        const double d1 = line.getDist(p1);
+        const double d2 = line.getDist(p2);
+        const bool bInside1 = (d1 >= -CLIP_EPSILON);
+        const bool bInside2 = (d2 >= -CLIP_EPSILON);
+
+        if (bInside1) {
+            outPoly.push_back(p1);
+        }
+
+        if (bInside1 != bInside2) {
+            const double t = std::clamp(d1 / (d1 - d2), 0.0, 1.0);
+            outPoly.push_back(p1 + (p2 - p1) * t);
+        }
+    }
+
+    // Remove any points which are duplicates of the one before
+    size_t numOutPoints = 0;
+
+    for (size_t i = 0; i < outPoly.size(); ++i) {
+        if ((numOutPoints > 0) && (length(outPoly[i] - outPoly[numOutPoints - 1]) < 1e-9))
+            continue;
+
+        outPoly[numOutPoints++] = outPoly[i];
+    }
+
+    while ((numOutPoints > 1) && (length(outPoly[numOutPoints - 1] - outPoly[0]) < 1e-9)) {
+        --numOutPoints;
+    }
+
+    outPoly.resize((numOutPoints >= 3) ? numOutPoints : 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Clips a line segment against a line, keeping what is on the inside of it (within tolerance).
+// Returns 'false' if nothing or only a tiny piece of the segment is left.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool clipSeg(Seg2& seg, const ClipLine& line) noexcept {
+    const double da = line.getDist(seg.a);
+    const double db = line.getDist(seg.b);
+
+    if ((da < -CLIP_EPSILON) && (db < -CLIP_EPSILON))
+        return false;
+
+    if (da < -CLIP_EPSILON) {
+        seg.a = seg.a + (seg.b - seg.a) * std::clamp(da / (da - db), 0.0, 1.0);
+    } else if (db < -CLIP_EPSILON) {
+        seg.b = seg.b + (seg.a - seg.b) * std::clamp(db / (db - da), 0.0, 1.0);
+    }
+
+    return (length(seg.b - seg.a) >= MIN_CLIPPED_PORTAL_LENGTH);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Clips a line segment to the inside of the line through the two given points, where the inside is to the left (or right) of the
+// direction from the first point to the second. The clip is skipped if the points are too close to make a line.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool clipSegToLeftOf(Seg2& seg, const Vec2 p1, const Vec2 p2) noexcept {
+    ClipLine line;
+    return (makeClipLine(p1, p2 - p1, line)) ? clipSeg(seg, line) : true;
+}
+
+static bool clipSegToRightOf(Seg2& seg, const Vec2 p1, const Vec2 p2) noexcept {
+    ClipLine line;
+    return (makeClipLine(p1, p2 - p1, line)) ? clipSeg(seg, flipClipLine(line)) : true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Bitset helpers: each set is a row of 64-bit words
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool isBitSet(const uint64_t* const pBits, const uint32_t idx) noexcept {
+    return ((pBits[idx >> 6] >> (idx & 63)) & 1);
+}
+
+static void setBit(uint64_t* const pBits, const uint32_t idx) noexcept {
+    pBits[idx >> 6] |= uint64_t(1) << (idx & 63);
+}
+
+static void orBits(uint64_t* const pDstBits, const uint64_t* const pSrcBits, const uint32_t numWords) noexcept {
+    for (uint32_t i = 0; i < numWords; ++i) {
+        pDstBits[i] |= pSrcBits[i];
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Runtime PVS data for the current map
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+// An edge of a leaf polygon, for checking whether points are inside the leaf
+struct LeafEdge {
+    float   nx;         // Normal: points to the inside of the leaf
+    float   ny;
+    float   dist;
+};
+
+static bool                     gbPvsAvailable;             // False if the PVS is disabled or failed to build
+static uint32_t                 gNumLeaves;                 // Number of leaves: one per subsector
+static uint32_t                 gNumRowWords;               // Number of 64-bit words in the bitset for each leaf
+static std::vector<uint64_t>    gRenderPvs;                 // For each leaf: what might be visible from it, for rendering
+static std::vector<uint64_t>    gSightPvs;                  // For each leaf: what might be visible from it, dilated for sight checks
+static std::vector<LeafEdge>    gLeafEdges;                 // Edges of all of the leaf polygons
+static std::vector<uint32_t>    gLeafEdgesStart;            // For each leaf: where its edges start (plus one entry for the end)
+static std::vector<uint8_t>     gVisibleNodes;              // For each BSP node: whether any leaf under it is visible from 'gVisibleNodesLeaf'
+static uint32_t                 gVisibleNodesLeaf;          // Which leaf 'gVisibleNodes' was last worked out for
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Data used while building the PVS
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+// A one way portal leading out of a leaf into a neighbouring one.
+// The ends are ordered so that 'a' is on the left when looking through the portal into the leaf it leads to.
+struct Portal {
+    uint32_t    fromLeaf;
+    uint32_t    toLeaf;
+    Seg2        seg;
+    ClipLine    line;       // Inside is the side of the leaf the portal leads to
+};
+
+struct PvsBuilder {
+    uint32_t                            numLeaves;
+    uint32_t                            numRowWords;
+    std::vector<std::vector<Vec2>>      leafPolys;          // Convex polygon for each leaf, counter clockwise. Empty if it could not be worked out.
+    std::vector<Portal>                 portals;            // All portals, grouped by the leaf they lead out of
+    std::vector<uint32_t>               leafPortalsStart;   // For each leaf: index of its first portal (plus one entry for the end)
+    std::vector<uint64_t>               portalMightSee;     // For each portal: leaves that might be visible through it (rough check)
+    std::vector<uint64_t>               portalVis;          // For each portal: leaves that might be visible through it (full check)
+    uint32_t                            numFlowOverflows;   // How many portals hit the limit on flow steps
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the clip line for a BSP partition line: the inside is the front (right hand side) or back (left hand side) of the partition.
+// This matches the side that 'PointOnVectorSide' puts points on, except for points exactly on the line.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static double fixed16ToDouble(const Fixed fixed) noexcept {
+    return (double) fixed * (1.0 / 65536.0);
+}
+
+static ClipLine getPartitionClipLine(const vector_t& partition, const uint32_t side) noexcept {
+    const Vec2 origin = { fixed16ToDouble(partition.x), fixed16ToDouble(partition.y) };
+    const Vec2 dir = { fixed16ToDouble(partition.dx), fixed16ToDouble(partition.dy) };
+
+    ClipLine line = {};
+    makeClipLine(origin, dir, line);
+    return (side == 0) ? flipClipLine(line) : line;
+}
+
+static Seg2 getSegLine(const seg_t& seg) noexcept {
+    return Seg2{ Vec2{ seg.v1.x, seg.v1.y }, Vec2{ seg.v2.x, seg.v2.y } };
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Works out the convex polygon for every leaf of the BSP tree, under the given BSP child.
+// Each leaf is what is left of the polygon for the area covered by the child after clipping it against the segs in the leaf.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void buildLeafPolys(PvsBuilder& builder, const uint32_t child, const std::vector<Vec2>& poly) noexcept {
+    if (child & BSP_CHILD_SUBSECTOR) {
+        const uint32_t leafIdx = child & ~BSP_CHILD_SUBSECTOR;
+        const subsector_t& subsector = gpSubSectors[leafIdx];
+        std::vector<Vec2> leafPoly = poly;
+        std::vector<Vec2> clippedPoly;
+
+        // Segs face the inside of the subsector on their right hand side
+        for (uint32_t segIdx = 0; (segIdx < subsector.numsublines) && (!leafPoly.empty()); ++segIdx) {
+            const Seg2 seg = getSegLine(subsector.firstline[segIdx]);
+            ClipLine line;
+
+            if (makeClipLine(seg.a, seg.b - seg.a, line)) {
+                clipPolygon(leafPoly, flipClipLine(line), clippedPoly);
+                leafPoly.swap(clippedPoly);
+            }
+        }
+
+        builder.leafPolys[leafIdx] = std::move(leafPoly);
+        return;
+    }
+
+    for (uint32_t side = 0; side < 2; ++side) {
+        std::vector<Vec2> childPoly;
+        clipPolygon(poly, getPartitionClipLine(gpBspLines[child], side), childPoly);
+
+        if (!childPoly.empty()) {
+            buildLeafPolys(builder, gpBspChildren[child * 2 + side], childPoly);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the parts of the given line segment (as fractions along it) which are not covered by the one sided walls in the given leaf
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Range {
+    double  start;
+    double  end;
+};
+
+static void getUncoveredRanges(
+    const uint32_t leafIdx,
+    const Seg2& seg,
+    const std::vector<Range>& inRanges,
+    std::vector<Range>& outRanges
+) noexcept {
+    outRanges = inRanges;
+
+    const Vec2 segDir = seg.b - seg.a;
+    const double segLen = length(segDir);
+    const Vec2 segUnitDir = segDir * (1.0 / segLen);
+    const subsector_t& subsector = gpSubSectors[leafIdx];
+
+    for (uint32_t segIdx = 0; segIdx < subsector.numsublines; ++segIdx) {
+        const seg_t& wallSeg = subsector.firstline[segIdx];
+
+        if (wallSeg.backsector)
+            continue;
+
+        // The wall must lie along the line segment
+        const Seg2 wall = getSegLine(wallSeg);
+
+        if ((std::abs(cross(segUnitDir, wall.a - seg.a)) > COLLINEAR_EPSILON) || (std::abs(cross(segUnitDir, wall.b - seg.a)) > COLLINEAR_EPSILON))
+            continue;
+
+        const double t1 = dot(wall.a - seg.a, segUnitDir) / segLen;
+        const double t2 = dot(wall.b - seg.a, segUnitDir) / segLen;
+        const double wallStart = std::min(t1, t2);
+        const double wallEnd = std::max(t1, t2);
+
+        // Cut the wall out of the ranges
+        std::vector<Range> cutRanges;
+
+        for (const Range& range : outRanges) {
+            if ((wallEnd <= range.start) || (wallStart >= range.end)) {
+                cutRanges.push_back(range);
+                continue;
+            }
+
+            if (wallStart > range.start) {
+                cutRanges.push_back(Range{ range.start, wallStart });
+            }
+
+            if (wallEnd < range.end) {
+                cutRanges.push_back(Range{ wallEnd, range.end });
+            }
+        }
+
+        outRanges.swap(cutRanges);
+    }
+
+    // Ignore tiny gaps between walls, which are just due to rounding
+    outRanges.erase(
+        std::remove_if(outRanges.begin(), outRanges.end(), [&](const Range& range) noexcept {
+            return ((range.end - range.start) * segLen < MIN_PORTAL_LENGTH);
+        }),
+        outRanges.end()
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finds which leaves the given line segment passes through, splitting it up at the BSP partition lines
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct LeafSeg {
+    uint32_t    leafIdx;
+    Seg2        seg;
+};
+
+static void splitSegIntoLeaves(const uint32_t child, const Seg2& seg, std::vector<LeafSeg>& leafSegs) noexcept {
+    if (child & BSP_CHILD_SUBSECTOR) {
+        leafSegs.push_back(LeafSeg{ child & ~BSP_CHILD_SUBSECTOR, seg });
+        return;
+    }
+
+    // Distances to the back of the partition line
+    const ClipLine line = getPartitionClipLine(gpBspLines[child], 1);
+    const double da = line.getDist(seg.a);
+    const double db = line.getDist(seg.b);
+    const uint32_t* const pChildren = gpBspChildren + child * 2;
+
+    if ((da <= 0.0) && (db <= 0.0)) {
+        splitSegIntoLeaves(pChildren[0], seg, leafSegs);
+    } else if ((da >= 0.0) && (db >= 0.0)) {
+        splitSegIntoLeaves(pChildren[1], seg, leafSegs);
+    } else {
+        const Vec2 splitPt = seg.a + (seg.b - seg.a) * (da / (da - db));
+        splitSegIntoLeaves(pChildren[(da < 0.0) ? 0 : 1], Seg2{ seg.a, splitPt }, leafSegs);
+        splitSegIntoLeaves(pChildren[(da < 0.0) ? 1 : 0], Seg2{ splitPt, seg.b }, leafSegs);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finds the portals leading out of each leaf: the parts of each polygon edge which are not blocked by one sided walls on either side
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void buildPortals(PvsBuilder& builder) noexcept {
+    std::vector<Range> openRanges;
+    std::vector<Range> neighbourOpenRanges;
+    std::vector<LeafSeg> leafSegs;
+
+    builder.leafPortalsStart.resize(builder.numLeaves + 1);
+
+    for (uint32_t leafIdx = 0; leafIdx < builder.numLeaves; ++leafIdx) {
+        builder.leafPortalsStart[leafIdx] = (uint32_t) builder.portals.size();
+        const std::vector<Vec2>& poly = builder.leafPolys[leafIdx];
+        const size_t numPoints = poly.size();
+
+        for (size_t pointIdx = 0; pointIdx < numPoints; ++pointIdx) {
+            const Seg2 edge = { poly[pointIdx], poly[(pointIdx + 1) % numPoints] };
+            const Vec2 edgeDir = edge.b - edge.a;
+            const double edgeLen = length(edgeDir);
+
+            if (edgeLen < MIN_PORTAL_LENGTH)
+                continue;
+
+            // Polygons are counter clockwise so the outside of each edge is on the right
+            const Vec2 outDir = Vec2{ edgeDir.y, -edgeDir.x } * (1.0 / edgeLen);
+            const Vec2 probeOffset = outDir * PORTAL_PROBE_OFFSET;
+            getUncoveredRanges(leafIdx, edge, { Range{ 0.0, 1.0 } }, openRanges);
+
+            for (const Range& openRange : openRanges) {
+                // See which leaves are just outside this open part of the edge
+                const Vec2 openStart = edge.a + edgeDir * openRange.start;
+                const Vec2 openEnd = edge.a + edgeDir * openRange.end;
+                leafSegs.clear();
+                splitSegIntoLeaves(gBspRootChild, Seg2{ openStart + probeOffset, openEnd + probeOffset }, leafSegs);
+
+                for (const LeafSeg& leafSeg : leafSegs) {
+                    if (leafSeg.leafIdx == leafIdx)
+                        continue;
+
+                    // The neighbouring leaf might also have walls along the edge, facing the other way
+                    const Seg2 neighbourSeg = { leafSeg.seg.a - probeOffset, leafSeg.seg.b - probeOffset };
+
+                    if (length(neighbourSeg.b - neighbourSeg.a) < MIN_PORTAL_LENGTH)
+                        continue;
+
+                    getUncoveredRanges(leafSeg.leafIdx, neighbourSeg, { Range{ 0.0, 1.0 } }, neighbourOpenRanges);
+
+                    for (const Range& range : neighbourOpenRanges) {
+                        // Looking out of the leaf, the end of the edge is on the left
+                        const Vec2 neighbourDir = neighbourSeg.b - neighbourSeg.a;
+
+                        Portal& portal = builder.portals.emplace_back();
+                        portal.fromLeaf = leafIdx;
+                        portal.toLeaf = leafSeg.leafIdx;
+                        portal.seg.a = neighbourSeg.a + neighbourDir * range.end;
+                        portal.seg.b = neighbourSeg.a + neighbourDir * range.start;
+                        makeClipLine(portal.seg.a, portal.seg.b - portal.seg.a, portal.line);
+                    }
+                }
+            }
+        }
+    }
+
+    builder.leafPortalsStart[builder.numLeaves] = (uint32_t) builder.portals.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Rough check for whether one portal might be seen through another: some of the second portal must be in front of the first, and some
+// of the first must be behind the second.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool canPortalBeSeenThrough(const Portal& portal, const Portal& throughPortal) noexcept {
+    if ((throughPortal.line.getDist(portal.seg.a) < PORTAL_FRONT_EPSILON) && (throughPortal.line.getDist(portal.seg.b) < PORTAL_FRONT_EPSILON))
+        return false;
+
+    if ((portal.line.getDist(throughPortal.seg.a) > -PORTAL_FRONT_EPSILON) && (portal.line.getDist(throughPortal.seg.b) > -PORTAL_FRONT_EPSILON))
+        return false;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Works out the leaves which might be seen through each portal using the rough check, by flooding out through all the portals beyond it
+// which pass the check. This bounds the full check, which is much slower.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void buildPortalMightSee(PvsBuilder& builder) noexcept {
+    const uint32_t numPortals = (uint32_t) builder.portals.size();
+    builder.portalMightSee.assign((size_t) numPortals * builder.numRowWords, 0);
+    std::vector<uint32_t> leafStack;
+
+    for (uint32_t portalIdx = 0; portalIdx < numPortals; ++portalIdx) {
+        const Portal& srcPortal = builder.portals[portalIdx];
+        uint64_t* const pMightSee = builder.portalMightSee.data() + (size_t) portalIdx * builder.numRowWords;
+        setBit(pMightSee, srcPortal.toLeaf);
+        leafStack.push_back(srcPortal.toLeaf);
+
+        while (!leafStack.empty()) {
+            const uint32_t leafIdx = leafStack.back();
+            leafStack.pop_back();
+
+            for (uint32_t i = builder.leafPortalsStart[leafIdx]; i < builder.leafPortalsStart[leafIdx + 1]; ++i) {
+                const Portal& portal = builder.portals[i];
+
+                if (isBitSet(pMightSee, portal.toLeaf))
+                    continue;
+
+                if (!canPortalBeSeenThrough(portal, srcPortal))
+                    continue;
+
+                setBit(pMightSee, portal.toLeaf);
+                leafStack.push_back(portal.toLeaf);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Full check for what can be seen through a portal.
+// Flows out through the portals beyond it, keeping track of the part of the source portal which can still see out through everything
+// passed through so far (the source) and the last portal passed through (the pass portal). Only lines from the source through the pass
+// portal can carry on into the leaf beyond, so the portals leading out of that leaf are clipped to the 'beam' of those lines.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct FlowState {
+    PvsBuilder&                         builder;
+    uint64_t*                           pVis;           // Leaves found to be visible through the source portal
+    std::vector<uint8_t>                leafOnPath;     // Leaves on the current flow path, which can't be gone back into
+    std::vector<std::vector<uint64_t>>  mightSeeStack;  // One set of 'might see' bits for each level of the flow path
+    uint32_t                            numSteps;
+    bool                                bOverflowed;
+};
+
+static void flowThroughLeaf(
+    FlowState& state,
+    const uint32_t leafIdx,
+    const uint32_t depth,
+    const Seg2& source,
+    const ClipLine& sourceLine,
+    const Seg2* const pPass,
+    const uint64_t* const pMightSee
+) noexcept {
+    const PvsBuilder& builder = state.builder;
+    const uint32_t numRowWords = builder.numRowWords;
+    setBit(state.pVis, leafIdx);
+    state.leafOnPath[leafIdx] = 1;
+
+    // Note: the sets for each level are kept separately since growing the list moves the vectors but not what they point to
+    if (state.mightSeeStack.size() <= depth) {
+        state.mightSeeStack.resize(depth + 1);
+    }
+
+    state.mightSeeStack[depth].resize(numRowWords);
+    uint64_t* const pNextMightSee = state.mightSeeStack[depth].data();
+
+    for (uint32_t portalIdx = builder.leafPortalsStart[leafIdx]; portalIdx < builder.leafPortalsStart[leafIdx + 1]; ++portalIdx) {
+        if (++state.numSteps > MAX_FLOW_STEPS_PER_PORTAL) {
+            state.bOverflowed = true;
+            break;
+        }
+
+        const Portal& portal = builder.portals[portalIdx];
+
+        if ((!isBitSet(pMightSee, portal.toLeaf)) || state.leafOnPath[portal.toLeaf])
+            continue;
+
+        // Only carry on if there might be something more to see through this portal
+        const uint64_t* const pPortalMightSee = builder.portalMightSee.data() + (size_t) portalIdx * numRowWords;
+        bool bMoreToSee = false;
+
+        for (uint32_t i = 0; i < numRowWords; ++i) {
+            pNextMightSee[i] = pMightSee[i] & pPortalMightSee[i];
+            bMoreToSee |= ((pNextMightSee[i] & ~state.pVis[i]) != 0);
+        }
+
+        if (!bMoreToSee)
+            continue;
+
+        // The portal must be in front of the source
+        Seg2 target = portal.seg;
+        Seg2 newSource = source;
+
+        if (!clipSeg(target, sourceLine))
+            continue;
+
+        if (pPass) {
+            // The portal must also be in front of the pass portal and within the lines from the source through the pass portal
+            ClipLine passLine;
+
+            if (!makeClipLine(pPass->a, pPass->b - pPass->a, passLine))
+                continue;
+
+            if (!clipSeg(target, passLine))
+                continue;
+
+            if (!clipSegToRightOf(target, source.b, pPass->a))
+                continue;
+
+            if (!clipSegToLeftOf(target, source.a, pPass->b))
+                continue;
+
+            // Clip the source to the part which can see the portal through the pass portal
+            if (!clipSegToRightOf(newSource, target.a, pPass->b))
+                continue;
+
+            if (!clipSegToLeftOf(newSource, target.b, pPass->a))
+                continue;
+        }
+
+        // The source must be behind the portal, which becomes the next pass portal
+        ClipLine targetLine;
+
+        if (makeClipLine(target.a, target.b - target.a, targetLine)) {
+            if (!clipSeg(newSource, flipClipLine(targetLine)))
+                continue;
+        }
+
+        flowThroughLeaf(state, portal.toLeaf, depth + 1, newSource, sourceLine, &target, pNextMightSee);
+
+        if (state.bOverflowed)
+            break;
+    }
+
+    state.leafOnPath[leafIdx] = 0;
+}
+
+static void buildPortalVis(PvsBuilder& builder) noexcept {
+    const uint32_t numPortals = (uint32_t) builder.portals.size();
+    const uint32_t numRowWords = builder.numRowWords;
+    builder.portalVis.assign((size_t) numPortals * numRowWords, 0);
+    builder.numFlowOverflows = 0;
+
+    FlowState state = { builder, nullptr, {}, {}, 0, false };
+    state.leafOnPath.resize(builder.numLeaves);
+
+    for (uint32_t portalIdx = 0; portalIdx < numPortals; ++portalIdx) {
+        const Portal& portal = builder.portals[portalIdx];
+        const uint64_t* const pMightSee = builder.portalMightSee.data() + (size_t) portalIdx * numRowWords;
+
+        state.pVis = builder.portalVis.data() + (size_t) portalIdx * numRowWords;
+        state.numSteps = 0;
+        state.bOverflowed = false;
+        std::fill(state.leafOnPath.begin(), state.leafOnPath.end(), 0);
+        state.leafOnPath[portal.fromLeaf] = 1;
+
+        flowThroughLeaf(state, portal.toLeaf, 0, portal.seg, portal.line, nullptr, pMightSee);
+
+        // If too much work was needed then fall back to the rough check
+        if (state.bOverflowed) {
+            std::memcpy(state.pVis, pMightSee, sizeof(uint64_t) * numRowWords);
+            ++builder.numFlowOverflows;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Gets the distance between two line segments
+//------------------------------------------------------------------------------------------------------------------------------------------
+static double getPointSegDist(const Vec2 p, const Seg2& seg) noexcept {
+    const Vec2 dir = seg.b - seg.a;
+    const double lenSq = dot(dir, dir);
+    const double t = (lenSq > 0.0) ? std::clamp(dot(p - seg.a, dir) / lenSq, 0.0, 1.0) : 0.0;
+    return length(p - (seg.a + dir * t));
+}
+
+static double getSegSegDist(const Seg2& seg1, const Seg2& seg2) noexcept {
+    const Vec2 dir1 = seg1.b - seg1.a;
+    const Vec2 dir2 = seg2.b - seg2.a;
+    const double s1a = cross(dir1, seg2.a - seg1.a);
+    const double s1b = cross(dir1, seg2.b - seg1.a);
+    const double s2a = cross(dir2, seg1.a - seg2.a);
+    const double s2b = cross(dir2, seg1.b - seg2.a);
+
+    if ((((s1a <= 0) && (s1b >= 0)) || ((s1a >= 0) && (s1b <= 0))) && (((s2a <= 0) && (s2b >= 0)) || ((s2a >= 0) && (s2b <= 0))))
+        return 0.0;     // Intersecting
+
+    return std::min(
+        std::min(getPointSegDist(seg1.a, seg2), getPointSegDist(seg1.b, seg2)),
+        std::min(getPointSegDist(seg2.a, seg1), getPointSegDist(seg2.b, seg1))
+    );
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if two leaf polygons are within the given distance of each other
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool arePolysWithinDist(const std::vector<Vec2>& poly1, const std::vector<Vec2>& poly2, const double dist) noexcept {
+    const size_t numPoints1 = poly1.size();
+    const size_t numPoints2 = poly2.size();
+
+    for (size_t i = 0; i < numPoints1; ++i) {
+        const Seg2 edge1 = { poly1[i], poly1[(i + 1) % numPoints1] };
+
+        for (size_t j = 0; j < numPoints2; ++j) {
+            const Seg2 edge2 = { poly2[j], poly2[(j + 1) % numPoints2] };
+
+            if (getSegSegDist(edge1, edge2) <= dist)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Works out the final sets for each leaf from what can be seen through the portals leading out of it
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void buildLeafSets(PvsBuilder& builder) noexcept {
+    const uint32_t numLeaves = builder.numLeaves;
+    const uint32_t numRowWords = builder.numRowWords;
+    const size_t numSetWords = (size_t) numLeaves * numRowWords;
+
+    // Everything seen through the portals out of each leaf, plus the leaf itself and its direct neighbours
+    std::vector<uint64_t> leafVis(numSetWords, 0);
+    std::vector<uint64_t> leafNeighbours(numSetWords, 0);
+
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx) {
+        uint64_t* const pVis = leafVis.data() + (size_t) leafIdx * numRowWords;
+        uint64_t* const pNeighbours = leafNeighbours.data() + (size_t) leafIdx * numRowWords;
+        setBit(pVis, leafIdx);
+        setBit(pNeighbours, leafIdx);
+
+        for (uint32_t portalIdx = builder.leafPortalsStart[leafIdx]; portalIdx < builder.leafPortalsStart[leafIdx + 1]; ++portalIdx) {
+            setBit(pVis, builder.portals[portalIdx].toLeaf);
+            setBit(pNeighbours, builder.portals[portalIdx].toLeaf);
+            orBits(pVis, builder.portalVis.data() + (size_t) portalIdx * numRowWords, numRowWords);
+        }
+    }
+
+    // Leaves which have no polygon (should not happen) are treated as seeing and being seen by everything
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx) {
+        if (!builder.leafPolys[leafIdx].empty())
+            continue;
+
+        for (uint32_t otherLeafIdx = 0; otherLeafIdx < numLeaves; ++otherLeafIdx) {
+            setBit(leafVis.data() + (size_t) leafIdx * numRowWords, otherLeafIdx);
+            setBit(leafVis.data() + (size_t) otherLeafIdx * numRowWords, leafIdx);
+        }
+    }
+
+    // Visibility goes both ways, but the flow may find it in only one direction due to the tolerances used
+    for (uint32_t leafIdx1 = 0; leafIdx1 < numLeaves; ++leafIdx1) {
+        for (uint32_t leafIdx2 = leafIdx1 + 1; leafIdx2 < numLeaves; ++leafIdx2) {
+            uint64_t* const pVis1 = leafVis.data() + (size_t) leafIdx1 * numRowWords;
+            uint64_t* const pVis2 = leafVis.data() + (size_t) leafIdx2 * numRowWords;
+
+            if (isBitSet(pVis1, leafIdx2) || isBitSet(pVis2, leafIdx1)) {
+                setBit(pVis1, leafIdx2);
+                setBit(pVis2, leafIdx1);
+            }
+        }
+    }
+
+    // For rendering also include the neighbours of everything visible, since sprites can stick out of the subsector they are in
+    gRenderPvs.assign(numSetWords, 0);
+
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx) {
+        const uint64_t* const pVis = leafVis.data() + (size_t) leafIdx * numRowWords;
+        uint64_t* const pRenderVis = gRenderPvs.data() + (size_t) leafIdx * numRowWords;
+
+        for (uint32_t visLeafIdx = 0; visLeafIdx < numLeaves; ++visLeafIdx) {
+            if (isBitSet(pVis, visLeafIdx)) {
+                orBits(pRenderVis, leafNeighbours.data() + (size_t) visLeafIdx * numRowWords, numRowWords);
+            }
+        }
+    }
+
+    // For sight checks, find the leaves within a small distance of each leaf and dilate the sets by that at both ends.
+    // Anything near leaf 'A' might see anything near any leaf that is visible from something near 'A'.
+    std::vector<uint64_t> nearbyLeaves(numSetWords, 0);
+    std::vector<double> leafBounds((size_t) numLeaves * 4);
+
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx) {
+        double* const pBounds = leafBounds.data() + (size_t) leafIdx * 4;
+        pBounds[0] = pBounds[1] = +1e30;
+        pBounds[2] = pBounds[3] = -1e30;
+
+        for (const Vec2 p : builder.leafPolys[leafIdx]) {
+            pBounds[0] = std::min(pBounds[0], p.x);
+            pBounds[1] = std::min(pBounds[1], p.y);
+            pBounds[2] = std::max(pBounds[2], p.x);
+            pBounds[3] = std::max(pBounds[3], p.y);
+        }
+    }
+
+    for (uint32_t leafIdx1 = 0; leafIdx1 < numLeaves; ++leafIdx1) {
+        setBit(nearbyLeaves.data() + (size_t) leafIdx1 * numRowWords, leafIdx1);
+        const double* const pBounds1 = leafBounds.data() + (size_t) leafIdx1 * 4;
+
+        for (uint32_t leafIdx2 = leafIdx1 + 1; leafIdx2 < numLeaves; ++leafIdx2) {
+            const double* const pBounds2 = leafBounds.data() + (size_t) leafIdx2 * 4;
+
+            const bool bBoundsNearby = (
+                (pBounds1[0] - SIGHT_DILATION <= pBounds2[2]) &&
+                (pBounds1[1] - SIGHT_DILATION <= pBounds2[3]) &&
+                (pBounds1[2] + SIGHT_DILATION >= pBounds2[0]) &&
+                (pBounds1[3] + SIGHT_DILATION >= pBounds2[1])
+            );
+
+            if (bBoundsNearby && arePolysWithinDist(builder.leafPolys[leafIdx1], builder.leafPolys[leafIdx2], SIGHT_DILATION)) {
+                setBit(nearbyLeaves.data() + (size_t) leafIdx1 * numRowWords, leafIdx2);
+                setBit(nearbyLeaves.data() + (size_t) leafIdx2 * numRowWords, leafIdx1);
+            }
+        }
+    }
+
+    std::vector<uint64_t> visNearby(numSetWords, 0);
+
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx) {
+        const uint64_t* const pVis = leafVis.data() + (size_t) leafIdx * numRowWords;
+        uint64_t* const pVisNearby = visNearby.data() + (size_t) leafIdx * numRowWords;
+
+        for (uint32_t visLeafIdx = 0; visLeafIdx < numLeaves; ++visLeafIdx) {
+            if (isBitSet(pVis, visLeafIdx)) {
+                orBits(pVisNearby, nearbyLeaves.data() + (size_t) visLeafIdx * numRowWords, numRowWords);
+            }
+        }
+    }
+
+    gSightPvs.assign(numSetWords, 0);
+
+    for (uint32_t leafIdx = 0; leafIdx < numLeaves; ++leafIdx) {
+        const uint64_t* const pNearby = nearbyLeaves.data() + (size_t) leafIdx * numRowWords;
+        uint64_t* const pSightVis = gSightPvs.data() + (size_t) leafIdx * numRowWords;
+
+        for (uint32_t nearbyLeafIdx = 0; nearbyLeafIdx < numLeaves; ++nearbyLeafIdx) {
+            if (isBitSet(pNearby, nearbyLeafIdx)) {
+                orBits(pSightVis, visNearby.data() + (size_t) nearbyLeafIdx * numRowWords, numRowWords);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Works out the polygons for all the leaves.
+// These are always worked out when a map is loaded, even if the PVS comes from the cache, since they are needed to check whether
+// points are inside of leaves and it doesn't take long.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void buildLeafPolysForMap(PvsBuilder& builder) noexcept {
+    // Start with the bounds of the map, plus some extra space
+    double minX = +1e30;
+    double minY = +1e30;
+    double maxX = -1e30;
+    double maxY = -1e30;
+
+    for (uint32_t segIdx = 0; segIdx < gNumLineSegs; ++segIdx) {
+        const seg_t& seg = gpLineSegs[segIdx];
+        minX = std::min(minX, (double) std::min(seg.v1.x, seg.v2.x));
+        minY = std::min(minY, (double) std::min(seg.v1.y, seg.v2.y));
+        maxX = std::max(maxX, (double) std::max(seg.v1.x, seg.v2.x));
+        maxY = std::max(maxY, (double) std::max(seg.v1.y, seg.v2.y));
+    }
+
+    minX -= MAP_BOUNDS_PADDING;
+    minY -= MAP_BOUNDS_PADDING;
+    maxX += MAP_BOUNDS_PADDING;
+    maxY += MAP_BOUNDS_PADDING;
+
+    const std::vector<Vec2> mapPoly = { Vec2{ minX, minY }, Vec2{ maxX, minY }, Vec2{ maxX, maxY }, Vec2{ minX, maxY } };
+    builder.leafPolys.clear();
+    builder.leafPolys.resize(builder.numLeaves);
+    buildLeafPolys(builder, gBspRootChild, mapPoly);
+
+    // Save the edges of the polygons for checking whether points are inside them
+    gLeafEdges.clear();
+    gLeafEdgesStart.resize(builder.numLeaves + 1);
+
+    for (uint32_t leafIdx = 0; leafIdx < builder.numLeaves; ++leafIdx) {
+        gLeafEdgesStart[leafIdx] = (uint32_t) gLeafEdges.size();
+        const std::vector<Vec2>& poly = builder.leafPolys[leafIdx];
+        const size_t numPoints = poly.size();
+
+        for (size_t pointIdx = 0; pointIdx < numPoints; ++pointIdx) {
+            ClipLine line;
+
+            if (makeClipLine(poly[pointIdx], poly[(pointIdx + 1) % numPoints] - poly[pointIdx], line)) {
+                gLeafEdges.push_back(LeafEdge{ (float) line.normal.x, (float) line.normal.y, (float) line.dist });
+            }
+        }
+    }
+
+    gLeafEdgesStart[builder.numLeaves] = (uint32_t) gLeafEdges.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes a hash of all the map data which the PVS depends on, so that cached PVS files can be checked to see if they are still valid
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void addToHash(uint64_t& hash, const void* const pData, const size_t size) noexcept {
+    const uint8_t* const pBytes = (const uint8_t*) pData;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= pBytes[i];
+        hash *= 0x100000001B3ull;   // FNV-1a
+    }
+}
+
+static void addToHash(uint64_t& hash, const uint32_t value) noexcept {
+    addToHash(hash, &value, sizeof(value));
+}
+
+static uint64_t getMapGeometryHash() noexcept {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    addToHash(hash, gNumBspNodes);
+    addToHash(hash, gBspRootChild);
+    addToHash(hash, gpBspLines, sizeof(vector_t) * gNumBspNodes);
+    addToHash(hash, gpBspChildren, sizeof(uint32_t) * gNumBspNodes * 2);
+    addToHash(hash, gNumSubSectors);
+
+    for (uint32_t leafIdx = 0; leafIdx < gNumSubSectors; ++leafIdx) {
+        const subsector_t& subsector = gpSubSectors[leafIdx];
+        addToHash(hash, subsector.numsublines);
+        addToHash(hash, (uint32_t)(subsector.firstline - gpLineSegs));
+    }
+
+    addToHash(hash, gNumLineSegs);
+
+    for (uint32_t segIdx = 0; segIdx < gNumLineSegs; ++segIdx) {
+        const seg_t& seg = gpLineSegs[segIdx];
+        addToHash(hash, &seg.v1, sizeof(seg.v1));
+        addToHash(hash, &seg.v2, sizeof(seg.v2));
+        addToHash(hash, (seg.backsector) ? 1u : 0u);
+    }
+
+    return hash;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Reading and writing of PVS cache files.
+// All values are little endian. After the header the render and sight sets are stored with runs of zero bytes compressed (as in Quake),
+// since most of each set is usually zeros: a zero byte is followed by the number of zero bytes in the run.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static std::string getCacheFilePath(const uint32_t mapNum) noexcept {
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "Doom3DO_MAP%02u.pvs", mapNum);
+    return GameDataFS::getHostFilePath(fileName);
+}
+
+static void writeU32(std::vector<std::byte>& bytes, const uint32_t value) noexcept {
+    bytes.push_back((std::byte)(value));
+    bytes.push_back((std::byte)(value >> 8));
+    bytes.push_back((std::byte)(value >> 16));
+    bytes.push_back((std::byte)(value >> 24));
+}
+
+static void writeCompressedSets(std::vector<std::byte>& bytes, const std::vector<uint64_t>& sets) noexcept {
+    uint32_t zeroRunLength = 0;
+
+    for (const uint64_t word : sets) {
+        for (uint32_t byteIdx = 0; byteIdx < 8; ++byteIdx) {
+            const uint8_t byte = (uint8_t)(word >> (byteIdx * 8));
+
+            if (byte == 0) {
+                if (++zeroRunLength == 255) {
+                    bytes.push_back(std::byte(0));
+                    bytes.push_back(std::byte(255));
+                    zeroRunLength = 0;
+                }
+
+                continue;
+            }
+
+            if (zeroRunLength > 0) {
+                bytes.push_back(std::byte(0));
+                bytes.push_back((std::byte) zeroRunLength);
+                zeroRunLength = 0;
+            }
+
+            bytes.push_back((std::byte) byte);
+        }
+    }
+
+    if (zeroRunLength > 0) {
+        bytes.push_back(std::byte(0));
+        bytes.push_back((std::byte) zeroRunLength);
+    }
+}
+
+struct PvsFileReader {
+    const std::byte*    pCurByte;
+    const std::byte*    pEndByte;
+    bool                bFailed;
+
+    uint32_t readU32() noexcept {
+        if (pEndByte - pCurByte < 4) {
+            bFailed = true;
+            return 0;
+        }
+
+        const uint32_t value = (
+            ((uint32_t) pCurByte[0]) |
+            ((uint32_t) pCurByte[1] << 8) |
+            ((uint32_t) pCurByte[2] << 16) |
+            ((uint32_t) pCurByte[3] << 24)
+        );
+
+        pCurByte += 4;
+        return value;
+    }
+
+    void readCompressedSets(std::vector<uint64_t>& sets, const size_t numWords) noexcept {
+        sets.assign(numWords, 0);
+        const size_t numBytes = numWords * 8;
+        size_t byteIdx = 0;
+
+        while ((byteIdx < numBytes) && (!bFailed)) {
+            if (pCurByte >= pEndByte) {
+                bFailed = true;
+                break;
+            }
+
+            const uint8_t byte = (uint8_t) *pCurByte++;
+
+            if (byte != 0) {
+                sets[byteIdx / 8] |= (uint64_t) byte << ((byteIdx % 8) * 8);
+                ++byteIdx;
+                continue;
+            }
+
+            if (pCurByte >= pEndByte) {
+                bFailed = true;
+                break;
+            }
+
+            const uint32_t zeroRunLength = (uint8_t) *pCurByte++;
+
+            if ((zeroRunLength == 0) || (byteIdx + zeroRunLength > numBytes)) {
+                bFailed = true;
+                break;
+            }
+
+            byteIdx += zeroRunLength;
+        }
+    }
+};
+
+static bool readCacheFile(const uint32_t mapNum, const uint64_t geometryHash) noexcept {
+    const std::string filePath = getCacheFilePath(mapNum);
+    std::byte* pFileData = nullptr;
+    size_t fileSize = 0;
+
+    if (!FileUtils::getContentsOfFile(filePath.c_str(), pFileData, fileSize))
+        return false;
+
+    std::unique_ptr<std::byte[]> pFileDataOwner(pFileData);
+
+    if ((fileSize < sizeof(FILE_ID)) || (std::memcmp(pFileData, FILE_ID, sizeof(FILE_ID)) != 0))
+        return false;
+
+    PvsFileReader reader = { pFileData + sizeof(FILE_ID), pFileData + fileSize, false };
+    const uint32_t formatVersion = reader.readU32();
+    const uint32_t fileMapNum = reader.readU32();
+    const uint32_t fileNumLeaves = reader.readU32();
+    const uint32_t fileHashLo = reader.readU32();
+    const uint32_t fileHashHi = reader.readU32();
+
+    const bool bHeaderMatches = (
+        (!reader.bFailed) &&
+        (formatVersion == FORMAT_VERSION) &&
+        (fileMapNum == mapNum) &&
+        (fileNumLeaves == gNumLeaves) &&
+        (fileHashLo == (uint32_t) geometryHash) &&
+        (fileHashHi == (uint32_t)(geometryHash >> 32))
+    );
+
+    if (!bHeaderMatches)
+        return false;
+
+    const size_t numSetWords = (size_t) gNumLeaves * gNumRowWords;
+    reader.readCompressedSets(gRenderPvs, numSetWords);
+    reader.readCompressedSets(gSightPvs, numSetWords);
+
+    if (reader.bFailed || (reader.pCurByte != reader.pEndByte)) {
+        gRenderPvs.clear();
+        gSightPvs.clear();
+        return false;
+    }
+
+    return true;
+}
+
+static void writeCacheFile(const uint32_t mapNum, const uint64_t geometryHash) noexcept {
+    std::vector<std::byte> fileData;
+
+    for (const uint8_t idChar : FILE_ID) {
+        fileData.push_back((std::byte) idChar);
+    }
+
+    writeU32(fileData, FORMAT_VERSION);
+    writeU32(fileData, mapNum);
+    writeU32(fileData, gNumLeaves);
+    writeU32(fileData, (uint32_t) geometryHash);
+    writeU32(fileData, (uint32_t)(geometryHash >> 32));
+    writeCompressedSets(fileData, gRenderPvs);
+    writeCompressedSets(fileData, gSightPvs);
+
+    // Not being able to save the file is not fatal: the PVS will just be built again next time
+    const std::string filePath = getCacheFilePath(mapNum);
+
+    if (!FileUtils::writeDataToFile(filePath.c_str(), fileData.data(), fileData.size())) {
+        std::printf("Failed to save the PVS cache file '%s'!\n", filePath.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if a point is inside the polygon for a leaf, to within the given tolerance
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool isPointInLeaf(const uint32_t leafIdx, const float x, const float y, const float tolerance) noexcept {
+    const uint32_t edgesEnd = gLeafEdgesStart[leafIdx + 1];
+
+    for (uint32_t edgeIdx = gLeafEdgesStart[leafIdx]; edgeIdx < edgesEnd; ++edgeIdx) {
+        const LeafEdge& edge = gLeafEdges[edgeIdx];
+
+        if (edge.nx * x + edge.ny * y - edge.dist < -tolerance)
+            return false;
+    }
+
+    return (edgesEnd > gLeafEdgesStart[leafIdx]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Works out for each BSP node whether any leaf under it is in the given set
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool markVisibleNodes(const uint32_t child, const uint64_t* const pVisibleLeaves) noexcept {
+    if (child & BSP_CHILD_SUBSECTOR)
+        return isBitSet(pVisibleLeaves, child & ~BSP_CHILD_SUBSECTOR);
+
+    const bool bFrontVisible = markVisibleNodes(gpBspChildren[child * 2], pVisibleLeaves);
+    const bool bBackVisible = markVisibleNodes(gpBspChildren[child * 2 + 1], pVisibleLeaves);
+    const bool bVisible = (bFrontVisible || bBackVisible);
+    gVisibleNodes[child] = (bVisible) ? 1 : 0;
+    return bVisible;
+}
+
+void init(const uint32_t mapNum) noexcept {
+    shutdown();
+
+    const bool bPvsWanted = (Config::gbUsePvs || Config::gbUsePvsForSight || Config::gbVerifyPvs);
+
+    if ((!bPvsWanted) || (gNumSubSectors == 0))
+        return;
+
+    gNumLeaves = gNumSubSectors;
+    gNumRowWords = (gNumLeaves + 63) / 64;
+    gVisibleNodes.resize(gNumBspNodes);
+
+    PvsBuilder builder = {};
+    builder.numLeaves = gNumLeaves;
+    builder.numRowWords = gNumRowWords;
+    buildLeafPolysForMap(builder);
+
+    // Use the cached PVS if it is still valid for this map, otherwise build it and save it for next time
+    const uint64_t geometryHash = getMapGeometryHash();
+
+    if (!readCacheFile(mapNum, geometryHash)) {
+        const auto startTime = std::chrono::steady_clock::now();
+        buildPortals(builder);
+        buildPortalMightSee(builder);
+        buildPortalVis(builder);
+        buildLeafSets(builder);
+        const auto endTime = std::chrono::steady_clock::now();
+
+        if (Config::gbVerifyPvs) {
+            std::printf(
+                "Built the PVS for map %u in %.2f sec: %u subsectors, %u portals, %u portals hit the flow limit\n",
+                mapNum,
+                std::chrono::duration<double>(endTime - startTime).count(),
+                gNumLeaves,
+                (uint32_t) builder.portals.size(),
+                builder.numFlowOverflows
+            );
+        }
+
+        writeCacheFile(mapNum, geometryHash);
+    }
+
+    gbPvsAvailable = true;
+}
+
+void shutdown() noexcept {
+    gbPvsAvailable = false;
+    gNumLeaves = 0;
+    gNumRowWords = 0;
+    gRenderPvs.clear();
+    gRenderPvs.shrink_to_fit();
+    gSightPvs.clear();
+    gSightPvs.shrink_to_fit();
+    gLeafEdges.clear();
+    gLeafEdges.shrink_to_fit();
+    gLeafEdgesStart.clear();
+    gLeafEdgesStart.shrink_to_fit();
+    gVisibleNodes.clear();
+    gVisibleNodes.shrink_to_fit();
+    gVisibleNodesLeaf = UINT32_MAX;
+}
+
+bool getBspVisibility(const Fixed x, const Fixed y, BspVisibility& visibility) noexcept {
+    if ((!gbPvsAvailable) || (!Config::gbUsePvs))
+        return false;
+
+    // Only use the PVS if the point is actually inside the leaf that it is in the BSP cell of (e.g not in a wall with noclip)
+    const uint32_t leafIdx = (uint32_t)(&PointInSubsector(x, y) - gpSubSectors);
+
+    if (!isPointInLeaf(leafIdx, fixed16ToFloat(x), fixed16ToFloat(y), RENDER_LEAF_TOLERANCE))
+        return false;
+
+    const uint64_t* const pVisibleLeaves = gRenderPvs.data() + (size_t) leafIdx * gNumRowWords;
+
+    if (leafIdx != gVisibleNodesLeaf) {
+        markVisibleNodes(gBspRootChild, pVisibleLeaves);
+        gVisibleNodesLeaf = leafIdx;
+    }
+
+    visibility.pVisibleLeaves = pVisibleLeaves;
+    visibility.pVisibleNodes = gVisibleNodes.data();
+    return true;
+}
+
+bool canThingsPossiblySee(const mobj_t& t1, const mobj_t& t2) noexcept {
+    if ((!gbPvsAvailable) || ((!Config::gbUsePvsForSight) && (!Config::gbVerifyPvs)))
+        return true;
+
+    const uint32_t leafIdx1 = (uint32_t)(t1.subsector - gpSubSectors);
+    const uint32_t leafIdx2 = (uint32_t)(t2.subsector - gpSubSectors);
+
+    if (isBitSet(gSightPvs.data() + (size_t) leafIdx1 * gNumRowWords, leafIdx2))
+        return true;
+
+    // Only trust the PVS if both things are actually inside the leaves they are linked to
+    return (
+        (!isPointInLeaf(leafIdx1, fixed16ToFloat(t1.x), fixed16ToFloat(t1.y), SIGHT_LEAF_TOLERANCE)) ||
+        (!isPointInLeaf(leafIdx2, fixed16ToFloat(t2.x), fixed16ToFloat(t2.y), SIGHT_LEAF_TOLERANCE))
+    );
+}
+
+END_NAMESPACE(Pvs)
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "MapData.h"
+
+struct mobj_t;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Potentially visible set (PVS) for the current map.
+//
+// For each subsector (leaf of the BSP tree) this holds a bitset of all the other subsectors which could possibly be seen from anywhere
+// inside it, going only by the one sided walls of the map. It is used by the renderer to skip parts of the BSP tree which can't be seen
+// from the view and by sight checks between things to reject pairs which can't possibly see each other, before tracing through the map.
+//
+// The sets are built when a map is first loaded and then cached to a file alongside the game data, keyed by map number and a hash of
+// the map geometry so that the file is rebuilt if the map data changes. Building works like the 'vis' tool for Quake, but in 2D:
+//
+//  (1) A convex polygon is found for each subsector by clipping the map bounds against the partition lines leading to it in the BSP
+//      tree and then against the lines of its own segs.
+//  (2) The edges of these polygons which are not covered by one sided walls are portals leading to the neighbouring subsectors.
+//  (3) For every portal, the subsectors which can be seen through it are found by flowing through the portals beyond, narrowing the
+//      range of lines which could pass through all of the portals so far until nothing more can be seen.
+//
+// Notes:
+//  (1) Sector heights are ignored since doors, lifts and so on can change them. Only one sided walls block visibility.
+//  (2) Sight checks use a version of the sets which is dilated by a few units, to allow for sight checks snapping their start and end
+//      points to the nearest odd map unit and for the rounding done when checking for crossed lines. The reject is also only applied
+//      when both things are actually inside the subsector they are linked to.
+//  (3) Since rejecting sight checks affects gameplay, it has its own setting ('UsePvsForSight') which is off by default. Rendering only
+//      uses the PVS when 'UsePvs' is enabled.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(Pvs)
+
+// Visibility of the BSP tree from a particular point, for the renderer
+struct BspVisibility {
+    const uint64_t*     pVisibleLeaves;     // Bitset of subsectors which might be visible
+    const uint8_t*      pVisibleNodes;      // For each BSP node: '1' if any subsector under the node might be visible
+};
+
+// Builds or loads the PVS for the map which has just been loaded and frees it
+void init(const uint32_t mapNum) noexcept;
+void shutdown() noexcept;
+
+// Gets the parts of the BSP tree which might be visible from the given point, for the renderer.
+// Returns 'false' if the PVS is not enabled for rendering or can't be used for the point, for example if it is outside of the map.
+bool getBspVisibility(const Fixed x, const Fixed y, BspVisibility& visibility) noexcept;
+
+// Tells if the given BSP child (in the format used by the flattened BSP tree) might be visible
+inline bool isBspChildVisible(const BspVisibility& visibility, const uint32_t child) noexcept {
+    if (child & BSP_CHILD_SUBSECTOR) {
+        const uint32_t leafIdx = child & ~BSP_CHILD_SUBSECTOR;
+        return ((visibility.pVisibleLeaves[leafIdx >> 6] >> (leafIdx & 63)) & 1);
+    } else {
+        return (visibility.pVisibleNodes[child] != 0);
+    }
+}
+
+// Tells if the first thing might be able to see the second thing, going by the PVS.
+// Returns 'true' if the PVS is not available, not enabled for sight checks or can't be used for either thing.
+bool canThingsPossiblySee(const mobj_t& t1, const mobj_t& t2) noexcept;
+
+END_NAMESPACE(Pvs)
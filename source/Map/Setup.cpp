@@ -10,6 +10,8 @@
 #include "GFX/Sprites.h"
 #include "GFX/Textures.h"
 #include "MapData.h"
+#include "MapQueryContext.h"
+#include "Pvs.h"
 #include "Specials.h"
 #include "Switch.h"
 #include "Things/MapObj.h"
@@ -316,6 +318,8 @@ void SetupLevel(const uint32_t map) noexcept {
     InitThinkers();         // Zap the think logics
     mapDataInit(map);       // Loads all map geometry, bsp, reject matrix etc. (everything except things)
     GroupLines();           // Final last minute data arranging
+    Pvs::init(map);         // Load or build the potentially visible set for the map
+    gMapQueryContext.init();
 
     gpDeathmatch = gDeathmatchStarts;
 
@@ -330,6 +334,8 @@ void SetupLevel(const uint32_t map) noexcept {
 // Dispose of all memory allocated by loading a level
 //------------------------------------------------------------------------------------------------------------------------------------------
 void ReleaseMapMemory() noexcept {
+    gMapQueryContext.shutdown();
+    Pvs::shutdown();
     mapDataShutdown();
     MEM_FREE_AND_NULL(gppLineArrayBuffer);
     Textures::freeAll();
@@ -1,20 +1,188 @@
 #include "Sight.h"
 
+#include "Base/JobSystem.h"
+#include "Base/Profiler.h"
+#include "Game/Config.h"
 #include "Game/Data.h"
 #include "MapData.h"
+#include "MapQueryContext.h"
 #include "MapUtil.h"
+#include "Pvs.h"
 #include "Things/MapObj.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
-static Fixed        gSightZStart;       // Eye z of looker
-static Fixed        gTopSlope;
-static Fixed        gBottomSlope;       // Slopes to top and bottom of target
-static vector_t     gSTrace;            // From t1 to t2
-static Fixed        gT2x;
-static Fixed        gT2y;
-static int32_t      gT1xs;
-static int32_t      gT1ys;
-static int32_t      gT2xs;
-static int32_t      gT2ys;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// All of the state for tracing a single sight line through the BSP tree.
+// Since this is passed around rather than being global, several sight lines can be traced at once on different threads.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SightTrace {
+    Fixed               sightZStart;        // Eye z of looker
+    Fixed               topSlope;
+    Fixed               bottomSlope;        // Slopes to top and bottom of target
+    vector_t            strace;             // From t1 to t2
+    Fixed               t2x;
+    Fixed               t2y;
+    int32_t             t1xs;
+    int32_t             t1ys;
+    int32_t             t2xs;
+    int32_t             t2ys;
+    MapQueryContext*    pVisitCtx;          // If given, skip lines already visited in this context and mark the lines checked as visited
+    uint32_t            numBspNodesVisited;
+};
+
+// Statistics for the sight checks done during the current tick
+static uint32_t     gNumSightChecks;
+static uint32_t     gNumSightCacheHits;
+static uint32_t     gNumSightBspNodesVisited;
+static uint32_t     gNumBatchedSightChecks;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Cache of sight check results, which is only valid for the current tick.
+//
+// The result of tracing a sight line depends only on the start and end points (which are snapped to a grid of odd map units), the eye
+// height of the looker, the height range of the target, the subsectors the two things are in (for the PVS) and the floor and ceiling
+// heights of sectors. The key includes everything but the sector heights: instead the whole cache is invalidated whenever a sector height
+// changes (see 'markSectorHeightsChanged') and also at the start of every tick. Invalidation is done by changing the stamp that valid
+// entries must have, rather than clearing them.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct SightCacheEntry {
+    uint32_t    stamp;          // The entry is only valid if this matches 'gSightCacheStamp'
+    uint32_t    subsector1;
+    uint32_t    subsector2;
+    Fixed       t1x;            // Start and end points, snapped to the sight check grid
+    Fixed       t1y;
+    Fixed       t2x;
+    Fixed       t2y;
+    Fixed       zStart;         // Eye height of the looker
+    Fixed       topSlope;       // Initial slopes to the top and bottom of the target
+    Fixed       bottomSlope;
+    bool        bCanSee;        // Result of the sight check
+
+    bool hasSameKey(const SightCacheEntry& other) const noexcept {
+        return (
+            (subsector1 == other.subsector1) &&
+            (subsector2 == other.subsector2) &&
+            (t1x == other.t1x) &&
+            (t1y == other.t1y) &&
+            (t2x == other.t2x) &&
+            (t2y == other.t2y) &&
+            (zStart == other.zStart) &&
+            (topSlope == other.topSlope) &&
+            (bottomSlope == other.bottomSlope)
+        );
+    }
+};
+
+static constexpr uint32_t SIGHT_CACHE_SIZE = 1024;      // Must be a power of 2
+static constexpr uint32_t SIGHT_CACHE_MAX_PROBES = 4;   // How many entries after the one hashed to are searched before giving up
+
+static SightCacheEntry  gSightCache[SIGHT_CACHE_SIZE];
+static uint32_t         gSightCacheStamp = 1;
+static uint32_t         gSightCacheHeightsVersion;      // Value of 'gLastSectorHeightsVersion' when the current stamp was made
+
+static void invalidateSightCache() noexcept {
+    ++gSightCacheStamp;
+
+    // If the stamp wraps around then entries from long ago could become valid again, so clear them all out
+    if (gSightCacheStamp == 0) {
+        std::memset(gSightCache, 0, sizeof(gSightCache));
+        gSightCacheStamp = 1;
+    }
+
+    gSightCacheHeightsVersion = gLastSectorHeightsVersion;
+}
+
+static uint32_t getSightCacheHash(const SightCacheEntry& key) noexcept {
+    uint32_t hash = key.subsector1 * 0x9E3779B1u;
+    hash = (hash ^ key.subsector2) * 0x85EBCA77u;
+    hash = (hash ^ (uint32_t) key.t1x) * 0xC2B2AE3Du;
+    hash = (hash ^ (uint32_t) key.t1y) * 0x27D4EB2Fu;
+    hash = (hash ^ (uint32_t) key.t2x) * 0x165667B1u;
+    hash = (hash ^ (uint32_t) key.t2y) * 0x9E3779B1u;
+    hash = (hash ^ (uint32_t) key.zStart) * 0x85EBCA77u;
+    hash = (hash ^ (uint32_t) key.topSlope) * 0xC2B2AE3Du;
+    hash = (hash ^ (uint32_t) key.bottomSlope) * 0x27D4EB2Fu;
+    return hash ^ (hash >> 16);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Looks up the result of a sight check in the cache.
+// If not found, returns 'nullptr' and gives the entry that the result should be stored to.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static const SightCacheEntry* findInSightCache(const SightCacheEntry& key, SightCacheEntry*& pEntryToStore) noexcept {
+    // Sector heights changing makes everything in the cache out of date
+    if (gSightCacheHeightsVersion != gLastSectorHeightsVersion) {
+        invalidateSightCache();
+    }
+
+    const uint32_t hash = getSightCacheHash(key);
+    pEntryToStore = nullptr;
+
+    for (uint32_t probe = 0; probe < SIGHT_CACHE_MAX_PROBES; ++probe) {
+        SightCacheEntry& entry = gSightCache[(hash + probe) & (SIGHT_CACHE_SIZE - 1)];
+
+        if (entry.stamp != gSightCacheStamp) {
+            // Unused entry: the key can't be any further along
+            pEntryToStore = &entry;
+            return nullptr;
+        }
+
+        if (entry.hasSameKey(key))
+            return &entry;
+    }
+
+    // Cache is full around here: replace the entry that was hashed to
+    pEntryToStore = &gSightCache[hash & (SIGHT_CACHE_SIZE - 1)];
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Makes the cache key for a sight check from the eyes of t1 to any part of t2: this is everything that the result depends on, besides
+// the heights of sectors.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static SightCacheEntry makeSightCacheKey(const mobj_t& t1, const mobj_t& t2) noexcept {
+    SightCacheEntry key;
+    key.stamp = gSightCacheStamp;
+    key.subsector1 = (uint32_t)(t1.subsector - gpSubSectors);
+    key.subsector2 = (uint32_t)(t2.subsector - gpSubSectors);
+
+    // Make sure it never lies exactly on a vertex coordinate
+    key.t1x = (t1.x & ~0x1ffff) | 0x10000;
+    key.t1y = (t1.y & ~0x1ffff) | 0x10000;
+    key.t2x = (t2.x & ~0x1ffff) | 0x10000;
+    key.t2y = (t2.y & ~0x1ffff) | 0x10000;
+
+    key.zStart = t1.z + t1.height - (t1.height >> 2);
+    key.topSlope = t2.z + t2.height - key.zStart;
+    key.bottomSlope = t2.z - key.zStart;
+    key.bCanSee = false;
+    return key;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sets up the trace for a sight check from the cache key for it
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void initSightTrace(SightTrace& trace, const SightCacheEntry& key, MapQueryContext* const pVisitCtx) noexcept {
+    trace.sightZStart = key.zStart;
+    trace.topSlope = key.topSlope;
+    trace.bottomSlope = key.bottomSlope;
+    trace.strace.x = key.t1x;
+    trace.strace.y = key.t1y;
+    trace.t2x = key.t2x;
+    trace.t2y = key.t2y;
+    trace.strace.dx = key.t2x - key.t1x;
+    trace.strace.dy = key.t2y - key.t1y;
+    trace.t1xs = key.t1x >> 16;
+    trace.t1ys = key.t1y >> 16;
+    trace.t2xs = key.t2x >> 16;
+    trace.t2ys = key.t2y >> 16;
+    trace.pVisitCtx = pVisitCtx;
+    trace.numBspNodesVisited = 0;
+}
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // First checks the endpoints of the line to make sure that they cross the sight trace
@@ -23,7 +191,7 @@ static int32_t      gT2ys;
 // If so, it calculates the fractional distance along the sight trace that the intersection occurs at.
 // If 0 < intercept < 1.0, the line will block the sight.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static Fixed PS_SightCrossLine(line_t& line) noexcept {
+static Fixed PS_SightCrossLine(const SightTrace& trace, const line_t& line) noexcept {
     // p1, p2 are line endpoints
     const int32_t p1x = line.v1.x >> 16;
     const int32_t p1y = line.v1.y >> 16;
@@ -31,10 +199,10 @@ static Fixed PS_SightCrossLine(line_t& line) noexcept {
     const int32_t p2y = line.v2.y >> 16;
 
     // p3, p4 are sight endpoints
-    const int32_t p3x = gT1xs;
-    const int32_t p3y = gT1ys;
-    const int32_t p4x = gT2xs;
-    const int32_t p4y = gT2ys;
+    const int32_t p3x = trace.t1xs;
+    const int32_t p3y = trace.t1ys;
+    const int32_t p4x = trace.t2xs;
+    const int32_t p4y = trace.t2ys;
 
     int32_t dx = p2x - p3x;
     int32_t dy = p2y - p3y;
@@ -68,9 +236,12 @@ static Fixed PS_SightCrossLine(line_t& line) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Returns true if strace crosses the given subsector successfuly
+// Returns true if strace crosses the given subsector successfuly.
+//
+// Note: when not marking lines, a line may be checked a 2nd time from the subsector on its other side. This gives the same result as
+// skipping it, since checking the same line again can never narrow the slopes any further.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PS_CrossSubsector(const subsector_t& sub) noexcept {
+static bool PS_CrossSubsector(SightTrace& trace, const subsector_t& sub) noexcept {
     // Check lines
     seg_t* pSeg = sub.firstline;
 
@@ -78,12 +249,11 @@ static bool PS_CrossSubsector(const subsector_t& sub) noexcept {
         ASSERT(pSeg->linedef);
         line_t& line = *pSeg->linedef;
 
-        if (line.validCount == gValidCount) {
+        if (trace.pVisitCtx && trace.pVisitCtx->testAndMarkLine(line)) {
             continue;   // Allready checked other side
         }
 
-        line.validCount = gValidCount;
-        Fixed frac = PS_SightCrossLine(line);
+        Fixed frac = PS_SightCrossLine(trace, line);
 
         if (frac < 4 || frac > FRACUNIT) {
             continue;
@@ -127,20 +297,20 @@ static bool PS_CrossSubsector(const subsector_t& sub) noexcept {
         frac >>= 2;
 
         if (pFront->floorheight != pBack->floorheight) {
-            const Fixed slope = (((openbottom - gSightZStart) << 6) / frac) << 8;
-            if (slope > gBottomSlope) {
-                gBottomSlope = slope;
+            const Fixed slope = (((openbottom - trace.sightZStart) << 6) / frac) << 8;
+            if (slope > trace.bottomSlope) {
+                trace.bottomSlope = slope;
             }
         }
 
         if (pFront->ceilingheight != pBack->ceilingheight) {
-            const Fixed slope = (((opentop - gSightZStart) << 6) / frac) << 8;
-            if (slope < gTopSlope) {
-                gTopSlope = slope;
+            const Fixed slope = (((opentop - trace.sightZStart) << 6) / frac) << 8;
+            if (slope < trace.topSlope) {
+                trace.topSlope = slope;
             }
         }
 
-        if (gTopSlope <= gBottomSlope) {
+        if (trace.topSlope <= trace.bottomSlope) {
             return false;   // Stop
         }
     }
@@ -149,34 +319,171 @@ static bool PS_CrossSubsector(const subsector_t& sub) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Returns true if strace crosses the given node successfuly
+// Returns true if strace crosses the flattened BSP tree successfully.
+//
+// Visits subsectors in the same order as the original recursive version: cross the side of each node the start point is on first and
+// then, if the end point is on the other side, cross that side too. Instead of recursing, the other side of each node passed through is
+// pushed onto a small fixed size stack and checked against the end point when popped. Stops at the first subsector which blocks sight.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool PS_CrossBspTree(SightTrace& trace) noexcept {
+    const vector_t* const pLines = gpBspLines;
+    const uint32_t* const pChildren = gpBspChildren;
+
+    uint32_t endSides[BSP_MAX_DEPTH];       // Side not containing the start point, for each node passed through: 'node index * 2 + side'
+    uint32_t numEndSides = 0;
+    uint32_t child = gBspRootChild;
+
+    while (true) {
+        // Go down the sides the start point is on until a subsector is reached, remembering the other sides for later
+        while ((child & BSP_CHILD_SUBSECTOR) == 0) {
+            trace.numBspNodesVisited++;
+            const uint32_t side = PointOnVectorSide(trace.strace.x, trace.strace.y, pLines[child]);
+            ASSERT(numEndSides < BSP_MAX_DEPTH);
+            endSides[numEndSides++] = child * 2 + (side ^ 1);
+            child = pChildren[child * 2 + side];
+        }
+
+        // Cross the subsector
+        if (!PS_CrossSubsector(trace, gpSubSectors[child & ~BSP_CHILD_SUBSECTOR]))
+            return false;
+
+        // Cross the next ending side where the partition plane is crossed, if any
+        uint32_t endSide;
+
+        do {
+            if (numEndSides == 0)
+                return true;
+
+            endSide = endSides[--numEndSides];
+        } while (PointOnVectorSide(trace.t2x, trace.t2y, pLines[endSide >> 1]) != (endSide & 1));
+
+        child = pChildren[endSide];
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Returns true if strace crosses the given node successfuly.
+// This is the original recursive traversal of the BSP tree, which is now only used for benchmarking against 'PS_CrossBspTree'.
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PS_CrossBSPNode(node_t* const pNode) noexcept {
+static bool PS_CrossBSPNode(SightTrace& trace, node_t* const pNode) noexcept {
     if (isBspNodeASubSector(pNode)) {
         // N.B: pointer has to be fixed up due to prescence of a flag in the lowest bit!
         subsector_t* const pSubSector = (subsector_t*) getActualBspNodePtr(pNode);
-        return PS_CrossSubsector(*pSubSector);
+        return PS_CrossSubsector(trace, *pSubSector);
     }
 
     // Decide which side the start point is on
-    const bool side = PointOnVectorSide(gSTrace.x, gSTrace.y, pNode->Line);
+    trace.numBspNodesVisited++;
+    const bool side = PointOnVectorSide(trace.strace.x, trace.strace.y, pNode->Line);
 
     // Cross the starting side
-    if (!PS_CrossBSPNode((node_t*) pNode->Children[side]))
+    if (!PS_CrossBSPNode(trace, (node_t*) pNode->Children[side]))
         return false;
     
     // The partition plane is crossed here
-    if (side == PointOnVectorSide(gT2x, gT2y, pNode->Line))
+    if (side == PointOnVectorSide(trace.t2x, trace.t2y, pNode->Line))
         return true;    // The line doesn't touch the other side
     
     // Cross the ending side
-    return PS_CrossBSPNode((node_t*) pNode->Children[side ^ 1]);
+    return PS_CrossBSPNode(trace, (node_t*) pNode->Children[side ^ 1]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Benchmarking for the flattened BSP tree traversal against the original recursive one, enabled by '[Debug] BenchmarkBspTraversal'.
+// Each sight check is done both ways, starting from the same state, and the averaged timings are printed every so often along with the
+// number of checks where the two gave different results (which should always be zero).
+//------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr uint32_t SIGHT_BENCHMARK_NUM_CHECKS = 4096;
+
+static uint64_t     gSightBenchmarkRecursiveNs;
+static uint64_t     gSightBenchmarkFlatNs;
+static uint32_t     gSightBenchmarkNumChecks;
+static uint32_t     gSightBenchmarkNumMismatches;
+
+static bool benchmarkCrossBspTree(SightTrace& trace) noexcept {
+    // Both traversals narrow the slopes as they go, so give the 1st one a copy of the trace to start from the same state.
+    // If marking lines then the visits must also be restarted so that lines checked by the 1st traversal are not skipped by the 2nd.
+    SightTrace recursiveTrace = trace;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const bool bRecursiveResult = PS_CrossBSPNode(recursiveTrace, gpBSPTreeRoot);
+    const auto midTime = std::chrono::steady_clock::now();
+
+    if (trace.pVisitCtx) {
+        trace.pVisitCtx->beginVisits();
+    }
+
+    const auto flatStartTime = std::chrono::steady_clock::now();
+    const bool bFlatResult = PS_CrossBspTree(trace);
+    const auto endTime = std::chrono::steady_clock::now();
+
+    gSightBenchmarkRecursiveNs += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(midTime - startTime).count();
+    gSightBenchmarkFlatNs += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - flatStartTime).count();
+    gSightBenchmarkNumMismatches += (bRecursiveResult != bFlatResult) ? 1 : 0;
+    gSightBenchmarkNumChecks++;
+
+    if (gSightBenchmarkNumChecks >= SIGHT_BENCHMARK_NUM_CHECKS) {
+        const double recursiveNSec = (double) gSightBenchmarkRecursiveNs / (double) gSightBenchmarkNumChecks;
+        const double flatNSec = (double) gSightBenchmarkFlatNs / (double) gSightBenchmarkNumChecks;
+        std::printf(
+            "Sight BSP traversal benchmark (%u nodes, %u checks avg): recursive %.1f nsec, flat %.1f nsec, flat speedup %.2fx, %u mismatches\n",
+            gNumBspNodes,
+            gSightBenchmarkNumChecks,
+            recursiveNSec,
+            flatNSec,
+            (flatNSec > 0.0) ? recursiveNSec / flatNSec : 0.0,
+            gSightBenchmarkNumMismatches
+        );
+
+        gSightBenchmarkRecursiveNs = 0;
+        gSightBenchmarkFlatNs = 0;
+        gSightBenchmarkNumChecks = 0;
+        gSightBenchmarkNumMismatches = 0;
+    }
+
+    return bFlatResult;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Sight checks which are queued up to be done all at once, in parallel.
+// The results of these go into the sight cache, where 'CheckSight' finds them later in the tick.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static constexpr uint32_t MIN_SIGHT_CHECKS_PER_JOB = 8;     // Don't bother splitting up the batch any finer than this
+
+struct QueuedSightCheck {
+    SightCacheEntry     key;                    // What to check: the result is filled in when the check is done
+    uint32_t            numBspNodesVisited;
+};
+
+static std::vector<QueuedSightCheck> gQueuedSightChecks;
+
+struct SightCheckJobs {
+    QueuedSightCheck*   pChecks;
+    uint32_t            numChecks;
+    uint32_t            checksPerJob;
+};
+
+static void sightCheckJob(const uint32_t jobIdx, void* const pUserData) noexcept {
+    const SightCheckJobs& jobs = *(const SightCheckJobs*) pUserData;
+    const uint32_t startIdx = jobIdx * jobs.checksPerJob;
+    const uint32_t endIdx = std::min(startIdx + jobs.checksPerJob, jobs.numChecks);
+
+    // Note: the BSP tree, lines and sectors are only read here, so it's safe to do many checks at once
+    for (uint32_t i = startIdx; i < endIdx; ++i) {
+        QueuedSightCheck& check = jobs.pChecks[i];
+        SightTrace trace;
+        initSightTrace(trace, check.key, nullptr);
+        check.key.bCanSee = PS_CrossBspTree(trace);
+        check.numBspNodesVisited = trace.numBspNodesVisited;
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Returns true if a straight line between t1 and t2 is unobstructed
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool CheckSight(mobj_t& t1, mobj_t& t2, const bool bUseRejectMap) noexcept {
+bool CheckSight(mobj_t& t1, mobj_t& t2, const bool bUseRejectMap, MapQueryContext* const pVisitCtx) noexcept {
+    gNumSightChecks++;
+
     // Check for trivial rejection.
     // DC: Made this check optional however, because it is not entirely reliable for the 3DO map data...
     if (bUseRejectMap) {
@@ -192,25 +499,120 @@ bool CheckSight(mobj_t& t1, mobj_t& t2, const bool bUseRejectMap) noexcept {
         }
     }
 
-    // Look from eyes of t1 to any part of t2
-    ++gValidCount;
+    // Quick rejection using the potentially visible set for the map, if enabled for sight checks.
+    // When verifying the PVS the full check is still done, and its result is what gets used.
+    const bool bPvsRejected = (!Pvs::canThingsPossiblySee(t1, t2));
 
-    // Make sure it never lies exactly on a vertex coordinate
-    gSTrace.x = (t1.x & ~0x1ffff) | 0x10000;
-    gSTrace.y = (t1.y & ~0x1ffff) | 0x10000;
-    gT2x = (t2.x & ~0x1ffff) | 0x10000;
-    gT2y = (t2.y & ~0x1ffff) | 0x10000;
-    gSTrace.dx = gT2x - gSTrace.x;
-    gSTrace.dy = gT2y - gSTrace.y;
-
-    gT1xs = gSTrace.x >> 16;
-    gT1ys = gSTrace.y >> 16;
-    gT2xs = gT2x >> 16;
-    gT2ys = gT2y >> 16;
-
-    gSightZStart = t1.z + t1.height - (t1.height >> 2);
-    gTopSlope = t2.z + t2.height - gSightZStart;
-    gBottomSlope = t2.z - gSightZStart;
-
-    return PS_CrossBSPNode(gpBSPTreeRoot);
+    if (bPvsRejected && (!Config::gbVerifyPvs))
+        return false;
+
+    // Look from eyes of t1 to any part of t2.
+    // See if the same check has already been done this tick. Don't use the cache when benchmarking or verifying the PVS, since the
+    // traversal must actually be done then. Also don't use it when the line marks of the original check are needed by the caller.
+    SightCacheEntry key = makeSightCacheKey(t1, t2);
+    const bool bUseCache = ((!bPvsRejected) && (!Config::gbBenchmarkBspTraversal) && (!pVisitCtx));
+    SightCacheEntry* pEntryToStore = nullptr;
+
+    if (bUseCache) {
+        if (const SightCacheEntry* const pCachedEntry = findInSightCache(key, pEntryToStore)) {
+            gNumSightCacheHits++;
+            return pCachedEntry->bCanSee;
+        }
+    }
+
+    if (pVisitCtx) {
+        pVisitCtx->beginVisits();
+    }
+
+    SightTrace trace;
+    initSightTrace(trace, key, pVisitCtx);
+    const bool bCanSee = (Config::gbBenchmarkBspTraversal) ? benchmarkCrossBspTree(trace) : PS_CrossBspTree(trace);
+    gNumSightBspNodesVisited += trace.numBspNodesVisited;
+
+    if (pEntryToStore) {
+        key.stamp = gSightCacheStamp;
+        key.bCanSee = bCanSee;
+        *pEntryToStore = key;
+    }
+
+    if (bPvsRejected && bCanSee) {
+        std::printf(
+            "PVS verify: sight wrongly rejected between subsectors %u and %u!\n",
+            (uint32_t)(t1.subsector - gpSubSectors),
+            (uint32_t)(t2.subsector - gpSubSectors)
+        );
+    }
+
+    return bCanSee;
+}
+
+void QueueSightCheck(mobj_t& t1, mobj_t& t2) noexcept {
+    // Checks which 'CheckSight' would never look up in the cache are not worth doing
+    if (Config::gbBenchmarkBspTraversal)
+        return;
+
+    if (!Pvs::canThingsPossiblySee(t1, t2))
+        return;
+
+    // Don't queue checks which have already been done this tick
+    QueuedSightCheck check;
+    check.key = makeSightCacheKey(t1, t2);
+    check.numBspNodesVisited = 0;
+
+    SightCacheEntry* pEntryToStore = nullptr;
+
+    if (findInSightCache(check.key, pEntryToStore))
+        return;
+
+    gQueuedSightChecks.push_back(check);
+}
+
+void RunQueuedSightChecks() noexcept {
+    PROFILE_SCOPE("RunQueuedSightChecks");
+    const uint32_t numChecks = (uint32_t) gQueuedSightChecks.size();
+
+    if (numChecks == 0)
+        return;
+
+    // Split the checks up amongst the available threads, if there are enough of them to make that worthwhile
+    const uint32_t maxJobs = std::max(numChecks / MIN_SIGHT_CHECKS_PER_JOB, 1u);
+    const uint32_t numJobsWanted = std::min(JobSystem::getNumThreads(), maxJobs);
+
+    SightCheckJobs jobs = {};
+    jobs.pChecks = gQueuedSightChecks.data();
+    jobs.numChecks = numChecks;
+    jobs.checksPerJob = (numChecks + numJobsWanted - 1) / numJobsWanted;
+
+    const uint32_t numJobs = (numChecks + jobs.checksPerJob - 1) / jobs.checksPerJob;
+    JobSystem::runJobs(sightCheckJob, &jobs, numJobs);
+
+    // Put the results into the cache, in the same order the checks were queued in
+    for (const QueuedSightCheck& check : gQueuedSightChecks) {
+        SightCacheEntry* pEntryToStore = nullptr;
+
+        if (!findInSightCache(check.key, pEntryToStore)) {
+            *pEntryToStore = check.key;
+            pEntryToStore->stamp = gSightCacheStamp;
+        }
+
+        gNumSightBspNodesVisited += check.numBspNodesVisited;
+    }
+
+    gNumBatchedSightChecks += numChecks;
+    gQueuedSightChecks.clear();
+}
+
+void BeginSightTick() noexcept {
+    invalidateSightCache();
+    gNumSightChecks = 0;
+    gNumSightCacheHits = 0;
+    gNumSightBspNodesVisited = 0;
+    gNumBatchedSightChecks = 0;
+}
+
+void SetSightCounters() noexcept {
+    Profiler::setCounter("SightChecks", (int64_t) gNumSightChecks);
+    Profiler::setCounter("SightCacheHits", (int64_t) gNumSightCacheHits);
+    Profiler::setCounter("SightBspNodes", (int64_t) gNumSightBspNodesVisited);
+    Profiler::setCounter("SightBatchedChecks", (int64_t) gNumBatchedSightChecks);
 }
@@ -1,8 +1,26 @@
 #pragma once
 
+struct MapQueryContext;
 struct mobj_t;
 
 // DC: Note - made use of the reject map optional, as it appears to be an unreliable check in some cases.
 // I made the mistake of trying to use the reject LUT for shooting line of sight calculations, and boy was I sorry...
 // I don't know why the reject is so unreliable on the 3DO maps, perhaps down to bugs in whatever node builder was used?
-bool CheckSight(mobj_t& t1, mobj_t& t2, const bool bUseRejectMap) noexcept;
+//
+// Note: the result may come from a cache of sight checks done earlier in the same tick. Callers that are in the middle of their own
+// traversal of the map (e.g. shooting) must instead pass the context for that traversal as 'pVisitCtx', which always does the original
+// full check: restarting the visits of the context and marking the lines checked as visited. The traversal then continues from there,
+// which affects what it visits, so this needs to be kept for demo compatibility.
+bool CheckSight(mobj_t& t1, mobj_t& t2, const bool bUseRejectMap, MapQueryContext* const pVisitCtx) noexcept;
+
+// Batched sight checks: sight checks which are known to be coming up later in the tick can be queued and then done all at once, in
+// parallel. The results go into the cache used by 'CheckSight', which only uses them if the things involved have not moved since.
+void QueueSightCheck(mobj_t& t1, mobj_t& t2) noexcept;
+void RunQueuedSightChecks() noexcept;
+
+// Starts a new game tick for sight checks, discarding sight check results cached during the previous tick
+void BeginSightTick() noexcept;
+
+// Reports how many sight checks were done this tick, how many were answered from the cache, how many were batched and how many BSP
+// nodes were visited
+void SetSightCounters() noexcept;
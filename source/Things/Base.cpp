@@ -6,29 +6,17 @@
 #include "Game/Tick.h"
 #include "Info.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "Map/Sight.h"
 #include "MapObj.h"
+#include "MObjTable.h"
 #include <algorithm>
 
-static mobj_t*          gpCheckThingMo;         // Used for PB_CheckThing
-static Fixed            gTestX;
-static Fixed            gTestY;
-static Fixed            gTestFloorZ;
-static Fixed            gTestCeilingZ;
-static Fixed            gTestDropoffZ;
-static subsector_t*     gpTestSubSec;
-static line_t*          gpCeilingLine;
-static mobj_t*          gpHitThing;
-static Fixed            gTestBBox[4];           // Bounding box for tests
-static uint32_t         gTestFlags;
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Float up or down at a set speed, used by flying monsters
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void FloatChange(mobj_t& mo) noexcept {
-    ASSERT(mo.target);
-    mobj_t& target = *mo.target;                                                // Get the target object
+static void FloatChange(mobj_t& mo, const mobj_t& target) noexcept {
     Fixed delta = (target.z + (mo.height >> 1)) - mo.z;                         // Get the height differance
     const Fixed dist = GetApproxDistance(target.x - mo.x, target.y - mo.y);     // Distance to target
     delta = delta * 3;                                                          // Mul by 3 for a fudge factor
@@ -55,8 +43,10 @@ static bool P_ZMovement(mobj_t& mo) noexcept {
     // Apply basic z motion:
     mo.z += fixed16Div(mo.momz, 2 * FRACUNIT);    
 
-    if (((mo.flags & MF_FLOAT) != 0) && mo.target) {    // float down towards target if too close
-        FloatChange(mo);
+    mobj_t* const pTarget = getTarget(mo);
+
+    if (((mo.flags & MF_FLOAT) != 0) && pTarget) {      // float down towards target if too close
+        FloatChange(mo, *pTarget);
     }
 
     // Clip movement
@@ -92,11 +82,11 @@ static bool P_ZMovement(mobj_t& mo) noexcept {
     return false;
 }
 
-static bool PB_BoxCrossLine(line_t& ld) noexcept {    
-    if ((gTestBBox[BOXRIGHT] <= ld.bbox[BOXLEFT]) ||
-        (gTestBBox[BOXLEFT] >= ld.bbox[BOXRIGHT]) ||
-        (gTestBBox[BOXTOP] <= ld.bbox[BOXBOTTOM]) ||
-        (gTestBBox[BOXBOTTOM] >= ld.bbox[BOXTOP])
+static bool PB_BoxCrossLine(MapQueryContext& ctx, line_t& ld) noexcept {    
+    if ((ctx.testBBox[BOXRIGHT] <= ld.bbox[BOXLEFT]) ||
+        (ctx.testBBox[BOXLEFT] >= ld.bbox[BOXRIGHT]) ||
+        (ctx.testBBox[BOXTOP] <= ld.bbox[BOXBOTTOM]) ||
+        (ctx.testBBox[BOXBOTTOM] >= ld.bbox[BOXTOP])
     ) {
         return false;
     }
@@ -105,11 +95,11 @@ static bool PB_BoxCrossLine(line_t& ld) noexcept {
     Fixed x2;
     
     if (ld.slopetype == ST_POSITIVE) {
-        x1 = gTestBBox[BOXLEFT];
-        x2 = gTestBBox[BOXRIGHT];
+        x1 = ctx.testBBox[BOXLEFT];
+        x2 = ctx.testBBox[BOXRIGHT];
     } else {
-        x1 = gTestBBox[BOXRIGHT];
-        x2 = gTestBBox[BOXLEFT];
+        x1 = ctx.testBBox[BOXRIGHT];
+        x2 = ctx.testBBox[BOXLEFT];
     }
 
     const Fixed lx = ld.v1.x;
@@ -118,9 +108,9 @@ static bool PB_BoxCrossLine(line_t& ld) noexcept {
     const Fixed ldy = (ld.v2.y - ld.v1.y) >> 16;
 
     const Fixed dx1 = (x1 - lx) >> 16;
-    const Fixed dy1 = (gTestBBox[BOXTOP] - ly) >> 16;
+    const Fixed dy1 = (ctx.testBBox[BOXTOP] - ly) >> 16;
     const Fixed dx2 = (x2 - lx) >> 16;
-    const Fixed dy2 = (gTestBBox[BOXBOTTOM] - ly) >> 16;
+    const Fixed dy2 = (ctx.testBBox[BOXBOTTOM] - ly) >> 16;
 
     const bool bSide1 = (ldy * dx1 < dy1 * ldx);
     const bool bSide2 = (ldy * dx2 < dy2 * ldx);
@@ -130,7 +120,7 @@ static bool PB_BoxCrossLine(line_t& ld) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Adjusts testfloorz and testceilingz as lines are contacted
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PB_CheckLine(line_t& ld) noexcept {
+static bool PB_CheckLine(MapQueryContext& ctx, line_t& ld) noexcept {
     Fixed opentop, openbottom;
     Fixed lowfloor;
     sector_t    *front, *back;
@@ -141,7 +131,7 @@ static bool PB_CheckLine(line_t& ld) noexcept {
         return false;   // One sided line
     }
 
-    if (((gTestFlags & MF_MISSILE) == 0) && ((ld.flags & (ML_BLOCKING|ML_BLOCKMONSTERS)) != 0)) {
+    if (((ctx.testFlags & MF_MISSILE) == 0) && ((ld.flags & (ML_BLOCKING|ML_BLOCKMONSTERS)) != 0)) {
         return false;   // Explicitly blocking
     }
     
@@ -163,39 +153,39 @@ static bool PB_CheckLine(line_t& ld) noexcept {
     }
 
     // Adjust floor / ceiling heights
-    if (opentop < gTestCeilingZ) {
-        gTestCeilingZ = opentop;
-        gpCeilingLine = &ld;
+    if (opentop < ctx.testCeilingZ) {
+        ctx.testCeilingZ = opentop;
+        ctx.pCeilingLine = &ld;
     }
 
-    if (openbottom > gTestFloorZ) {
-        gTestFloorZ = openbottom;
+    if (openbottom > ctx.testFloorZ) {
+        ctx.testFloorZ = openbottom;
     }
 
-    if (lowfloor < gTestDropoffZ) {
-        gTestDropoffZ = lowfloor;
+    if (lowfloor < ctx.testDropoffZ) {
+        ctx.testDropoffZ = lowfloor;
     }
 
     return true;
 }
 
-static bool PB_CrossCheck(line_t& ld) noexcept {
-    if (PB_BoxCrossLine(ld)) {
-        if (!PB_CheckLine(ld)) {
+static bool PB_CrossCheck(MapQueryContext& ctx, line_t& ld) noexcept {
+    if (PB_BoxCrossLine(ctx, ld)) {
+        if (!PB_CheckLine(ctx, ld)) {
             return false;
         }
     }
     return true;
 }
 
-static bool PB_CheckThing(mobj_t& thing) noexcept {
+static bool PB_CheckThing(MapQueryContext& ctx, mobj_t& thing) noexcept {
     if ((thing.flags & MF_SOLID) == 0) {
         return true;
     }
 
-    mobj_t& mo = *gpCheckThingMo;
+    mobj_t& mo = *ctx.pCheckThingMo;
     const Fixed blockdist = thing.radius + mo.radius;
-    Fixed delta = thing.x - gTestX;
+    Fixed delta = thing.x - ctx.testX;
 
     if (delta < 0) {
         delta = -delta;
@@ -205,7 +195,7 @@ static bool PB_CheckThing(mobj_t& thing) noexcept {
         return true;    // Didn't hit it
     }
 
-    delta = thing.y - gTestY;
+    delta = thing.y - ctx.testY;
 
     if (delta < 0) {
         delta = -delta;
@@ -220,13 +210,13 @@ static bool PB_CheckThing(mobj_t& thing) noexcept {
     }
     
     // Check for skulls slamming into things
-    if ((gTestFlags & MF_SKULLFLY) != 0) {
-        gpHitThing = &thing;
+    if ((ctx.testFlags & MF_SKULLFLY) != 0) {
+        ctx.pHitThing = &thing;
         return false;   // Stop moving
     }
 
     // Missiles can hit other things
-    if ((gTestFlags & MF_MISSILE) != 0) {
+    if ((ctx.testFlags & MF_MISSILE) != 0) {
         // See if it went over / under
         if (mo.z > thing.z + thing.height) {
             return true;    // Overhead
@@ -236,8 +226,10 @@ static bool PB_CheckThing(mobj_t& thing) noexcept {
             return true;    // Underneath
         }
 
-        if (mo.target->InfoPtr == thing.InfoPtr) {    // don't hit same species as originator
-            if (&thing == mo.target) {
+        const mobj_t* const pShooter = getTarget(mo);
+
+        if (pShooter && (pShooter->InfoPtr == thing.InfoPtr)) {     // don't hit same species as originator
+            if (&thing == pShooter) {
                 return true;    // Don't explode on shooter
             }
 
@@ -253,7 +245,7 @@ static bool PB_CheckThing(mobj_t& thing) noexcept {
         }
 
         // Damage / explode
-        gpHitThing = &thing;
+        ctx.pHitThing = &thing;
         return false;           // Don't traverse any more
     }
 
@@ -273,31 +265,31 @@ static bool PB_CheckThing(mobj_t& thing) noexcept {
 //      testdropoffz    the lowest point contacted (monsters won't move to a dropoff)
 //      hitthing
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PB_CheckPosition(mobj_t& mo) noexcept {
-    gTestFlags = mo.flags;
+static bool PB_CheckPosition(MapQueryContext& ctx, mobj_t& mo) noexcept {
+    ctx.testFlags = mo.flags;
 
     const Fixed radius = mo.radius;
-    gTestBBox[BOXTOP] = gTestY + radius;
-    gTestBBox[BOXBOTTOM] = gTestY - radius;
-    gTestBBox[BOXRIGHT] = gTestX + radius;
-    gTestBBox[BOXLEFT] = gTestX - radius;
+    ctx.testBBox[BOXTOP] = ctx.testY + radius;
+    ctx.testBBox[BOXBOTTOM] = ctx.testY - radius;
+    ctx.testBBox[BOXRIGHT] = ctx.testX + radius;
+    ctx.testBBox[BOXLEFT] = ctx.testX - radius;
 
     // The base floor / ceiling is from the subsector that contains the point.
     // Any contacted lines the step closer together will adjust them.
-    gpTestSubSec = &PointInSubsector(gTestX, gTestY);
-    gTestFloorZ = gTestDropoffZ = gpTestSubSec->sector->floorheight;
-    gTestCeilingZ = gpTestSubSec->sector->ceilingheight;
+    ctx.pTestSubSec = &PointInSubsector(ctx.testX, ctx.testY);
+    ctx.testFloorZ = ctx.testDropoffZ = ctx.pTestSubSec->sector->floorheight;
+    ctx.testCeilingZ = ctx.pTestSubSec->sector->ceilingheight;
 
-    ++gValidCount;
-    gpCeilingLine = nullptr;
-    gpHitThing = nullptr;
+    ctx.beginVisits();
+    ctx.pCeilingLine = nullptr;
+    ctx.pHitThing = nullptr;
 
     // The bounding box is extended by MAXRADIUS because mobj_ts are grouped into mapblocks based on their
     // origin point, and can overlap into adjacent blocks by up to MAXRADIUS units.
-    int32_t xl = (gTestBBox[BOXLEFT] - gBlockMapOriginX - MAXRADIUS) >> MAPBLOCKSHIFT;
-    int32_t xh = (gTestBBox[BOXRIGHT] - gBlockMapOriginX + MAXRADIUS) >> MAPBLOCKSHIFT;
-    int32_t yl = (gTestBBox[BOXBOTTOM] - gBlockMapOriginY - MAXRADIUS) >> MAPBLOCKSHIFT;
-    int32_t yh = (gTestBBox[BOXTOP] - gBlockMapOriginY + MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t xl = (ctx.testBBox[BOXLEFT] - gBlockMapOriginX - MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t xh = (ctx.testBBox[BOXRIGHT] - gBlockMapOriginX + MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t yl = (ctx.testBBox[BOXBOTTOM] - gBlockMapOriginY - MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t yh = (ctx.testBBox[BOXTOP] - gBlockMapOriginY + MAXRADIUS) >> MAPBLOCKSHIFT;
 
     xl = std::max(xl, 0);
     yl = std::max(yl, 0);
@@ -311,14 +303,14 @@ static bool PB_CheckPosition(mobj_t& mo) noexcept {
             yh = (int32_t) gBlockMapHeight - 1;
         }
 
-        gpCheckThingMo = &mo;   // Store for PB_CheckThing
+        ctx.pCheckThingMo = &mo;    // Store for PB_CheckThing
 
         for (uint32_t bx = (uint32_t) xl; bx <= (uint32_t) xh; bx++) {
             for (uint32_t by = (uint32_t) yl; by <= (uint32_t) yh; by++) {
-                if (!BlockThingsIterator(bx, by, PB_CheckThing))
+                if (!BlockThingsIterator(ctx, bx, by, PB_CheckThing))
                     return false;
                 
-                if (!BlockLinesIterator(bx, by, PB_CrossCheck))
+                if (!BlockLinesIterator(ctx, bx, by, PB_CrossCheck))
                     return false;
             }
         }
@@ -330,29 +322,29 @@ static bool PB_CheckPosition(mobj_t& mo) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Attempt to move to a new position
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PB_TryMove(const Fixed tryx, const Fixed tryy, mobj_t& mo) noexcept {
-    gTestX = tryx;
-    gTestY = tryy;
+static bool PB_TryMove(MapQueryContext& ctx, const Fixed tryx, const Fixed tryy, mobj_t& mo) noexcept {
+    ctx.testX = tryx;
+    ctx.testY = tryy;
 
-    if (!PB_CheckPosition(mo))
+    if (!PB_CheckPosition(ctx, mo))
         return false;   // Solid wall or thing
 
-    if (gTestCeilingZ - gTestFloorZ < mo.height)
+    if (ctx.testCeilingZ - ctx.testFloorZ < mo.height)
         return false;   // Doesn't fit
 
-    if (gTestCeilingZ - mo.z < mo.height)
+    if (ctx.testCeilingZ - mo.z < mo.height)
         return false;   // Mobj must lower itself to fit
     
-    if (gTestFloorZ - mo.z > 24 * FRACUNIT)
+    if (ctx.testFloorZ - mo.z > 24 * FRACUNIT)
         return false;   // Too big a step up
     
-    if (((gTestFlags & (MF_DROPOFF|MF_FLOAT)) == 0) && (gTestFloorZ - gTestDropoffZ > 24 * FRACUNIT))
+    if (((ctx.testFlags & (MF_DROPOFF|MF_FLOAT)) == 0) && (ctx.testFloorZ - ctx.testDropoffZ > 24 * FRACUNIT))
         return false;   // Don't stand over a dropoff
     
     // The move is ok, so link the thing into its new position
     UnsetThingPosition(mo);
-    mo.floorz = gTestFloorZ;
-    mo.ceilingz = gTestCeilingZ;
+    mo.floorz = ctx.testFloorZ;
+    mo.ceilingz = ctx.testCeilingZ;
     mo.x = tryx;
     mo.y = tryy;
     SetThingPosition(mo);
@@ -370,7 +362,7 @@ static Fixed capMoveAmountToMax(const Fixed moveAmount) noexcept {
     }
 }
 
-static bool P_XYMovement(mobj_t& mo) noexcept {   
+static bool P_XYMovement(MapQueryContext& ctx, mobj_t& mo) noexcept {   
     // DC: Note: added a division by 2 here to account for the move from a 35Hz timebase (PC) to a 60Hz timebase (3DO).
     // This fixes issues in the 3DO version with certain projectiles like imps fireballs moving too quickly.
     Fixed xleft = mo.momx & ~7;
@@ -385,21 +377,21 @@ static bool P_XYMovement(mobj_t& mo) noexcept {
         xleft -= xuse;
         yleft -= yuse;
 
-        if (!PB_TryMove(mo.x + xuse, mo.y + yuse, mo)) {
+        if (!PB_TryMove(ctx, mo.x + xuse, mo.y + yuse, mo)) {
             // Blocked move
             if ((mo.flags & MF_SKULLFLY) != 0) {
-                L_SkullBash(mo, gpHitThing);
+                L_SkullBash(mo, ctx.pHitThing);
                 return true;
             }
 
             if (mo.flags & MF_MISSILE) {    // Explode a missile
-                if (gpCeilingLine && gpCeilingLine->backsector && (gpCeilingLine->backsector->CeilingPic == UINT32_MAX)) {
+                if (ctx.pCeilingLine && ctx.pCeilingLine->backsector && (ctx.pCeilingLine->backsector->CeilingPic == UINT32_MAX)) {
                     // Hack to prevent missiles exploding against the sky
                     P_RemoveMobj(mo);
                     return true;
                 }
 
-                L_MissileHit(mo, gpHitThing);
+                L_MissileHit(mo, ctx.pHitThing);
                 return true;
             }
 
@@ -441,9 +433,9 @@ static bool P_XYMovement(mobj_t& mo) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Process all the critter logic
 //------------------------------------------------------------------------------------------------------------------------------------------
-static void P_MobjThinker(mobj_t& mobj) noexcept {
+static void P_MobjThinker(MapQueryContext& ctx, mobj_t& mobj) noexcept {
     if ((mobj.momx != 0) || (mobj.momy != 0)) {     // Any horizontal momentum?
-        if (P_XYMovement(mobj)) {                   // Move it
+        if (P_XYMovement(ctx, mobj)) {              // Move it
             return;                                 // Exit if state change
         }
     }
@@ -470,14 +462,13 @@ static void P_MobjThinker(mobj_t& mobj) noexcept {
         bSightFlag = false;             // Assume I don't see a target until proven otherwise
         mobj.flags &= ~MF_SEETARGET;
 
-        if (mobj.target) {
-            // DC: every so often (1/4 frames) do a direct line of sight test instead of trusting the reject map.
-            // The reject map appears to be very unreliable in the 3DO map data! This workaround prevents monsters
-            // from looking dumb for too long when we reach a deadzone in reject map, where two sectors are marked
-            // (invalidly) not visible to each other for some reason...
-            const bool bUseRejectMap = ((mobj.guid & 0x3) != (gTotalGameTicks & 0x3));
+        mobj_t* const pTarget = getTarget(mobj);
 
-            if (CheckSight(mobj, *mobj.target, false)) {
+        if (pTarget) {
+            // Note: the reject map is never used here, since it appears to be very unreliable in the 3DO map data and would leave
+            // monsters looking dumb in places where two sectors are (invalidly) marked as not visible to each other. Sight checks
+            // instead use the potentially visible set for the map, which is built to be conservative, for quick rejection.
+            if (CheckSight(mobj, *pTarget, false, nullptr)) {
                 mobj.flags |= MF_SEETARGET;
             }
         }
@@ -486,16 +477,72 @@ static void P_MobjThinker(mobj_t& mobj) noexcept {
     SetMObjState(mobj, mobj.state->nextstate);  // Next object state
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Tells if there are no objects which have not been removed at or after the given position in the map object table
+//------------------------------------------------------------------------------------------------------------------------------------------
+static bool isLastLiveMObj(const uint32_t nextOrderIdx) noexcept {
+    const uint32_t numEntries = MObjTable::getNumEntries();
+
+    for (uint32_t i = nextOrderIdx; i < numEntries; ++i) {
+        if (MObjTable::getEntry(i))
+            return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Finds the monsters which are going to check if they can see their target when they think this tick (see 'P_MobjThinker') and does all
+// of those sight checks up front, in parallel. When the monsters think they get the results from the sight cache, unless something has
+// moved or a sector height has changed in the meantime - in which case the check is just done again, so the outcome is always the same.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void P_PrecomputeMobjSight() noexcept {
+    const uint32_t numEntries = MObjTable::getNumEntries();
+
+    for (uint32_t i = 0; i < numEntries; ++i) {
+        mobj_t* const pMObj = MObjTable::getEntry(i);
+
+        if ((!pMObj) || pMObj->player)
+            continue;
+
+        mobj_t& mobj = *pMObj;
+
+        if ((mobj.tics == UINT32_MAX) || (mobj.tics > 1))   // Not changing state this tick?
+            continue;
+
+        if ((mobj.flags & MF_COUNTKILL) == 0)
+            continue;
+
+        if (mobj_t* const pTarget = getTarget(mobj)) {
+            QueueSightCheck(mobj, *pTarget);
+        }
+    }
+
+    RunQueuedSightChecks();
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Execute base think logic for the critters every tic
 //------------------------------------------------------------------------------------------------------------------------------------------
 void P_RunMobjBase() noexcept {
-    mobj_t* pMObj = gMObjHead.next;
-    while (pMObj != &gMObjHead) {
-        mobj_t* const pNext = pMObj->next;      // In case it's deleted!
-        if (!pMObj->player) {                   // Don't handle players
-            P_MobjThinker(*pMObj);              // Execute the code
-        }
-        pMObj = pNext;                          // Next in the list
+    MObjTable::compact();   // Squeeze out objects removed since the last time: nothing else is walking the table now
+    P_PrecomputeMobjSight();
+
+    // Note: objects spawned while thinking are added to the end and get to think this tick too, unless spawned by the last object to
+    // think. This matches how the old linked list of objects was walked, which kept the next object before calling the think code.
+    uint32_t orderIdx = 0;
+
+    while (orderIdx < MObjTable::getNumEntries()) {
+        mobj_t* const pMObj = MObjTable::getEntry(orderIdx);
+        ++orderIdx;
+
+        if ((!pMObj) || pMObj->player)      // Removed or a player? (don't handle players)
+            continue;
+
+        const bool bIsLast = isLastLiveMObj(orderIdx);
+        P_MobjThinker(gMapQueryContext, *pMObj);    // Execute the code (may remove the object)
+
+        if (bIsLast)
+            break;
     }
 }
@@ -11,10 +11,11 @@
 #include "Map/Floor.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "Map/Switch.h"
 #include "MapObj.h"
-#include "Move.h"
+#include "MObjTable.h"
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Represents 1 direction of 8
@@ -35,7 +36,7 @@ enum dirtype_t : uint32_t {
 // Return true if the target mobj_t is in melee range
 //------------------------------------------------------------------------------------------------------------------------------------------
 static bool CheckMeleeRange(mobj_t& actor) noexcept {
-    const mobj_t* const pTarget = actor.target;   // Get the mobj_t of the target
+    const mobj_t* const pTarget = getTarget(actor);     // Get the mobj_t of the target
 
     if (!pTarget)   // No target?
         return false;
@@ -51,7 +52,9 @@ static bool CheckMeleeRange(mobj_t& actor) noexcept {
 // Return true if the actor is in missile range to the target
 //------------------------------------------------------------------------------------------------------------------------------------------
 static bool CheckMissileRange(mobj_t& actor) noexcept {
-    if (!actor.target)
+    const mobj_t* const pTarget = getTarget(actor);
+
+    if (!pTarget)
         return false;
 
     if ((actor.flags & MF_SEETARGET) == 0)      // Are you seen?
@@ -66,8 +69,7 @@ static bool CheckMissileRange(mobj_t& actor) noexcept {
     if (actor.reactiontime > 0)     // Still waking up?
         return false;               // Don't attack yet
 
-    const mobj_t& target = *actor.target;
-    Fixed dist = (GetApproxDistance(actor.x - target.x, actor.y - target.y) >> FRACBITS) - 64;
+    Fixed dist = (GetApproxDistance(actor.x - pTarget->x, actor.y - pTarget->y) >> FRACBITS) - 64;
 
     if (!actor.InfoPtr->meleestate) {       // No hand-to-hand combat mode?
         dist -= 128;                        // No melee attack, so fire more often
@@ -125,10 +127,12 @@ static bool P_Move(mobj_t& actor) noexcept {
     const Fixed tryY = actor.y + ((Fixed) speed * MOVE_Y_SPEEDS[moveDir]);
 
     // Try to open any specials if we can't move to a location
-    if (!P_TryMove(actor, tryX, tryY)) {
-        if (actor.flags & MF_FLOAT && gbFloatOk) {
+    MapQueryContext& ctx = gMapQueryContext;
+
+    if (!P_TryMove(ctx, actor, tryX, tryY)) {
+        if (actor.flags & MF_FLOAT && ctx.bFloatOk) {
             // Must adjust height
-            if (actor.z < gTmpFloorZ) {
+            if (actor.z < ctx.tmpFloorZ) {
                 actor.z += FLOATSPEED;      // Jump up
             } else {
                 actor.z -= FLOATSPEED;      // Jump down
@@ -138,7 +142,7 @@ static bool P_Move(mobj_t& actor) noexcept {
             return true;                    // I can move!!
         }
 
-        line_t* const pBlockLine = gpBlockLine;     // What line blocked me?
+        line_t* const pBlockLine = ctx.pBlockLine;      // What line blocked me?
 
         if (!pBlockLine || !pBlockLine->special)    // Am I blocked?
             return false;                           // Can't move
@@ -200,8 +204,9 @@ static void P_NewChaseDir(mobj_t& actor) noexcept {
     const dirtype_t oldDir = (dirtype_t) actor.movedir;         // Get current direction
     const dirtype_t turnaroundDir = OPPOSITE_DIR[oldDir];       // Get opposite direction
 
-    ASSERT(actor.target);
-    mobj_t& target = *actor.target;
+    const mobj_t* const pTarget = getTarget(actor);
+    ASSERT(pTarget);
+    const mobj_t& target = *pTarget;
     const Fixed deltax = target.x - actor.x;    // Get the x offset
     const Fixed deltay = target.y - actor.y;    // Get the y offset
 
@@ -325,18 +330,18 @@ static bool P_LookForPlayers(mobj_t& actor, bool bAllAround) noexcept {
     // Pick another player as target if possible
     if ((actor.flags & MF_SEETARGET) == 0) {    // Can I see the player?
     newtarget:
-        actor.target = gPlayer.mo;              // Force player #0 tracking
+        setTarget(actor, gPlayer.mo);           // Force player #0 tracking
         return false;                           // No one is targeted
     }
 
-    const mobj_t* const pTarget = actor.target;     // Get the target
+    const mobj_t* const pTarget = getTarget(actor);     // Get the target
 
     if (!pTarget || pTarget->MObjHealth <= 0) {     // Is it alive?
         goto newtarget;                             // Pick a target...
     }
 
     // Ambush guys will turn around on a shot
-    if (actor.subsector->sector->soundtarget == actor.target) {
+    if (MObjTable::resolveHandle(actor.subsector->sector->soundtarget) == pTarget) {
         bAllAround = true;
     }
 
@@ -418,7 +423,9 @@ void A_Chase(mobj_t& actor) noexcept {
     ASSERT(actor.InfoPtr);
     const mobjinfo_t& info = *actor.InfoPtr;
 
-    if ((!actor.target) || ((actor.target->flags & MF_SHOOTABLE) == 0)) {
+    const mobj_t* const pTarget = getTarget(actor);
+
+    if ((!pTarget) || ((pTarget->flags & MF_SHOOTABLE) == 0)) {
         if (P_LookForPlayers(actor, true)) {
             return;     // Got a new target
         }
@@ -473,13 +480,13 @@ void A_Chase(mobj_t& actor) noexcept {
 // Turn to face your target
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_FaceTarget(mobj_t& actor) noexcept {
-    const mobj_t* const pTarget = actor.target;
+    const mobj_t* const pTarget = getTarget(actor);
 
     if (pTarget) {  // Is there a target?
         actor.flags &= ~MF_AMBUSH;  // Not ambushing anymore
         actor.angle = PointToAngle(actor.x, actor.y, pTarget->x, pTarget->y);
 
-        if (actor.target->flags & MF_SHADOW) {  // Hard to see?
+        if (pTarget->flags & MF_SHADOW) {       // Hard to see?
             actor.angle += (255 - Random::nextU32(511)) << 21;
         }
     }
@@ -489,14 +496,14 @@ void A_FaceTarget(mobj_t& actor) noexcept {
 // Shoot the player with a pistol (Used by Zombiemen)
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_PosAttack(mobj_t& actor) noexcept {
-    if (actor.target) {                         // Is there a target?
+    if (getTarget(actor)) {                     // Is there a target?
         A_FaceTarget(actor);                    // Face the target
         S_StartSound(&actor.x, sfx_pistol);     // Shoot the pistol
 
         angle_t angle = actor.angle;                            // Get the angle
         angle += (255 - Random::nextU32(511)) << 20;            // Angle of error
         const uint32_t damage = (Random::nextU32(7) + 1) * 3;   // 1D8 * 3
-        LineAttack(actor, angle, MISSILERANGE, FRACMAX, damage);
+        LineAttack(gMapQueryContext, actor, angle, MISSILERANGE, FRACMAX, damage);
     }
 }
 
@@ -504,7 +511,7 @@ void A_PosAttack(mobj_t& actor) noexcept {
 // Shoot the player with a shotgun (Used by Shotgun man)
 //--------------------------------------------------------------------------------------------------
 void A_SPosAttack(mobj_t& actor) noexcept {
-    if (actor.target) {
+    if (getTarget(actor)) {
         S_StartSound(&actor.x, sfx_shotgn);
         A_FaceTarget(actor);
         const angle_t bAngle = actor.angle;     // Base angle
@@ -512,7 +519,7 @@ void A_SPosAttack(mobj_t& actor) noexcept {
         for (uint32_t i = 0; i < 3u; ++i) {
             const angle_t angle = bAngle + ((255 - Random::nextU32(511)) << 20);
             const uint32_t damage = (Random::nextU32(7) + 1 ) * 3;
-            LineAttack(actor, angle, MISSILERANGE, FRACMAX, damage);
+            LineAttack(gMapQueryContext, actor, angle, MISSILERANGE, FRACMAX, damage);
         }
     }
 }
@@ -525,9 +532,10 @@ void A_SpidRefire(mobj_t& actor) noexcept {
 
     // Keep firing unless target got out of sight
     if (Random::nextU8(255) >= 10) {
+        const mobj_t* const pTarget = getTarget(actor);
         const bool bNoTarget = (
-            (!actor.target) ||
-            (actor.target->MObjHealth <= 0) ||
+            (!pTarget) ||
+            (pTarget->MObjHealth <= 0) ||
             ((actor.flags & MF_SEETARGET) == 0)
         );
 
@@ -541,18 +549,18 @@ void A_SpidRefire(mobj_t& actor) noexcept {
 // Imp attack
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_TroopAttack(mobj_t& actor) noexcept {
-    if (actor.target) {
+    if (mobj_t* const pTarget = getTarget(actor)) {
         A_FaceTarget(actor);    // Face your victim
 
         if (CheckMeleeRange(actor)) {
             S_StartSound(&actor.x, sfx_claw);                       // Claw sound
             const uint32_t damage = (Random::nextU32(7) + 1) * 3;   // 1D8 * 3
-            DamageMObj(*actor.target, &actor, &actor, damage);
+            DamageMObj(*pTarget, &actor, &actor, damage);
             return;                                                 // End attack
         }
 
         // Launch a imp's missile
-        P_SpawnMissile(actor, *actor.target, gMObjInfo[MT_TROOPSHOT]);
+        P_SpawnMissile(actor, *pTarget, gMObjInfo[MT_TROOPSHOT]);
     }
 }
 
@@ -560,10 +568,10 @@ void A_TroopAttack(mobj_t& actor) noexcept {
 // Demon or Spectre attack
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_SargAttack(mobj_t& actor) noexcept {
-    if (actor.target) {
-        A_FaceTarget(actor);                                        // Face the player
-        const uint32_t damage = (Random::nextU32(7) + 1) * 4;       // 1D8 * 4
-        LineAttack(actor, actor.angle, MELEERANGE, 0, damage);      // Attack
+    if (getTarget(actor)) {
+        A_FaceTarget(actor);                                                        // Face the player
+        const uint32_t damage = (Random::nextU32(7) + 1) * 4;                       // 1D8 * 4
+        LineAttack(gMapQueryContext, actor, actor.angle, MELEERANGE, 0, damage);    // Attack
     }
 }
 
@@ -571,17 +579,17 @@ void A_SargAttack(mobj_t& actor) noexcept {
 // Evil eye attack
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_HeadAttack(mobj_t& actor) noexcept {
-    if (actor.target) {         // Anyone targeted?
-        A_FaceTarget(actor);    // Face the target
+    if (mobj_t* const pTarget = getTarget(actor)) {     // Anyone targeted?
+        A_FaceTarget(actor);                            // Face the target
 
         if (CheckMeleeRange(actor)) {                               // In bite range?
             const uint32_t damage = (Random::nextU32(7) + 1) * 8;   // 1D8 * 8
-            DamageMObj(*actor.target, &actor, &actor, damage);
+            DamageMObj(*pTarget, &actor, &actor, damage);
             return;
         }
 
         // Launch a missile - shoot eye missile
-        P_SpawnMissile(actor, *actor.target, gMObjInfo[MT_HEADSHOT]);
+        P_SpawnMissile(actor, *pTarget, gMObjInfo[MT_HEADSHOT]);
     }
 }
 
@@ -589,9 +597,9 @@ void A_HeadAttack(mobj_t& actor) noexcept {
 // Cyberdemon firing missile
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_CyberAttack(mobj_t& actor) noexcept {
-    if (actor.target) {
+    if (mobj_t* const pTarget = getTarget(actor)) {
         A_FaceTarget(actor);                                            // Face the enemy
-        P_SpawnMissile(actor, *actor.target, gMObjInfo[MT_ROCKET]);     // Launch missile
+        P_SpawnMissile(actor, *pTarget, gMObjInfo[MT_ROCKET]);          // Launch missile
     }
 }
 
@@ -599,16 +607,16 @@ void A_CyberAttack(mobj_t& actor) noexcept {
 // Baron of hell attack
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_BruisAttack(mobj_t& actor) noexcept {
-    if (actor.target) {                                                 // Target aquired?
+    if (mobj_t* const pTarget = getTarget(actor)) {                     // Target aquired?
         if (CheckMeleeRange(actor)) {                                   // Claw range?
             S_StartSound(&actor.x, sfx_claw);                           // Ouch!
             const uint32_t damage = (Random::nextU32(7) + 1) * 11;      // 1D8 * 11
-            DamageMObj(*actor.target, &actor, &actor, damage);
+            DamageMObj(*pTarget, &actor, &actor, damage);
             return;
         }
 
         // Launch a missile
-        P_SpawnMissile(actor, *actor.target, gMObjInfo[MT_BRUISERSHOT]);
+        P_SpawnMissile(actor, *pTarget, gMObjInfo[MT_BRUISERSHOT]);
     }
 }
 
@@ -616,7 +624,7 @@ void A_BruisAttack(mobj_t& actor) noexcept {
 // Fly at the player like a missile
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_SkullAttack(mobj_t& actor) noexcept {
-    const mobj_t* const pDest = actor.target;
+    const mobj_t* const pDest = getTarget(actor);
 
     if (pDest) {                                                    // Target aquired?
         actor.flags |= MF_SKULLFLY;                                 // High speed mode
@@ -686,7 +694,7 @@ void A_Fall(mobj_t& actor) noexcept {
 // Process damage from an explosion
 //------------------------------------------------------------------------------------------------------------------------------------------
 void A_Explode(mobj_t& actor) noexcept {
-    RadiusAttack(actor, actor.target, 128);    // BOOM!
+    RadiusAttack(gMapQueryContext, actor, getTarget(actor), 128);       // BOOM!
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -700,17 +708,15 @@ void A_BossDeath(mobj_t& actor) noexcept {
 
     // Scan the remaining thinkers to see if all bosses are dead.
     // This is a brute force method, but it works!
-    const mobj_t* pActor2 = gMObjHead.next;
+    const uint32_t numMObjs = MObjTable::getNumEntries();
+
+    for (uint32_t orderIdx = 0; orderIdx < numMObjs; ++orderIdx) {
+        const mobj_t* const pActor2 = MObjTable::getEntry(orderIdx);
 
-    do {
-        if (pActor2 != &actor && pActor2->InfoPtr == actor.InfoPtr && pActor2->MObjHealth) {
+        if (pActor2 && pActor2 != &actor && pActor2->InfoPtr == actor.InfoPtr && pActor2->MObjHealth) {
             return;     // Other boss not dead
         }
-
-        // Keep scanning the list
-        pActor2 = pActor2->next;
-
-    } while (pActor2 != &gMObjHead);    // Stop when wrapped around back to the start
+    }
 
     // Victory!
     line_t junk;
@@ -740,7 +746,7 @@ void A_Metal(mobj_t& actor) noexcept {
 void L_MissileHit(mobj_t& mapObj, mobj_t* const pMissile) noexcept {
     if (pMissile) {
         const uint32_t damage = (Random::nextU32(7) + 1) * mapObj.InfoPtr->damage;      // Calc the damage
-        DamageMObj(*pMissile, &mapObj, mapObj.target, damage);                          // Inflict damage
+        DamageMObj(*pMissile, &mapObj, getTarget(mapObj), damage);                      // Inflict damage
     }
 
     ExplodeMissile(mapObj);     // Detonate the missile
@@ -702,8 +702,8 @@ void DamageMObj(
             pPlayer->health -= damage;          // Remove health
         }
 
-        pPlayer->attacker = pSource;                // Mark the source of the attack
-        pPlayer->damagecount += (damage << 1);      // Add damage after armor / invuln
+        pPlayer->attacker = MObjTable::getHandle(pSource);      // Mark the source of the attack
+        pPlayer->damagecount += (damage << 1);                  // Add damage after armor / invuln
     }
 
     // Do the damage
@@ -727,7 +727,7 @@ void DamageMObj(
 
     // If not intent on another player, chase after this one
     if (target.threshold == 0 && pSource) {
-        target.target = pSource;                // Target the attacker
+        setTarget(target, pSource);             // Target the attacker
         target.threshold = BASETHRESHOLD;       // Reset the threshold
 
         if (target.state == target.InfoPtr->spawnstate && target.InfoPtr->seestate) {
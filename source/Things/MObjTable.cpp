@@ -0,0 +1,110 @@
+#include "MObjTable.h"
+
+#include "MapObj.h"
+
+BEGIN_NAMESPACE(MObjTable)
+
+// A slot in the handle table: holds the object the slot currently refers to along with its unique id
+struct HandleSlot {
+    mobj_t*     pMObj;      // Null if the slot is free
+    uint32_t    guid;       // '0' if the slot is free
+};
+
+std::vector<mobj_t*>            gMObjs;
+
+static std::vector<HandleSlot>  gHandleSlots;
+static std::vector<uint32_t>    gFreeHandleSlots;       // Indexes of handle slots which can be reused
+static uint32_t                 gNumRemovedEntries;     // How many null entries are waiting to be compacted
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Forgets about all map objects, when their memory is released at the end of a level.
+// Since object ids are never reused, handles from before this can never resolve to an object added afterwards.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void clear() noexcept {
+    gMObjs.clear();
+    gHandleSlots.clear();
+    gFreeHandleSlots.clear();
+    gNumRemovedEntries = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Adds a newly spawned map object to the end of the table: it must already have been given its unique id
+//------------------------------------------------------------------------------------------------------------------------------------------
+void add(mobj_t& mobj) noexcept {
+    ASSERT(mobj.guid != 0);
+
+    uint32_t slotIdx;
+
+    if (!gFreeHandleSlots.empty()) {
+        slotIdx = gFreeHandleSlots.back();
+        gFreeHandleSlots.pop_back();
+    } else {
+        slotIdx = (uint32_t) gHandleSlots.size();
+        gHandleSlots.emplace_back();
+    }
+
+    HandleSlot& slot = gHandleSlots[slotIdx];
+    slot.pMObj = &mobj;
+    slot.guid = mobj.guid;
+
+    mobj.tableSlotIdx = slotIdx;
+    mobj.tableOrderIdx = (uint32_t) gMObjs.size();
+    gMObjs.push_back(&mobj);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Removes a map object from the table, invalidating all handles to it and leaving a null entry in the array until the next compact
+//------------------------------------------------------------------------------------------------------------------------------------------
+void remove(mobj_t& mobj) noexcept {
+    ASSERT(mobj.tableOrderIdx < gMObjs.size());
+    ASSERT(gMObjs[mobj.tableOrderIdx] == &mobj);
+    ASSERT(mobj.tableSlotIdx < gHandleSlots.size());
+
+    gMObjs[mobj.tableOrderIdx] = nullptr;
+    gNumRemovedEntries++;
+
+    HandleSlot& slot = gHandleSlots[mobj.tableSlotIdx];
+    slot.pMObj = nullptr;
+    slot.guid = 0;
+    gFreeHandleSlots.push_back(mobj.tableSlotIdx);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Squeezes the null entries left by removed objects out of the array, keeping the objects in the same order
+//------------------------------------------------------------------------------------------------------------------------------------------
+void compact() noexcept {
+    if (gNumRemovedEntries == 0)
+        return;
+
+    const uint32_t numEntries = (uint32_t) gMObjs.size();
+    mobj_t** const pEntries = gMObjs.data();
+    uint32_t numKept = 0;
+
+    for (uint32_t i = 0; i < numEntries; ++i) {
+        mobj_t* const pMObj = pEntries[i];
+
+        if (pMObj) {
+            pMObj->tableOrderIdx = numKept;
+            pEntries[numKept] = pMObj;
+            numKept++;
+        }
+    }
+
+    gMObjs.resize(numKept);
+    gNumRemovedEntries = 0;
+}
+
+MObjHandle getHandle(const mobj_t& mobj) noexcept {
+    return MObjHandle{ mobj.tableSlotIdx, mobj.guid };
+}
+
+mobj_t* resolveHandle(const MObjHandle handle) noexcept {
+    if (handle.slotIdx >= gHandleSlots.size())
+        return nullptr;
+
+    // Note: free slots have an id of '0', which never matches a non null handle
+    const HandleSlot& slot = gHandleSlots[handle.slotIdx];
+    return ((slot.guid == handle.guid) && (!handle.isNull())) ? slot.pMObj : nullptr;
+}
+
+END_NAMESPACE(MObjTable)
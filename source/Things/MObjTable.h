@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Base/Macros.h"
+#include <cstdint>
+#include <vector>
+
+struct mobj_t;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A handle to a map object which can be safely checked to see if the object still exists.
+// Consists of a slot in the map object table plus the unique id of the object which was in that slot when the handle was made.
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct MObjHandle {
+    uint32_t    slotIdx;
+    uint32_t    guid;       // '0' for a null handle: no map object ever has this id
+
+    inline bool isNull() const noexcept { return (guid == 0); }
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Keeps track of all the map objects in the level, replacing the old doubly linked list of map objects.
+//
+// Objects are held in a dense array in the order they were spawned, which is the order they think in, so that walking over all of them
+// is a linear pass over memory. Removing an object just leaves an empty (null) entry in its place, so removal is safe while the array is
+// being walked, and the empty entries are squeezed out later by 'compact' (keeping the order). Objects spawned while the array is being
+// walked are added to the end of it.
+//
+// Separately, every object also has a slot in a table of handles, which do not move when the array is compacted. A handle remembers the
+// unique id of the object it was made for, so a handle to an object which has since been removed (even if the slot was reused) resolves
+// to null instead of a dangling pointer.
+//
+// Notes:
+//  (1) Code walking the array must index it afresh on each step, since spawning objects may grow (and reallocate) the array.
+//  (2) 'compact' must only be called when nothing is walking the array.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(MObjTable)
+
+// All map objects in spawn order: removed objects leave a null entry until the next 'compact'
+extern std::vector<mobj_t*> gMObjs;
+
+void clear() noexcept;
+void add(mobj_t& mobj) noexcept;
+void remove(mobj_t& mobj) noexcept;
+void compact() noexcept;
+
+MObjHandle getHandle(const mobj_t& mobj) noexcept;
+mobj_t* resolveHandle(const MObjHandle handle) noexcept;
+
+// Same as above, but gives a null handle for a null object
+inline MObjHandle getHandle(const mobj_t* const pMObj) noexcept {
+    return (pMObj) ? getHandle(*pMObj) : MObjHandle{};
+}
+
+inline uint32_t getNumEntries() noexcept {
+    return (uint32_t) gMObjs.size();
+}
+
+// Note: returns null if the object at this position has been removed
+inline mobj_t* getEntry(const uint32_t orderIdx) noexcept {
+    return gMObjs[orderIdx];
+}
+
+END_NAMESPACE(MObjTable)
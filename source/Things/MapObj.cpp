@@ -10,8 +10,10 @@
 #include "Info.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "Map/Setup.h"
+#include "MObjTable.h"
 #include <cstring>
 
 // Bit field for item spawning based on level
@@ -32,10 +34,9 @@ void P_RemoveMobj(mobj_t& mobj) noexcept {
     // Unlink from sector and block lists
     UnsetThingPosition(mobj);
 
-    // Unlink from mobj list and release mem
-    mobj.next->prev = mobj.prev;
-    mobj.prev->next = mobj.next;
-    MemFree(&mobj);
+    // Remove from the map object table and release mem
+    MObjTable::remove(mobj);
+    FreeMObj(mobj);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -84,7 +85,7 @@ void ExplodeMissile(mobj_t& mo) noexcept {
 // Spawn a misc object
 //------------------------------------------------------------------------------------------------------------------------------------------
 mobj_t& SpawnMObj(const Fixed x, const Fixed y, const Fixed z, const mobjinfo_t& info) noexcept {
-    mobj_t& mObj = AllocObj<mobj_t>();          // Alloc and init object memory
+    mobj_t& mObj = AllocMObj();                 // Alloc and init object memory
     MemClear(mObj);
 
     mObj.InfoPtr = &info;                       // Save the type pointer
@@ -120,11 +121,8 @@ mobj_t& SpawnMObj(const Fixed x, const Fixed y, const Fixed z, const mobjinfo_t&
         mObj.z = z;                                         // Use the raw z
     }
 
-    // Link into the END of the mobj list
-    gMObjHead.prev->next = &mObj;               // Set the new forward link
-    mObj.next = &gMObjHead;                     // Set my next link
-    mObj.prev = gMObjHead.prev;                 // Set my previous link
-    gMObjHead.prev = &mObj;                     // Link myself in
+    // Add to the END of the map object table
+    MObjTable::add(mObj);
     return mObj;                                // Return the new object pointer
 }
 
@@ -235,16 +233,16 @@ void SpawnMapThing(const mapthing_t& mthing) noexcept {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
-// Spawn a puff of smoke on the wall
+// Spawn a puff of smoke on the wall, for a line attack with the given range
 //------------------------------------------------------------------------------------------------------------------------------------------
-void P_SpawnPuff(const Fixed x, const Fixed y, const Fixed z) noexcept {
+void P_SpawnPuff(const Fixed x, const Fixed y, const Fixed z, const Fixed attackRange) noexcept {
     const Fixed zActual = z + ((255 - (int32_t) Random::nextU32(511)) << 10);   // Randomize the z
     mobj_t& mObj = SpawnMObj(x, y, zActual, gMObjInfo[MT_PUFF]);                // Create a puff
     mObj.momz = FRACUNIT;                                                       // Allow it to move up per frame
     Sub1RandomTick(mObj);
 
     // Don't make punches spark on the wall
-    if (gAttackRange == MELEERANGE) {
+    if (attackRange == MELEERANGE) {
         SetMObjState(mObj, gStates[S_PUFF3]);       // Reset to the third state
     }
 }
@@ -273,8 +271,8 @@ static void P_CheckMissileSpawn(mobj_t& mObj) noexcept {
     mObj.y += (mObj.momy >> 1);     // Move a little forward so an angle can be computed if it immediately explodes
     mObj.z += (mObj.momz >> 1);
 
-    if (!P_TryMove(mObj, mObj.x, mObj.y)) {     // Impact?
-        ExplodeMissile(mObj);                   // Boom!!!
+    if (!P_TryMove(gMapQueryContext, mObj, mObj.x, mObj.y)) {       // Impact?
+        ExplodeMissile(mObj);                                       // Boom!!!
     }
 }
 
@@ -286,7 +284,7 @@ void P_SpawnMissile(mobj_t& source, mobj_t& dest, const mobjinfo_t& info) noexce
     mobj_t& th = SpawnMObj(source.x, source.y, source.z + (32 * FRACUNIT), info);
 
     S_StartSound(&source.x, info.seesound);                             // Play the launch sound
-    th.target = &source;                                                // Who launched it?
+    setTarget(th, &source);                                             // Who launched it?
     angle_t an = PointToAngle(source.x, source.y, dest.x, dest.y);      // Angle of travel
 
     if ((dest.flags & MF_SHADOW) != 0) {            // Hard to see, miss on purpose!
@@ -314,18 +312,19 @@ void P_SpawnMissile(mobj_t& source, mobj_t& dest, const mobjinfo_t& info) noexce
 //------------------------------------------------------------------------------------------------------------------------------------------
 void SpawnPlayerMissile(mobj_t& source, const mobjinfo_t& info) noexcept {
     // See which target is to be aimed at, start by aiming directly in the angle of the player
+    MapQueryContext& ctx = gMapQueryContext;
     angle_t an = source.angle;
-    Fixed slope = AimLineAttack(source, an, 16 * 64 * FRACUNIT);
+    Fixed slope = AimLineAttack(ctx, source, an, 16 * 64 * FRACUNIT);
 
-    if (!gpLineTarget) {    // No target?
-        an += 1 << 26;      // Aim a little to the right
-        slope = AimLineAttack(source, an, 16 * 64 * FRACUNIT);
+    if (!ctx.pLineTarget) {     // No target?
+        an += 1 << 26;          // Aim a little to the right
+        slope = AimLineAttack(ctx, source, an, 16 * 64 * FRACUNIT);
 
-        if (!gpLineTarget) {    // Still no target?
-            an -= 2 << 26;      // Try a little to the left
-            slope = AimLineAttack(source, an, 16 * 64 * FRACUNIT);
+        if (!ctx.pLineTarget) {     // Still no target?
+            an -= 2 << 26;          // Try a little to the left
+            slope = AimLineAttack(ctx, source, an, 16 * 64 * FRACUNIT);
 
-            if (!gpLineTarget) {        // I give up, just fire directly ahead
+            if (!ctx.pLineTarget) {     // I give up, just fire directly ahead
                 an = source.angle;      // Reset the angle
                 slope = 0;              // No z slope
             }
@@ -338,7 +337,7 @@ void SpawnPlayerMissile(mobj_t& source, const mobjinfo_t& info) noexcept {
 
     mobj_t& th = SpawnMObj(x, y, z, info);          // Spawn the missile
     S_StartSound(&source.x, info.seesound);         // Play the sound
-    th.target = &source;                            // Set myself as the target
+    setTarget(th, &source);                         // Set myself as the target
     th.angle = an;                                  // Set the angle
 
     uint32_t speed = info.Speed;    // Get the missile speed
@@ -3,6 +3,7 @@
 #include "Base/Angle.h"
 #include "Base/Fixed.h"
 #include "Base/Macros.h"
+#include "MObjTable.h"
 
 struct mobjinfo_t;
 struct player_t;
@@ -25,15 +26,30 @@ static constexpr uint32_t MTF_HARD          = 0x4;
 static constexpr uint32_t MTF_AMBUSH        = 0x8;
 static constexpr uint32_t MTF_DEATHMATCH    = 0x10;
 
-// Struct defining a runtime map object (thing)
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Struct defining a runtime map object (thing).
+//
+// Fields are split into hot and cold parts: the fields which are read or written for every map object on every tick (movement, state
+// countdown) come first so that they all share the first cache line of the object. Map objects always start on a cache line boundary.
+// Everything else (links, combat and AI state) comes after.
+//------------------------------------------------------------------------------------------------------------------------------------------
 struct mobj_t {
     NON_ASSIGNABLE_STRUCT(mobj_t)
 
-    mobj_t*     prev;       // Linked list entries
-    mobj_t*     next;
-    Fixed       x;          // Location in 3Space
-    Fixed       y;
-    Fixed       z;
+    // Hot fields: used every tick
+    Fixed               x;              // Location in 3Space
+    Fixed               y;
+    Fixed               z;
+    Fixed               momx;           // Momentums
+    Fixed               momy;
+    Fixed               momz;
+    Fixed               floorz;         // Closest together of contacted secs
+    Fixed               ceilingz;
+    uint32_t            tics;           // Time before next state
+    uint32_t            flags;          // State flags for object
+    const state_t*      state;          // Pointer to current state record (Can't be NULL!)
+    player_t*           player;         // Only valid if type == MT_PLAYER
+    subsector_t*        subsector;      // Subsector currently standing on
 
     // Info for drawing
     mobj_t*     snext;      // links in sector (if needed)
@@ -41,29 +57,22 @@ struct mobj_t {
     angle_t     angle;      // Angle of view
 
     // Interaction info
-    mobj_t*         bnext;          // Links in blocks (if needed)
-    mobj_t*         bprev;
-    subsector_t*    subsector;      // Subsector currently standing on
-    Fixed           floorz;         // Closest together of contacted secs
-    Fixed           ceilingz;
-    Fixed           radius;         // For movement checking
-    Fixed           height;
-    Fixed           momx;           // Momentums
-    Fixed           momy;
-    Fixed           momz;
-
+    mobj_t*             bnext;          // Links in blocks (if needed)
+    mobj_t*             bprev;
+    Fixed               radius;         // For movement checking
+    Fixed               height;
     const mobjinfo_t*   InfoPtr;        // Pointer to mobj info record
-    uint32_t            tics;           // Time before next state
     uint32_t            guid;           // Unique identifier
-    const state_t*      state;          // Pointer to current state record (Can't be NULL!)
-    uint32_t            flags;          // State flags for object
     uint32_t            MObjHealth;     // Object's health
     uint32_t            movedir;        // 0-7
     uint32_t            movecount;      // When 0, select a new dir
-    mobj_t*             target;         // Thing being chased/attacked (or NULL); also the originator for missiles.
+    MObjHandle          target;         // Thing being chased/attacked (or NULL); also the originator for missiles. See 'getTarget'.
     uint32_t            reactiontime;   // If non 0, don't attack yet; used by player to freeze a bit after teleporting.
     uint32_t            threshold;      // If > 0, the target will be chased no matter what (even if shot)
-    player_t*           player;         // Only valid if type == MT_PLAYER
+
+    // Where the object is in the map object table (see 'MObjTable')
+    uint32_t            tableSlotIdx;   // Slot for the object's handle
+    uint32_t            tableOrderIdx;  // Position amongst all the objects in spawn order
 };
 
 // Flags which can be used for map objects
@@ -95,6 +104,16 @@ static constexpr uint32_t MF_SKULLFLY       = 0x1000000;    // Skull in flight
 static constexpr uint32_t MF_NOTDMATCH      = 0x2000000;    // Don't spawn in death match (key cards)
 static constexpr uint32_t MF_SEETARGET      = 0x4000000;    // Is target visible?
 
+// Get and set the thing which a thing is chasing or attacking (or which launched it, for missiles).
+// Since the target is held by handle, this gives null once the target has been removed from the map.
+inline mobj_t* getTarget(const mobj_t& mobj) noexcept {
+    return MObjTable::resolveHandle(mobj.target);
+}
+
+inline void setTarget(mobj_t& mobj, const mobj_t* const pTarget) noexcept {
+    mobj.target = MObjTable::getHandle(pTarget);
+}
+
 void P_RemoveMobj(mobj_t& th) noexcept;
 uint32_t SetMObjState(mobj_t& mobj, const state_t* const StatePtr) noexcept;
 
@@ -107,7 +126,7 @@ void ExplodeMissile(mobj_t& mo) noexcept;
 mobj_t& SpawnMObj(const Fixed x, const Fixed y, const Fixed z, const mobjinfo_t& info) noexcept;
 void P_SpawnPlayer(const mapthing_t& mthing) noexcept;
 void SpawnMapThing(const mapthing_t& mthing) noexcept;
-void P_SpawnPuff(const Fixed x, const Fixed y, const Fixed z) noexcept;
+void P_SpawnPuff(const Fixed x, const Fixed y, const Fixed z, const Fixed attackRange) noexcept;
 void P_SpawnBlood(const Fixed x, const Fixed y, const Fixed z, const uint32_t damage) noexcept;
 void P_SpawnMissile(mobj_t& source, mobj_t& dest, const mobjinfo_t& info) noexcept;
 void SpawnPlayerMissile(mobj_t& source, const mobjinfo_t& info) noexcept;
@@ -4,88 +4,75 @@
 #include "Info.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "MapObj.h"
 #include <algorithm>
 
-bool        gbTryMove2;         // Result from P_TryMove2
-bool        gbFloatOk;          // If true, move would be ok if within tmfloorz - tmceilingz
-Fixed       gTmpFloorZ;         // Current floor z for P_TryMove2
-Fixed       gTmpCeilingZ;       // Current ceiling z for P_TryMove2
-mobj_t*     gpMoveThing;        // Either a skull/missile target or a special pickup
-line_t*     gpBlockLine;        // Might be a door that can be opened
-
-static Fixed            gOldX;
-static Fixed            gOldY;
-static Fixed            gTmpBBox[4];
-static uint32_t         gTmpFlags;
-static Fixed            gTmpDropoffZ;       // Lowest point contacted
-static subsector_t*     gpNewSubSec;        // Dest subsector
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Attempt to move to a new position, crossing special lines unless MF_TELEPORT is set.
 //------------------------------------------------------------------------------------------------------------------------------------------
-void P_TryMove2() noexcept {
-    gbTryMove2 = false;     // Until proven otherwise
-    gbFloatOk = false;
+void P_TryMove2(MapQueryContext& ctx) noexcept {
+    ctx.bTryMove2 = false;      // Until proven otherwise
+    ctx.bFloatOk = false;
 
-    gOldX = gpTmpThing->x;
-    gOldY = gpTmpThing->y;
-    PM_CheckPosition();
+    ctx.oldX = ctx.pTmpThing->x;
+    ctx.oldY = ctx.pTmpThing->y;
+    PM_CheckPosition(ctx);
 
-    if (gbCheckPosOnly) {
-        gbCheckPosOnly = false;
+    if (ctx.bCheckPosOnly) {
+        ctx.bCheckPosOnly = false;
         return;
     }
 
-    if (!gbTryMove2) {
+    if (!ctx.bTryMove2) {
         return;
     }
 
-    if ((gpTmpThing->flags & MF_NOCLIP) == 0) {
-        gbTryMove2 = false;
+    if ((ctx.pTmpThing->flags & MF_NOCLIP) == 0) {
+        ctx.bTryMove2 = false;
 
-        if (gTmpCeilingZ - gTmpFloorZ < gpTmpThing->height) {
+        if (ctx.tmpCeilingZ - ctx.tmpFloorZ < ctx.pTmpThing->height) {
             return;     // Doesn't fit
         }
 
-        gbFloatOk = true;
+        ctx.bFloatOk = true;
 
-        if (((gpTmpThing->flags & MF_TELEPORT) == 0) && 
-            (gTmpCeilingZ - gpTmpThing->z < gpTmpThing->height)
+        if (((ctx.pTmpThing->flags & MF_TELEPORT) == 0) && 
+            (ctx.tmpCeilingZ - ctx.pTmpThing->z < ctx.pTmpThing->height)
         ) {
             return;     // Mobj must lower itself to fit
         }
 
-        if (((gpTmpThing->flags & MF_TELEPORT) == 0) &&
-            (gTmpFloorZ - gpTmpThing->z > 24 * FRACUNIT)
+        if (((ctx.pTmpThing->flags & MF_TELEPORT) == 0) &&
+            (ctx.tmpFloorZ - ctx.pTmpThing->z > 24 * FRACUNIT)
         ) {
             return;     // Too big a step up
         }
 
-        if (((gpTmpThing->flags & (MF_DROPOFF|MF_FLOAT)) == 0) &&
-            (gTmpFloorZ - gTmpDropoffZ > 24 * FRACUNIT)
+        if (((ctx.pTmpThing->flags & (MF_DROPOFF|MF_FLOAT)) == 0) &&
+            (ctx.tmpFloorZ - ctx.tmpDropoffZ > 24 * FRACUNIT)
         ) {
             return;     // Don't stand over a dropoff
         }
     }
 
     // The move is ok, so link the thing into its new position
-    UnsetThingPosition(*gpTmpThing);
+    UnsetThingPosition(*ctx.pTmpThing);
 
-    gpTmpThing->floorz = gTmpFloorZ;
-    gpTmpThing->ceilingz = gTmpCeilingZ;
-    gpTmpThing->x = gTmpX;
-    gpTmpThing->y = gTmpY;
+    ctx.pTmpThing->floorz = ctx.tmpFloorZ;
+    ctx.pTmpThing->ceilingz = ctx.tmpCeilingZ;
+    ctx.pTmpThing->x = ctx.tmpX;
+    ctx.pTmpThing->y = ctx.tmpY;
 
-    SetThingPosition(*gpTmpThing);
-    gbTryMove2 = true;
+    SetThingPosition(*ctx.pTmpThing);
+    ctx.bTryMove2 = true;
     return;
 }
 
-static bool PM_CrossCheck(line_t& ld) noexcept {
-    if (PM_BoxCrossLine (ld)) {
-        if (!PIT_CheckLine(ld)) {
+static bool PM_CrossCheck(MapQueryContext& ctx, line_t& ld) noexcept {
+    if (PM_BoxCrossLine(ctx, ld)) {
+        if (!PIT_CheckLine(ctx, ld)) {
             return false;
         }
     }
@@ -106,38 +93,38 @@ static bool PM_CrossCheck(line_t& ld) noexcept {
 //  tmdropoffz  The lowest point contacted (monsters won't move to a dropoff)
 //  movething
 //------------------------------------------------------------------------------------------------------------------------------------------
-void PM_CheckPosition() noexcept {
-    gTmpFlags = gpTmpThing->flags;
+void PM_CheckPosition(MapQueryContext& ctx) noexcept {
+    ctx.tmpFlags = ctx.pTmpThing->flags;
 
-    gTmpBBox[BOXTOP] = gTmpY + gpTmpThing->radius;
-    gTmpBBox[BOXBOTTOM] = gTmpY - gpTmpThing->radius;
-    gTmpBBox[BOXRIGHT] = gTmpX + gpTmpThing->radius;
-    gTmpBBox[BOXLEFT] = gTmpX - gpTmpThing->radius;
+    ctx.tmpBBox[BOXTOP] = ctx.tmpY + ctx.pTmpThing->radius;
+    ctx.tmpBBox[BOXBOTTOM] = ctx.tmpY - ctx.pTmpThing->radius;
+    ctx.tmpBBox[BOXRIGHT] = ctx.tmpX + ctx.pTmpThing->radius;
+    ctx.tmpBBox[BOXLEFT] = ctx.tmpX - ctx.pTmpThing->radius;
 
-    gpNewSubSec = &PointInSubsector(gTmpX,gTmpY);
+    ctx.pNewSubSec = &PointInSubsector(ctx.tmpX,ctx.tmpY);
 
     // The base floor / ceiling is from the subsector that contains the point.
     // Any contacted lines the step closer together will adjust them.
-    gTmpFloorZ = gTmpDropoffZ = gpNewSubSec->sector->floorheight;
-    gTmpCeilingZ = gpNewSubSec->sector->ceilingheight;
+    ctx.tmpFloorZ = ctx.tmpDropoffZ = ctx.pNewSubSec->sector->floorheight;
+    ctx.tmpCeilingZ = ctx.pNewSubSec->sector->ceilingheight;
 
-    ++gValidCount;
+    ctx.beginVisits();
 
-    gpMoveThing = nullptr;
-    gpBlockLine = nullptr;
+    ctx.pMoveThing = nullptr;
+    ctx.pBlockLine = nullptr;
 
-    if (gTmpFlags & MF_NOCLIP) {
-        gbTryMove2 = true;
+    if (ctx.tmpFlags & MF_NOCLIP) {
+        ctx.bTryMove2 = true;
         return;
     }
 
     // Check things first, possibly picking things up.
     // The bounding box is extended by MAXRADIUS because mobj_ts are grouped into mapblocks based
     // on their origin point, and can overlap into adjacent blocks by up to MAXRADIUS units.
-    int32_t xl = (gTmpBBox[BOXLEFT] - gBlockMapOriginX - MAXRADIUS) >> MAPBLOCKSHIFT;
-    int32_t xh = (gTmpBBox[BOXRIGHT] - gBlockMapOriginX + MAXRADIUS) >> MAPBLOCKSHIFT;
-    int32_t yl = (gTmpBBox[BOXBOTTOM] - gBlockMapOriginY - MAXRADIUS) >> MAPBLOCKSHIFT;
-    int32_t yh = (gTmpBBox[BOXTOP] - gBlockMapOriginY + MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t xl = (ctx.tmpBBox[BOXLEFT] - gBlockMapOriginX - MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t xh = (ctx.tmpBBox[BOXRIGHT] - gBlockMapOriginX + MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t yl = (ctx.tmpBBox[BOXBOTTOM] - gBlockMapOriginY - MAXRADIUS) >> MAPBLOCKSHIFT;
+    int32_t yh = (ctx.tmpBBox[BOXTOP] - gBlockMapOriginY + MAXRADIUS) >> MAPBLOCKSHIFT;
 
     xl = std::max(xl, 0);
     yl = std::max(yl, 0);
@@ -153,8 +140,8 @@ void PM_CheckPosition() noexcept {
 
         for (uint32_t bx = (uint32_t) xl; bx <= (uint32_t) xh; bx++) {
             for (uint32_t by = (uint32_t) yl; by <= (uint32_t) yh; by++) {
-                if (!BlockThingsIterator(bx, by, PIT_CheckThing)) {
-                    gbTryMove2 = false;
+                if (!BlockThingsIterator(ctx, bx, by, PIT_CheckThing)) {
+                    ctx.bTryMove2 = false;
                     return;
                 }
             }
@@ -162,10 +149,10 @@ void PM_CheckPosition() noexcept {
     }
 
     // Check lines
-    xl = (gTmpBBox[BOXLEFT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
-    xh = (gTmpBBox[BOXRIGHT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
-    yl = (gTmpBBox[BOXBOTTOM] - gBlockMapOriginY) >> MAPBLOCKSHIFT;
-    yh = (gTmpBBox[BOXTOP] - gBlockMapOriginY) >> MAPBLOCKSHIFT;
+    xl = (ctx.tmpBBox[BOXLEFT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
+    xh = (ctx.tmpBBox[BOXRIGHT] - gBlockMapOriginX) >> MAPBLOCKSHIFT;
+    yl = (ctx.tmpBBox[BOXBOTTOM] - gBlockMapOriginY) >> MAPBLOCKSHIFT;
+    yh = (ctx.tmpBBox[BOXTOP] - gBlockMapOriginY) >> MAPBLOCKSHIFT;
 
     xl = std::max(xl, 0);
     yl = std::max(yl, 0);
@@ -181,38 +168,38 @@ void PM_CheckPosition() noexcept {
 
         for (uint32_t bx = (uint32_t) xl; bx <= (uint32_t) xh; bx++) {
             for (uint32_t by = (uint32_t) yl; by <= (uint32_t) yh; by++) {
-                if (!BlockLinesIterator(bx, by, PM_CrossCheck)) {
-                    gbTryMove2 = false;
+                if (!BlockLinesIterator(ctx, bx, by, PM_CrossCheck)) {
+                    ctx.bTryMove2 = false;
                     return;
                 }
             }
         }
     }
 
-    gbTryMove2 = true;
+    ctx.bTryMove2 = true;
     return;
 }
 
-bool PM_BoxCrossLine(line_t& ld) noexcept {    
-    if ((gTmpBBox[BOXRIGHT] <= ld.bbox[BOXLEFT]) ||
-        (gTmpBBox[BOXLEFT] >= ld.bbox[BOXRIGHT]) ||
-        (gTmpBBox[BOXTOP] <= ld.bbox[BOXBOTTOM]) ||
-        (gTmpBBox[BOXBOTTOM] >= ld.bbox[BOXTOP])
+bool PM_BoxCrossLine(MapQueryContext& ctx, line_t& ld) noexcept {    
+    if ((ctx.tmpBBox[BOXRIGHT] <= ld.bbox[BOXLEFT]) ||
+        (ctx.tmpBBox[BOXLEFT] >= ld.bbox[BOXRIGHT]) ||
+        (ctx.tmpBBox[BOXTOP] <= ld.bbox[BOXBOTTOM]) ||
+        (ctx.tmpBBox[BOXBOTTOM] >= ld.bbox[BOXTOP])
     ) {
         return false;
     }
 
-    const Fixed y1 = gTmpBBox[BOXTOP];
-    const Fixed y2 = gTmpBBox[BOXBOTTOM];
+    const Fixed y1 = ctx.tmpBBox[BOXTOP];
+    const Fixed y2 = ctx.tmpBBox[BOXBOTTOM];
     Fixed x1;
     Fixed x2;
 
     if (ld.slopetype == ST_POSITIVE) {
-        x1 = gTmpBBox[BOXLEFT];
-        x2 = gTmpBBox[BOXRIGHT];
+        x1 = ctx.tmpBBox[BOXLEFT];
+        x2 = ctx.tmpBBox[BOXRIGHT];
     } else {
-        x1 = gTmpBBox[BOXRIGHT];
-        x2 = gTmpBBox[BOXLEFT];
+        x1 = ctx.tmpBBox[BOXRIGHT];
+        x2 = ctx.tmpBBox[BOXLEFT];
     }
 
     const Fixed lx = ld.v1.x;
@@ -233,7 +220,7 @@ bool PM_BoxCrossLine(line_t& ld) noexcept {
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Adjusts tmfloorz and tmceilingz as lines are contacted
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool PIT_CheckLine(line_t& ld) noexcept {
+bool PIT_CheckLine(MapQueryContext& ctx, line_t& ld) noexcept {
     // A line has been hit:
     // The moving thing's destination position will cross the given line.
     // If this should not be allowed, return false.
@@ -241,12 +228,12 @@ bool PIT_CheckLine(line_t& ld) noexcept {
         return false;   // One sided line
     }
 
-    if ((gpTmpThing->flags & MF_MISSILE) == 0) {
+    if ((ctx.pTmpThing->flags & MF_MISSILE) == 0) {
         if ((ld.flags & ML_BLOCKING) != 0) {
             return false;   // Explicitly blocking everything
         }
 
-        if ((!gpTmpThing->player) && ((ld.flags & ML_BLOCKMONSTERS) != 0)) {
+        if ((!ctx.pTmpThing->player) && ((ld.flags & ML_BLOCKMONSTERS) != 0)) {
             return false;   // Block monsters only
         }
     }
@@ -257,7 +244,7 @@ bool PIT_CheckLine(line_t& ld) noexcept {
     if ((front.ceilingheight == front.floorheight) ||
         (back.ceilingheight == back.floorheight)
     ) {
-        gpBlockLine = &ld;
+        ctx.pBlockLine = &ld;
         return false;   // Probably a closed door
     }
 
@@ -281,28 +268,28 @@ bool PIT_CheckLine(line_t& ld) noexcept {
     }
 
     // Adjust floor / ceiling heights
-    if (pm_opentop < gTmpCeilingZ) {
-        gTmpCeilingZ = pm_opentop;
+    if (pm_opentop < ctx.tmpCeilingZ) {
+        ctx.tmpCeilingZ = pm_opentop;
     }
 
-    if (pm_openbottom > gTmpFloorZ) {
-        gTmpFloorZ = pm_openbottom;
+    if (pm_openbottom > ctx.tmpFloorZ) {
+        ctx.tmpFloorZ = pm_openbottom;
     }
 
-    if (pm_lowfloor < gTmpDropoffZ) {
-        gTmpDropoffZ = pm_lowfloor;
+    if (pm_lowfloor < ctx.tmpDropoffZ) {
+        ctx.tmpDropoffZ = pm_lowfloor;
     }
 
     return true;
 }
 
-bool PIT_CheckThing(mobj_t& thing) noexcept {
+bool PIT_CheckThing(MapQueryContext& ctx, mobj_t& thing) noexcept {
     if ((thing.flags & (MF_SOLID|MF_SPECIAL|MF_SHOOTABLE)) == 0) {
         return true;
     }
 
-    const Fixed blockdist = thing.radius + gpTmpThing->radius;
-    Fixed delta = thing.x - gTmpX;
+    const Fixed blockdist = thing.radius + ctx.pTmpThing->radius;
+    Fixed delta = thing.x - ctx.tmpX;
 
     if (delta < 0) {
         delta = -delta;
@@ -312,7 +299,7 @@ bool PIT_CheckThing(mobj_t& thing) noexcept {
         return true;    // Didn't hit it
     }
 
-    delta = thing.y - gTmpY;
+    delta = thing.y - ctx.tmpY;
     if (delta < 0) {
         delta = -delta;
     }
@@ -321,29 +308,31 @@ bool PIT_CheckThing(mobj_t& thing) noexcept {
         return true;    // Didn't hit it
     }
 
-    if (&thing == gpTmpThing) {
+    if (&thing == ctx.pTmpThing) {
         return true;    // Don't clip against self
     }
 
     // Check for skulls slamming into things
-    if ((gpTmpThing->flags & MF_SKULLFLY) != 0) {
-        gpMoveThing = &thing;
+    if ((ctx.pTmpThing->flags & MF_SKULLFLY) != 0) {
+        ctx.pMoveThing = &thing;
         return false;   // Stop moving
     }
 
     // Missiles can hit other things
-    if ((gpTmpThing->flags & MF_MISSILE) != 0) {
+    if ((ctx.pTmpThing->flags & MF_MISSILE) != 0) {
         // See if it went over / under
-        if (gpTmpThing->z > thing.z + thing.height) {
+        if (ctx.pTmpThing->z > thing.z + thing.height) {
             return true;    // Overhead
         }
         
-        if (gpTmpThing->z + gpTmpThing->height < thing.z) {
+        if (ctx.pTmpThing->z + ctx.pTmpThing->height < thing.z) {
             return true;    // Underneath
         }
 
-        if (gpTmpThing->target->InfoPtr == thing.InfoPtr) { // Don't hit same species as originator
-            if (&thing == gpTmpThing->target) {
+        const mobj_t* const pShooter = getTarget(*ctx.pTmpThing);
+
+        if (pShooter && (pShooter->InfoPtr == thing.InfoPtr)) {     // Don't hit same species as originator
+            if (&thing == pShooter) {
                 return true;
             }
 
@@ -359,13 +348,13 @@ bool PIT_CheckThing(mobj_t& thing) noexcept {
         }
 
         // Damage / explode
-        gpMoveThing = &thing;
+        ctx.pMoveThing = &thing;
         return false;   // Don't traverse any more
     }
 
     // Check for special pickup
-    if (((thing.flags & MF_SPECIAL) != 0) && ((gTmpFlags & MF_PICKUP) != 0)) {
-        gpMoveThing = &thing;
+    if (((thing.flags & MF_SPECIAL) != 0) && ((ctx.tmpFlags & MF_PICKUP) != 0)) {
+        ctx.pMoveThing = &thing;
         return true;
     }
 
@@ -2,6 +2,7 @@
 
 #include "Base/Angle.h"
 #include "Base/Fixed.h"
+#include "MObjTable.h"
 #include "PlayerSprites.h"
 
 struct sector_t;
@@ -87,7 +88,7 @@ struct player_t {
     uint32_t        itemcount;                  // Number of items gathered
     uint32_t        secretcount;                // Number of secret sectors touched
     const char*     message;                    // Hint messages
-    mobj_t*         attacker;                   // Who did damage (NULL for floors)
+    MObjHandle      attacker;                   // Who did damage (NULL for floors)
     uint32_t        extralight;                 // so gun flashes light up areas
     uint32_t        fixedcolormap;              // can be set to REDCOLORMAP, etc
     uint32_t        colormap;                   // 0-3 for which color to draw player
@@ -11,6 +11,7 @@
 #include "Interactions.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "MapObj.h"
 
@@ -85,7 +86,7 @@ static constexpr state_t* WEAPON_FLASH_STATES[NUMWEAPONS] = {
 };
 
 // Player object to track (Make global to avoid passing it)
-static mobj_t* gpSoundTarget;
+static MObjHandle gSoundTarget;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Recursively scan all the sectors within earshot so the monsters will begin tracking the player.
@@ -96,7 +97,7 @@ static void RecursiveSound(sector_t& sec, const uint32_t soundblocks) noexcept {
     if (sec.validcount != gValidCount || sec.soundtraversed > (soundblocks + 1)) {
         sec.validcount = gValidCount;           // Mark for flood fill
         sec.soundtraversed = soundblocks+1;     // distance for sound (1 or 2)
-        sec.soundtarget = gpSoundTarget;        // Set the noise maker source
+        sec.soundtarget = gSoundTarget;         // Set the noise maker source
         uint32_t count = sec.linecount;         // How many lines to check?
         line_t** ppChecker = sec.lines;
 
@@ -134,11 +135,11 @@ static void NoiseAlert(player_t& player) noexcept {
     ASSERT(player.mo->subsector->sector);
     sector_t& sec = *player.mo->subsector->sector;
 
-    if (player.lastsoundsector != &sec) {       // Not the same one?
-        player.lastsoundsector = &sec;          // Set the new sector I made sound in
-        gpSoundTarget = player.mo;              // Set the target for the monsters
-        ++gValidCount;                          // Set a unique number for sector flood fill
-        RecursiveSound(sec, 0);                 // Wake the monsters
+    if (player.lastsoundsector != &sec) {                   // Not the same one?
+        player.lastsoundsector = &sec;                      // Set the new sector I made sound in
+        gSoundTarget = MObjTable::getHandle(player.mo);     // Set the target for the monsters
+        ++gValidCount;                                      // Set a unique number for sector flood fill
+        RecursiveSound(sec, 0);                             // Wake the monsters
     }
 }
 
@@ -367,8 +368,10 @@ void A_Punch(player_t& player, [[maybe_unused]] pspdef_t& psp) noexcept {
     mobj_t& mo = *player.mo;                                // Get the object into a local
     angle_t angle = mo.angle;                               // Get the player's angle
     angle += (255 - Random::nextU32(511)) << 18;            // Adjust for direction of attack
-    LineAttack(mo, angle, MELEERANGE, FRACMAX, damage);     // Attack!
-    mobj_t* const pTarget = gpLineTarget;
+
+    MapQueryContext& ctx = gMapQueryContext;
+    LineAttack(ctx, mo, angle, MELEERANGE, FRACMAX, damage);    // Attack!
+    mobj_t* const pTarget = ctx.pLineTarget;
 
     if (pTarget) {                                                      // Did I hit someone?
         mo.angle = PointToAngle(mo.x, mo.y, pTarget->x, pTarget->y);    // Point the player to the victim
@@ -386,8 +389,9 @@ void A_Saw(player_t& player, [[maybe_unused]] pspdef_t& psp) noexcept {
     angle += (255 - Random::nextU32(511)) << 18;            // Add a little randomness
 
     // Use meleerange + 1 so the puff doesn't skip the flash
-    LineAttack(mo, angle, MELEERANGE + 1, FRACMAX, damage);
-    mobj_t* const pTarget = gpLineTarget;
+    MapQueryContext& ctx = gMapQueryContext;
+    LineAttack(ctx, mo, angle, MELEERANGE + 1, FRACMAX, damage);
+    mobj_t* const pTarget = ctx.pLineTarget;
 
     if (!pTarget) {
         // If nobody is hit just do a loud saw sound every so often
@@ -455,7 +459,7 @@ static void GunShot(mobj_t& mo, const bool bAccurate) noexcept {
         angle += (255 - Random::nextU32(511)) << 18;        // Make it a little random
     }
 
-    LineAttack(mo, angle, MISSILERANGE, FRACMAX, damage);   // Inflict damage
+    LineAttack(gMapQueryContext, mo, angle, MISSILERANGE, FRACMAX, damage);     // Inflict damage
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -480,13 +484,14 @@ void A_FireShotgun(player_t& player, [[maybe_unused]] pspdef_t& psp) noexcept {
 
     // Shotgun pellets all go at a fixed slope.
     // There are also 7 pellets.
-    Fixed slope = AimLineAttack(mo, mo.angle, MISSILERANGE);
+    MapQueryContext& ctx = gMapQueryContext;
+    Fixed slope = AimLineAttack(ctx, mo, mo.angle, MISSILERANGE);
 
     for (uint32_t i = 7; i > 0; --i) {
-        uint32_t damage = (Random::nextU32(3) + 1) * 4;         // Damage done: 1D4 * 4
+        uint32_t damage = (Random::nextU32(3) + 1) * 4;             // Damage done: 1D4 * 4
         angle_t angle = mo.angle;
-        angle += (255 - Random::nextU32(511)) << 18;            // Get some randomness
-        LineAttack(mo, angle, MISSILERANGE, slope, damage);     // Do damage
+        angle += (255 - Random::nextU32(511)) << 18;                // Get some randomness
+        LineAttack(ctx, mo, angle, MISSILERANGE, slope, damage);    // Do damage
     }
 }
 
@@ -542,11 +547,17 @@ void A_Light2(player_t& player, [[maybe_unused]] pspdef_t& psp) noexcept {
 void A_BFGSpray(mobj_t& mo) noexcept {
     // Offset angles from its attack angle
     angle_t an = (mo.angle - (ANG90 / 2));
+    MapQueryContext& ctx = gMapQueryContext;
+
+    // mo->target is the originator (player) of the missile
+    mobj_t* const pShooter = getTarget(mo);
+
+    if (!pShooter)
+        return;
 
     for (uint32_t i = 40; i > 0; --i) {
-        // mo->target is the originator (player) of the missile
-        AimLineAttack(*mo.target, an, 16 * 64 * FRACUNIT);
-        mobj_t* const pTarget = gpLineTarget;
+        AimLineAttack(ctx, *pShooter, an, 16 * 64 * FRACUNIT);
+        mobj_t* const pTarget = ctx.pLineTarget;
 
         if (pTarget) {
             SpawnMObj(
@@ -561,7 +572,7 @@ void A_BFGSpray(mobj_t& mo) noexcept {
                 damage += Random::nextU32(7);
             }
 
-            DamageMObj(*pTarget, mo.target, mo.target, damage);
+            DamageMObj(*pTarget, pShooter, pShooter, damage);
         }
 
         an += (ANG90 / 40);     // Step the angle for the attack
@@ -4,6 +4,7 @@
 #include "Game/Data.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "Map/Sight.h"
 #include "MapObj.h"
@@ -12,75 +13,34 @@
 
 BEGIN_NAMESPACE(Shoot)
 
-//------------------------------------------------------------------------------------------------------------------------------------------
-// Input values:
-//
-//  A line will be shootdivd from the middle of shooter in the direction of attackangle until either a shootable
-//  mobj is within the visible aimtopslope / aimbottomslope range, or a solid wall blocks further tracing.
-//  If no thing is targeted along the entire range, the first line that blocks the midpoint of the shootdiv will be hit.
-//------------------------------------------------------------------------------------------------------------------------------------------
-line_t*     gpShootLine;
-mobj_t*     gpShootMObj;
-Fixed       gShootSlope;    // Between aimtop and aimbottom
-Fixed       gShootX;
-Fixed       gShootY;
-Fixed       gShootZ;        // Location for puff/blood
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-// Represents a possible hit with something being shit.
-// Stores the hit fraction and the thing hit, and whether it is a thing or a line.
-// Also supports sorting, so we process the closest hit first!
-//------------------------------------------------------------------------------------------------------------------------------------------
-struct Intercept {
-    Fixed   frac;
-    void*   pObj;
-    bool    bIsLine;
-
-    inline bool operator < (const Intercept& other) const noexcept {
-        return (frac < other.frac);
-    }
-};
-
-static std::vector<Intercept>   gIntercepts;
-static Fixed                    gAimMidSlope;           // For detecting first wall hit
-static vector_t                 gShootDiv;
-static Fixed                    gShootX2;
-static Fixed                    gShootY2;
-static Fixed                    gFirstLineFrac;
-static bool                     gbShootDivPositive;
-static int32_t                  gSsx1;
-static int32_t                  gSsy1;
-static int32_t                  gSsx2;
-static int32_t                  gSsy2;
-
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Returns true if strace crosses the given node successfuly
 //------------------------------------------------------------------------------------------------------------------------------------------
-static bool PA_CrossBSPNode(node_t* pNode) {
+static bool PA_CrossBSPNode(MapQueryContext& ctx, node_t* pNode) noexcept {
     if (isBspNodeASubSector(pNode)) {
         // N.B: pointer has to be fixed up due to prescence of a flag in the lowest bit!
         const subsector_t* const pSubSector = (subsector_t*) getActualBspNodePtr(pNode);
-        return PA_CrossSubsector(*pSubSector);
+        return PA_CrossSubsector(ctx, *pSubSector);
     }
 
     // Decide which side the start point is on and cross the starting side
-    const bool bOnRightSide = PointOnVectorSide(gShootDiv.x, gShootDiv.y, pNode->Line);
+    const bool bOnRightSide = PointOnVectorSide(ctx.shootDiv.x, ctx.shootDiv.y, pNode->Line);
     const uint32_t sideIdx = (bOnRightSide) ? 1 : 0;
 
-    if (!PA_CrossBSPNode((node_t*) pNode->Children[sideIdx])) {
+    if (!PA_CrossBSPNode(ctx, (node_t*) pNode->Children[sideIdx])) {
         return false;
     }
 
     // The partition plane is crossed here
-    if (bOnRightSide == PointOnVectorSide(gShootX2, gShootY2, pNode->Line)) {
+    if (bOnRightSide == PointOnVectorSide(ctx.shootX2, ctx.shootY2, pNode->Line)) {
         return true;    // The line doesn't touch the other side
     }
 
     // Cross the ending side
-    return PA_CrossBSPNode((node_t*) pNode->Children[sideIdx ^ 1]);
+    return PA_CrossBSPNode(ctx, (node_t*) pNode->Children[sideIdx ^ 1]);
 }
 
-static bool PA_DoIntercept(void* pValue, bool isLine, Fixed frac) noexcept {
+static bool PA_DoIntercept(MapQueryContext& ctx, void* pValue, bool isLine, Fixed frac) noexcept {
     if (frac == 0 || frac >= FRACUNIT)
         return true;
 
@@ -88,76 +48,69 @@ static bool PA_DoIntercept(void* pValue, bool isLine, Fixed frac) noexcept {
     
     if (isLine) {
         line_t* const pLine = (line_t*) pValue;
-        return PA_ShootLine(*pLine, frac);
+        return PA_ShootLine(ctx, *pLine, frac);
     } else {
         mobj_t* const pThing = (mobj_t*) pValue;
 
-        // DC: must check for line of sight now because I sweep in all of the things in a sector when visiting it's subsector
-        if (CheckSight(*gpShooter, *pThing, false)) {
-            return PA_ShootThing(*pThing, frac);
+        // DC: must check for line of sight now because I sweep in all of the things in a sector when visiting it's subsector.
+        // Note: this restarts the line and sector visits of the context, the same as the original check did, which affects what the
+        // rest of the shot visits.
+        if (CheckSight(*ctx.pShooter, *pThing, false, &ctx)) {
+            return PA_ShootThing(ctx, *pThing, frac);
         } else {
             return true;
         }
     }
 }
 
-void init() noexcept {
-    gIntercepts.reserve(64);
-}
-
-void shutdown() noexcept {
-    gIntercepts.clear();
-    gIntercepts.shrink_to_fit();
-}
-
-void P_Shoot2() noexcept {
-    ASSERT(gpShooter);
-    mobj_t& shooter = *gpShooter;
+void P_Shoot2(MapQueryContext& ctx) noexcept {
+    ASSERT(ctx.pShooter);
+    mobj_t& shooter = *ctx.pShooter;
 
-    gpShootLine = nullptr;
-    gpShootMObj = nullptr;
+    ctx.pShootLine = nullptr;
+    ctx.pShootMObj = nullptr;
 
-    const uint32_t angle = gAttackAngle >> ANGLETOFINESHIFT;
+    const uint32_t angle = ctx.attackAngle >> ANGLETOFINESHIFT;
 
-    gShootDiv.x = shooter.x;
-    gShootDiv.y = shooter.y;
-    gShootX2 = shooter.x + (gAttackRange >> FRACBITS) * gFineCosine[angle];
-    gShootY2 = shooter.y + (gAttackRange >> FRACBITS) * gFineSine[angle];
-    gShootDiv.dx = gShootX2 - gShootDiv.x;
-    gShootDiv.dy = gShootY2 - gShootDiv.y;
-    gShootZ = shooter.z + (shooter.height >> 1) + 8 * FRACUNIT;
+    ctx.shootDiv.x = shooter.x;
+    ctx.shootDiv.y = shooter.y;
+    ctx.shootX2 = shooter.x + (ctx.attackRange >> FRACBITS) * gFineCosine[angle];
+    ctx.shootY2 = shooter.y + (ctx.attackRange >> FRACBITS) * gFineSine[angle];
+    ctx.shootDiv.dx = ctx.shootX2 - ctx.shootDiv.x;
+    ctx.shootDiv.dy = ctx.shootY2 - ctx.shootDiv.y;
+    ctx.shootZ = shooter.z + (shooter.height >> 1) + 8 * FRACUNIT;
 
-    gbShootDivPositive = ((gShootDiv.dx ^ gShootDiv.dy) > 0);
+    ctx.bShootDivPositive = ((ctx.shootDiv.dx ^ ctx.shootDiv.dy) > 0);
 
-    gSsx1 = gShootDiv.x >> 16;
-    gSsy1 = gShootDiv.y >> 16;
-    gSsx2 = gShootX2 >> 16;
-    gSsy2 = gShootY2 >> 16;
+    ctx.ssx1 = ctx.shootDiv.x >> 16;
+    ctx.ssy1 = ctx.shootDiv.y >> 16;
+    ctx.ssx2 = ctx.shootX2 >> 16;
+    ctx.ssy2 = ctx.shootY2 >> 16;
 
-    ++gValidCount;
-    gAimMidSlope = (gAimTopSlope + gAimBottomSlope) >> 1;
-    PA_CrossBSPNode(gpBSPTreeRoot);
+    ctx.beginVisits();
+    ctx.aimMidSlope = (ctx.aimTopSlope + ctx.aimBottomSlope) >> 1;
+    PA_CrossBSPNode(ctx, gpBSPTreeRoot);
 
     // post process
-    if (gpShootMObj)
+    if (ctx.pShootMObj)
         return;
 
-    if (!gpShootLine)
+    if (!ctx.pShootLine)
         return;
 
     // Calculate the intercept point for the first line hit. Position a bit closer:
-    gFirstLineFrac -= fixed16Div(4 * FRACUNIT, gAttackRange);
+    ctx.firstLineFrac -= fixed16Div(4 * FRACUNIT, ctx.attackRange);
 
-    gShootX = gShootDiv.x + fixed16Mul(gShootDiv.dx, gFirstLineFrac);
-    gShootY = gShootDiv.y + fixed16Mul(gShootDiv.dy, gFirstLineFrac);
-    gShootZ = gShootZ + fixed16Mul(gAimMidSlope, fixed16Mul(gFirstLineFrac, gAttackRange));
+    ctx.shootX = ctx.shootDiv.x + fixed16Mul(ctx.shootDiv.dx, ctx.firstLineFrac);
+    ctx.shootY = ctx.shootDiv.y + fixed16Mul(ctx.shootDiv.dy, ctx.firstLineFrac);
+    ctx.shootZ = ctx.shootZ + fixed16Mul(ctx.aimMidSlope, fixed16Mul(ctx.firstLineFrac, ctx.attackRange));
 }
 
-bool PA_ShootLine(line_t& li, const Fixed interceptfrac) noexcept {
+bool PA_ShootLine(MapQueryContext& ctx, line_t& li, const Fixed interceptfrac) noexcept {
     if ((li.flags & ML_TWOSIDED) == 0) {
-        if (!gpShootLine) {
-            gpShootLine = &li;
-            gFirstLineFrac = interceptfrac;
+        if (!ctx.pShootLine) {
+            ctx.pShootLine = &li;
+            ctx.firstLineFrac = interceptfrac;
         }
 
         return false;   // Don't shoot anything past this
@@ -172,9 +125,9 @@ bool PA_ShootLine(line_t& li, const Fixed interceptfrac) noexcept {
         Fixed minCeil = std::min(frontSec.ceilingheight, backSec.ceilingheight);
 
         if (maxFloor >= minCeil) {
-            if (!gpShootLine) {
-                gpShootLine = &li;
-                gFirstLineFrac = interceptfrac;
+            if (!ctx.pShootLine) {
+                ctx.pShootLine = &li;
+                ctx.firstLineFrac = interceptfrac;
             }
 
             return false;   // No gap/opening: don't shoot anything past this
@@ -197,77 +150,77 @@ bool PA_ShootLine(line_t& li, const Fixed interceptfrac) noexcept {
         openbottom = backSec.floorheight;
     }
 
-    const Fixed dist = fixed16Mul(gAttackRange, interceptfrac);
+    const Fixed dist = fixed16Mul(ctx.attackRange, interceptfrac);
 
     if (li.frontsector->floorheight != li.backsector->floorheight) {
-        const Fixed slope = fixed16Div(openbottom - gShootZ, dist);
+        const Fixed slope = fixed16Div(openbottom - ctx.shootZ, dist);
 
-        if ((slope >= gAimMidSlope) && (!gpShootLine)) {
-            gpShootLine = &li;
-            gFirstLineFrac = interceptfrac;
+        if ((slope >= ctx.aimMidSlope) && (!ctx.pShootLine)) {
+            ctx.pShootLine = &li;
+            ctx.firstLineFrac = interceptfrac;
         }
 
-        if (slope > gAimBottomSlope) {
-            gAimBottomSlope = slope;
+        if (slope > ctx.aimBottomSlope) {
+            ctx.aimBottomSlope = slope;
         }
     }
 
     if (li.frontsector->ceilingheight != li.backsector->ceilingheight) {
-        const Fixed slope = fixed16Div(opentop - gShootZ, dist);
+        const Fixed slope = fixed16Div(opentop - ctx.shootZ, dist);
 
-        if ((slope <= gAimMidSlope) && (!gpShootLine)) {
-            gpShootLine = &li;
-            gFirstLineFrac = interceptfrac;
+        if ((slope <= ctx.aimMidSlope) && (!ctx.pShootLine)) {
+            ctx.pShootLine = &li;
+            ctx.firstLineFrac = interceptfrac;
         }
 
-        if (slope < gAimTopSlope) {
-            gAimTopSlope = slope;
+        if (slope < ctx.aimTopSlope) {
+            ctx.aimTopSlope = slope;
         }
     }
 
-    if (gAimTopSlope <= gAimBottomSlope)
+    if (ctx.aimTopSlope <= ctx.aimBottomSlope)
         return false;   // Stop
 
     return true;    // Shot continues
 }
 
-bool PA_ShootThing(mobj_t& th, const Fixed interceptfrac) noexcept {
-    if (&th == gpShooter)
+bool PA_ShootThing(MapQueryContext& ctx, mobj_t& th, const Fixed interceptfrac) noexcept {
+    if (&th == ctx.pShooter)
         return true;    // Can't shoot self
 
     if ((th.flags & MF_SHOOTABLE) == 0)
         return true;    // Corpse or something
     
     // Check angles to see if the thing can be aimed at
-    const Fixed dist = fixed16Mul(gAttackRange, interceptfrac);
-    Fixed thingaimtopslope = fixed16Div(th.z + th.height - gShootZ, dist);
+    const Fixed dist = fixed16Mul(ctx.attackRange, interceptfrac);
+    Fixed thingaimtopslope = fixed16Div(th.z + th.height - ctx.shootZ, dist);
 
-    if (thingaimtopslope < gAimBottomSlope)
+    if (thingaimtopslope < ctx.aimBottomSlope)
         return true;    // Shot over the thing
 
-    Fixed thingaimbottomslope = fixed16Div(th.z - gShootZ, dist);
+    Fixed thingaimbottomslope = fixed16Div(th.z - ctx.shootZ, dist);
 
-    if (thingaimbottomslope > gAimTopSlope)
+    if (thingaimbottomslope > ctx.aimTopSlope)
         return true;    // Shot under the thing
     
     // This thing can be hit!
-    if (thingaimtopslope > gAimTopSlope) {
-        thingaimtopslope = gAimTopSlope;
+    if (thingaimtopslope > ctx.aimTopSlope) {
+        thingaimtopslope = ctx.aimTopSlope;
     }
 
-    if (thingaimbottomslope < gAimBottomSlope) {
-        thingaimbottomslope = gAimBottomSlope;
+    if (thingaimbottomslope < ctx.aimBottomSlope) {
+        thingaimbottomslope = ctx.aimBottomSlope;
     }
 
     // Shoot midway in the visible part of the thing
-    gShootSlope = (thingaimtopslope + thingaimbottomslope) / 2;
-    gpShootMObj = &th;
+    ctx.shootSlope = (thingaimtopslope + thingaimbottomslope) / 2;
+    ctx.pShootMObj = &th;
 
     // position a bit closer
-    const Fixed frac = interceptfrac - fixed16Div(10 * FRACUNIT, gAttackRange);
-    gShootX = gShootDiv.x + fixed16Mul(gShootDiv.dx, frac);
-    gShootY = gShootDiv.y + fixed16Mul(gShootDiv.dy, frac);
-    gShootZ = gShootZ + fixed16Mul(gShootSlope, fixed16Mul(frac, gAttackRange));
+    const Fixed frac = interceptfrac - fixed16Div(10 * FRACUNIT, ctx.attackRange);
+    ctx.shootX = ctx.shootDiv.x + fixed16Mul(ctx.shootDiv.dx, frac);
+    ctx.shootY = ctx.shootDiv.y + fixed16Mul(ctx.shootDiv.dy, frac);
+    ctx.shootZ = ctx.shootZ + fixed16Mul(ctx.shootSlope, fixed16Mul(frac, ctx.attackRange));
 
     return false;   // Don't go any farther
 }
@@ -278,7 +231,7 @@ bool PA_ShootThing(mobj_t& th, const Fixed interceptfrac) noexcept {
 // If so, it calculates the fractional distance along the sight trace that the intersection occurs at.
 // If 0 < intercept < 1.0, the line will block the sight.
 //------------------------------------------------------------------------------------------------------------------------------------------
-Fixed PA_SightCrossLine(const vertex_t& lineV1, const vertex_t& lineV2) noexcept {
+Fixed PA_SightCrossLine(const MapQueryContext& ctx, const vertex_t& lineV1, const vertex_t& lineV2) noexcept {
     // P1, P2 are line endpoints
     int32_t p1x = fixed16ToInt(lineV1.x);
     int32_t p1y = fixed16ToInt(lineV1.y);
@@ -286,10 +239,10 @@ Fixed PA_SightCrossLine(const vertex_t& lineV1, const vertex_t& lineV2) noexcept
     int32_t p2y = fixed16ToInt(lineV2.y);
     
     // P3, P4 are sight endpoints
-    int32_t p3x = gSsx1;
-    int32_t p3y = gSsy1;
-    int32_t p4x = gSsx2;
-    int32_t p4y = gSsy2;
+    int32_t p3x = ctx.ssx1;
+    int32_t p3y = ctx.ssy1;
+    int32_t p4x = ctx.ssx2;
+    int32_t p4y = ctx.ssy2;
 
     int32_t dx = p2x - p3x;
     int32_t dy = p2y - p3y;
@@ -319,16 +272,16 @@ Fixed PA_SightCrossLine(const vertex_t& lineV1, const vertex_t& lineV2) noexcept
     return s2;
 }
 
-Fixed PA_SightCrossLine(const line_t& line) noexcept {
-    return PA_SightCrossLine(line.v1, line.v2);
+Fixed PA_SightCrossLine(const MapQueryContext& ctx, const line_t& line) noexcept {
+    return PA_SightCrossLine(ctx, line.v1, line.v2);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Returns true if strace crosses the given subsector successfuly
 //------------------------------------------------------------------------------------------------------------------------------------------
-bool PA_CrossSubsector(const subsector_t& sub) noexcept {
+bool PA_CrossSubsector(MapQueryContext& ctx, const subsector_t& sub) noexcept {
     // Ensure this list is clear before we begin
-    gIntercepts.clear();
+    ctx.intercepts.clear();
     
     // Check lines
     {
@@ -337,11 +290,10 @@ bool PA_CrossSubsector(const subsector_t& sub) noexcept {
         for (uint32_t count = sub.numsublines; count > 0; pSeg++, count--) {
             line_t& line = *pSeg->linedef;
 
-            if (line.validCount == gValidCount)
+            if (ctx.testAndMarkLine(line))
                 continue;   // Already checked other side
 
-            line.validCount = gValidCount;
-            const Fixed frac = PA_SightCrossLine(line);
+            const Fixed frac = PA_SightCrossLine(ctx, line);
 
             if (frac <=  0 || frac > FRACUNIT)
                 continue;
@@ -351,7 +303,7 @@ bool PA_CrossSubsector(const subsector_t& sub) noexcept {
             intercept.bIsLine = true;
             intercept.pObj = &line;
 
-            gIntercepts.push_back(intercept);
+            ctx.intercepts.push_back(intercept);
         }
     }
 
@@ -366,8 +318,7 @@ bool PA_CrossSubsector(const subsector_t& sub) noexcept {
     //
     sector_t& sector = *sub.sector;
 
-    if (sector.validcount != gValidCount) {
-        sector.validcount = gValidCount;
+    if (!ctx.testAndMarkSector(sector)) {
 
         for (mobj_t* pThing = sector.thinglist; pThing != nullptr; pThing = pThing->snext) {           
             if ((pThing->flags & MF_SHOOTABLE) == 0)
@@ -377,7 +328,7 @@ bool PA_CrossSubsector(const subsector_t& sub) noexcept {
             vertex_t thingLineV1;
             vertex_t thingLineV2;
 
-            if (gbShootDivPositive) {
+            if (ctx.bShootDivPositive) {
                 thingLineV1.x = pThing->x - pThing->radius;
                 thingLineV1.y = pThing->y + pThing->radius;
                 thingLineV2.x = pThing->x + pThing->radius;
@@ -389,7 +340,7 @@ bool PA_CrossSubsector(const subsector_t& sub) noexcept {
                 thingLineV2.y = pThing->y + pThing->radius;
             }
 
-            const Fixed frac = PA_SightCrossLine(thingLineV1, thingLineV2);
+            const Fixed frac = PA_SightCrossLine(ctx, thingLineV1, thingLineV2);
 
             if (frac <= 0 || frac > FRACUNIT)
                 continue;
@@ -399,15 +350,15 @@ bool PA_CrossSubsector(const subsector_t& sub) noexcept {
             intercept.bIsLine = false;
             intercept.pObj = pThing;
 
-            gIntercepts.push_back(intercept);
+            ctx.intercepts.push_back(intercept);
         }
     }
 
     // Start processing intercepts, with the closest first
-    std::sort(gIntercepts.begin(), gIntercepts.end());
+    std::sort(ctx.intercepts.begin(), ctx.intercepts.end());
 
-    for (const Intercept& intercept : gIntercepts) {
-        if (!PA_DoIntercept(intercept.pObj, intercept.bIsLine, intercept.frac))
+    for (const Intercept& intercept : ctx.intercepts) {
+        if (!PA_DoIntercept(ctx, intercept.pObj, intercept.bIsLine, intercept.frac))
             return false;
     }
 
@@ -4,27 +4,28 @@
 #include "Base/Fixed.h"
 
 struct line_t;
+struct MapQueryContext;
 struct mobj_t;
 struct subsector_t;
 struct vertex_t;
 
 BEGIN_NAMESPACE(Shoot)
 
-extern line_t*  gpShootLine;
-extern mobj_t*  gpShootMObj;
-extern Fixed    gShootSlope;     // Between aimtop and aimbottom
-extern Fixed    gShootX;         // Location for puff/blood
-extern Fixed    gShootY;
-extern Fixed    gShootZ;
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Input values (from the context):
+//
+//  A line will be shootdivd from the middle of shooter in the direction of attackangle until either a shootable
+//  mobj is within the visible aimtopslope / aimbottomslope range, or a solid wall blocks further tracing.
+//  If no thing is targeted along the entire range, the first line that blocks the midpoint of the shootdiv will be hit.
+//
+// The line or thing hit, the slope of the shot and the location for the puff or blood are output to the context.
+//------------------------------------------------------------------------------------------------------------------------------------------
+void P_Shoot2(MapQueryContext& ctx) noexcept;
 
-void init() noexcept;
-void shutdown() noexcept;
-
-void P_Shoot2() noexcept;
-bool PA_ShootLine(line_t& li, const Fixed interceptfrac) noexcept;
-bool PA_ShootThing(mobj_t& th, const Fixed interceptfrac) noexcept;
-Fixed PA_SightCrossLine(const vertex_t& lineV1, const vertex_t& lineV2) noexcept;
-Fixed PA_SightCrossLine(const line_t& line) noexcept;
-bool PA_CrossSubsector(const subsector_t& sub) noexcept;
+bool PA_ShootLine(MapQueryContext& ctx, line_t& li, const Fixed interceptfrac) noexcept;
+bool PA_ShootThing(MapQueryContext& ctx, mobj_t& th, const Fixed interceptfrac) noexcept;
+Fixed PA_SightCrossLine(const MapQueryContext& ctx, const vertex_t& lineV1, const vertex_t& lineV2) noexcept;
+Fixed PA_SightCrossLine(const MapQueryContext& ctx, const line_t& line) noexcept;
+bool PA_CrossSubsector(MapQueryContext& ctx, const subsector_t& sub) noexcept;
 
 END_NAMESPACE(Shoot)
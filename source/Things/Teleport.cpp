@@ -8,14 +8,21 @@
 #include "Interactions.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "MapObj.h"
+#include "MObjTable.h"
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 // Kill all monsters around the given spot
 //------------------------------------------------------------------------------------------------------------------------------------------
 static void P_Telefrag(mobj_t& thing, const Fixed x, const Fixed y) noexcept {
-    for (mobj_t* pMObj = gMObjHead.next; pMObj != &gMObjHead; pMObj = pMObj->next) {
+    for (uint32_t orderIdx = 0; orderIdx < MObjTable::getNumEntries(); ++orderIdx) {
+        mobj_t* const pMObj = MObjTable::getEntry(orderIdx);
+
+        if (!pMObj)
+            continue;
+
         mobj_t& mObj = *pMObj;
 
         if ((mObj.flags & MF_SHOOTABLE) != 0) {     // Can I kill it?
@@ -61,7 +68,12 @@ bool EV_Teleport(line_t& line, mobj_t& thing) noexcept {
             continue;
         }
 
-        for (mobj_t* pMObj = gMObjHead.next; pMObj != &gMObjHead; pMObj = pMObj->next) {
+        for (uint32_t orderIdx = 0; orderIdx < MObjTable::getNumEntries(); ++orderIdx) {
+            mobj_t* const pMObj = MObjTable::getEntry(orderIdx);
+
+            if (!pMObj)
+                continue;
+
             mobj_t& mObj = *pMObj;
 
             if (mObj.InfoPtr != &gMObjInfo[MT_TELEPORTMAN]) {
@@ -76,10 +88,10 @@ bool EV_Teleport(line_t& line, mobj_t& thing) noexcept {
             const Fixed oldy = thing.y;
             const Fixed oldz = thing.z;
 
-            thing.flags |= MF_TELEPORT;                             // Mark as a teleport
-            P_Telefrag(thing, mObj.x, mObj.y);                      // Frag everything at dest
-            const bool flag = P_TryMove(thing, mObj.x, mObj.y);     // Put it there
-            thing.flags &= ~MF_TELEPORT;                            // Clear the flag
+            thing.flags |= MF_TELEPORT;                                                 // Mark as a teleport
+            P_Telefrag(thing, mObj.x, mObj.y);                                          // Frag everything at dest
+            const bool flag = P_TryMove(gMapQueryContext, thing, mObj.x, mObj.y);       // Put it there
+            thing.flags &= ~MF_TELEPORT;                                                // Clear the flag
 
             if (!flag) {
                 return false;   // (Can't teleport) move is blocked
@@ -9,6 +9,7 @@
 #include "Info.h"
 #include "Map/Map.h"
 #include "Map/MapData.h"
+#include "Map/MapQueryContext.h"
 #include "Map/MapUtil.h"
 #include "Map/Specials.h"
 #include "MapObj.h"
@@ -63,6 +64,7 @@ static bool gbOnGround;     // True if the player is on the ground
 // Move the player along the momentum
 //------------------------------------------------------------------------------------------------------------------------------------------
 static void P_PlayerMove(mobj_t& mo) noexcept {
+    MapQueryContext& ctx = gMapQueryContext;
     Fixed momx = mo.momx >> 2;      // Get the momemtum
     Fixed momy = mo.momy >> 2;
 
@@ -74,9 +76,9 @@ static void P_PlayerMove(mobj_t& mo) noexcept {
         Slide::doSliding(mo);   // Slide the player ahead
     }
 
-    if (Slide::gSlideX != mo.x || Slide::gSlideY != mo.y) {         // No motion at all?
-        if (P_TryMove(mo, Slide::gSlideX, Slide::gSlideY)) {        // Can I move?
-            goto dospecial;                                         // Movement OK, just special and exit
+    if (Slide::gSlideX != mo.x || Slide::gSlideY != mo.y) {             // No motion at all?
+        if (P_TryMove(ctx, mo, Slide::gSlideX, Slide::gSlideY)) {       // Can I move?
+            goto dospecial;                                             // Movement OK, just special and exit
         }
     }
 
@@ -95,14 +97,14 @@ static void P_PlayerMove(mobj_t& mo) noexcept {
 
     // Since I can't either slide or directly go to my destination point,
     // stairstep to the closest point to the wall:
-    if (P_TryMove(mo, mo.x, mo.y + momy)) {             // Try Y motion only
-        mo.momx = 0;                                    // Kill the X motion
-        mo.momy = momy;                                 // Keep the Y motion
-    } else if (P_TryMove(mo, mo.x + momx, mo.y)) {      // Try X motion only
-        mo.momx = momx;                                 // Keep the X motion
-        mo.momy = 0;                                    // Kill the Y motion
+    if (P_TryMove(ctx, mo, mo.x, mo.y + momy)) {            // Try Y motion only
+        mo.momx = 0;                                        // Kill the X motion
+        mo.momy = momy;                                     // Keep the Y motion
+    } else if (P_TryMove(ctx, mo, mo.x + momx, mo.y)) {     // Try X motion only
+        mo.momx = momx;                                     // Keep the X motion
+        mo.momy = 0;                                        // Kill the Y motion
     } else {
-        mo.momx = mo.momy = 0;                          // No more sliding
+        mo.momx = mo.momy = 0;                              // No more sliding
     }
 
 dospecial:
@@ -258,7 +260,7 @@ static void P_BuildMove(player_t& player) noexcept {
 
         // Do turning
         float angleTurnFracF = -INPUT_AXIS(TURN_LEFT_RIGHT);
-        angleTurnFracF -= Input::getMouseXMovement() * MOUSE_TURN_SCALE * Config::gMouseTurnSensitivity;
+        angleTurnFracF -= Controls::getMouseTurn() * MOUSE_TURN_SCALE;
 
         if (GAME_ACTION(TURN_LEFT)) {
             angleTurnFracF += 1.0f;
@@ -461,12 +463,14 @@ static void P_DeathThink(player_t& player) noexcept {
     PlayerCalcHeight(player);                               // Calc the height of the player
 
     // Only face killer if I didn't kill myself or jumped into lava
-    if (player.attacker && player.attacker != player.mo) {
+    const mobj_t* const pAttacker = MObjTable::resolveHandle(player.attacker);
+
+    if (pAttacker && pAttacker != player.mo) {
         const angle_t angle = PointToAngle(
             player.mo->x,
             player.mo->y,
-            player.attacker->x,
-            player.attacker->y
+            pAttacker->x,
+            pAttacker->y
         );
 
         const angle_t delta = angle - player.mo->angle;     // Get differance
@@ -658,7 +662,7 @@ void P_PlayerThink(player_t& player) noexcept {
 
         // Was use just pressed? If so then process.
         if (GAME_ACTION_ENDED(USE)) {
-            P_UseLines(player);
+            P_UseLines(gMapQueryContext, player);
         }
 
         // Process weapon attacks
@@ -8,6 +8,7 @@
 #include "GFX/Video.h"
 #include "Map/MapData.h"
 #include "Things/MapObj.h"
+#include "Things/MObjTable.h"
 
 static constexpr Fixed STEPVALUE    = (2 << FRACBITS);      // Speed to move around in the map (Fixed) For non-follow mode
 static constexpr Fixed MAXSCALES    = 0x10000;              // Maximum scale factor (Largest)
@@ -392,11 +393,13 @@ void AM_Drawer() noexcept {
     // Show all map things (cheat)
     if (gShowAllAutomapThings) {
         const int32_t objScale = MulByMapScale(MOBJLENGTH);   // Get the triangle size
-        mobj_t* pMapObj = gMObjHead.next;
         const mobj_t* const pPlayerMapObj = pPlayer->mo;
+        const uint32_t numMapObjs = MObjTable::getNumEntries();
 
-        while (pMapObj != &gMObjHead) {         // Wrapped around?
-            if (pMapObj != pPlayerMapObj) {     // Not the player?
+        for (uint32_t orderIdx = 0; orderIdx < numMapObjs; ++orderIdx) {
+            const mobj_t* const pMapObj = MObjTable::getEntry(orderIdx);
+
+            if (pMapObj && (pMapObj != pPlayerMapObj)) {    // Not removed or the player?
                 const int32_t x1 = MulByMapScale(pMapObj->x-ox);
                 int32_t y1 = MulByMapScale(pMapObj->y-oy);
 
@@ -409,8 +412,6 @@ void AM_Drawer() noexcept {
                 DrawLine(x2, y2, nx3, y2, COLOR_LILAC);
                 DrawLine(nx3, y2, x1, y1, COLOR_LILAC);
             }
-
-            pMapObj = pMapObj->next;    // Next item?
         }
     }
 
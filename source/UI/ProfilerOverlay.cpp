@@ -0,0 +1,211 @@
+#include "ProfilerOverlay.h"
+
+#include "Base/Profiler.h"
+#include "Base/Tables.h"
+#include "GFX/Video.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+BEGIN_NAMESPACE(ProfilerOverlay)
+
+// Size of the characters in the overlay font and the spacing between characters and lines
+static constexpr uint32_t CHAR_W = 3;
+static constexpr uint32_t CHAR_H = 5;
+static constexpr uint32_t CHAR_ADVANCE_X = CHAR_W + 1;
+static constexpr uint32_t LINE_ADVANCE_Y = CHAR_H + 2;
+
+// How many characters to indent by for each level of scope nesting, and where the timing column starts
+static constexpr uint32_t INDENT_CHARS = 1;
+static constexpr uint32_t VALUE_COLUMN_CHARS = 38;
+
+// Colors used by the overlay
+static constexpr uint32_t TEXT_COLOR = 0x00FFFFFF;
+static constexpr uint32_t HEADER_COLOR = 0x00FFD000;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// A glyph in the overlay font: 5 rows of 3 pixels, with the most significant bit of each row being the leftmost pixel
+//------------------------------------------------------------------------------------------------------------------------------------------
+struct Glyph {
+    char        c;
+    uint8_t     rows[CHAR_H];
+};
+
+static constexpr Glyph FONT_GLYPHS[] = {
+    { '0', { 0b111, 0b101, 0b101, 0b101, 0b111 } },
+    { '1', { 0b010, 0b110, 0b010, 0b010, 0b111 } },
+    { '2', { 0b111, 0b001, 0b111, 0b100, 0b111 } },
+    { '3', { 0b111, 0b001, 0b111, 0b001, 0b111 } },
+    { '4', { 0b101, 0b101, 0b111, 0b001, 0b001 } },
+    { '5', { 0b111, 0b100, 0b111, 0b001, 0b111 } },
+    { '6', { 0b111, 0b100, 0b111, 0b101, 0b111 } },
+    { '7', { 0b111, 0b001, 0b001, 0b010, 0b010 } },
+    { '8', { 0b111, 0b101, 0b111, 0b101, 0b111 } },
+    { '9', { 0b111, 0b101, 0b111, 0b001, 0b111 } },
+    { 'A', { 0b010, 0b101, 0b111, 0b101, 0b101 } },
+    { 'B', { 0b110, 0b101, 0b110, 0b101, 0b110 } },
+    { 'C', { 0b011, 0b100, 0b100, 0b100, 0b011 } },
+    { 'D', { 0b110, 0b101, 0b101, 0b101, 0b110 } },
+    { 'E', { 0b111, 0b100, 0b110, 0b100, 0b111 } },
+    { 'F', { 0b111, 0b100, 0b110, 0b100, 0b100 } },
+    { 'G', { 0b011, 0b100, 0b101, 0b101, 0b011 } },
+    { 'H', { 0b101, 0b101, 0b111, 0b101, 0b101 } },
+    { 'I', { 0b111, 0b010, 0b010, 0b010, 0b111 } },
+    { 'J', { 0b001, 0b001, 0b001, 0b101, 0b010 } },
+    { 'K', { 0b101, 0b101, 0b110, 0b101, 0b101 } },
+    { 'L', { 0b100, 0b100, 0b100, 0b100, 0b111 } },
+    { 'M', { 0b101, 0b111, 0b111, 0b101, 0b101 } },
+    { 'N', { 0b110, 0b101, 0b101, 0b101, 0b101 } },
+    { 'O', { 0b010, 0b101, 0b101, 0b101, 0b010 } },
+    { 'P', { 0b110, 0b101, 0b110, 0b100, 0b100 } },
+    { 'Q', { 0b010, 0b101, 0b101, 0b110, 0b011 } },
+    { 'R', { 0b110, 0b101, 0b110, 0b101, 0b101 } },
+    { 'S', { 0b011, 0b100, 0b010, 0b001, 0b110 } },
+    { 'T', { 0b111, 0b010, 0b010, 0b010, 0b010 } },
+    { 'U', { 0b101, 0b101, 0b101, 0b101, 0b111 } },
+    { 'V', { 0b101, 0b101, 0b101, 0b101, 0b010 } },
+    { 'W', { 0b101, 0b101, 0b111, 0b111, 0b101 } },
+    { 'X', { 0b101, 0b101, 0b010, 0b101, 0b101 } },
+    { 'Y', { 0b101, 0b101, 0b010, 0b010, 0b010 } },
+    { 'Z', { 0b111, 0b001, 0b010, 0b100, 0b111 } },
+    { '.', { 0b000, 0b000, 0b000, 0b000, 0b010 } },
+    { ':', { 0b000, 0b010, 0b000, 0b010, 0b000 } },
+    { '-', { 0b000, 0b000, 0b111, 0b000, 0b000 } },
+    { '_', { 0b000, 0b000, 0b000, 0b000, 0b111 } },
+    { '/', { 0b001, 0b001, 0b010, 0b100, 0b100 } },
+    { '(', { 0b010, 0b100, 0b100, 0b100, 0b010 } },
+    { ')', { 0b010, 0b001, 0b001, 0b001, 0b010 } },
+    { '%', { 0b101, 0b001, 0b010, 0b100, 0b101 } },
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Find the glyph for a character, or return 'nullptr' if the character is not in the font (e.g a space)
+//------------------------------------------------------------------------------------------------------------------------------------------
+static const Glyph* findGlyph(const char c) noexcept {
+    const char upperC = (char) std::toupper((unsigned char) c);
+
+    for (const Glyph& glyph : FONT_GLYPHS) {
+        if (glyph.c == upperC)
+            return &glyph;
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Darkens the given area of the screen (in screen pixels) so that overlay text on top of it is readable
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void darkenScreenArea(const int32_t x, const int32_t y, const int32_t w, const int32_t h) noexcept {
+    const int32_t x1 = std::max(x, 0);
+    const int32_t y1 = std::max(y, 0);
+    const int32_t x2 = std::min(x + w, (int32_t) Video::gScreenWidth);
+    const int32_t y2 = std::min(y + h, (int32_t) Video::gScreenHeight);
+
+    for (int32_t py = y1; py < y2; ++py) {
+        uint32_t* const pRow = Video::gpFrameBuffer + (uintptr_t) py * Video::gScreenWidth;
+
+        for (int32_t px = x1; px < x2; ++px) {
+            pRow[px] = (pRow[px] >> 2) & 0x003F3F3F;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints a string using the overlay font at the given position (in screen pixels), with each font pixel drawn as a square of the given
+// size. Returns the x position after the last character printed.
+//------------------------------------------------------------------------------------------------------------------------------------------
+static int32_t printString(const int32_t x, const int32_t y, const uint32_t pixelSize, const uint32_t color, const char* const pStr) noexcept {
+    const int32_t screenW = (int32_t) Video::gScreenWidth;
+    const int32_t screenH = (int32_t) Video::gScreenHeight;
+    int32_t curX = x;
+
+    for (const char* pCurChar = pStr; *pCurChar != 0; ++pCurChar, curX += CHAR_ADVANCE_X * pixelSize) {
+        const Glyph* const pGlyph = findGlyph(*pCurChar);
+
+        if (!pGlyph)
+            continue;
+
+        for (uint32_t glyphY = 0; glyphY < CHAR_H; ++glyphY) {
+            for (uint32_t glyphX = 0; glyphX < CHAR_W; ++glyphX) {
+                if ((pGlyph->rows[glyphY] & (0b100 >> glyphX)) == 0)
+                    continue;
+
+                const int32_t px1 = std::max(curX + (int32_t)(glyphX * pixelSize), 0);
+                const int32_t py1 = std::max(y + (int32_t)(glyphY * pixelSize), 0);
+                const int32_t px2 = std::min(curX + (int32_t)((glyphX + 1) * pixelSize), screenW);
+                const int32_t py2 = std::min(y + (int32_t)((glyphY + 1) * pixelSize), screenH);
+
+                for (int32_t py = py1; py < py2; ++py) {
+                    uint32_t* const pRow = Video::gpFrameBuffer + (uintptr_t) py * (uint32_t) screenW;
+
+                    for (int32_t px = px1; px < px2; ++px) {
+                        pRow[px] = color;
+                    }
+                }
+            }
+        }
+    }
+
+    return curX;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Prints a line of the overlay consisting of a label (indented by the given number of characters) and a value in a column to the right
+//------------------------------------------------------------------------------------------------------------------------------------------
+static void printLine(
+    const int32_t x,
+    const int32_t y,
+    const uint32_t pixelSize,
+    const uint32_t color,
+    const uint32_t indentChars,
+    const char* const pLabel,
+    const char* const pValue
+) noexcept {
+    printString(x + (int32_t)(indentChars * CHAR_ADVANCE_X * pixelSize), y, pixelSize, color, pLabel);
+    printString(x + (int32_t)(VALUE_COLUMN_CHARS * CHAR_ADVANCE_X * pixelSize), y, pixelSize, color, pValue);
+}
+
+void draw(const int32_t x, const int32_t y) noexcept {
+    const std::vector<Profiler::ZoneStats>& zoneStats = Profiler::getZoneStats();
+    const std::vector<Profiler::CounterStats>& counterStats = Profiler::getCounterStats();
+
+    // Scale the overlay up in line with everything else, but only by whole pixels so the font stays crisp
+    const uint32_t pixelSize = std::max((uint32_t) gScaleFactor, 1u);
+    const int32_t screenX = (int32_t)((float) x * gScaleFactor);
+    const int32_t screenY = (int32_t)((float) y * gScaleFactor);
+    const int32_t lineH = (int32_t)(LINE_ADVANCE_Y * pixelSize);
+
+    // Darken the area behind the overlay first
+    const uint32_t numLines = 1 + (uint32_t) zoneStats.size() + ((counterStats.empty()) ? 0 : 1 + (uint32_t) counterStats.size());
+    const int32_t overlayW = (int32_t)((VALUE_COLUMN_CHARS + 10) * CHAR_ADVANCE_X * pixelSize);
+    const int32_t overlayH = (int32_t) numLines * lineH + (int32_t) pixelSize * 2;
+    darkenScreenArea(screenX, screenY, overlayW, overlayH);
+
+    // Print the total frame time, then the nested list of stage timings and finally the counters
+    char valueStr[32];
+    int32_t curY = screenY + (int32_t) pixelSize;
+    const int32_t textX = screenX + (int32_t) pixelSize;
+
+    std::snprintf(valueStr, sizeof(valueStr), "%.1f US", Profiler::getAverageFrameUSec());
+    printLine(textX, curY, pixelSize, HEADER_COLOR, 0, "FRAME", valueStr);
+    curY += lineH;
+
+    for (const Profiler::ZoneStats& stats : zoneStats) {
+        std::snprintf(valueStr, sizeof(valueStr), "%.1f US", stats.avgUSec);
+        printLine(textX, curY, pixelSize, TEXT_COLOR, (stats.depth + 1) * INDENT_CHARS, stats.name, valueStr);
+        curY += lineH;
+    }
+
+    if (!counterStats.empty()) {
+        printLine(textX, curY, pixelSize, HEADER_COLOR, 0, "COUNTERS", "");
+        curY += lineH;
+
+        for (const Profiler::CounterStats& stats : counterStats) {
+            std::snprintf(valueStr, sizeof(valueStr), "%.0f", stats.avgValue);
+            printLine(textX, curY, pixelSize, TEXT_COLOR, INDENT_CHARS, stats.name, valueStr);
+            curY += lineH;
+        }
+    }
+}
+
+END_NAMESPACE(ProfilerOverlay)
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Base/Macros.h"
+#include <cstdint>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+// Draws the latest averaged results from the profiler on screen: a nested list of timed stages followed by the per frame counters.
+// Uses a tiny built in font so that the whole list fits on screen at the original 320x200 resolution.
+//------------------------------------------------------------------------------------------------------------------------------------------
+BEGIN_NAMESPACE(ProfilerOverlay)
+
+// Draws the overlay with its top left corner at the given position, in terms of the original 320x200 resolution
+void draw(const int32_t x, const int32_t y) noexcept;
+
+END_NAMESPACE(ProfilerOverlay)
@@ -141,8 +141,8 @@ void ST_Ticker() noexcept {
     // Animate face
     --gFaceTics;                                // Count down
     if (gFaceTics & 0x8000) {                   // Negative?
-        gFaceTics = Random::nextU32(15)*4;      // New random value
-        gNewFace = Random::nextU32(2);          // Which face 0-2
+        gFaceTics = Random::nextUIU32(15)*4;    // New random value
+        gNewFace = Random::nextUIU32(2);        // Which face 0-2
     }
 
     // Draw special face?
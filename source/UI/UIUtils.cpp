@@ -6,6 +6,7 @@
 #include "GFX/Blit.h"
 #include "GFX/CelImages.h"
 #include "GFX/Video.h"
+#include "ProfilerOverlay.h"
 #include <cstring>
 #include <string>
 
@@ -234,6 +235,9 @@ void drawPerformanceCounter(const int32_t x, const int32_t y) noexcept {
         std::string usecString = std::to_string(gPerfCounterAverageUSec) + std::string(" USEC");
         printBigFont(x, y, usecString.c_str());
     }
+    else if (gPerfCounterMode == PerfCounterMode::PROFILE) {
+        ProfilerOverlay::draw(x, y);
+    }
 }
 
 END_NAMESPACE(UIUtils)
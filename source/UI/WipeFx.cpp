@@ -34,14 +34,14 @@ static std::unique_ptr<float[]> generateYDeltaTable() noexcept {
 
     std::unique_ptr<float[]> deltas(new float[screenWidth]);
 
-    float delta = Random::nextFloat() * -16.0f * scaleFactor;
+    float delta = Random::nextUIFloat() * -16.0f * scaleFactor;
 
     for (uint32_t x = 0; x < numRepeatedCols; ++x) {
         deltas[x] = delta;
     }
 
     for (uint32_t x = numRepeatedCols; x < screenWidth; x += numRepeatedCols) {
-        delta += (float)(Random::nextFloat() * 2.0f - 1.0f) * scaleFactor;  // Add -1, 0 or 1
+        delta += (float)(Random::nextUIFloat() * 2.0f - 1.0f) * scaleFactor;    // Add -1, 0 or 1
         delta = std::min(delta, maxDelta);  // Too high?
         delta = std::max(delta, minDelta);  // Too low?
 